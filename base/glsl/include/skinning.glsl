@@ -4,16 +4,34 @@
 in uvec4 a_JointIndices;
 in vec4 a_JointWeights;
 
+#if INSTANCED
+// every instance's skinning matrices, starting at u_InstanceData[ i ].pose
+uniform samplerBuffer u_InstancePoses;
+
+mat4 SkinningMatrix( uint joint ) {
+	int base = ( u_InstanceData[ gl_InstanceID ].pose + int( joint ) ) * 4;
+	return mat4(
+		texelFetch( u_InstancePoses, base ),
+		texelFetch( u_InstancePoses, base + 1 ),
+		texelFetch( u_InstancePoses, base + 2 ),
+		texelFetch( u_InstancePoses, base + 3 ) );
+}
+#else
 layout( std140 ) uniform u_Pose {
 	mat4 u_SkinningMatrices[ MAX_JOINTS ];
 };
 
+mat4 SkinningMatrix( uint joint ) {
+	return u_SkinningMatrices[ joint ];
+}
+#endif
+
 void Skin( inout vec4 position, inout vec3 normal ) {
 	mat4 skin =
-		a_JointWeights.x * u_SkinningMatrices[ a_JointIndices.x ] +
-		a_JointWeights.y * u_SkinningMatrices[ a_JointIndices.y ] +
-		a_JointWeights.z * u_SkinningMatrices[ a_JointIndices.z ] +
-		a_JointWeights.w * u_SkinningMatrices[ a_JointIndices.w ];
+		a_JointWeights.x * SkinningMatrix( a_JointIndices.x ) +
+		a_JointWeights.y * SkinningMatrix( a_JointIndices.y ) +
+		a_JointWeights.z * SkinningMatrix( a_JointIndices.z ) +
+		a_JointWeights.w * SkinningMatrix( a_JointIndices.w );
 
 	position = skin * position;
 	normal = normalize( mat3( skin ) * normal );
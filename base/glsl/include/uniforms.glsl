@@ -12,9 +12,23 @@ layout( std140 ) uniform u_View {
 	vec3 u_LightDir;
 };
 
+#if INSTANCED
+struct Instance {
+	mat4 M;
+	vec4 color;
+	int pose;
+};
+
+layout( std140 ) uniform u_Instances {
+	Instance u_InstanceData[ MAX_INSTANCES ];
+};
+
+#define u_M u_InstanceData[ gl_InstanceID ].M
+#else
 layout( std140 ) uniform u_Model {
 	mat4 u_M;
 };
+#endif
 
 layout( std140 ) uniform u_Material {
 	vec4 u_MaterialColor;
@@ -17,6 +17,10 @@ v2f vec4 v_FarShadowmapPosition;
 v2f vec4 v_Color;
 #endif
 
+#if INSTANCED
+flat v2f vec4 v_InstanceColor;
+#endif
+
 #if APPLY_SOFT_PARTICLE
 v2f float v_Depth;
 #endif
@@ -60,6 +64,10 @@ void main() {
 	v_Color = sRGBToLinear( a_Color );
 #endif
 
+#if INSTANCED
+	v_InstanceColor = u_InstanceData[ gl_InstanceID ].color;
+#endif
+
 	gl_Position = u_P * u_V * u_M * Position;
 
 #if APPLY_SOFT_PARTICLE
@@ -99,8 +107,12 @@ void main() {
 	vec3 normal = normalize( v_Normal );
 #if APPLY_DRAWFLAT
 	vec4 diffuse = u_MaterialColor;
+#else
+#if INSTANCED
+	vec4 color = v_InstanceColor;
 #else
 	vec4 color = u_MaterialColor;
+#endif
 
 #if VERTEX_COLORS
 	color *= v_Color;
@@ -162,6 +162,79 @@ do
 		gcc_extra_ldflags = "-lm -lpthread -ldl -no-pie -static-libstdc++",
 		msvc_extra_ldflags = "ole32.lib ws2_32.lib crypt32.lib",
 	} )
+
+	bin( "loadgen", {
+		srcs = {
+			"source/gameshared/*.cpp",
+			"source/loadgen/*.cpp",
+			"source/stubs/sv_stubs.cpp",
+			"source/qcommon/*.cpp",
+			platform_srcs
+		},
+
+		libs = {
+			"ggentropy",
+			"ggformat",
+			"monocypher",
+			"tracy",
+			"whereami",
+			"zlib",
+			"zstd",
+		},
+
+		gcc_extra_ldflags = "-lm -lpthread -ldl -no-pie -static-libstdc++",
+		msvc_extra_ldflags = "ole32.lib ws2_32.lib crypt32.lib",
+	} )
+
+	bin( "soundtest", {
+		srcs = {
+			"source/client/assets.cpp",
+			"source/client/asset_cache.cpp",
+			"source/gameshared/*.cpp",
+			"source/soundtest/*.cpp",
+			"source/stubs/sv_stubs.cpp",
+			"source/qcommon/*.cpp",
+			platform_srcs
+		},
+
+		libs = {
+			"ggentropy",
+			"ggformat",
+			"monocypher",
+			"openal",
+			"stb_vorbis",
+			"tracy",
+			"whereami",
+			"zlib",
+			"zstd",
+		},
+
+		gcc_extra_ldflags = "-lm -lpthread -ldl -no-pie -static-libstdc++",
+		msvc_extra_ldflags = "ole32.lib ws2_32.lib crypt32.lib winmm.lib",
+	} )
+
+	bin( "relay", {
+		srcs = {
+			"source/gameshared/*.cpp",
+			"source/relay/*.cpp",
+			"source/stubs/sv_stubs.cpp",
+			"source/qcommon/*.cpp",
+			platform_srcs
+		},
+
+		libs = {
+			"ggentropy",
+			"ggformat",
+			"monocypher",
+			"tracy",
+			"whereami",
+			"zlib",
+			"zstd",
+		},
+
+		gcc_extra_ldflags = "-lm -lpthread -ldl -no-pie -static-libstdc++",
+		msvc_extra_ldflags = "ole32.lib ws2_32.lib crypt32.lib",
+	} )
 end
 
 obj_cxxflags( "source/game/angelwrap/.+", "-I third-party/angelscript/sdk/angelscript/include" )
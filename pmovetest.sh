@@ -0,0 +1,33 @@
+#!/bin/sh
+
+# records loadgen clients running into each other with client moves made one
+# at a time, then replays the recorded usercmds with client moves predicted in
+# parallel, which has to end up with exactly the same game state every snapshot
+
+MAP=gladiator
+CLIENTS=16
+DURATION=30
+
+cd "$(dirname "$0")/release" || exit 1
+
+# keep the recording out of the real home dir
+XDG_DATA_HOME="$(mktemp -d)"
+export XDG_DATA_HOME
+trap 'rm -rf "$XDG_DATA_HOME"' EXIT
+
+./server +set sv_iplimit 0 +set sv_maxclients $CLIENTS +set g_parallel_pmove 0 +set sv_recordinputs 1 +map $MAP > /dev/null 2>&1 &
+server=$!
+sleep 3
+timeout $DURATION ./loadgen +loadgen 127.0.0.1:44400 $CLIENTS > /dev/null 2>&1
+kill $server
+wait $server
+
+replay="$(ls "$XDG_DATA_HOME"/*/replays/*.replay 2> /dev/null | head -n 1)"
+if [ -z "$replay" ]; then
+	echo "Didn't record anything"
+	exit 1
+fi
+replay="$(basename "$replay" .replay)"
+
+./server +set sv_maxclients $CLIENTS +set g_parallel_pmove 1 +replayinputs "$replay" +quit 2>&1 | tee "$XDG_DATA_HOME/replay.log"
+grep -q "All [0-9]* game states matched" "$XDG_DATA_HOME/replay.log"
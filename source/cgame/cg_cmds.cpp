@@ -445,6 +445,10 @@ static const cgcmd_t cgcmds[] = {
 	{ "weapprev", CG_Cmd_PrevWeapon_f, false },
 	{ "weapon", CG_Cmd_Weapon_f, false },
 	{ "viewpos", CG_Viewpos_f, true },
+	{ "animationbenchmark", CG_AnimationBenchmark_f, true },
+	{ "hudbenchmark", CG_HUDBenchmark_f, true },
+	{ "decalbenchmark", CG_DecalBenchmark_f, true },
+	{ "predictionbenchmark", CG_PredictionBenchmark_f, true },
 	{ "players", NULL, false },
 	{ "spectators", NULL, false },
 
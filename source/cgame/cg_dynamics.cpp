@@ -3,7 +3,7 @@
 #include "qcommon/span2d.h"
 #include "cgame/cg_local.h"
 #include "client/renderer/renderer.h"
-#include "qcommon/array.h"
+#include "qcommon/threadpool.h"
 
 static TextureBuffer decal_tiles_buffer;
 static TextureBuffer dlight_tiles_buffer;
@@ -22,10 +22,19 @@ struct Decal {
 	// NOTE(msc): uvwh should all be < 1.0
 };
 
+// inclusive range of screen tiles touched by a decal/dlight
+struct TileRect {
+	u16 minx, miny, maxx, maxy;
+};
+
 struct PersistentDecal {
 	Decal decal;
 	s64 spawn_time;
 	s64 duration;
+
+	// persistent decals don't move so we can reuse their tiles until the camera moves
+	TileRect tiles;
+	bool tiles_cached;
 };
 
 STATIC_ASSERT( sizeof( Decal ) == 2 * 4 * sizeof( float ) );
@@ -64,6 +73,10 @@ static u32 num_dlights;
 static PersistentDecal persistent_decals[ MAX_DECALS ];
 static u32 num_persistent_decals;
 
+// DrawPersistentDecals copies persistent_decals[ i ] to decals[ first_persistent_decal + i ]
+static u32 first_persistent_decal;
+static u32 num_persistent_decals_drawn;
+
 static PersistentDynamicLight persistent_dlights[ MAX_DLIGHTS ];
 static u32 num_persistent_dlights;
 
@@ -85,6 +98,26 @@ struct DynamicCount {
 
 static Span2D< DynamicCount > gpu_dynamic_counts;
 
+// dlights come first and are stored with idx = num_decals + dlight index, so
+// rects and coverage sets stay sorted from high to low idx
+struct DynamicRect {
+	TileRect tiles;
+	u32 idx;
+};
+
+struct DynamicSet {
+	u32 indices[ MAX_DYNAMICS_PER_SET ];
+	u32 num;
+};
+
+static DynamicRect dynamic_rects[ MAX_DLIGHTS + MAX_DECALS ];
+
+static Span< DynamicSet > rows_coverage;
+static Span< DynamicSet > cols_coverage;
+
+static Mat4 last_V, last_P;
+static Vec2 last_viewport;
+
 void InitDecals() {
 	num_persistent_decals = 0;
 	num_persistent_dlights = 0;
@@ -97,6 +130,11 @@ void InitDecals() {
 }
 
 void ShutdownDecals() {
+	FREE( sys_allocator, rows_coverage.ptr );
+	rows_coverage = Span< DynamicSet >();
+	FREE( sys_allocator, cols_coverage.ptr );
+	cols_coverage = Span< DynamicSet >();
+
 	FREE( sys_allocator, gpu_decal_tiles.ptr );
 	gpu_decal_tiles.ptr = NULL;
 	DeferDeleteTextureBuffer( decal_tiles_buffer );
@@ -152,11 +190,15 @@ void AddPersistentDecal( Vec3 origin, Vec3 normal, float radius, float angle, St
 	decal->decal.color_uvwh_height = Vec4( uvwh.x, uvwh.y + c.x, uvwh.z + c.y, uvwh.w + c.z );
 	decal->spawn_time = cl.serverTime;
 	decal->duration = duration;
+	decal->tiles_cached = false;
 
 	num_persistent_decals++;
 }
 
 void DrawPersistentDecals() {
+	first_persistent_decal = num_decals;
+	num_persistent_decals_drawn = 0;
+
 	for( u32 i = 0; i < num_persistent_decals; i++ ) {
 		if( num_decals == ARRAY_COUNT( decals ) )
 			break;
@@ -171,6 +213,7 @@ void DrawPersistentDecals() {
 
 		decals[ num_decals ] = decal->decal;
 		num_decals++;
+		num_persistent_decals_drawn++;
 	}
 }
 
@@ -313,168 +356,214 @@ void AllocateDecalBuffers() {
 		gpu_dynamic_counts = ALLOC_SPAN2D( sys_allocator, DynamicCount, cols, rows );
 		dynamic_count = NewTextureBuffer( TextureBufferFormat_U8x2, rows * cols );
 
+		FREE( sys_allocator, rows_coverage.ptr );
+		rows_coverage = ALLOC_SPAN( sys_allocator, DynamicSet, rows );
+		FREE( sys_allocator, cols_coverage.ptr );
+		cols_coverage = ALLOC_SPAN( sys_allocator, DynamicSet, cols );
+
 		last_viewport_width = frame_static.viewport_width;
 		last_viewport_height = frame_static.viewport_height;
 	}
 }
 
-enum DynamicType {
-	DynamicType_Decal,
-	DynamicType_Light,
-};
+static constexpr u16 CULLED_TILE = U16_MAX;
 
-struct DynamicRect {
-	DynamicType type;
-	u32 minx, miny, maxx, maxy;
-	u32 idx;
-};
+static TileRect SphereTiles( Vec3 origin, float radius ) {
+	MinMax2 bounds = SphereScreenSpaceBounds( origin, radius );
+	bounds.mins.y = -bounds.mins.y;
+	bounds.maxs.y = -bounds.maxs.y;
+	Swap2( &bounds.mins.y, &bounds.maxs.y );
 
-struct DynamicSet {
-	u32 indices[ MAX_DYNAMICS_PER_SET ];
-	DynamicType types[ MAX_DYNAMICS_PER_SET ];
-	u32 num;
+	TileRect tiles;
+	if( bounds.maxs.x <= -1.0f || bounds.maxs.y <= -1.0f || bounds.mins.x >= 1.0f || bounds.mins.y >= 1.0f ) {
+		tiles.minx = CULLED_TILE;
+		return tiles;
+	}
+
+	Vec2 mins = ( bounds.mins + 1.0f ) * 0.5f * frame_static.viewport;
+	mins = Clamp( Vec2( 0.0f ), mins, frame_static.viewport - 1.0f ) / float( TILE_SIZE );
+
+	Vec2 maxs = ( bounds.maxs + 1.0f ) * 0.5f * frame_static.viewport;
+	maxs = Clamp( Vec2( 0.0f ), maxs, frame_static.viewport - 1.0f ) / float( TILE_SIZE );
+
+	tiles.minx = mins.x;
+	tiles.miny = mins.y;
+	tiles.maxx = maxs.x;
+	tiles.maxy = maxs.y;
+
+	return tiles;
+}
+
+struct DynamicBoundsJob {
+	u32 first;
+	u32 count;
+	bool camera_moved;
 };
 
-void UploadDecalBuffers() {
+static void ComputeDynamicBounds( TempAllocator * temp, void * data ) {
 	ZoneScoped;
 
-	u32 rows = ( frame_static.viewport_height + TILE_SIZE - 1 ) / TILE_SIZE;
-	u32 cols = ( frame_static.viewport_width + TILE_SIZE - 1 ) / TILE_SIZE;
-
-	DynamicArray< DynamicRect > rects( sys_allocator );
+	const DynamicBoundsJob * job = ( const DynamicBoundsJob * ) data;
 
-	for( u32 i = 0; i < num_dlights; i++ ) {
-		u32 index = num_dlights - i - 1;
-		MinMax2 bounds = SphereScreenSpaceBounds( Floor( dlights[ index ].origin_color ), dlights[ index ].radius );
-		bounds.mins.y = -bounds.mins.y;
-		bounds.maxs.y = -bounds.maxs.y;
-		Swap2( &bounds.mins.y, &bounds.maxs.y );
+	for( u32 i = job->first; i < job->first + job->count; i++ ) {
+		DynamicRect * rect = &dynamic_rects[ i ];
 
-		if( bounds.maxs.x <= -1.0f || bounds.maxs.y <= -1.0f || bounds.mins.x >= 1.0f || bounds.mins.y >= 1.0f ) {
+		if( i < num_dlights ) {
+			u32 index = num_dlights - i - 1;
+			rect->tiles = SphereTiles( Floor( dlights[ index ].origin_color ), dlights[ index ].radius );
+			rect->idx = num_decals + index;
 			continue;
 		}
 
-		Vec2 mins = ( bounds.mins + 1.0f ) * 0.5f * frame_static.viewport;
-		mins = Clamp( Vec2( 0.0f ), mins, frame_static.viewport - 1.0f ) / float( TILE_SIZE );
+		u32 index = num_decals - ( i - num_dlights ) - 1;
+		rect->idx = index;
+
+		PersistentDecal * persistent = NULL;
+		if( index >= first_persistent_decal && index < first_persistent_decal + num_persistent_decals_drawn ) {
+			persistent = &persistent_decals[ index - first_persistent_decal ];
+			if( persistent->tiles_cached && !job->camera_moved ) {
+				rect->tiles = persistent->tiles;
+				continue;
+			}
+		}
 
-		Vec2 maxs = ( bounds.maxs + 1.0f ) * 0.5f * frame_static.viewport;
-		maxs = Clamp( Vec2( 0.0f ), maxs, frame_static.viewport - 1.0f ) / float( TILE_SIZE );
+		rect->tiles = SphereTiles( Floor( decals[ index ].origin_normal ), floorf( decals[ index ].radius_angle ) );
 
-		DynamicRect rect;
-		rect.type = DynamicType_Light;
-		rect.minx = mins.x;
-		rect.miny = mins.y;
-		rect.maxx = maxs.x;
-		rect.maxy = maxs.y;
-		rect.idx = num_decals + index;
-		rects.add( rect );
+		if( persistent != NULL ) {
+			persistent->tiles = rect->tiles;
+			persistent->tiles_cached = true;
+		}
 	}
+}
 
-	for( u32 i = 0; i < num_decals; i++ ) {
-		u32 index = num_decals - i - 1;
-		MinMax2 bounds = SphereScreenSpaceBounds( Floor( decals[ index ].origin_normal ), floorf( decals[ index ].radius_angle ) );
-		bounds.mins.y = -bounds.mins.y;
-		bounds.maxs.y = -bounds.maxs.y;
-		Swap2( &bounds.mins.y, &bounds.maxs.y );
+static void AddToSet( DynamicSet * set, u32 idx ) {
+	if( set->num < MAX_DYNAMICS_PER_SET ) {
+		set->indices[ set->num ] = idx;
+		set->num++;
+	}
+}
 
-		if( bounds.maxs.x <= -1.0f || bounds.maxs.y <= -1.0f || bounds.mins.x >= 1.0f || bounds.mins.y >= 1.0f ) {
-			continue;
+static void FillTileRow( TempAllocator * temp, void * data ) {
+	u32 y = *( const u32 * ) data;
+
+	const DynamicSet & y_set = rows_coverage[ y ];
+	for( u32 x = 0; x < cols_coverage.n; x++ ) {
+		const DynamicSet & x_set = cols_coverage[ x ];
+		u32 x_idx = 0;
+		u32 y_idx = 0;
+		DecalTile & decal_tile = gpu_decal_tiles( x, y );
+		DynamicLightTile & dlight_tile = gpu_dlight_tiles( x, y );
+		DynamicCount & count = gpu_dynamic_counts( x, y );
+		count = { };
+
+		// NOTE(msc): decals guaranteed to sorted front to back / high to low
+		while( x_idx < x_set.num && y_idx < y_set.num ) {
+			u32 x_instance = x_set.indices[ x_idx ];
+			u32 y_instance = y_set.indices[ y_idx ];
+			// NOTE(msc): instance in both column & row, must be active in this cell
+			if( x_instance == y_instance ) {
+				if( x_instance < num_decals ) {
+					if( count.decal_count < MAX_DECALS_PER_TILE ) {
+						decal_tile.decals[ count.decal_count ] = x_instance;
+						count.decal_count++;
+					}
+				}
+				else {
+					if( count.dlight_count < MAX_DLIGHTS_PER_TILE ) {
+						dlight_tile.dlights[ count.dlight_count ] = x_instance - num_decals;
+						count.dlight_count++;
+					}
+				}
+				if( count.decal_count == MAX_DECALS_PER_TILE && count.dlight_count == MAX_DLIGHTS_PER_TILE ) {
+					break;
+				}
+				x_idx++;
+				y_idx++;
+			} else if( x_instance > y_instance ) {
+				// NOTE(msc): indices ordered high to low
+				x_idx++;
+			} else {
+				y_idx++;
+			}
 		}
+	}
+}
 
-		Vec2 mins = ( bounds.mins + 1.0f ) * 0.5f * frame_static.viewport;
-		mins = Clamp( Vec2( 0.0f ), mins, frame_static.viewport - 1.0f ) / float( TILE_SIZE );
+static void BinDynamics() {
+	ZoneScoped;
 
-		Vec2 maxs = ( bounds.maxs + 1.0f ) * 0.5f * frame_static.viewport;
-		maxs = Clamp( Vec2( 0.0f ), maxs, frame_static.viewport - 1.0f ) / float( TILE_SIZE );
+	u32 num_rects = num_dlights + num_decals;
 
-		DynamicRect rect;
-		rect.type = DynamicType_Decal;
-		rect.minx = mins.x;
-		rect.miny = mins.y;
-		rect.maxx = maxs.x;
-		rect.maxy = maxs.y;
-		rect.idx = index;
-		rects.add( rect );
+	{
+		ZoneScopedN( "Screen space bounds" );
+
+		// persistent decals can keep last frame's tiles if the camera didn't move
+		bool camera_moved = memcmp( &last_V, &frame_static.V, sizeof( Mat4 ) ) != 0 || memcmp( &last_P, &frame_static.P, sizeof( Mat4 ) ) != 0;
+		camera_moved = camera_moved || last_viewport != frame_static.viewport;
+		last_V = frame_static.V;
+		last_P = frame_static.P;
+		last_viewport = frame_static.viewport;
+
+		constexpr u32 rects_per_job = 1024;
+		DynamicBoundsJob jobs[ ( ARRAY_COUNT( dynamic_rects ) + rects_per_job - 1 ) / rects_per_job ];
+		u32 num_jobs = 0;
+
+		for( u32 i = 0; i < num_rects; i += rects_per_job ) {
+			jobs[ num_jobs ].first = i;
+			jobs[ num_jobs ].count = Min2( rects_per_job, num_rects - i );
+			jobs[ num_jobs ].camera_moved = camera_moved;
+			num_jobs++;
+		}
+
+		if( num_jobs > 1 ) {
+			ParallelFor( Span< DynamicBoundsJob >( jobs, num_jobs ), ComputeDynamicBounds );
+		}
+		else if( num_jobs == 1 ) {
+			ComputeDynamicBounds( NULL, &jobs[ 0 ] );
+		}
 	}
 
 	{
-		ZoneScopedN( "Fill buffers" );
-
-		Span< DynamicSet > rows_coverage = ALLOC_SPAN( sys_allocator, DynamicSet, rows );
-		Span< DynamicSet > cols_coverage = ALLOC_SPAN( sys_allocator, DynamicSet, cols );
-
-		memset( rows_coverage.ptr, 0, rows_coverage.num_bytes() );
-		memset( cols_coverage.ptr, 0, cols_coverage.num_bytes() );
-
-		for( u32 i = 0; i < rects.size(); i++ ) {
-			DynamicRect & rect = rects[ i ];
-			for( u32 x = rect.minx; x <= rect.maxx; x++ ) {
-				DynamicSet & set = cols_coverage[ x ];
-				if( set.num < MAX_DYNAMICS_PER_SET ) {
-					set.indices[ set.num ] = rect.idx;
-					set.types[ set.num ] = rect.type;
-					set.num++;
-				}
+		ZoneScopedN( "Fill coverage sets" );
+
+		for( DynamicSet & set : rows_coverage ) {
+			set.num = 0;
+		}
+		for( DynamicSet & set : cols_coverage ) {
+			set.num = 0;
+		}
+
+		for( u32 i = 0; i < num_rects; i++ ) {
+			const DynamicRect & rect = dynamic_rects[ i ];
+			if( rect.tiles.minx == CULLED_TILE )
+				continue;
+
+			for( u32 x = rect.tiles.minx; x <= rect.tiles.maxx; x++ ) {
+				AddToSet( &cols_coverage[ x ], rect.idx );
 			}
-			for( u32 y = rect.miny; y <= rect.maxy; y++ ) {
-				DynamicSet & set = rows_coverage[ y ];
-				if( set.num < MAX_DYNAMICS_PER_SET ) {
-					set.indices[ set.num ] = rect.idx;
-					set.types[ set.num ] = rect.type;
-					set.num++;
-				}
+			for( u32 y = rect.tiles.miny; y <= rect.tiles.maxy; y++ ) {
+				AddToSet( &rows_coverage[ y ], rect.idx );
 			}
 		}
+	}
 
-		memset( gpu_dynamic_counts.ptr, 0, gpu_dynamic_counts.num_bytes() );
-
-		for( u32 y = 0; y < rows; y++ ) {
-			DynamicSet & y_set = rows_coverage[ y ];
-			for( u32 x = 0; x < cols; x++ ) {
-				DynamicSet & x_set = cols_coverage[ x ];
-				u32 x_idx = 0;
-				u32 y_idx = 0;
-				DecalTile & decal_tile = gpu_decal_tiles( x, y );
-				DynamicLightTile & dlight_tile = gpu_dlight_tiles( x, y );
-
-				// NOTE(msc): decals guaranteed to sorted front to back / high to low
-				while( x_idx < x_set.num && y_idx < y_set.num ) {
-					u32 x_instance = x_set.indices[ x_idx ];
-					u32 y_instance = y_set.indices[ y_idx ];
-					// NOTE(msc): instance in both column & row, must be active in this cell
-					if( x_instance == y_instance ) {
-						DynamicType type = x_set.types[ x_idx ];
-						DynamicCount &count = gpu_dynamic_counts( x, y );
-						if( type == DynamicType_Decal ) {
-							if( count.decal_count < MAX_DECALS_PER_TILE ) {
-								decal_tile.decals[ count.decal_count ] = x_instance;
-								count.decal_count++;
-							}
-						}
-						else if( type == DynamicType_Light ) {
-							if( count.dlight_count < MAX_DLIGHTS_PER_TILE ) {
-								dlight_tile.dlights[ count.dlight_count ] = x_instance - num_decals;
-								count.dlight_count++;
-							}
-						}
-						if( count.decal_count == MAX_DECALS_PER_TILE && count.dlight_count == MAX_DLIGHTS_PER_TILE ) {
-							break;
-						}
-						x_idx++;
-						y_idx++;
-					} else if( x_instance > y_instance ) {
-						// NOTE(msc): indices ordered high to low
-						x_idx++;
-					} else {
-						y_idx++;
-					}
-				}
-			}
+	{
+		ZoneScopedN( "Fill tiles" );
+
+		TempAllocator temp = cls.frame_arena.temp();
+		Span< u32 > rows = ALLOC_SPAN( &temp, u32, rows_coverage.n );
+		for( u32 i = 0; i < rows.n; i++ ) {
+			rows[ i ] = i;
 		}
 
-		FREE( sys_allocator, rows_coverage.ptr );
-		FREE( sys_allocator, cols_coverage.ptr );
+		ParallelFor( rows, FillTileRow );
 	}
+}
+
+void UploadDecalBuffers() {
+	ZoneScoped;
+
+	BinDynamics();
 
 	{
 		ZoneScopedN( "Upload TBOs" );
@@ -487,6 +576,53 @@ void UploadDecalBuffers() {
 
 	num_decals = 0;
 	num_dlights = 0;
+	num_persistent_decals_drawn = 0;
+}
+
+void CG_DecalBenchmark_f() {
+	constexpr u32 num_benchmark_decals = 20000;
+	constexpr u32 num_benchmark_dlights = 1000;
+	constexpr int iterations = 100;
+
+	if( num_decals != 0 || num_dlights != 0 || gpu_decal_tiles.ptr == NULL ) {
+		Com_Printf( "Can't run the decal benchmark right now\n" );
+		return;
+	}
+
+	// scatter decals and lights on a wall in front of the camera
+	RNG rng = NewRNG( 0, 0 );
+	Vec3 forward = -frame_static.V.row2().xyz();
+	Vec3 wall = cg.view.origin + forward * 512.0f;
+
+	for( u32 i = 0; i < num_benchmark_decals; i++ ) {
+		Vec3 origin = wall + Vec3( RandomFloat11( &rng ), RandomFloat11( &rng ), RandomFloat11( &rng ) ) * 512.0f;
+		decals[ i ].origin_normal = Floor( origin ) + ( -forward * 0.49f + 0.5f );
+		decals[ i ].radius_angle = floorf( RandomUniformFloat( &rng, 8.0f, 64.0f ) );
+		decals[ i ].color_uvwh_height = Vec4( 0.0f );
+	}
+
+	for( u32 i = 0; i < num_benchmark_dlights; i++ ) {
+		Vec3 origin = wall + Vec3( RandomFloat11( &rng ), RandomFloat11( &rng ), RandomFloat11( &rng ) ) * 512.0f;
+		dlights[ i ].origin_color = Floor( origin ) + Vec3( 0.5f );
+		dlights[ i ].radius = RandomUniformFloat( &rng, 32.0f, 256.0f );
+	}
+
+	num_decals = num_benchmark_decals;
+	num_dlights = num_benchmark_dlights;
+	first_persistent_decal = 0;
+	num_persistent_decals_drawn = 0;
+
+	u64 start = Sys_Microseconds();
+	for( int i = 0; i < iterations; i++ ) {
+		BinDynamics();
+	}
+	u64 dt = Sys_Microseconds() - start;
+
+	num_decals = 0;
+	num_dlights = 0;
+
+	Com_Printf( "%u decals, %u dlights, %zux%zu tiles: %.3fms per frame\n",
+		num_benchmark_decals, num_benchmark_dlights, cols_coverage.n, rows_coverage.n, double( dt ) / iterations / 1000.0 );
 }
 
 void AddDynamicsToPipeline( PipelineState * pipeline ) {
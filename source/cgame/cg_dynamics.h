@@ -19,3 +19,5 @@ void DrawPersistentDynamicLights();
 void AllocateDecalBuffers();
 void UploadDecalBuffers();
 void AddDynamicsToPipeline( PipelineState * pipeline );
+
+void CG_DecalBenchmark_f();
@@ -296,7 +296,7 @@ bool CG_NewFrameSnap( snapshot_t *frame, snapshot_t *lerpframe ) {
 	CG_UpdateEntities();
 	CG_CheckPredictionError();
 
-	cg.predictFrom = 0; // force the prediction to be restarted from the new snapshot
+	CG_CheckPredictionCache(); // restart the prediction from the new snapshot unless it agrees with us
 	cg.fireEvents = true;
 
 	for( int i = 0; i < cg.frame.numgamecommands; i++ ) {
@@ -465,14 +465,16 @@ static void DrawEntityModel( centity_t * cent ) {
 		UniformBlock model_uniforms = UploadModelUniforms( transform * model->transform );
 		for( u32 i = 0; i < model->num_primitives; i++ ) {
 			if( model->primitives[ i ].material->blend_func == BlendFunc_Disabled ) {
-				{
+				u8 visible = CullBounds( TransformBounds( transform * model->transform, model->primitives[ i ].bounds ) );
+
+				if( visible & VisibleIn_View ) {
 					PipelineState pipeline = MaterialToPipelineState( model->primitives[ i ].material );
 					pipeline.set_uniform( "u_View", frame_static.view_uniforms );
 					pipeline.set_uniform( "u_Model", model_uniforms );
 
 					DrawModelPrimitive( model, &model->primitives[ i ], pipeline );
 				}
-				{
+				if( visible & VisibleIn_NearShadowmap ) {
 					PipelineState pipeline;
 					pipeline.pass = frame_static.near_shadowmap_pass;
 					pipeline.shader = &shaders.depth_only;
@@ -483,7 +485,7 @@ static void DrawEntityModel( centity_t * cent ) {
 
 					DrawModelPrimitive( model, &model->primitives[ i ], pipeline );
 				}
-				{
+				if( visible & VisibleIn_FarShadowmap ) {
 					PipelineState pipeline;
 					pipeline.pass = frame_static.far_shadowmap_pass;
 					pipeline.shader = &shaders.depth_only;
@@ -670,6 +672,9 @@ static void DrawEntityTrail( const centity_t * cent, StringHash name ) {
 void DrawEntities() {
 	ZoneScoped;
 
+	TempAllocator temp = cls.frame_arena.temp();
+	CG_AnimatePlayers( &temp );
+
 	for( int pnum = 0; pnum < cg.frame.numEntities; pnum++ ) {
 		SyncEntityState * state = &cg.frame.parsedEntities[pnum & ( MAX_PARSE_ENTITIES - 1 )];
 		centity_t * cent = &cg_entities[state->number];
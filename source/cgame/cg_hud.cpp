@@ -58,8 +58,42 @@ static const Font * GetHUDFont() {
 
 using opFunc_t = float( * )( const float a, float b );
 
+/*
+ * the parsed cg_layoutnode_t tree is compiled into a flat list of
+ * instructions. numeric arguments are chains of terms evaluated right to
+ * left, and constant tails of those chains get folded at load time
+ */
+struct HUDTerm {
+	int ( *func )( const void *parameter ); // NULL for constants
+	const void *parameter;
+	float value;
+	opFunc_t opFunc;
+};
+
+struct HUDArg {
+	char *string;
+	bool numeric;
+	u32 first_term;
+	u32 num_terms;
+};
+
+using HUDArgs = Span< const HUDArg >;
+
+struct HUDInstruction {
+	bool ( *func )( HUDArgs args );
+	u32 first_arg;
+	u32 num_args;
+	u32 skip_to; // jump here when func returns false
+};
+
+static NonRAIIDynamicArray< HUDInstruction > hud_program;
+static NonRAIIDynamicArray< HUDArg > hud_args;
+static NonRAIIDynamicArray< HUDTerm > hud_terms;
+
+static u64 hud_last_execute_time;
+
 struct cg_layoutnode_t {
-	bool ( *func )( cg_layoutnode_t *argumentnode );
+	bool ( *func )( HUDArgs args );
 	int type;
 	char *string;
 	int num_args;
@@ -71,8 +105,6 @@ struct cg_layoutnode_t {
 	cg_layoutnode_t *ifthread;
 };
 
-static cg_layoutnode_t * hud_root;
-
 struct constant_numeric_t {
 	const char *name;
 	int value;
@@ -699,7 +731,7 @@ static void CG_DrawAwards( int x, int y, Alignment alignment, float font_size, V
 	}
 }
 
-static bool CG_LFuncDrawCallvote( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncDrawCallvote( HUDArgs argumentnode ) {
 	const char * vote = cgs.configStrings[ CS_CALLVOTE ];
 	if( strlen( vote ) == 0 )
 		return true;
@@ -901,8 +933,8 @@ static opFunc_t CG_OperatorFuncForArgument( Span< const char > token ) {
 
 //=============================================================================
 
-static const char *CG_GetStringArg( cg_layoutnode_t **argumentsnode );
-static float CG_GetNumericArg( cg_layoutnode_t **argumentsnode );
+static const char *CG_GetStringArg( HUDArgs *args );
+static float CG_GetNumericArg( HUDArgs *args );
 
 //=============================================================================
 
@@ -1029,7 +1061,7 @@ static void CG_DrawWeaponIcons( int x, int y, int offx, int offy, int iw, int ih
 	}
 }
 
-static bool CG_LFuncDrawPicByName( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncDrawPicByName( HUDArgs argumentnode ) {
 	int x = CG_HorizontalAlignForWidth( layout_cursor_x, layout_cursor_alignment, layout_cursor_width );
 	int y = CG_VerticalAlignForHeight( layout_cursor_y, layout_cursor_alignment, layout_cursor_height );
 	Draw2DBox( x, y, layout_cursor_width, layout_cursor_height, FindMaterial( CG_GetStringArg( &argumentnode ) ), layout_cursor_color );
@@ -1044,7 +1076,7 @@ static float ScaleY( float y ) {
 	return y * frame_static.viewport_height / 600.0f;
 }
 
-static bool CG_LFuncCursor( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncCursor( HUDArgs argumentnode ) {
 	float x = ScaleX( CG_GetNumericArg( &argumentnode ) );
 	float y = ScaleY( CG_GetNumericArg( &argumentnode ) );
 
@@ -1053,7 +1085,7 @@ static bool CG_LFuncCursor( cg_layoutnode_t *argumentnode ) {
 	return true;
 }
 
-static bool CG_LFuncMoveCursor( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncMoveCursor( HUDArgs argumentnode ) {
 	float x = ScaleX( CG_GetNumericArg( &argumentnode ) );
 	float y = ScaleY( CG_GetNumericArg( &argumentnode ) );
 
@@ -1062,7 +1094,7 @@ static bool CG_LFuncMoveCursor( cg_layoutnode_t *argumentnode ) {
 	return true;
 }
 
-static bool CG_LFuncSize( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncSize( HUDArgs argumentnode ) {
 	float x = ScaleX( CG_GetNumericArg( &argumentnode ) );
 	float y = ScaleY( CG_GetNumericArg( &argumentnode ) );
 
@@ -1071,36 +1103,36 @@ static bool CG_LFuncSize( cg_layoutnode_t *argumentnode ) {
 	return true;
 }
 
-static bool CG_LFuncColor( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncColor( HUDArgs argumentnode ) {
 	for( int i = 0; i < 4; i++ ) {
 		layout_cursor_color[ i ] = Clamp01( CG_GetNumericArg( &argumentnode ) );
 	}
 	return true;
 }
 
-static bool CG_LFuncColorsRGB( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncColorsRGB( HUDArgs argumentnode ) {
 	for( int i = 0; i < 4; i++ ) {
 		layout_cursor_color[ i ] = sRGBToLinear( Clamp01( CG_GetNumericArg( &argumentnode ) ) );
 	}
 	return true;
 }
 
-static bool CG_LFuncColorToTeamColor( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncColorToTeamColor( HUDArgs argumentnode ) {
 	layout_cursor_color = CG_TeamColorVec4( CG_GetNumericArg( &argumentnode ) );
 	return true;
 }
 
-static bool CG_LFuncAttentionGettingColor( cg_layoutnode_t * argumentnode ) {
+static bool CG_LFuncAttentionGettingColor( HUDArgs argumentnode ) {
 	layout_cursor_color = AttentionGettingColor();
 	return true;
 }
 
-static bool CG_LFuncColorAlpha( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncColorAlpha( HUDArgs argumentnode ) {
 	layout_cursor_color.w = CG_GetNumericArg( &argumentnode );
 	return true;
 }
 
-static bool CG_LFuncAlignment( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncAlignment( HUDArgs argumentnode ) {
 	const char * x = CG_GetStringArg( &argumentnode );
 	const char * y = CG_GetStringArg( &argumentnode );
 
@@ -1135,8 +1167,8 @@ static bool CG_LFuncAlignment( cg_layoutnode_t *argumentnode ) {
 	return true;
 }
 
-static bool CG_LFuncFontSize( cg_layoutnode_t *argumentnode ) {
-	cg_layoutnode_t *charnode = argumentnode;
+static bool CG_LFuncFontSize( HUDArgs argumentnode ) {
+	HUDArgs charnode = argumentnode;
 	const char * fontsize = CG_GetStringArg( &charnode );
 
 	if( !Q_stricmp( fontsize, "tiny" ) ) {
@@ -1158,7 +1190,7 @@ static bool CG_LFuncFontSize( cg_layoutnode_t *argumentnode ) {
 	return true;
 }
 
-static bool CG_LFuncFontStyle( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncFontStyle( HUDArgs argumentnode ) {
 	const char * fontstyle = CG_GetStringArg( &argumentnode );
 
 	if( !Q_stricmp( fontstyle, "normal" ) ) {
@@ -1181,13 +1213,13 @@ static bool CG_LFuncFontStyle( cg_layoutnode_t *argumentnode ) {
 	return true;
 }
 
-static bool CG_LFuncFontBorder( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncFontBorder( HUDArgs argumentnode ) {
 	const char * border = CG_GetStringArg( &argumentnode );
 	layout_cursor_font_border = Q_stricmp( border, "on" ) == 0;
 	return true;
 }
 
-static bool CG_LFuncDrawObituaries( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncDrawObituaries( HUDArgs argumentnode ) {
 	int internal_align = (int)CG_GetNumericArg( &argumentnode );
 	int icon_size = (int)CG_GetNumericArg( &argumentnode );
 
@@ -1196,27 +1228,27 @@ static bool CG_LFuncDrawObituaries( cg_layoutnode_t *argumentnode ) {
 	return true;
 }
 
-static bool CG_LFuncDrawAwards( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncDrawAwards( HUDArgs argumentnode ) {
 	CG_DrawAwards( layout_cursor_x, layout_cursor_y, layout_cursor_alignment, layout_cursor_font_size, layout_cursor_color, layout_cursor_font_border );
 	return true;
 }
 
-static bool CG_LFuncDrawClock( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncDrawClock( HUDArgs argumentnode ) {
 	CG_DrawClock( layout_cursor_x, layout_cursor_y, layout_cursor_alignment, GetHUDFont(), layout_cursor_font_size, layout_cursor_color, layout_cursor_font_border );
 	return true;
 }
 
-static bool CG_LFuncDrawDamageNumbers( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncDrawDamageNumbers( HUDArgs argumentnode ) {
 	CG_DrawDamageNumbers();
 	return true;
 }
 
-static bool CG_LFuncDrawBombIndicators( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncDrawBombIndicators( HUDArgs argumentnode ) {
 	CG_DrawBombHUD();
 	return true;
 }
 
-static bool CG_LFuncDrawPlayerIcons( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncDrawPlayerIcons( HUDArgs argumentnode ) {
 	int team = int( CG_GetNumericArg( &argumentnode ) );
 	int alive = int( CG_GetNumericArg( &argumentnode ) );
 	int total = int( CG_GetNumericArg( &argumentnode ) );
@@ -1245,12 +1277,12 @@ static bool CG_LFuncDrawPlayerIcons( cg_layoutnode_t *argumentnode ) {
 	return true;
 }
 
-static bool CG_LFuncDrawPointed( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncDrawPointed( HUDArgs argumentnode ) {
 	CG_DrawPlayerNames( GetHUDFont(), layout_cursor_font_size, layout_cursor_color, layout_cursor_font_border );
 	return true;
 }
 
-static bool CG_LFuncDrawString( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncDrawString( HUDArgs argumentnode ) {
 	const char *string = CG_GetStringArg( &argumentnode );
 
 	if( !string || !string[0] ) {
@@ -1262,7 +1294,7 @@ static bool CG_LFuncDrawString( cg_layoutnode_t *argumentnode ) {
 	return true;
 }
 
-static bool CG_LFuncDrawBindString( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncDrawBindString( HUDArgs argumentnode ) {
 	const char * fmt = CG_GetStringArg( &argumentnode );
 	const char * command = CG_GetStringArg( &argumentnode );
 
@@ -1279,7 +1311,7 @@ static bool CG_LFuncDrawBindString( cg_layoutnode_t *argumentnode ) {
 	return true;
 }
 
-static bool CG_LFuncDrawPlayerName( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncDrawPlayerName( HUDArgs argumentnode ) {
 	int index = (int)CG_GetNumericArg( &argumentnode ) - 1;
 
 	if( index >= 0 && index < client_gs.maxclients && cgs.clientInfo[index].name[0] ) {
@@ -1290,13 +1322,13 @@ static bool CG_LFuncDrawPlayerName( cg_layoutnode_t *argumentnode ) {
 	return false;
 }
 
-static bool CG_LFuncDrawNumeric( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncDrawNumeric( HUDArgs argumentnode ) {
 	int value = CG_GetNumericArg( &argumentnode );
 	DrawText( GetHUDFont(), layout_cursor_font_size, va( "%i", value ), layout_cursor_alignment, layout_cursor_x, layout_cursor_y, layout_cursor_color, layout_cursor_font_border );
 	return true;
 }
 
-static bool CG_LFuncDrawWeaponIcons( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncDrawWeaponIcons( HUDArgs argumentnode ) {
 	int offx = CG_GetNumericArg( &argumentnode ) * frame_static.viewport_width / 800;
 	int offy = CG_GetNumericArg( &argumentnode ) * frame_static.viewport_height / 600;
 	int w = CG_GetNumericArg( &argumentnode ) * frame_static.viewport_width / 800;
@@ -1308,31 +1340,31 @@ static bool CG_LFuncDrawWeaponIcons( cg_layoutnode_t *argumentnode ) {
 	return true;
 }
 
-static bool CG_LFuncDrawCrossHair( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncDrawCrossHair( HUDArgs argumentnode ) {
 	CG_DrawCrosshair();
 	return true;
 }
 
-static bool CG_LFuncDrawNet( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncDrawNet( HUDArgs argumentnode ) {
 	CG_DrawNet( layout_cursor_x, layout_cursor_y, layout_cursor_width, layout_cursor_height, layout_cursor_alignment, layout_cursor_color );
 	return true;
 }
 
-static bool CG_LFuncIf( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncIf( HUDArgs argumentnode ) {
 	return (int)CG_GetNumericArg( &argumentnode ) != 0;
 }
 
-static bool CG_LFuncIfNot( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncIfNot( HUDArgs argumentnode ) {
 	return (int)CG_GetNumericArg( &argumentnode ) == 0;
 }
 
-static bool CG_LFuncEndIf( cg_layoutnode_t *argumentnode ) {
+static bool CG_LFuncEndIf( HUDArgs argumentnode ) {
 	return true;
 }
 
 struct cg_layoutcommand_t {
 	const char *name;
-	bool ( *func )( cg_layoutnode_t *argumentnode );
+	bool ( *func )( HUDArgs argumentnode );
 	int numparms;
 	const char *help;
 };
@@ -1559,43 +1591,37 @@ static const cg_layoutcommand_t cg_LayoutCommands[] = {
 
 //=============================================================================
 
-static const char *CG_GetStringArg( cg_layoutnode_t **argumentsnode ) {
-	cg_layoutnode_t *anode = *argumentsnode;
-
-	if( anode == NULL ) {
+static const char *CG_GetStringArg( HUDArgs *args ) {
+	if( args->n == 0 ) {
 		return "";
 	}
 
-	*argumentsnode = anode->next;
-	return anode->string;
+	const HUDArg & arg = ( *args )[ 0 ];
+	*args = HUDArgs( args->ptr + 1, args->n - 1 );
+	return arg.string;
 }
 
-/*
-* CG_GetNumericArg
-* can use recursion for mathematical operations
-*/
-static float CG_GetNumericArg( cg_layoutnode_t **argumentsnode ) {
-	cg_layoutnode_t *anode = *argumentsnode;
+static float CG_EvaluateTerm( const HUDTerm & term ) {
+	return term.func == NULL ? term.value : term.func( term.parameter );
+}
 
-	if( anode == NULL ) {
+static float CG_GetNumericArg( HUDArgs *args ) {
+	if( args->n == 0 ) {
 		return 0.0f;
 	}
 
-	if( anode->type != LNODE_NUMERIC && anode->type != LNODE_REFERENCE_NUMERIC ) {
-		Com_Printf( "WARNING: 'CG_LayoutGetNumericArg': arg %s is not numeric\n", anode->string );
-	}
+	const HUDArg & arg = ( *args )[ 0 ];
+	*args = HUDArgs( args->ptr + 1, args->n - 1 );
 
-	*argumentsnode = anode->next;
-	float value;
-	if( anode->type == LNODE_REFERENCE_NUMERIC ) {
-		value = cg_numeric_references[anode->idx].func( cg_numeric_references[anode->idx].parameter );
-	} else {
-		value = anode->value;
+	if( !arg.numeric ) {
+		Com_Printf( "WARNING: 'CG_LayoutGetNumericArg': arg %s is not numeric\n", arg.string );
 	}
 
-	// recurse if there are operators
-	if( anode->opFunc != NULL ) {
-		value = anode->opFunc( value, CG_GetNumericArg( argumentsnode ) );
+	// operators are right associative, so a - b - c means a - ( b - c )
+	const HUDTerm * terms = &hud_terms[ arg.first_term ];
+	float value = CG_EvaluateTerm( terms[ arg.num_terms - 1 ] );
+	for( u32 i = arg.num_terms - 1; i > 0; i-- ) {
+		value = terms[ i - 1 ].opFunc( CG_EvaluateTerm( terms[ i - 1 ] ), value );
 	}
 
 	return value;
@@ -1820,26 +1846,120 @@ static cg_layoutnode_t *CG_RecurseParseLayoutScript( Span< const char > * cursor
 	return nodes.head;
 }
 
+static bool CG_IsConstantArg( const HUDArg & arg ) {
+	return arg.num_terms == 1 && hud_terms[ arg.first_term ].func == NULL;
+}
+
+static void CG_FreeHUDArgs( u32 first_arg ) {
+	if( first_arg == hud_args.size() )
+		return;
+
+	for( u32 i = first_arg; i < hud_args.size(); i++ ) {
+		FREE( sys_allocator, hud_args[ i ].string );
+	}
+
+	hud_terms.resize( hud_args[ first_arg ].first_term );
+	hud_args.resize( first_arg );
+}
+
 /*
-* CG_RecurseExecuteLayoutThread
-* Execution works like this: First node (on backwards) is expected to be the command, followed by arguments nodes.
-* we keep a pointer to the command and run the tree counting arguments until we reach the next command,
-* then we call the command function sending the pointer to first argument and the pointer to the command.
-* At return we advance one node (we stopped at last argument node) so it starts again from the next command (if any).
-*
-* When finding an "if" command with a subtree, we execute the "if" command. In the case it
-* returns any value, we recurse execute the subtree
+* CG_CompileLayoutArg
+* an argument is a node plus every node chained to it with an operator
 */
-static void CG_RecurseExecuteLayoutThread( cg_layoutnode_t * node ) {
-	if( node == NULL )
-		return;
+static void CG_CompileLayoutArg( cg_layoutnode_t ** cursor ) {
+	cg_layoutnode_t * node = *cursor;
+
+	HUDArg arg;
+	arg.string = CopyString( sys_allocator, node->string );
+	arg.numeric = node->type == LNODE_NUMERIC || node->type == LNODE_REFERENCE_NUMERIC;
+	arg.first_term = hud_terms.size();
+
+	while( true ) {
+		HUDTerm term = { };
+		if( node->type == LNODE_REFERENCE_NUMERIC ) {
+			term.func = cg_numeric_references[ node->idx ].func;
+			term.parameter = cg_numeric_references[ node->idx ].parameter;
+		}
+		else {
+			term.value = node->value;
+		}
+		term.opFunc = node->opFunc;
+		hud_terms.add( term );
 
-	// args->next to skip the dummy node
-	if( node->type != LNODE_DUMMY && node->func( node->args->next ) ) {
-		CG_RecurseExecuteLayoutThread( node->ifthread );
+		node = node->next;
+		if( term.opFunc == NULL )
+			break;
+
+		// trailing operator, the missing operand evaluates to 0
+		if( node == NULL ) {
+			hud_terms.add( HUDTerm() );
+			break;
+		}
+	}
+
+	// fold the constant tail of the chain
+	while( hud_terms.size() - arg.first_term >= 2 ) {
+		HUDTerm & a = hud_terms[ hud_terms.size() - 2 ];
+		const HUDTerm & b = hud_terms.top();
+		if( a.func != NULL || b.func != NULL )
+			break;
+
+		a.value = a.opFunc( a.value, b.value );
+		a.opFunc = NULL;
+		hud_terms.resize( hud_terms.size() - 1 );
+	}
+
+	arg.num_terms = hud_terms.size() - arg.first_term;
+	hud_args.add( arg );
+
+	*cursor = node;
+}
+
+static void CG_CompileLayoutThread( cg_layoutnode_t * node ) {
+	for( ; node != NULL; node = node->next ) {
+		if( node->type == LNODE_DUMMY || node->func == CG_LFuncEndIf )
+			continue;
+
+		u32 first_arg = hud_args.size();
+
+		// args->next to skip the dummy node
+		cg_layoutnode_t * arg = node->args->next;
+		while( arg != NULL ) {
+			CG_CompileLayoutArg( &arg );
+		}
+
+		u32 num_args = hud_args.size() - first_arg;
+
+		// resolve constant conditions now so the branch costs nothing at runtime
+		bool conditional = node->func == CG_LFuncIf || node->func == CG_LFuncIfNot;
+		if( conditional && num_args == 1 && CG_IsConstantArg( hud_args[ first_arg ] ) ) {
+			bool nonzero = int( hud_terms[ hud_args[ first_arg ].first_term ].value ) != 0;
+			CG_FreeHUDArgs( first_arg );
+
+			if( nonzero == ( node->func == CG_LFuncIf ) ) {
+				CG_CompileLayoutThread( node->ifthread );
+			}
+			continue;
+		}
+
+		HUDInstruction instruction;
+		instruction.func = node->func;
+		instruction.first_arg = first_arg;
+		instruction.num_args = num_args;
+		size_t idx = hud_program.add( instruction );
+
+		CG_CompileLayoutThread( node->ifthread );
+		hud_program[ idx ].skip_to = hud_program.size();
 	}
+}
 
-	CG_RecurseExecuteLayoutThread( node->next );
+static void CG_ExecuteHUDProgram() {
+	size_t pc = 0;
+	while( pc < hud_program.size() ) {
+		const HUDInstruction & instruction = hud_program[ pc ];
+		HUDArgs args( hud_args.ptr() + instruction.first_arg, instruction.num_args );
+		pc = instruction.func( args ) ? pc + 1 : instruction.skip_to;
+	}
 }
 
 static bool LoadHUDFile( const char * path, DynamicString & script ) {
@@ -1887,6 +2007,10 @@ void CG_InitHUD() {
 	TempAllocator temp = cls.frame_arena.temp();
 	const char * path = "huds/default.hud";
 
+	hud_program.init( sys_allocator );
+	hud_args.init( sys_allocator );
+	hud_terms.init( sys_allocator );
+
 	DynamicString script( &temp );
 	if( !LoadHUDFile( path, script ) ) {
 		Com_Printf( "HUD: failed to load %s file\n", path );
@@ -1894,14 +2018,45 @@ void CG_InitHUD() {
 	}
 
 	Span< const char > cursor = script.span();
-	hud_root = CG_RecurseParseLayoutScript( &cursor, 0 );
+	cg_layoutnode_t * root = CG_RecurseParseLayoutScript( &cursor, 0 );
+	CG_CompileLayoutThread( root );
+	CG_RecurseFreeLayoutThread( root );
 
 	layout_cursor_font_style = FontStyle_Normal;
 	layout_cursor_font_size = cgs.textSizeSmall;
 }
 
 void CG_ShutdownHUD() {
-	CG_RecurseFreeLayoutThread( hud_root );
+	CG_FreeHUDArgs( 0 );
+
+	hud_program.shutdown();
+	hud_args.shutdown();
+	hud_terms.shutdown();
+}
+
+void CG_HUDBenchmark_f() {
+	constexpr int iterations = 10000;
+
+	volatile float sink = 0.0f;
+
+	u64 start = Sys_Microseconds();
+	for( int i = 0; i < iterations; i++ ) {
+		for( const HUDInstruction & instruction : hud_program ) {
+			HUDArgs args( hud_args.ptr() + instruction.first_arg, instruction.num_args );
+			while( args.n > 0 ) {
+				if( args[ 0 ].numeric ) {
+					sink = sink + CG_GetNumericArg( &args );
+				}
+				else {
+					CG_GetStringArg( &args );
+				}
+			}
+		}
+	}
+	u64 dt = Sys_Microseconds() - start;
+
+	Com_Printf( "HUD: %zu instructions, %zu args, %zu terms\n", hud_program.size(), hud_args.size(), hud_terms.size() );
+	Com_Printf( "%.3fus per frame evaluating arguments, last frame took %uus to draw the HUD\n", double( dt ) / iterations, u32( hud_last_execute_time ) );
 }
 
 void CG_DrawHUD() {
@@ -1919,5 +2074,8 @@ void CG_DrawHUD() {
 	}
 
 	ZoneScoped;
-	CG_RecurseExecuteLayoutThread( hud_root );
+
+	u64 start = Sys_Microseconds();
+	CG_ExecuteHUDProgram();
+	hud_last_execute_time = Sys_Microseconds() - start;
 }
@@ -246,9 +246,8 @@ struct cg_state_t {
 	int predictedGroundEntity;
 
 	// prediction optimization (don't run all ucmds in not needed)
-	int64_t predictFrom;
-	SyncEntityState predictFromEntityState;
-	SyncPlayerState predictFromPlayerState;
+	int64_t predictFrom;                // newest ucmd with a cached prediction
+	int predictedUsercmds;              // how many ucmds the last prediction had to run
 
 	float lerpfrac;                     // between oldframe and frame
 	float xerpTime;
@@ -346,12 +345,16 @@ void CG_PlayerSound( int entnum, int entchannel, PlayerSound ps );
 // cg_predict.c
 //
 extern cvar_t *cg_showMiss;
+extern cvar_t *cg_predictCache;
 
 void CG_PredictedEvent( int entNum, int ev, u64 parm );
 void CG_PredictedFireWeapon( int entNum, u64 parm );
 void CG_PredictMovement();
 void CG_CheckPredictionError();
+void CG_CheckPredictionCache();
+void CG_PredictionBenchmark_f();
 void CG_BuildSolidList();
+void CG_PlotTraceStats();
 void CG_Trace( trace_t *t, Vec3 start, Vec3 mins, Vec3 maxs, Vec3 end, int ignore, int contentmask );
 int CG_PointContents( Vec3 point );
 void CG_Predict_TouchTriggers( pmove_t *pm, Vec3 previous_origin );
@@ -397,6 +400,7 @@ void CG_ShutdownHUD();
 void CG_SC_ResetObituaries();
 void CG_SC_Obituary();
 void CG_DrawHUD();
+void CG_HUDBenchmark_f();
 void CG_ClearAwards();
 
 //
@@ -425,6 +429,8 @@ extern cvar_t *cg_chat;
 
 extern cvar_t *cg_particleDebug;
 
+extern cvar_t *cg_threadedAnimation;
+
 #define CG_Malloc( size ) _Mem_AllocExt( cg_mempool, size, 16, 1, 0, 0, __FILE__, __LINE__ );
 #define CG_Free( data ) Mem_Free( data )
 
@@ -28,6 +28,7 @@ mempool_t *cg_mempool;
 centity_t cg_entities[MAX_EDICTS];
 
 cvar_t *cg_showMiss;
+cvar_t *cg_predictCache;
 
 cvar_t *cg_thirdPerson;
 cvar_t *cg_thirdPersonAngle;
@@ -46,6 +47,8 @@ cvar_t *cg_showClamp;
 
 cvar_t *cg_particleDebug;
 
+cvar_t *cg_threadedAnimation;
+
 void CG_LocalPrint( const char *format, ... ) {
 	va_list argptr;
 	char msg[ 1024 ];
@@ -122,6 +125,7 @@ static void CG_RegisterClients() {
 
 static void CG_RegisterVariables() {
 	cg_showMiss =       Cvar_Get( "cg_showMiss", "0", 0 );
+	cg_predictCache =   Cvar_Get( "cg_predictCache", "1", 0 );
 
 	cg_showHotkeys = Cvar_Get( "cg_showHotkeys", "1", CVAR_ARCHIVE );
 	cg_colorBlind  = Cvar_Get( "cg_colorBlind", "0", CVAR_ARCHIVE );
@@ -142,6 +146,8 @@ static void CG_RegisterVariables() {
 
 	cg_particleDebug =  Cvar_Get( "cg_particleDebug", "0", CVAR_DEVELOPER );
 
+	cg_threadedAnimation = Cvar_Get( "cg_threadedAnimation", "1", CVAR_ARCHIVE );
+
 	Cvar_Get( "cg_loadout", "", CVAR_ARCHIVE | CVAR_USERINFO );
 }
 
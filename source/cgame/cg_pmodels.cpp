@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "qcommon/hash.h"
 #include "qcommon/hashtable.h"
 #include "client/assets.h"
+#include "qcommon/threadpool.h"
 #include "client/renderer/renderer.h"
 #include "client/renderer/model.h"
 
@@ -744,40 +745,40 @@ static Mat4 TransformTag( const Model * model, const Mat4 & transform, const Mat
 	return transform * model->transform * pose.node_transforms[ tag.node_idx ] * tag.transform;
 }
 
-void CG_DrawPlayer( centity_t *cent ) {
-	pmodel_t * pmodel = &cg_entPModels[ cent->current.number ];
-	const PlayerModelMetadata * meta = GetPlayerModelMetadata( cent->current.number );
-	if( meta == NULL )
-		return;
-
-	// if viewer model, and casting shadows, offset the entity to predicted player position
-	// for view and shadow accuracy
-
-	if( ISVIEWERENTITY( cent->current.number ) ) {
-		Vec3 origin;
-
-		if( cg.view.playerPrediction ) {
-			float backlerp = 1.0f - cg.lerpfrac;
-
-			origin = cg.predictedPlayerState.pmove.origin - backlerp * cg.predictionError;
+struct PlayerPoseJob {
+	centity_t * cent;
+	const PlayerModelMetadata * meta;
+	Span< TRS > lower;
+	Span< TRS > upper;
+	MatrixPalettes pose;
+};
 
-			CG_ViewSmoothPredictedSteps( &origin );
-		}
-		else {
-			origin = cent->interpolated.origin;
-		}
+static PlayerPoseJob AllocPlayerPoseJob( Allocator * a, centity_t * cent, const PlayerModelMetadata * meta ) {
+	PlayerPoseJob job;
+	job.cent = cent;
+	job.meta = meta;
+	job.lower = ALLOC_SPAN( a, TRS, meta->model->num_nodes );
+	job.upper = ALLOC_SPAN( a, TRS, meta->model->num_nodes );
+	job.pose = AllocMatrixPalettes( a, meta->model );
+	return job;
+}
 
-		cent->interpolated.origin = origin;
-		cent->interpolated.origin2 = origin;
-	}
+// touches nothing but the job's own entity, so it's safe to run on the thread pool
+static void ComputePlayerPose( TempAllocator * temp, void * data ) {
+	ZoneScoped;
 
-	TempAllocator temp = cls.frame_arena.temp();
+	PlayerPoseJob * job = ( PlayerPoseJob * ) data;
+	centity_t * cent = job->cent;
+	const PlayerModelMetadata * meta = job->meta;
+	pmodel_t * pmodel = &cg_entPModels[ cent->current.number ];
 
 	float lower_time, upper_time;
 	CG_GetAnimationTimes( meta, pmodel, cl.serverTime, &lower_time, &upper_time );
-	Span< TRS > lower = SampleAnimation( &temp, meta->model, lower_time );
-	Span< TRS > upper = SampleAnimation( &temp, meta->model, upper_time );
-	MergeLowerUpperPoses( lower, upper, meta->model, meta->upper_root_node );
+	SampleAnimation( job->lower, meta->model, lower_time );
+	SampleAnimation( job->upper, meta->model, upper_time );
+	MergeLowerUpperPoses( job->lower, job->upper, meta->model, meta->upper_root_node );
+
+	Span< TRS > lower = job->lower;
 
 	// add skeleton effects (pose is unmounted yet)
 	bool corpse = cent->current.type == ET_CORPSE;
@@ -813,7 +814,115 @@ void CG_DrawPlayer( centity_t *cent ) {
 		}
 	}
 
-	MatrixPalettes pose = ComputeMatrixPalettes( &temp, meta->model, lower );
+	ComputeMatrixPalettes( &job->pose, meta->model, lower );
+}
+
+void CG_AnimatePlayers( Allocator * a ) {
+	ZoneScoped;
+
+	PlayerPoseJob * jobs = ALLOC_MANY( a, PlayerPoseJob, cg.frame.numEntities );
+	size_t num_jobs = 0;
+
+	for( int pnum = 0; pnum < cg.frame.numEntities; pnum++ ) {
+		SyncEntityState * state = &cg.frame.parsedEntities[ pnum & ( MAX_PARSE_ENTITIES - 1 ) ];
+		centity_t * cent = &cg_entities[ state->number ];
+
+		if( cent->type != ET_PLAYER && cent->type != ET_CORPSE )
+			continue;
+		if( cent->current.team == TEAM_SPECTATOR )
+			continue;
+
+		const PlayerModelMetadata * meta = GetPlayerModelMetadata( cent->current.number );
+		if( meta == NULL )
+			continue;
+
+		jobs[ num_jobs ] = AllocPlayerPoseJob( a, cent, meta );
+		num_jobs++;
+	}
+
+	if( cg_threadedAnimation->integer != 0 && num_jobs > 1 ) {
+		ParallelFor( Span< PlayerPoseJob >( jobs, num_jobs ), ComputePlayerPose );
+	}
+	else {
+		for( size_t i = 0; i < num_jobs; i++ ) {
+			TempAllocator temp = cls.frame_arena.temp();
+			ComputePlayerPose( &temp, &jobs[ i ] );
+		}
+	}
+
+	for( size_t i = 0; i < num_jobs; i++ ) {
+		pmodel_t * pmodel = &cg_entPModels[ jobs[ i ].cent->current.number ];
+		pmodel->pose = jobs[ i ].pose;
+		pmodel->pose_frame = cg.frameCount;
+	}
+}
+
+void CG_AnimationBenchmark_f() {
+	constexpr int iterations = 10000;
+
+	for( u32 i = 0; i < num_player_models; i++ ) {
+		const PlayerModelMetadata * meta = &player_model_metadatas[ i ];
+		const Model * model = meta->model;
+
+		TempAllocator temp = cls.frame_arena.temp();
+		Span< TRS > lower = ALLOC_SPAN( &temp, TRS, model->num_nodes );
+		Span< TRS > upper = ALLOC_SPAN( &temp, TRS, model->num_nodes );
+		MatrixPalettes pose = AllocMatrixPalettes( &temp, model );
+
+		const PlayerModelMetadata::AnimationClip & lower_clip = meta->clips[ LEGS_RUN_FORWARD ];
+		const PlayerModelMetadata::AnimationClip & upper_clip = meta->clips[ TORSO_SHOOT_LIGHTWEAPON ];
+
+		u64 start = Sys_Microseconds();
+		for( int j = 0; j < iterations; j++ ) {
+			float t = float( j ) / float( iterations );
+			SampleAnimation( lower, model, lower_clip.start_time + t * lower_clip.duration );
+			SampleAnimation( upper, model, upper_clip.start_time + t * upper_clip.duration );
+			MergeLowerUpperPoses( lower, upper, model, meta->upper_root_node );
+			ComputeMatrixPalettes( &pose, model, lower );
+		}
+		u64 dt = Sys_Microseconds() - start;
+
+		Com_Printf( "model %u: %u nodes, %u joints, %.3fus per pose\n", i, model->num_nodes, model->num_joints, double( dt ) / iterations );
+	}
+}
+
+void CG_DrawPlayer( centity_t *cent ) {
+	pmodel_t * pmodel = &cg_entPModels[ cent->current.number ];
+	const PlayerModelMetadata * meta = GetPlayerModelMetadata( cent->current.number );
+	if( meta == NULL )
+		return;
+
+	// if viewer model, and casting shadows, offset the entity to predicted player position
+	// for view and shadow accuracy
+
+	if( ISVIEWERENTITY( cent->current.number ) ) {
+		Vec3 origin;
+
+		if( cg.view.playerPrediction ) {
+			float backlerp = 1.0f - cg.lerpfrac;
+
+			origin = cg.predictedPlayerState.pmove.origin - backlerp * cg.predictionError;
+
+			CG_ViewSmoothPredictedSteps( &origin );
+		}
+		else {
+			origin = cent->interpolated.origin;
+		}
+
+		cent->interpolated.origin = origin;
+		cent->interpolated.origin2 = origin;
+	}
+
+	TempAllocator temp = cls.frame_arena.temp();
+
+	MatrixPalettes pose = pmodel->pose;
+	if( pmodel->pose_frame != cg.frameCount ) {
+		PlayerPoseJob job = AllocPlayerPoseJob( &temp, cent, meta );
+		ComputePlayerPose( &temp, &job );
+		pose = job.pose;
+	}
+
+	bool corpse = cent->current.type == ET_CORPSE;
 
 	Mat4 transform = FromAxisAndOrigin( cent->interpolated.axis, cent->interpolated.origin );
 
@@ -190,6 +190,10 @@ struct pmodel_t {
 
 	// effects
 	orientation_t projectionSource;     // for projectiles
+
+	// computed by CG_AnimatePlayers, only valid during the frame it was computed
+	MatrixPalettes pose;
+	int pose_frame;
 };
 
 extern pmodel_t cg_entPModels[MAX_EDICTS];      //a pmodel handle for each cg_entity
@@ -211,6 +215,8 @@ const PlayerModelMetadata * GetPlayerModelMetadata( int ent_num );
 
 void CG_ResetPModels();
 
+void CG_AnimatePlayers( Allocator * a );
+void CG_AnimationBenchmark_f();
 void CG_DrawPlayer( centity_t * cent );
 bool CG_PModel_GetProjectionSource( int entnum, orientation_t *tag_result );
 void CG_UpdatePlayerModelEnt( centity_t *cent );
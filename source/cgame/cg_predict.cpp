@@ -28,6 +28,40 @@ static int cg_numTriggers;
 static SyncEntityState *cg_triggersList[MAX_PARSE_ENTITIES];
 static bool cg_triggersListTriggered[MAX_PARSE_ENTITIES];
 
+/*
+ * solids and triggers get binned into a coarse 2D grid over the snapshot when
+ * it arrives, so traces only test the entities near them. clip indices below
+ * cg_numSolids are solids, the rest are triggers
+ */
+constexpr int CLIP_GRID_SIZE = 32;
+constexpr float CLIP_GRID_MIN_CELL_SIZE = 64.0f;
+constexpr int CLIP_GRID_MAX_ENT_CELLS = 16; // entities covering more cells than this get tested by every query
+
+struct ClipGrid {
+	Vec2 mins;
+	Vec2 inv_cell_size;
+
+	u16 cell_first[CLIP_GRID_SIZE * CLIP_GRID_SIZE + 1];
+	u16 cell_ents[MAX_PARSE_ENTITIES * CLIP_GRID_MAX_ENT_CELLS];
+
+	u16 large_ents[MAX_PARSE_ENTITIES];
+	int num_large_ents;
+};
+
+static ClipGrid cg_clipGrid;
+static MinMax3 cg_clipBounds[MAX_PARSE_ENTITIES];
+
+static u32 cg_clipQuery;
+static u32 cg_clipQueryMarks[MAX_PARSE_ENTITIES];
+
+struct TraceFrameStats {
+	u32 traces;
+	u32 entity_tests;
+	u64 time;
+};
+
+static TraceFrameStats trace_frame_stats;
+
 static bool ucmdReady = false;
 
 /*
@@ -96,6 +130,185 @@ void CG_CheckPredictionError() {
 	}
 }
 
+static MinMax3 Union( MinMax3 a, MinMax3 b ) {
+	return Extend( Extend( a, b.mins ), b.maxs );
+}
+
+static bool BoundsOverlap( MinMax3 a, MinMax3 b ) {
+	return a.mins.x <= b.maxs.x && a.maxs.x >= b.mins.x
+		&& a.mins.y <= b.maxs.y && a.maxs.y >= b.mins.y
+		&& a.mins.z <= b.maxs.z && a.maxs.z >= b.mins.z;
+}
+
+/*
+* CG_ClipEntityBounds
+* covers everywhere CG_Trace, CG_PointContents and the trigger checks might
+* put the entity this snapshot
+*/
+static MinMax3 CG_ClipEntityBounds( const SyncEntityState * ent ) {
+	const cmodel_t * cmodel = CM_TryFindCModel( CM_Client, ent->model );
+	if( cmodel == NULL ) {
+		return MinMax3( ent->origin + ent->bounds.mins, ent->origin + ent->bounds.maxs );
+	}
+
+	Vec3 mins, maxs;
+	CM_InlineModelBounds( cl.cms, cmodel, &mins, &maxs );
+
+	if( !cmodel->builtin && ent->angles != Vec3( 0.0f ) ) {
+		Vec3 corner = Vec3( Max2( Abs( mins.x ), Abs( maxs.x ) ), Max2( Abs( mins.y ), Abs( maxs.y ) ), Max2( Abs( mins.z ), Abs( maxs.z ) ) );
+		float radius = Length( corner );
+		mins = Vec3( -radius );
+		maxs = Vec3( radius );
+	}
+
+	MinMax3 bounds( ent->origin + mins, ent->origin + maxs );
+	if( ent->linearMovement ) {
+		Vec3 origin;
+		GS_LinearMovement( ent, cg.frame.serverTime, &origin );
+		bounds = Union( bounds, MinMax3( origin + mins, origin + maxs ) );
+	}
+
+	return bounds;
+}
+
+static void CG_ClipGridCells( MinMax3 bounds, int * x0, int * y0, int * x1, int * y1 ) {
+	const ClipGrid * grid = &cg_clipGrid;
+	*x0 = Clamp( 0, int( floorf( ( bounds.mins.x - grid->mins.x ) * grid->inv_cell_size.x ) ), CLIP_GRID_SIZE - 1 );
+	*y0 = Clamp( 0, int( floorf( ( bounds.mins.y - grid->mins.y ) * grid->inv_cell_size.y ) ), CLIP_GRID_SIZE - 1 );
+	*x1 = Clamp( 0, int( floorf( ( bounds.maxs.x - grid->mins.x ) * grid->inv_cell_size.x ) ), CLIP_GRID_SIZE - 1 );
+	*y1 = Clamp( 0, int( floorf( ( bounds.maxs.y - grid->mins.y ) * grid->inv_cell_size.y ) ), CLIP_GRID_SIZE - 1 );
+}
+
+/*
+* CG_BuildClipGrid
+*/
+static void CG_BuildClipGrid() {
+	ZoneScoped;
+
+	ClipGrid * grid = &cg_clipGrid;
+	int num_clip_ents = cg_numSolids + cg_numTriggers;
+
+	MinMax3 total = MinMax3::Empty();
+	for( int i = 0; i < num_clip_ents; i++ ) {
+		const SyncEntityState * ent = i < cg_numSolids ? cg_solidList[i] : cg_triggersList[i - cg_numSolids];
+
+		// pad a little so touching counts, traces stop DIST_EPSILON short anyway
+		MinMax3 bounds = CG_ClipEntityBounds( ent );
+		bounds.mins -= Vec3( 1.0f );
+		bounds.maxs += Vec3( 1.0f );
+
+		cg_clipBounds[i] = bounds;
+		total = Union( total, bounds );
+	}
+
+	Vec2 size = Vec2( 0.0f );
+	if( num_clip_ents > 0 ) {
+		grid->mins = Vec2( total.mins.x, total.mins.y );
+		size = Vec2( total.maxs.x - total.mins.x, total.maxs.y - total.mins.y );
+	}
+	grid->inv_cell_size.x = 1.0f / Max2( size.x / CLIP_GRID_SIZE, CLIP_GRID_MIN_CELL_SIZE );
+	grid->inv_cell_size.y = 1.0f / Max2( size.y / CLIP_GRID_SIZE, CLIP_GRID_MIN_CELL_SIZE );
+
+	// count, prefix sum, then fill
+	memset( grid->cell_first, 0, sizeof( grid->cell_first ) );
+	grid->num_large_ents = 0;
+
+	for( int i = 0; i < num_clip_ents; i++ ) {
+		int x0, y0, x1, y1;
+		CG_ClipGridCells( cg_clipBounds[i], &x0, &y0, &x1, &y1 );
+
+		if( ( x1 - x0 + 1 ) * ( y1 - y0 + 1 ) > CLIP_GRID_MAX_ENT_CELLS ) {
+			grid->large_ents[grid->num_large_ents++] = i;
+			continue;
+		}
+
+		for( int y = y0; y <= y1; y++ ) {
+			for( int x = x0; x <= x1; x++ ) {
+				grid->cell_first[y * CLIP_GRID_SIZE + x + 1]++;
+			}
+		}
+	}
+
+	for( int i = 0; i < CLIP_GRID_SIZE * CLIP_GRID_SIZE; i++ ) {
+		grid->cell_first[i + 1] += grid->cell_first[i];
+	}
+
+	u16 cursors[CLIP_GRID_SIZE * CLIP_GRID_SIZE];
+	memcpy( cursors, grid->cell_first, sizeof( cursors ) );
+
+	for( int i = 0; i < num_clip_ents; i++ ) {
+		int x0, y0, x1, y1;
+		CG_ClipGridCells( cg_clipBounds[i], &x0, &y0, &x1, &y1 );
+
+		if( ( x1 - x0 + 1 ) * ( y1 - y0 + 1 ) > CLIP_GRID_MAX_ENT_CELLS ) {
+			continue;
+		}
+
+		for( int y = y0; y <= y1; y++ ) {
+			for( int x = x0; x <= x1; x++ ) {
+				grid->cell_ents[cursors[y * CLIP_GRID_SIZE + x]++] = i;
+			}
+		}
+	}
+}
+
+/*
+* CG_ClipEntitiesInBox
+*
+* finds clip indices in [first, end) whose bounds touch box, in order so
+* ties go to the same entity as testing the whole list would
+*/
+static int CG_ClipEntitiesInBox( MinMax3 box, int first, int end, u16 * list ) {
+	const ClipGrid * grid = &cg_clipGrid;
+	int n = 0;
+
+	cg_clipQuery++;
+	if( cg_clipQuery == 0 ) {
+		memset( cg_clipQueryMarks, 0, sizeof( cg_clipQueryMarks ) );
+		cg_clipQuery++;
+	}
+
+	for( int i = 0; i < grid->num_large_ents; i++ ) {
+		u16 idx = grid->large_ents[i];
+		if( idx >= first && idx < end && BoundsOverlap( box, cg_clipBounds[idx] ) ) {
+			cg_clipQueryMarks[idx] = cg_clipQuery;
+			list[n++] = idx;
+		}
+	}
+
+	int x0, y0, x1, y1;
+	CG_ClipGridCells( box, &x0, &y0, &x1, &y1 );
+
+	for( int y = y0; y <= y1; y++ ) {
+		for( int x = x0; x <= x1; x++ ) {
+			int cell = y * CLIP_GRID_SIZE + x;
+			for( int i = grid->cell_first[cell]; i < grid->cell_first[cell + 1]; i++ ) {
+				u16 idx = grid->cell_ents[i];
+				if( cg_clipQueryMarks[idx] == cg_clipQuery || idx < first || idx >= end )
+					continue;
+				cg_clipQueryMarks[idx] = cg_clipQuery;
+
+				if( BoundsOverlap( box, cg_clipBounds[idx] ) ) {
+					list[n++] = idx;
+				}
+			}
+		}
+	}
+
+	// insertion sort, there are only ever a handful
+	for( int i = 1; i < n; i++ ) {
+		u16 idx = list[i];
+		int j = i;
+		while( j > 0 && list[j - 1] > idx ) {
+			list[j] = list[j - 1];
+			j--;
+		}
+		list[j] = idx;
+	}
+
+	return n;
+}
+
 /*
 * CG_BuildSolidList
 */
@@ -138,6 +351,8 @@ void CG_BuildSolidList() {
 				break;
 		}
 	}
+
+	CG_BuildClipGrid();
 }
 
 /*
@@ -184,7 +399,12 @@ void CG_Predict_TouchTriggers( pmove_t *pm, Vec3 previous_origin ) {
 		return;
 	}
 
-	for( int i = 0; i < cg_numTriggers; i++ ) {
+	MinMax3 box( pm->playerState->pmove.origin + pm->mins, pm->playerState->pmove.origin + pm->maxs );
+	u16 touching[MAX_PARSE_ENTITIES];
+	int num_touching = CG_ClipEntitiesInBox( box, cg_numSolids, cg_numSolids + cg_numTriggers, touching );
+
+	for( int j = 0; j < num_touching; j++ ) {
+		int i = touching[j] - cg_numSolids;
 		const SyncEntityState * state = cg_triggersList[i];
 
 		if( state->type == ET_JUMPPAD || state->type == ET_PAINKILLER_JUMPPAD ) {
@@ -204,8 +424,17 @@ void CG_Predict_TouchTriggers( pmove_t *pm, Vec3 previous_origin ) {
 static void CG_ClipMoveToEntities( Vec3 start, Vec3 mins, Vec3 maxs, Vec3 end, int ignore, int contentmask, trace_t *tr ) {
 	int64_t serverTime = cg.frame.serverTime;
 
-	for( int i = 0; i < cg_numSolids; i++ ) {
-		const SyncEntityState * ent = cg_solidList[i];
+	MinMax3 box = MinMax3::Empty();
+	box = Extend( box, start + mins );
+	box = Extend( box, start + maxs );
+	box = Extend( box, end + mins );
+	box = Extend( box, end + maxs );
+
+	u16 touching[MAX_PARSE_ENTITIES];
+	int num_touching = CG_ClipEntitiesInBox( box, 0, cg_numSolids, touching );
+
+	for( int i = 0; i < num_touching; i++ ) {
+		const SyncEntityState * ent = cg_solidList[touching[i]];
 
 		if( ent->number == ignore ) {
 			continue;
@@ -240,6 +469,7 @@ static void CG_ClipMoveToEntities( Vec3 start, Vec3 mins, Vec3 maxs, Vec3 end, i
 
 		trace_t trace;
 		CM_TransformedBoxTrace( CM_Client, cl.cms, &trace, start, end, mins, maxs, cmodel, contentmask, origin, angles );
+		trace_frame_stats.entity_tests++;
 		if( trace.allsolid || trace.fraction < tr->fraction ) {
 			trace.ent = ent->number;
 			*tr = trace;
@@ -259,15 +489,19 @@ static void CG_ClipMoveToEntities( Vec3 start, Vec3 mins, Vec3 maxs, Vec3 end, i
 void CG_Trace( trace_t *t, Vec3 start, Vec3 mins, Vec3 maxs, Vec3 end, int ignore, int contentmask ) {
 	ZoneScoped;
 
+	u64 start_time = Sys_Microseconds();
+	trace_frame_stats.traces++;
+
 	// check against world
 	CM_TransformedBoxTrace( CM_Client, cl.cms, t, start, end, mins, maxs, NULL, contentmask, Vec3( 0.0f ), Vec3( 0.0f ) );
 	t->ent = t->fraction < 1.0 ? 0 : -1; // world entity is 0
-	if( t->fraction == 0 ) {
-		return; // blocked by the world
-	}
 
 	// check all other solid models
-	CG_ClipMoveToEntities( start, mins, maxs, end, ignore, contentmask, t );
+	if( t->fraction != 0 ) {
+		CG_ClipMoveToEntities( start, mins, maxs, end, ignore, contentmask, t );
+	}
+
+	trace_frame_stats.time += Sys_Microseconds() - start_time;
 }
 
 /*
@@ -278,8 +512,11 @@ int CG_PointContents( Vec3 point ) {
 
 	int contents = CM_TransformedPointContents( CM_Client, cl.cms, point, NULL, Vec3( 0.0f ), Vec3( 0.0f ) );
 
-	for( int i = 0; i < cg_numSolids; i++ ) {
-		const SyncEntityState * ent = cg_solidList[i];
+	u16 touching[MAX_PARSE_ENTITIES];
+	int num_touching = CG_ClipEntitiesInBox( MinMax3( point, point ), 0, cg_numSolids, touching );
+
+	for( int i = 0; i < num_touching; i++ ) {
+		const SyncEntityState * ent = cg_solidList[touching[i]];
 
 		cmodel_t * cmodel = CM_TryFindCModel( CM_Client, ent->model );
 		if( cmodel != NULL ) {
@@ -290,6 +527,16 @@ int CG_PointContents( Vec3 point ) {
 	return contents;
 }
 
+/*
+* CG_PlotTraceStats
+*/
+void CG_PlotTraceStats() {
+	TracyPlot( "Client traces", s64( trace_frame_stats.traces ) );
+	TracyPlot( "Client trace entity tests", s64( trace_frame_stats.entity_tests ) );
+	TracyPlot( "Client trace time (us)", s64( trace_frame_stats.time ) );
+	trace_frame_stats = { };
+}
+
 
 static float predictedSteps[CMD_BACKUP]; // for step smoothing
 /*
@@ -352,83 +599,222 @@ static void CG_PredictSmoothSteps() {
 }
 
 /*
-* CG_PredictMovement
+* prediction cache
 *
-* Sets cg.predictedVelocty, cg.predictedOrigin and cg.predictedAngles
+* the playerstate after every closed usercmd is kept around. when a snapshot
+* acks a usercmd and agrees with what we predicted for it, the predictions for
+* the usercmds after it are still good and only new usercmds need to be run.
+* cg.predictFrom is the newest usercmd with a cached result, or 0 if the
+* cache is empty
 */
-void CG_PredictMovement() {
-	ZoneScoped;
+struct PredictedCommand {
+	int64_t ucmdNum;
+	usercmd_t cmd;
+	SyncPlayerState playerState;
+};
 
-	int64_t ucmdExecuted, ucmdHead;
-	int64_t frame;
-	pmove_t pm;
+static PredictedCommand predictedCommands[CMD_BACKUP];
 
-	trap_NET_GetCurrentState( NULL, &ucmdHead, NULL );
-	ucmdExecuted = cg.frame.ucmdExecuted;
+static bool CG_SameUsercmd( const usercmd_t * a, const usercmd_t * b ) {
+	return a->msec == b->msec && a->buttons == b->buttons && a->entropy == b->entropy
+		&& a->serverTimeStamp == b->serverTimeStamp
+		&& a->angles[ 0 ] == b->angles[ 0 ] && a->angles[ 1 ] == b->angles[ 1 ] && a->angles[ 2 ] == b->angles[ 2 ]
+		&& a->forwardmove == b->forwardmove && a->sidemove == b->sidemove && a->upmove == b->upmove
+		&& a->weaponSwitch == b->weaponSwitch;
+}
 
-	if( ucmdHead - cg.predictFrom >= CMD_BACKUP ) {
+static bool CG_NearlyEqual( Vec3 a, Vec3 b ) {
+	constexpr float epsilon = 0.1f;
+	return Abs( a.x - b.x ) <= epsilon && Abs( a.y - b.y ) <= epsilon && Abs( a.z - b.z ) <= epsilon;
+}
+
+/*
+* CG_SamePredictedState
+* compares everything Pmove and UpdateWeapons read or write
+*/
+static bool CG_SamePredictedState( const SyncPlayerState * a, const SyncPlayerState * b ) {
+	const pmove_state_t * pa = &a->pmove;
+	const pmove_state_t * pb = &b->pmove;
+
+	if( pa->pm_type != pb->pm_type || pa->pm_flags != pb->pm_flags || pa->pm_time != pb->pm_time || pa->features != pb->features )
+		return false;
+	if( !CG_NearlyEqual( pa->origin, pb->origin ) || !CG_NearlyEqual( pa->velocity, pb->velocity ) )
+		return false;
+	if( pa->delta_angles[ 0 ] != pb->delta_angles[ 0 ] || pa->delta_angles[ 1 ] != pb->delta_angles[ 1 ] || pa->delta_angles[ 2 ] != pb->delta_angles[ 2 ] )
+		return false;
+	if( pa->knockback_time != pb->knockback_time || pa->crouch_time != pb->crouch_time || pa->tbag_time != pb->tbag_time
+		|| pa->dash_time != pb->dash_time || pa->walljump_time != pb->walljump_time )
+		return false;
+	if( pa->max_speed != pb->max_speed || pa->jump_speed != pb->jump_speed || pa->dash_speed != pb->dash_speed )
+		return false;
+
+	for( size_t i = 0; i < ARRAY_COUNT( a->weapons ); i++ ) {
+		if( a->weapons[ i ].weapon != b->weapons[ i ].weapon || a->weapons[ i ].ammo != b->weapons[ i ].ammo )
+			return false;
+	}
+
+	for( size_t i = 0; i < ARRAY_COUNT( a->items ); i++ ) {
+		if( a->items[ i ] != b->items[ i ] )
+			return false;
+	}
+
+	return a->weapon_state == b->weapon_state && a->weapon_state_time == b->weapon_state_time
+		&& a->weapon == b->weapon && a->pending_weapon == b->pending_weapon && a->last_weapon == b->last_weapon
+		&& a->zoom_time == b->zoom_time && a->team == b->team;
+}
+
+/*
+* CG_CopyPredictedState
+* the rest of the playerstate always comes from the newest snapshot
+*/
+static void CG_CopyPredictedState( SyncPlayerState * dst, const SyncPlayerState * src ) {
+	dst->pmove = src->pmove;
+	dst->viewangles = src->viewangles;
+	dst->viewheight = src->viewheight;
+	memcpy( dst->weapons, src->weapons, sizeof( dst->weapons ) );
+	dst->weapon_state = src->weapon_state;
+	dst->weapon_state_time = src->weapon_state_time;
+	dst->weapon = src->weapon;
+	dst->pending_weapon = src->pending_weapon;
+	dst->last_weapon = src->last_weapon;
+	dst->zoom_time = src->zoom_time;
+}
+
+/*
+* CG_CheckPredictionCache
+* throw away the cached predictions if the snapshot disagrees with them
+*/
+static void CG_CheckPredictionCache( const SyncPlayerState * snapshot, int64_t ucmdExecuted ) {
+	if( cg.predictFrom == 0 ) {
+		return;
+	}
+
+	if( cg.predictFrom <= ucmdExecuted || cg_predictCache->integer == 0 ) {
 		cg.predictFrom = 0;
+		return;
 	}
 
-	if( cg.predictFrom > 0 ) {
-		ucmdExecuted = cg.predictFrom;
-		cg.predictedPlayerState = cg.predictFromPlayerState;
-		cg_entities[cg.frame.playerState.POVnum].current = cg.predictFromEntityState;
-	} else {
-		cg.predictedPlayerState = cg.frame.playerState; // start from the final position
+	const PredictedCommand * acked = &predictedCommands[ ucmdExecuted & CMD_MASK ];
+	if( acked->ucmdNum != ucmdExecuted || !CG_SamePredictedState( &acked->playerState, snapshot ) ) {
+		cg.predictFrom = 0;
 	}
+}
 
-	cg.predictedPlayerState.POVnum = cgs.playerNum + 1;
+void CG_CheckPredictionCache() {
+	CG_CheckPredictionCache( &cg.frame.playerState, cg.frame.ucmdExecuted );
+}
 
-	// if we are too far out of date, just freeze
-	if( ucmdHead - ucmdExecuted >= CMD_BACKUP ) {
-		if( cg_showMiss->integer ) {
-			Com_Printf( "exceeded CMD_BACKUP\n" );
+/*
+* CG_RunPrediction
+*
+* predicts usercmds ucmdExecuted+1 to ucmdHead on top of the snapshot,
+* skipping ahead over cached usercmds that haven't changed. cmds is indexed
+* by usercmd number & CMD_MASK. returns how many usercmds were run
+*/
+static int CG_RunPrediction( const SyncPlayerState * snapshot, int64_t ucmdExecuted, int64_t ucmdHead, const usercmd_t * cmds, pmove_t * pm ) {
+	cg.predictedPlayerState = *snapshot;
+
+	if( cg.predictFrom >= ucmdHead ) {
+		cg.predictFrom = 0;
+	}
+
+	int64_t resume = ucmdExecuted;
+	for( int64_t i = ucmdExecuted + 1; i <= cg.predictFrom; i++ ) {
+		const PredictedCommand * cached = &predictedCommands[ i & CMD_MASK ];
+		if( cached->ucmdNum != i || !CG_SameUsercmd( &cached->cmd, &cmds[ i & CMD_MASK ] ) ) {
+			break;
 		}
+		resume = i;
+	}
 
-		cg.predictingTimeStamp = cl.serverTime;
-		return;
+	cg.predictFrom = 0;
+	if( resume > ucmdExecuted ) {
+		cg.predictFrom = resume;
+		CG_CopyPredictedState( &cg.predictedPlayerState, &predictedCommands[ resume & CMD_MASK ].playerState );
 	}
 
+	cg.predictedPlayerState.POVnum = cgs.playerNum + 1;
+
 	// copy current state to pmove
-	memset( &pm, 0, sizeof( pm ) );
-	pm.playerState = &cg.predictedPlayerState;
+	memset( pm, 0, sizeof( *pm ) );
+	pm->playerState = &cg.predictedPlayerState;
 
 	// clear the triggered toggles for this prediction round
 	memset( &cg_triggersListTriggered, false, sizeof( cg_triggersListTriggered ) );
 
 	// run frames
-	while( ++ucmdExecuted <= ucmdHead ) {
-		frame = ucmdExecuted & CMD_MASK;
-		trap_NET_GetUserCmd( frame, &pm.cmd );
+	int num_predicted = 0;
+	int64_t ucmdNum = resume;
+	while( ++ucmdNum <= ucmdHead ) {
+		int64_t frame = ucmdNum & CMD_MASK;
+		pm->cmd = cmds[ frame ];
 
-		ucmdReady = ( pm.cmd.serverTimeStamp != 0 );
+		ucmdReady = ( pm->cmd.serverTimeStamp != 0 );
 		if( ucmdReady ) {
-			cg.predictingTimeStamp = pm.cmd.serverTimeStamp;
+			cg.predictingTimeStamp = pm->cmd.serverTimeStamp;
 		}
 
-		Pmove( &client_gs, &pm );
+		Pmove( &client_gs, pm );
+		num_predicted++;
 
 		// copy for stair smoothing
-		predictedSteps[frame] = pm.step;
+		predictedSteps[frame] = pm->step;
 
 		if( ucmdReady ) { // hmm fixme: the wip command may not be run enough time to get proper key presses
-			UpdateWeapons( &client_gs, &cg.predictedPlayerState, &pm.cmd, 0 );
+			UpdateWeapons( &client_gs, &cg.predictedPlayerState, &pm->cmd, 0 );
 		}
 
 		// save for debug checking
 		cg.predictedOrigins[frame] = cg.predictedPlayerState.pmove.origin; // store for prediction error checks
 
-		// backup the last predicted ucmd which has a timestamp (it's closed)
-		if( ucmdExecuted == ucmdHead - 1 ) {
-			if( ucmdExecuted != cg.predictFrom ) {
-				cg.predictFrom = ucmdExecuted;
-				cg.predictFromPlayerState = cg.predictedPlayerState;
-				cg.predictFromEntityState = cg_entities[cg.frame.playerState.POVnum].current;
-			}
+		// cache closed ucmds, the last one is still being built
+		if( ucmdNum < ucmdHead && cg_predictCache->integer != 0 ) {
+			PredictedCommand * cached = &predictedCommands[ frame ];
+			cached->ucmdNum = ucmdNum;
+			cached->cmd = pm->cmd;
+			cached->playerState = cg.predictedPlayerState;
+			cg.predictFrom = ucmdNum;
 		}
 	}
 
+	return num_predicted;
+}
+
+/*
+* CG_PredictMovement
+*
+* Sets cg.predictedVelocty, cg.predictedOrigin and cg.predictedAngles
+*/
+void CG_PredictMovement() {
+	ZoneScoped;
+
+	int64_t ucmdExecuted, ucmdHead;
+	pmove_t pm;
+
+	trap_NET_GetCurrentState( NULL, &ucmdHead, NULL );
+	ucmdExecuted = cg.frame.ucmdExecuted;
+
+	// if we are too far out of date, just freeze
+	if( ucmdHead - ucmdExecuted >= CMD_BACKUP ) {
+		if( cg_showMiss->integer ) {
+			Com_Printf( "exceeded CMD_BACKUP\n" );
+		}
+
+		cg.predictedPlayerState = cg.frame.playerState;
+		cg.predictedPlayerState.POVnum = cgs.playerNum + 1;
+		cg.predictingTimeStamp = cl.serverTime;
+		cg.predictFrom = 0;
+		return;
+	}
+
+	usercmd_t cmds[CMD_BACKUP];
+	for( int64_t i = ucmdExecuted + 1; i <= ucmdHead; i++ ) {
+		trap_NET_GetUserCmd( i & CMD_MASK, &cmds[i & CMD_MASK] );
+	}
+
+	cg.predictedUsercmds = CG_RunPrediction( &cg.frame.playerState, ucmdExecuted, ucmdHead, cmds, &pm );
+	TracyPlot( "Predicted usercmds", s64( cg.predictedUsercmds ) );
+
 	cg.predictedGroundEntity = pm.groundentity;
 
 	// compensate for ground entity movement
@@ -445,3 +831,93 @@ void CG_PredictMovement() {
 
 	CG_PredictSmoothSteps();
 }
+
+static usercmd_t CG_PredictionBenchmarkUsercmd( int64_t ucmdNum ) {
+	usercmd_t cmd = { };
+	cmd.msec = 4;
+	cmd.serverTimeStamp = cg.frame.serverTime + ucmdNum * cmd.msec;
+	cmd.angles[ YAW ] = ANGLE2SHORT( float( ucmdNum % 720 ) * 0.5f );
+	cmd.forwardmove = 127;
+	cmd.sidemove = ( ucmdNum / 100 ) % 2 == 0 ? 127 : -127;
+	cmd.upmove = ucmdNum % 60 < 5 ? 127 : 0;
+	return cmd;
+}
+
+/*
+* CG_PredictionBenchmark_f
+*
+* predicts a made up stream of usercmds every frame on top of the player in
+* the demo, like a 250fps client with 128ms of lag, once restarting on every
+* snapshot and once with the prediction cache
+*/
+void CG_PredictionBenchmark_f() {
+	constexpr int num_frames = 10000;
+	constexpr int frames_per_snapshot = 4;
+	constexpr int64_t ucmds_in_flight = 32;
+	constexpr int snapshots_per_knockback = 50; // the server disagrees with us now and then
+
+	if( !cgs.demoPlaying || !cg.frame.valid ) {
+		Com_Printf( "Play a demo to run the prediction benchmark\n" );
+		return;
+	}
+
+	SyncPlayerState saved_player_state = cg.predictedPlayerState;
+	int64_t saved_predicting_time_stamp = cg.predictingTimeStamp;
+	int64_t saved_event_times[PREDICTABLE_EVENTS_MAX];
+	memcpy( saved_event_times, cg.predictedEventTimes, sizeof( saved_event_times ) );
+
+	for( int cache = 0; cache < 2; cache++ ) {
+		SyncPlayerState server = cg.frame.playerState;
+		usercmd_t cmds[CMD_BACKUP];
+		int64_t ucmdExecuted = 0;
+		int64_t ucmdHead = 0;
+		int num_snapshots = 0;
+		u64 num_predicted = 0;
+		u64 dt = 0;
+
+		cg.predictFrom = 0;
+
+		for( int i = 0; i < num_frames; i++ ) {
+			ucmdHead++;
+			cmds[ucmdHead & CMD_MASK] = CG_PredictionBenchmarkUsercmd( ucmdHead );
+
+			if( i % frames_per_snapshot == 0 && ucmdHead - ucmdExecuted > ucmds_in_flight ) {
+				while( ucmdHead - ucmdExecuted > ucmds_in_flight ) {
+					ucmdExecuted++;
+
+					pmove_t pm = { };
+					pm.playerState = &server;
+					pm.cmd = cmds[ucmdExecuted & CMD_MASK];
+					Pmove( &client_gs, &pm );
+					UpdateWeapons( &client_gs, &server, &pm.cmd, 0 );
+				}
+
+				num_snapshots++;
+				if( num_snapshots % snapshots_per_knockback == 0 ) {
+					server.pmove.velocity.z += 300.0f;
+				}
+
+				if( cache == 1 ) {
+					CG_CheckPredictionCache( &server, ucmdExecuted );
+				}
+				else {
+					cg.predictFrom = 0;
+				}
+			}
+
+			pmove_t pm;
+			u64 start = Sys_Microseconds();
+			num_predicted += CG_RunPrediction( &server, ucmdExecuted, ucmdHead, cmds, &pm );
+			dt += Sys_Microseconds() - start;
+		}
+
+		Com_Printf( "%s: %.2f usercmds predicted per frame, %.3fus per frame\n",
+			cache == 1 ? "cached" : "restart every snapshot", double( num_predicted ) / num_frames, double( dt ) / num_frames );
+	}
+
+	cg.predictFrom = 0;
+	cg.predictedPlayerState = saved_player_state;
+	cg.predictingTimeStamp = saved_predicting_time_stamp;
+	memcpy( cg.predictedEventTimes, saved_event_times, sizeof( saved_event_times ) );
+	ucmdReady = false;
+}
@@ -593,7 +593,9 @@ static void DrawWorld() {
 	const Model * model = FindModel( StringHash( hash ) );
 
 	for( u32 i = 0; i < model->num_primitives; i++ ) {
-		if( model->primitives[ i ].material->blend_func == BlendFunc_Disabled ) {
+		u8 visible = CullBounds( model->primitives[ i ].bounds );
+
+		if( model->primitives[ i ].material->blend_func == BlendFunc_Disabled && ( visible & VisibleIn_NearShadowmap ) ) {
 			PipelineState pipeline;
 			pipeline.pass = frame_static.near_shadowmap_pass;
 			pipeline.shader = &shaders.depth_only;
@@ -605,7 +607,7 @@ static void DrawWorld() {
 			DrawModelPrimitive( model, &model->primitives[ i ], pipeline );
 		}
 
-		if( model->primitives[ i ].material->blend_func == BlendFunc_Disabled ) {
+		if( model->primitives[ i ].material->blend_func == BlendFunc_Disabled && ( visible & VisibleIn_FarShadowmap ) ) {
 			PipelineState pipeline;
 			pipeline.pass = frame_static.far_shadowmap_pass;
 			pipeline.shader = &shaders.depth_only;
@@ -617,6 +619,9 @@ static void DrawWorld() {
 			DrawModelPrimitive( model, &model->primitives[ i ], pipeline );
 		}
 
+		if( ( visible & VisibleIn_View ) == 0 )
+			continue;
+
 		{
 			PipelineState pipeline;
 			pipeline.pass = frame_static.world_opaque_prepass_pass;
@@ -790,4 +795,6 @@ void CG_RenderView( unsigned extrapolationTime ) {
 	CG_Draw2D();
 
 	UploadDecalBuffers();
+
+	CG_PlotTraceStats();
 }
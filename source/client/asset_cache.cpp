@@ -0,0 +1,96 @@
+#include "qcommon/base.h"
+#include "qcommon/qcommon.h"
+#include "qcommon/fs.h"
+#include "qcommon/sys_fs.h"
+#include "client/asset_cache.h"
+
+static constexpr u32 ASSET_CACHE_MAGIC = U32( 0x43535341 ); // ASSC
+
+// keep this a multiple of 16 so entry data stays aligned
+struct AssetCacheHeader {
+	u32 magic;
+	u32 version;
+	u64 key;
+	u64 size;
+	u64 padding;
+};
+
+STATIC_ASSERT( sizeof( AssetCacheHeader ) % 16 == 0 );
+
+static char * AssetCacheEntryPath( Allocator * a, const char * kind, u64 key ) {
+	return ( *a )( "{}/cache/{}/{016x}", HomeDirPath(), kind, key );
+}
+
+bool MapAssetCacheEntry( Allocator * a, AssetCacheEntry * entry, const char * kind, u32 version, u64 key ) {
+	ZoneScoped;
+
+	*entry = { };
+
+	char * path = AssetCacheEntryPath( a, kind, key );
+	defer { FREE( a, path ); };
+
+	Span< const u8 > mapped = MapFile( a, path );
+	if( mapped.ptr == NULL )
+		return false;
+
+	const AssetCacheHeader * header = ( const AssetCacheHeader * ) mapped.ptr;
+	bool ok = mapped.n >= sizeof( AssetCacheHeader )
+		&& header->magic == ASSET_CACHE_MAGIC
+		&& header->version == version
+		&& header->key == key
+		&& header->size == mapped.n - sizeof( AssetCacheHeader );
+
+	if( !ok ) {
+		UnmapFile( mapped );
+		return false;
+	}
+
+	entry->mapped = mapped;
+	entry->data = mapped + sizeof( AssetCacheHeader );
+
+	return true;
+}
+
+void UnmapAssetCacheEntry( AssetCacheEntry * entry ) {
+	UnmapFile( entry->mapped );
+	*entry = { };
+}
+
+bool WriteAssetCacheEntry( TempAllocator * temp, const char * kind, u32 version, u64 key, Span< const u8 > data ) {
+	ZoneScoped;
+
+	AssetCacheHeader header = { };
+	header.magic = ASSET_CACHE_MAGIC;
+	header.version = version;
+	header.key = key;
+	header.size = data.n;
+
+	// this gets called from the thread pool where temp is tiny, so create
+	// the directories and write the file in pieces instead of using WriteFile
+	if( !CreateDirectory( temp, ( *temp )( "{}/cache", HomeDirPath() ) ) )
+		return false;
+	if( !CreateDirectory( temp, ( *temp )( "{}/cache/{}", HomeDirPath(), kind ) ) )
+		return false;
+
+	// write to a temporary file and move it into place so other
+	// instances of the game never see partially written entries
+	char * path = AssetCacheEntryPath( temp, kind, key );
+	char * tmp_path = ( *temp )( "{}.tmp", path );
+
+	FILE * file = OpenFile( temp, tmp_path, "wb" );
+	if( file == NULL ) {
+		Com_Printf( S_COLOR_YELLOW "Couldn't write asset cache entry %s\n", tmp_path );
+		return false;
+	}
+
+	bool ok = fwrite( &header, sizeof( header ), 1, file ) == 1;
+	ok = ok && fwrite( data.ptr, 1, data.n, file ) == data.n;
+	fclose( file );
+
+	if( !ok || !MoveFile( temp, tmp_path, path, MoveFile_DoReplace ) ) {
+		RemoveFile( temp, tmp_path );
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "qcommon/types.h"
+
+/*
+ * processed asset data (decoded textures etc) cached on disk so we don't have
+ * to redo the work every time the game starts. entries are keyed by a hash of
+ * the source data and live in $HOME/cache/<kind>/
+ */
+
+struct AssetCacheEntry {
+	Span< const u8 > mapped;
+	Span< const u8 > data;
+};
+
+bool MapAssetCacheEntry( Allocator * a, AssetCacheEntry * entry, const char * kind, u32 version, u64 key );
+void UnmapAssetCacheEntry( AssetCacheEntry * entry );
+
+// safe to call from the thread pool
+bool WriteAssetCacheEntry( TempAllocator * temp, const char * kind, u32 version, u64 key, Span< const u8 > data );
@@ -10,19 +10,43 @@
 #include "qcommon/string.h"
 #include "qcommon/threads.h"
 #include "client/assets.h"
-#include "client/threadpool.h"
+
+/*
+ * InitAssets only indexes base/, file contents get loaded the first time
+ * somebody asks for them with AssetString/AssetBinary.
+ *
+ * AssetString needs a NUL terminator so it always reads the file into
+ * memory. AssetBinary maps uncompressed files in public builds. We don't map
+ * in dev builds because editors that truncate files when they save them turn
+ * hotloading into SIGBUS, and Windows won't let you save a mapped file at all.
+ *
+ * Loading happens outside assets_mutex so the decode jobs can read and
+ * decompress their assets in parallel. Threads that want an asset somebody
+ * else is already loading wait on assets_loaded_sem.
+ */
+#if PUBLIC_BUILD
+static constexpr bool map_uncompressed_assets = true;
+#else
+static constexpr bool map_uncompressed_assets = false;
+#endif
 
 struct Asset {
 	char * path;
-	char * data;
-	size_t len;
+	char * full_path;
 	s64 modified_time;
 	bool compressed;
+
+	char * data;
+	size_t len;
+	Span< const u8 > mapped;
+	bool loading;
 };
 
 static constexpr u32 MAX_ASSETS = 4096;
 
 static Mutex * assets_mutex;
+static Semaphore * assets_loaded_sem;
+static u32 num_waiting_for_assets;
 
 static Asset assets[ MAX_ASSETS ];
 static const char * asset_paths[ MAX_ASSETS ];
@@ -33,75 +57,43 @@ static u32 num_modified_assets;
 
 static Hashtable< MAX_ASSETS * 2 > assets_hashtable;
 
-enum IsCompressed {
-	IsCompressed_No,
-	IsCompressed_Yes,
-};
-
-static void AddAsset( const char * path, u64 hash, s64 modified_time, char * contents, size_t len, IsCompressed compressed ) {
-	Lock( assets_mutex );
-	defer { Unlock( assets_mutex ); };
+static void UnloadAsset( Asset * a ) {
+	FREE( sys_allocator, a->data );
+	UnmapFile( a->mapped );
+	a->data = NULL;
+	a->len = 0;
+	a->mapped = Span< const u8 >();
+}
 
+static void AddAsset( Span< const char > path, const char * full_path, u64 hash, s64 modified_time, bool compressed ) {
 	u64 idx;
 	bool exists = assets_hashtable.get( hash, &idx );
 
 	Asset * a;
 	if( exists ) {
 		a = &assets[ idx ];
-		FREE( sys_allocator, a->data );
+		UnloadAsset( a );
+		FREE( sys_allocator, a->full_path );
+
+		modified_asset_paths[ num_modified_assets ] = a->path;
+		num_modified_assets++;
 	}
 	else {
 		a = &assets[ num_assets ];
-		a->path = CopyString( sys_allocator, path );
+		*a = { };
+		a->path = ( *sys_allocator )( "{}", path );
 		asset_paths[ num_assets ] = a->path;
-	}
-
-	a->data = contents;
-	a->len = len;
-	a->modified_time = modified_time;
-	a->compressed = compressed == IsCompressed_Yes;
 
-	modified_asset_paths[ num_modified_assets ] = a->path;
-	num_modified_assets++;
-
-	if( !exists ) {
 		assets_hashtable.add( hash, num_assets );
 		num_assets++;
 	}
-}
 
-struct DecompressAssetJob {
-	char * path;
-	u64 hash;
-	s64 modified_time;
-	Span< u8 > compressed;
-};
-
-static void DecompressAsset( TempAllocator * temp, void * data ) {
-	ZoneScoped;
-
-	DecompressAssetJob * job = ( DecompressAssetJob * ) data;
-
-	ZoneText( job->path, strlen( job->path ) );
-
-	char * path_with_zst = ( *temp )( "{}.zst", job->path );
-	Span< u8 > decompressed;
-	if( Decompress( path_with_zst, sys_allocator, job->compressed, &decompressed ) ) {
-		// TODO: we need to add a null terminator too so AssetString etc works
-		char * decompressed_and_terminated = ALLOC_MANY( sys_allocator, char, decompressed.n + 1 );
-		memcpy( decompressed_and_terminated, decompressed.ptr, decompressed.n );
-		decompressed_and_terminated[ decompressed.n ] = '\0';
-
-		AddAsset( job->path, job->hash, job->modified_time, decompressed_and_terminated, decompressed.n, IsCompressed_Yes );
-	}
-
-	FREE( sys_allocator, decompressed.ptr );
-	FREE( sys_allocator, job->path );
-	FREE( sys_allocator, job->compressed.ptr );
-	FREE( sys_allocator, job );
+	a->full_path = CopyString( sys_allocator, full_path );
+	a->modified_time = modified_time;
+	a->compressed = compressed;
 }
 
-static void LoadAsset( TempAllocator * temp, const char * game_path, const char * full_path ) {
+static void IndexAsset( TempAllocator * temp, const char * game_path, const char * full_path ) {
 	ZoneScoped;
 	ZoneText( game_path, strlen( game_path ) );
 
@@ -117,45 +109,126 @@ static void LoadAsset( TempAllocator * temp, const char * game_path, const char
 
 	s64 modified_time = FileLastModifiedTime( temp, full_path );
 
-	{
-		Lock( assets_mutex );
-		defer { Unlock( assets_mutex ); };
-
-		u64 idx;
-		bool exists = assets_hashtable.get( hash, &idx );
-		if( exists ) {
-			if( !StrEqual( game_path_no_zst, asset_paths[ idx ] ) ) {
-				Sys_Error( "Asset hash name collision: %s and %s", game_path, assets[ idx ].path );
-			}
-
-			bool modified = assets[ idx ].compressed == compressed && assets[ idx ].modified_time != modified_time;
-			bool replaces = assets[ idx ].compressed && !compressed;
-			if( !( modified || replaces ) ) {
-				return;
-			}
+	Lock( assets_mutex );
+	defer { Unlock( assets_mutex ); };
+
+	u64 idx;
+	bool exists = assets_hashtable.get( hash, &idx );
+	if( exists ) {
+		if( !StrEqual( game_path_no_zst, asset_paths[ idx ] ) ) {
+			Sys_Error( "Asset hash name collision: %s and %s", game_path, assets[ idx ].path );
+		}
+
+		bool modified = assets[ idx ].compressed == compressed && assets[ idx ].modified_time != modified_time;
+		bool replaces = assets[ idx ].compressed && !compressed;
+		if( !( modified || replaces ) ) {
+			return;
 		}
 	}
 
+	AddAsset( game_path_no_zst, full_path, hash, modified_time, compressed );
+}
+
+struct LoadedAsset {
+	char * data;
 	size_t len;
-	char * contents = ReadFileString( sys_allocator, full_path, &len );
-	if( contents == NULL )
-		return;
+	Span< const u8 > mapped;
+};
+
+// doesn't touch the Asset so it can run without holding assets_mutex
+static LoadedAsset LoadAsset( const char * path, const char * full_path, bool compressed, bool need_terminator ) {
+	ZoneScoped;
+	ZoneText( path, strlen( path ) );
+
+	LoadedAsset loaded = { };
 
 	if( compressed ) {
-		DecompressAssetJob * job = ALLOC( sys_allocator, DecompressAssetJob );
-		job->path = ( *sys_allocator )( "{}", game_path_no_zst );
-		job->hash = hash;
-		job->compressed = Span< u8 >( ( u8 * ) contents, len );
-		job->modified_time = modified_time;
+		Span< u8 > file = ReadFileBinary( sys_allocator, full_path );
+		defer { FREE( sys_allocator, file.ptr ); };
+		if( file.ptr == NULL )
+			return loaded;
+
+		Span< u8 > decompressed;
+		if( Decompress( full_path, sys_allocator, file, &decompressed ) ) {
+			loaded.data = ALLOC_MANY( sys_allocator, char, decompressed.n + 1 );
+			memcpy( loaded.data, decompressed.ptr, decompressed.n );
+			loaded.data[ decompressed.n ] = '\0';
+			loaded.len = decompressed.n;
+		}
+		FREE( sys_allocator, decompressed.ptr );
+		return loaded;
+	}
 
-		ThreadPoolDo( DecompressAsset, job );
+	if( !need_terminator && map_uncompressed_assets ) {
+		loaded.mapped = MapFile( sys_allocator, full_path );
+		if( loaded.mapped.ptr != NULL )
+			return loaded;
 	}
-	else {
-		AddAsset( game_path, hash, modified_time, contents, len, IsCompressed_No );
+
+	loaded.data = ReadFileString( sys_allocator, full_path, &loaded.len );
+	return loaded;
+}
+
+static Span< const char > LoadedAssetContents( const Asset * a, bool need_terminator ) {
+	if( a->data != NULL )
+		return Span< const char >( a->data, a->len );
+	if( a->mapped.ptr != NULL && !need_terminator )
+		return a->mapped.cast< const char >();
+	return Span< const char >();
+}
+
+static Span< const char > GetAsset( u64 hash, bool need_terminator ) {
+	Lock( assets_mutex );
+	defer { Unlock( assets_mutex ); };
+
+	u64 idx;
+	if( !assets_hashtable.get( hash, &idx ) )
+		return Span< const char >();
+
+	Asset * a = &assets[ idx ];
+
+	while( a->loading ) {
+		num_waiting_for_assets++;
+		Unlock( assets_mutex );
+		Wait( assets_loaded_sem );
+		Lock( assets_mutex );
+	}
+
+	Span< const char > contents = LoadedAssetContents( a, need_terminator );
+	if( contents.ptr != NULL )
+		return contents;
+
+	a->loading = true;
+	const char * path = a->path;
+	const char * full_path = a->full_path;
+	bool compressed = a->compressed;
+
+	Unlock( assets_mutex );
+	LoadedAsset loaded = LoadAsset( path, full_path, compressed, need_terminator );
+	Lock( assets_mutex );
+
+	// if we already mapped it keep the mapping around because somebody
+	// might still be holding a pointer into it
+	if( loaded.data != NULL ) {
+		a->data = loaded.data;
+		a->len = loaded.len;
+	}
+	if( loaded.mapped.ptr != NULL ) {
+		a->mapped = loaded.mapped;
 	}
+	a->loading = false;
+
+	if( num_waiting_for_assets > 0 ) {
+		Signal( assets_loaded_sem, checked_cast< int >( num_waiting_for_assets ) );
+		num_waiting_for_assets = 0;
+	}
+
+	if( a->data != NULL )
+		return Span< const char >( a->data, a->len );
+	return a->mapped.cast< const char >();
 }
 
-static void LoadAssetsRecursive( TempAllocator * temp, DynamicString * path, size_t skip ) {
+static void IndexAssetsRecursive( TempAllocator * temp, DynamicString * path, size_t skip ) {
 	ListDirHandle scan = BeginListDir( temp, path->c_str() );
 
 	const char * name;
@@ -173,10 +246,10 @@ static void LoadAssetsRecursive( TempAllocator * temp, DynamicString * path, siz
 		size_t old_len = path->length();
 		path->append( "/{}", name );
 		if( dir ) {
-			LoadAssetsRecursive( temp, path, skip );
+			IndexAssetsRecursive( temp, path, skip );
 		}
 		else {
-			LoadAsset( temp, path->c_str() + skip, path->c_str() );
+			IndexAsset( temp, path->c_str() + skip, path->c_str() );
 		}
 		path->truncate( old_len );
 	}
@@ -186,13 +259,15 @@ void InitAssets( TempAllocator * temp ) {
 	ZoneScoped;
 
 	assets_mutex = NewMutex();
+	assets_loaded_sem = NewSemaphore();
+	num_waiting_for_assets = 0;
 
 	num_assets = 0;
 	num_modified_assets = 0;
 	assets_hashtable.clear();
 
 	DynamicString base( temp, "{}/base", RootDirPath() );
-	LoadAssetsRecursive( temp, &base, base.length() + 1 );
+	IndexAssetsRecursive( temp, &base, base.length() + 1 );
 
 	num_modified_assets = 0;
 }
@@ -203,7 +278,7 @@ void HotloadAssets( TempAllocator * temp ) {
 	num_modified_assets = 0;
 
 	DynamicString base( temp, "{}/base", RootDirPath() );
-	LoadAssetsRecursive( temp, &base, base.length() + 1 );
+	IndexAssetsRecursive( temp, &base, base.length() + 1 );
 
 	if( num_modified_assets > 0 ) {
 		Com_Printf( "Hotloading:\n" );
@@ -219,18 +294,17 @@ void DoneHotloadingAssets() {
 
 void ShutdownAssets() {
 	for( u32 i = 0; i < num_assets; i++ ) {
+		UnloadAsset( &assets[ i ] );
 		FREE( sys_allocator, assets[ i ].path );
-		FREE( sys_allocator, assets[ i ].data );
+		FREE( sys_allocator, assets[ i ].full_path );
 	}
 
 	DeleteMutex( assets_mutex );
+	DeleteSemaphore( assets_loaded_sem );
 }
 
 Span< const char > AssetString( StringHash path ) {
-	size_t i;
-	if( !assets_hashtable.get( path.hash, &i ) )
-		return Span< const char >();
-	return Span< const char >( assets[ i ].data, assets[ i ].len );
+	return GetAsset( path.hash, true );
 }
 
 Span< const char > AssetString( const char * path ) {
@@ -238,7 +312,7 @@ Span< const char > AssetString( const char * path ) {
 }
 
 Span< const u8 > AssetBinary( StringHash path ) {
-	return AssetString( path ).cast< const u8 >();
+	return GetAsset( path.hash, false ).cast< const u8 >();
 }
 
 Span< const u8 > AssetBinary( const char * path ) {
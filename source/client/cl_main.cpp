@@ -22,7 +22,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "client/client.h"
 #include "client/assets.h"
 #include "client/downloads.h"
-#include "client/threadpool.h"
+#include "qcommon/threadpool.h"
 #include "client/renderer/renderer.h"
 #include "qcommon/csprng.h"
 #include "qcommon/hash.h"
@@ -1593,8 +1593,6 @@ void CL_Init() {
 
 	cl_initialized = true;
 
-	InitThreadPool();
-
 	ThreadPoolDo( []( TempAllocator * temp, void * data ) {
 		InitAssets( temp );
 	} );
@@ -1682,8 +1680,6 @@ void CL_Shutdown() {
 
 	CL_ShutdownLocal();
 
-	ShutdownThreadPool();
-
 	Con_Shutdown();
 
 	ShutdownAssets();
@@ -13,21 +13,23 @@ constexpr u32 MAX_MAPS = 128;
 constexpr u32 MAX_MAP_MODELS = 1024;
 
 static Map maps[ MAX_MAPS ];
+static bool maps_loaded[ MAX_MAPS ];
 static u32 num_maps;
 static Hashtable< MAX_MAPS * 2 > maps_hashtable;
 
 static Hashtable< MAX_MAP_MODELS * 2 > map_models_hashtable;
 
-static void DeleteMap( Map * map ) {
-	FREE( sys_allocator, const_cast< char * >( map->name ) );
-	CM_Free( CM_Client, map->cms );
-	DeleteBSPRenderData( map );
+static void DeleteMap( u64 idx ) {
+	FREE( sys_allocator, const_cast< char * >( maps[ idx ].name ) );
+	if( maps_loaded[ idx ] ) {
+		if( maps[ idx ].cms != NULL ) {
+			CM_Free( CM_Client, maps[ idx ].cms );
+		}
+		DeleteBSPRenderData( &maps[ idx ] );
+	}
 }
 
-bool AddMap( Span< const u8 > data, const char * path ) {
-	ZoneScoped;
-	ZoneText( path, strlen( path ) );
-
+static u64 RegisterMap( const char * path ) {
 	u64 hash = Hash64( StripExtension( path ) );
 
 	u64 idx = num_maps;
@@ -36,25 +38,47 @@ bool AddMap( Span< const u8 > data, const char * path ) {
 		num_maps++;
 	}
 	else {
-		DeleteMap( &maps[ idx ] );
+		DeleteMap( idx );
 	}
 
+	maps[ idx ] = { };
 	maps[ idx ].name = CopyString( sys_allocator, path );
+	maps_loaded[ idx ] = false;
 
-	// TODO: need more map validation because they can be downloaded from the server
-	if( !LoadBSPRenderData( &maps[ idx ], hash, data ) ) {
-		return false;
-	}
+	return idx;
+}
+
+static bool LoadMap( u64 idx, Span< const u8 > data ) {
+	ZoneScoped;
+	ZoneText( maps[ idx ].name, strlen( maps[ idx ].name ) );
+
+	u64 hash = Hash64( StripExtension( maps[ idx ].name ) );
+	maps_loaded[ idx ] = true;
 
 	maps[ idx ].cms = CM_LoadMap( CM_Client, data, hash );
 	if( maps[ idx ].cms == NULL ) {
-		// TODO: free render data
+		return false;
+	}
+
+	// TODO: need more map validation because they can be downloaded from the server
+	if( !LoadBSPRenderData( &maps[ idx ], hash, data, maps[ idx ].cms->checksum ) ) {
+		CM_Free( CM_Client, maps[ idx ].cms );
+		maps[ idx ].cms = NULL;
 		return false;
 	}
 
 	return true;
 }
 
+static void FillMapModelsHashtable();
+
+bool AddMap( Span< const u8 > data, const char * path ) {
+	u64 idx = RegisterMap( path );
+	bool ok = LoadMap( idx, data );
+	FillMapModelsHashtable();
+	return ok;
+}
+
 static void FillMapModelsHashtable() {
 	map_models_hashtable.clear();
 
@@ -70,17 +94,19 @@ static void FillMapModelsHashtable() {
 	}
 }
 
+// maps are only indexed here and get loaded the first time FindMap asks for them
 void InitMaps() {
 	ZoneScoped;
 
 	num_maps = 0;
+	maps_hashtable.clear();
 
 	for( const char * path : AssetPaths() ) {
 		Span< const char > ext = FileExtension( path );
 		if( ext != ".bsp" )
 			continue;
 
-		AddMap( AssetBinary( path ), path );
+		RegisterMap( path );
 	}
 
 	FillMapModelsHashtable();
@@ -96,6 +122,10 @@ void HotloadMaps() {
 		if( ext != ".bsp" )
 			continue;
 
+		u64 idx;
+		if( maps_hashtable.get( Hash64( StripExtension( path ) ), &idx ) && !maps_loaded[ idx ] )
+			continue;
+
 		AddMap( AssetBinary( path ), path );
 		hotloaded_anything = true;
 	}
@@ -109,7 +139,7 @@ void HotloadMaps() {
 
 void ShutdownMaps() {
 	for( u32 i = 0; i < num_maps; i++ ) {
-		DeleteMap( &maps[ i ] );
+		DeleteMap( i );
 	}
 }
 
@@ -117,6 +147,12 @@ const Map * FindMap( StringHash name ) {
 	u64 idx;
 	if( !maps_hashtable.get( name.hash, &idx ) )
 		return NULL;
+
+	if( !maps_loaded[ idx ] ) {
+		LoadMap( idx, AssetBinary( maps[ idx ].name ) );
+		FillMapModelsHashtable();
+	}
+
 	return &maps[ idx ];
 }
 
@@ -7,8 +7,10 @@
 #include "qcommon/hashtable.h"
 #include "client/client.h"
 #include "client/assets.h"
+#include "client/asset_cache.h"
 #include "client/sound.h"
-#include "client/threadpool.h"
+#include "qcommon/threadpool.h"
+#include "qcommon/threads.h"
 #include "gameshared/gs_public.h"
 
 #define AL_LIBTYPE_STATIC
@@ -22,6 +24,13 @@
 struct Sound {
 	ALuint buf;
 	bool mono;
+
+	u32 num_samples;
+	u32 sample_rate;
+
+	// long sounds get decoded bit by bit by the stream thread instead
+	bool streamed;
+	Span< const u8 > ogg;
 };
 
 struct SoundEffect {
@@ -45,6 +54,19 @@ enum PlayingSoundType {
 	PlayingSoundType_Line, // play sound from closest point on a line
 };
 
+/*
+ * each section of a playing sound effect is a voice. only the most audible
+ * MAX_VOICES voices get an AL source, the rest are virtual and just keep
+ * time so they can pick up from the right place if they become audible
+ */
+struct Voice {
+	const Sound * sound;
+	s64 start_time;
+	ALuint source; // 0 while virtual
+	bool started;
+	bool stopped;
+};
+
 struct PlayingSound {
 	PlayingSoundType type;
 	const SoundEffect * sfx;
@@ -62,9 +84,7 @@ struct PlayingSound {
 	Vec3 origin;
 	Vec3 end;
 
-	ALuint sources[ ARRAY_COUNT( &SoundEffect::sounds ) ];
-	bool started[ ARRAY_COUNT( &SoundEffect::sounds ) ];
-	bool stopped[ ARRAY_COUNT( &SoundEffect::sounds ) ];
+	Voice voices[ ARRAY_COUNT( &SoundEffect::sounds ) ];
 };
 
 struct EntitySound {
@@ -86,6 +106,8 @@ static cvar_t * s_muteinbackground;
 constexpr u32 MAX_SOUND_ASSETS = 4096;
 constexpr u32 MAX_SOUND_EFFECTS = 4096;
 constexpr u32 MAX_PLAYING_SOUNDS = 256;
+constexpr u32 MAX_VOICES = 64;
+constexpr float MIN_AUDIBLE_GAIN = 0.001f;
 
 static Sound sounds[ MAX_SOUND_ASSETS ];
 static u32 num_sounds;
@@ -95,7 +117,7 @@ static SoundEffect sound_effects[ MAX_SOUND_EFFECTS ];
 static u32 num_sound_effects;
 static Hashtable< MAX_SOUND_EFFECTS * 2 > sound_effects_hashtable;
 
-static ALuint free_sound_sources[ MAX_PLAYING_SOUNDS ];
+static ALuint free_sound_sources[ MAX_VOICES ];
 static u32 num_free_sound_sources;
 
 static PlayingSound playing_sound_effects[ MAX_PLAYING_SOUNDS ];
@@ -106,6 +128,7 @@ static u64 immediate_sounds_autoinc;
 
 static ALuint music_source;
 static bool music_playing;
+static bool music_streamed;
 
 static EntitySound entities[ MAX_EDICTS ];
 
@@ -189,11 +212,6 @@ static void CheckedALSource( ALuint source, ALenum param, float x ) {
 	CheckALErrors( "alSourcef( {}, {}, {} )", source, param, x );
 }
 
-static void CheckedALSource( ALuint source, ALenum param, Vec3 v ) {
-	alSourcefv( source, param, v.ptr() );
-	CheckALErrors( "alSourcefv( {}, {}, {} )", source, param, v );
-}
-
 static void CheckedALSourcePlay( ALuint source ) {
 	alSourcePlay( source );
 	CheckALErrors( "alSourcePlay( {} )", source );
@@ -258,25 +276,465 @@ static bool S_InitAL() {
 	return true;
 }
 
+/*
+ * sounds longer than STREAM_MIN_SECONDS aren't decoded up front. they get
+ * decoded a few buffers at a time by the stream thread, which keeps the
+ * queues of the sources playing them topped up
+ *
+ * the stream thread makes its own AL calls, which is fine because OpenAL Soft
+ * is thread safe, but it doesn't check for errors because AL errors are per
+ * context and we would end up reporting errors made by the main thread
+ *
+ * the stream thread decodes without holding streams_mutex, and the decoder
+ * belongs to it until it's done. streams that get stopped in the meantime
+ * are left for the stream thread to close
+ */
+
+constexpr float STREAM_MIN_SECONDS = 10.0f;
+constexpr u32 MAX_STREAMS = 8;
+constexpr u32 STREAM_BUFFERS = 4;
+constexpr int STREAM_BUFFER_SAMPLES = 8192; // per channel, so ~0.75s queued at 44.1kHz
+
+struct SoundStream {
+	ALuint source;
+	ALuint buffers[ STREAM_BUFFERS ];
+
+	// our own copy of the ogg so hotloading can't free it out from under us
+	u8 * ogg;
+	stb_vorbis * decoder;
+	int channels;
+	int sample_rate;
+	bool looping;
+	bool finished;
+
+	bool decoding;
+	bool stopped;
+};
+
+static SoundStream streams[ MAX_STREAMS ];
+static Mutex * streams_mutex;
+static Semaphore * streams_sem; // wakes the stream thread when it has nothing to stream
+static Thread * stream_thread;
+static bool stream_thread_quit;
+
+// only touched by the stream thread
+static s16 stream_staging[ STREAM_BUFFERS ][ STREAM_BUFFER_SAMPLES * 2 ];
+
+// returns the number of samples per channel written to samples
+static int DecodeStreamBuffer( SoundStream * stream, s16 * samples, bool * finished ) {
+	ZoneScoped;
+
+	int n = 0;
+	bool rewound = false;
+
+	while( n < STREAM_BUFFER_SAMPLES && !*finished ) {
+		int decoded = stb_vorbis_get_samples_short_interleaved( stream->decoder, stream->channels, samples + n * stream->channels, ( STREAM_BUFFER_SAMPLES - n ) * stream->channels );
+		if( decoded == 0 ) {
+			// don't spin forever on looping sounds that decode to nothing
+			if( !stream->looping || rewound ) {
+				*finished = true;
+			}
+			else {
+				stb_vorbis_seek_start( stream->decoder );
+				rewound = true;
+			}
+			continue;
+		}
+
+		rewound = false;
+		n += decoded;
+	}
+
+	return n;
+}
+
+static void UploadStreamBuffer( const SoundStream * stream, ALuint buf, const s16 * samples, int n ) {
+	ALenum format = stream->channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+	alBufferData( buf, format, samples, n * stream->channels * sizeof( s16 ), stream->sample_rate );
+}
+
+static void CloseStream( SoundStream * stream ) {
+	stb_vorbis_close( stream->decoder );
+	FREE( sys_allocator, stream->ogg );
+	stream->decoder = NULL;
+	stream->ogg = NULL;
+	stream->stopped = false;
+}
+
+static void RefillStream( SoundStream * stream ) {
+	Lock( streams_mutex );
+
+	if( stream->decoder == NULL || stream->stopped ) {
+		Unlock( streams_mutex );
+		return;
+	}
+
+	ALint processed;
+	alGetSourcei( stream->source, AL_BUFFERS_PROCESSED, &processed );
+	processed = Min2( processed, ALint( STREAM_BUFFERS ) );
+
+	bool finished = stream->finished;
+	stream->decoding = true;
+
+	Unlock( streams_mutex );
+
+	int staged[ STREAM_BUFFERS ];
+	int num_staged = 0;
+	for( ALint i = 0; i < processed; i++ ) {
+		int n = DecodeStreamBuffer( stream, stream_staging[ i ], &finished );
+		if( n == 0 )
+			break;
+		staged[ num_staged ] = n;
+		num_staged++;
+	}
+
+	Lock( streams_mutex );
+	defer { Unlock( streams_mutex ); };
+
+	stream->decoding = false;
+
+	if( stream->stopped ) {
+		CloseStream( stream );
+		return;
+	}
+
+	stream->finished = finished;
+
+	for( ALint i = 0; i < processed; i++ ) {
+		ALuint buf;
+		alSourceUnqueueBuffers( stream->source, 1, &buf );
+		if( i < num_staged ) {
+			UploadStreamBuffer( stream, buf, stream_staging[ i ], staged[ i ] );
+			alSourceQueueBuffers( stream->source, 1, &buf );
+		}
+	}
+
+	// if we fell behind and the source ran dry it stops, so kick it again
+	ALint state, queued;
+	alGetSourcei( stream->source, AL_SOURCE_STATE, &state );
+	alGetSourcei( stream->source, AL_BUFFERS_QUEUED, &queued );
+	if( state == AL_STOPPED && queued > 0 ) {
+		alSourcePlay( stream->source );
+	}
+}
+
+static void StreamThread( void * data ) {
+#if TRACY_ENABLE
+	tracy::SetThreadName( "Sound streaming" );
+#endif
+
+	while( true ) {
+		Lock( streams_mutex );
+
+		bool quit = stream_thread_quit;
+		bool streaming = false;
+		for( const SoundStream & stream : streams ) {
+			streaming = streaming || stream.decoder != NULL;
+		}
+
+		Unlock( streams_mutex );
+
+		if( quit )
+			break;
+
+		if( !streaming ) {
+			Wait( streams_sem );
+			continue;
+		}
+
+		for( SoundStream & stream : streams ) {
+			RefillStream( &stream );
+		}
+
+		Sys_Sleep( 20 );
+	}
+}
+
+static SoundStream * FindStream( ALuint source ) {
+	for( SoundStream & stream : streams ) {
+		if( stream.decoder != NULL && !stream.stopped && stream.source == source ) {
+			return &stream;
+		}
+	}
+	return NULL;
+}
+
+static bool InitStreams() {
+	ZoneScoped;
+
+	for( SoundStream & stream : streams ) {
+		stream = { };
+		alGenBuffers( ARRAY_COUNT( stream.buffers ), stream.buffers );
+	}
+
+	if( alGetError() != AL_NO_ERROR ) {
+		Com_Printf( S_COLOR_RED "Failed to allocate streaming buffers\n" );
+		return false;
+	}
+
+	streams_mutex = NewMutex();
+	streams_sem = NewSemaphore();
+	stream_thread_quit = false;
+	stream_thread = NewThread( StreamThread );
+
+	return true;
+}
+
+static void ShutdownStreams() {
+	Lock( streams_mutex );
+	stream_thread_quit = true;
+	Unlock( streams_mutex );
+
+	Signal( streams_sem );
+	JoinThread( stream_thread );
+	DeleteSemaphore( streams_sem );
+	DeleteMutex( streams_mutex );
+
+	for( SoundStream & stream : streams ) {
+		if( stream.decoder != NULL ) {
+			CheckedALSourceStop( stream.source );
+			CheckedALSource( stream.source, AL_BUFFER, 0 );
+			CloseStream( &stream );
+		}
+		alDeleteBuffers( ARRAY_COUNT( stream.buffers ), stream.buffers );
+	}
+}
+
+// queues up the first few buffers, the caller still has to play the source
+static bool StartStream( ALuint source, const Sound & sound, bool looping, u32 offset ) {
+	ZoneScoped;
+
+	Lock( streams_mutex );
+	defer { Unlock( streams_mutex ); };
+
+	SoundStream * stream = NULL;
+	for( SoundStream & s : streams ) {
+		if( s.decoder == NULL ) {
+			stream = &s;
+			break;
+		}
+	}
+
+	if( stream == NULL ) {
+		Com_Printf( S_COLOR_YELLOW "Too many streaming sounds!\n" );
+		return false;
+	}
+
+	stream->ogg = ALLOC_MANY( sys_allocator, u8, sound.ogg.n );
+	memcpy( stream->ogg, sound.ogg.ptr, sound.ogg.n );
+
+	int error;
+	stream->decoder = stb_vorbis_open_memory( stream->ogg, sound.ogg.num_bytes(), &error, NULL );
+	if( stream->decoder == NULL ) {
+		FREE( sys_allocator, stream->ogg );
+		stream->ogg = NULL;
+		return false;
+	}
+
+	stb_vorbis_info info = stb_vorbis_get_info( stream->decoder );
+	stream->source = source;
+	stream->channels = Min2( info.channels, 2 );
+	stream->sample_rate = info.sample_rate;
+	stream->looping = looping;
+	stream->finished = false;
+
+	if( offset > 0 ) {
+		stb_vorbis_seek( stream->decoder, offset );
+	}
+
+	CheckedALSource( source, AL_BUFFER, 0 );
+	CheckedALSource( source, AL_LOOPING, AL_FALSE );
+
+	// sources come back from the pool stopped, and every buffer queued on a
+	// stopped source counts as processed. the stream thread would try to
+	// refill them before the caller gets around to playing it
+	alSourceRewind( source );
+	CheckALErrors( "alSourceRewind( {} )", source );
+
+	for( ALuint buf : stream->buffers ) {
+		s16 samples[ STREAM_BUFFER_SAMPLES * 2 ];
+		int n = DecodeStreamBuffer( stream, samples, &stream->finished );
+		if( n == 0 )
+			break;
+		UploadStreamBuffer( stream, buf, samples, n );
+		alSourceQueueBuffers( source, 1, &buf );
+		CheckALErrors( "alSourceQueueBuffers( {} )", source );
+	}
+
+	Signal( streams_sem );
+
+	return true;
+}
+
+static void StopSource( ALuint source, bool streamed ) {
+	if( !streamed ) {
+		CheckedALSourceStop( source );
+		CheckedALSource( source, AL_BUFFER, 0 );
+		return;
+	}
+
+	Lock( streams_mutex );
+	defer { Unlock( streams_mutex ); };
+
+	CheckedALSourceStop( source );
+	CheckedALSource( source, AL_BUFFER, 0 );
+
+	SoundStream * stream = FindStream( source );
+	if( stream != NULL ) {
+		if( stream->decoding ) {
+			stream->stopped = true;
+		}
+		else {
+			CloseStream( stream );
+		}
+	}
+}
+
+static bool SourceStopped( ALuint source, bool streamed ) {
+	ALint state = CheckedALGetSource( source, AL_SOURCE_STATE );
+	if( state != AL_STOPPED || !streamed )
+		return state == AL_STOPPED;
+
+	// streams that run dry get restarted, so they're only done once the decoder is
+	Lock( streams_mutex );
+	defer { Unlock( streams_mutex ); };
+
+	const SoundStream * stream = FindStream( source );
+	return stream == NULL || stream->finished;
+}
+
+/*
+ * shorter sounds get decoded in full, and the decoded PCM is cached on disk
+ */
+
+// bump this when the cached PCM format changes
+static constexpr u32 SOUND_CACHE_VERSION = 1;
+
+struct SoundCacheHeader {
+	u32 channels;
+	u32 sample_rate;
+	u32 num_samples;
+};
+
 struct DecodeSoundJob {
 	struct {
 		const char * path;
-		Span< const u8 > ogg;
+		Span< const u8 > ogg; // filled in by DecodeSound so the file gets loaded on the thread pool
 	} in;
 
 	struct {
+		bool ok;
+		bool streamed;
 		int channels;
 		int sample_rate;
 		int num_samples;
-		s16 * samples;
+		const s16 * samples;
+
+		// at most one of these owns samples, streamed sounds don't have any
+		u8 * decoded;
+		AssetCacheEntry cache_entry;
 	} out;
 };
 
-static void AddSound( const char * path, int num_samples, int channels, int sample_rate, s16 * samples ) {
+static bool LoadCachedSound( TempAllocator * temp, DecodeSoundJob * job, u64 key ) {
+	AssetCacheEntry entry;
+	if( !MapAssetCacheEntry( temp, &entry, "sounds", SOUND_CACHE_VERSION, key ) )
+		return false;
+
+	SoundCacheHeader header;
+	bool ok = entry.data.n >= sizeof( header );
+	if( ok ) {
+		memcpy( &header, entry.data.ptr, sizeof( header ) );
+		ok = ( header.channels == 1 || header.channels == 2 )
+			&& entry.data.n - sizeof( header ) == size_t( header.num_samples ) * header.channels * sizeof( s16 );
+	}
+
+	if( !ok ) {
+		UnmapAssetCacheEntry( &entry );
+		return false;
+	}
+
+	job->out.ok = true;
+	job->out.channels = header.channels;
+	job->out.sample_rate = header.sample_rate;
+	job->out.num_samples = header.num_samples;
+	job->out.samples = ( const s16 * ) ( entry.data.ptr + sizeof( header ) );
+	job->out.cache_entry = entry;
+
+	return true;
+}
+
+// runs on the thread pool
+static void DecodeSound( TempAllocator * temp, void * data ) {
+	ZoneScoped;
+
+	DecodeSoundJob * job = ( DecodeSoundJob * ) data;
+	ZoneText( job->in.path, strlen( job->in.path ) );
+
+	job->out = { };
+
+	job->in.ogg = AssetBinary( job->in.path );
+	u64 key = Hash64( job->in.ogg );
+	if( LoadCachedSound( temp, job, key ) )
+		return;
+
+	int error;
+	stb_vorbis * decoder = stb_vorbis_open_memory( job->in.ogg.ptr, job->in.ogg.num_bytes(), &error, NULL );
+	if( decoder == NULL )
+		return;
+	defer { stb_vorbis_close( decoder ); };
+
+	stb_vorbis_info info = stb_vorbis_get_info( decoder );
+	u32 length = stb_vorbis_stream_length_in_samples( decoder );
+
+	job->out.channels = Min2( info.channels, 2 );
+	job->out.sample_rate = info.sample_rate;
+
+	if( length >= STREAM_MIN_SECONDS * info.sample_rate ) {
+		job->out.ok = true;
+		job->out.streamed = true;
+		job->out.num_samples = length;
+		return;
+	}
+
+	// store the header in front of the samples so we can write it straight to the cache
+	size_t samples_size = size_t( length ) * job->out.channels * sizeof( s16 );
+	u8 * decoded = ALLOC_MANY( sys_allocator, u8, sizeof( SoundCacheHeader ) + samples_size );
+	s16 * samples = ( s16 * ) ( decoded + sizeof( SoundCacheHeader ) );
+
+	int num_samples;
+	{
+		ZoneScopedN( "stb_vorbis_get_samples_short_interleaved" );
+		num_samples = stb_vorbis_get_samples_short_interleaved( decoder, job->out.channels, samples, length * job->out.channels );
+	}
+
+	SoundCacheHeader header;
+	header.channels = job->out.channels;
+	header.sample_rate = job->out.sample_rate;
+	header.num_samples = num_samples;
+	memcpy( decoded, &header, sizeof( header ) );
+
+	size_t size = sizeof( header ) + size_t( num_samples ) * job->out.channels * sizeof( s16 );
+	WriteAssetCacheEntry( temp, "sounds", SOUND_CACHE_VERSION, key, Span< const u8 >( decoded, size ) );
+
+	job->out.ok = true;
+	job->out.num_samples = num_samples;
+	job->out.samples = samples;
+	job->out.decoded = decoded;
+}
+
+static void AddSound( DecodeSoundJob * job ) {
 	ZoneScoped;
+
+	const char * path = job->in.path;
 	ZoneText( path, strlen( path ) );
 
-	if( num_samples == -1 ) {
+	defer {
+		FREE( sys_allocator, job->out.decoded );
+		UnmapAssetCacheEntry( &job->out.cache_entry );
+	};
+
+	if( !job->out.ok ) {
 		Com_Printf( S_COLOR_RED "Couldn't decode sound %s\n", path );
 		return;
 	}
@@ -308,57 +766,70 @@ static void AddSound( const char * path, int num_samples, int channels, int samp
 	else {
 		restart_music = music_playing;
 		S_StopAllSounds( true );
-		alDeleteBuffers( 1, &sounds[ idx ].buf );
+		if( !sounds[ idx ].streamed ) {
+			alDeleteBuffers( 1, &sounds[ idx ].buf );
+		}
 	}
 
-	ALenum format = channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
-	alGenBuffers( 1, &sounds[ idx ].buf );
-	alBufferData( sounds[ idx ].buf, format, samples, num_samples * channels * sizeof( s16 ), sample_rate );
-	CheckALErrors( "AddSound" );
+	Sound * sound = &sounds[ idx ];
+	*sound = { };
+	sound->mono = job->out.channels == 1;
+	sound->num_samples = job->out.num_samples;
+	sound->sample_rate = job->out.sample_rate;
+	sound->streamed = job->out.streamed;
 
-	sounds[ idx ].mono = channels == 1;
+	if( sound->streamed ) {
+		sound->ogg = job->in.ogg;
+	}
+	else {
+		ALenum format = job->out.channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+		alGenBuffers( 1, &sound->buf );
+		alBufferData( sound->buf, format, job->out.samples, job->out.num_samples * job->out.channels * sizeof( s16 ), job->out.sample_rate );
+		CheckALErrors( "AddSound" );
+	}
 
 	if( restart_music ) {
 		S_StartMenuMusic();
 	}
-
-	free( samples );
 }
 
 static void LoadSounds() {
 	ZoneScoped;
 
+	u64 start = Sys_Microseconds();
+
 	DynamicArray< DecodeSoundJob > jobs( sys_allocator );
 	{
 		ZoneScopedN( "Build job list" );
 
 		for( const char * path : AssetPaths() ) {
 			if( FileExtension( path ) == ".ogg" ) {
-				DecodeSoundJob job;
+				DecodeSoundJob job = { };
 				job.in.path = path;
-				job.in.ogg = AssetBinary( path );
 
 				jobs.add( job );
 			}
 		}
-
-		std::sort( jobs.begin(), jobs.end(), []( const DecodeSoundJob & a, const DecodeSoundJob & b ) {
-			return a.in.ogg.n > b.in.ogg.n;
-		} );
 	}
 
-	ParallelFor( jobs.span(), []( TempAllocator * temp, void * data ) {
-		DecodeSoundJob * job = ( DecodeSoundJob * ) data;
-
-		ZoneScopedN( "stb_vorbis_decode_memory" );
-		ZoneText( job->in.path, strlen( job->in.path ) );
+	ParallelFor( jobs.span(), DecodeSound );
 
-		job->out.num_samples = stb_vorbis_decode_memory( job->in.ogg.ptr, job->in.ogg.num_bytes(), &job->out.channels, &job->out.sample_rate, &job->out.samples );
-	} );
+	u32 num_cached = 0;
+	u32 num_streamed = 0;
+	size_t pcm_bytes = 0;
+	for( DecodeSoundJob & job : jobs ) {
+		if( job.out.cache_entry.mapped.ptr != NULL )
+			num_cached++;
+		if( job.out.streamed )
+			num_streamed++;
+		else if( job.out.ok )
+			pcm_bytes += size_t( job.out.num_samples ) * job.out.channels * sizeof( s16 );
 
-	for( DecodeSoundJob job : jobs ) {
-		AddSound( job.in.path, job.out.num_samples, job.out.channels, job.out.sample_rate, job.out.samples );
+		AddSound( &job );
 	}
+
+	Com_Printf( "Loaded %u sounds (%u from cache, %u streamed) in %.2fms, %.1fMB of PCM\n",
+		u32( jobs.size() ), num_cached, num_streamed, ( Sys_Microseconds() - start ) / 1000.0, pcm_bytes / 1024.0 / 1024.0 );
 }
 
 static void HotloadSounds() {
@@ -366,17 +837,12 @@ static void HotloadSounds() {
 
 	for( const char * path : ModifiedAssetPaths() ) {
 		if( FileExtension( path ) == ".ogg" ) {
-			Span< const u8 > ogg = AssetBinary( path );
-
-			int num_samples, channels, sample_rate;
-			s16 * samples;
-			{
-				ZoneScopedN( "stb_vorbis_decode_memory" );
-				ZoneText( path, strlen( path ) );
-				num_samples = stb_vorbis_decode_memory( ogg.ptr, ogg.num_bytes(), &channels, &sample_rate, &samples );
-			}
+			DecodeSoundJob job = { };
+			job.in.path = path;
 
-			AddSound( path, num_samples, channels, sample_rate, samples );
+			TempAllocator temp = cls.frame_arena.temp();
+			DecodeSound( &temp, &job );
+			AddSound( &job );
 		}
 	}
 }
@@ -548,6 +1014,11 @@ bool S_Init() {
 	if( !S_InitAL() )
 		return false;
 
+	if( !InitStreams() ) {
+		S_Shutdown();
+		return false;
+	}
+
 	LoadSounds();
 	LoadSoundEffects();
 
@@ -561,12 +1032,15 @@ void S_Shutdown() {
 		return;
 
 	S_StopAllSounds( true );
+	ShutdownStreams();
 
 	alDeleteSources( ARRAY_COUNT( free_sound_sources ), free_sound_sources );
 	alDeleteSources( 1, &music_source );
 
 	for( u32 i = 0; i < num_sounds; i++ ) {
-		alDeleteBuffers( 1, &sounds[ i ].buf );
+		if( !sounds[ i ].streamed ) {
+			alDeleteBuffers( 1, &sounds[ i ].buf );
+		}
 	}
 
 	CheckALErrors( "S_Shutdown" );
@@ -579,12 +1053,11 @@ const char * GetAudioDevicesAsSequentialStrings() {
 	return alcGetString( NULL, ALC_ALL_DEVICES_SPECIFIER );
 }
 
-static bool FindSound( StringHash name, Sound * sound ) {
+static const Sound * FindSound( StringHash name ) {
 	u64 idx;
 	if( !initialized || !sounds_hashtable.get( name.hash, &idx ) )
-		return false;
-	*sound = sounds[ idx ];
-	return true;
+		return NULL;
+	return &sounds[ idx ];
 }
 
 static const SoundEffect * FindSoundEffect( StringHash name ) {
@@ -594,6 +1067,58 @@ static const SoundEffect * FindSoundEffect( StringHash name ) {
 	return &sound_effects[ idx ];
 }
 
+static bool VoiceLooping( const PlayingSound * ps ) {
+	return ps->immediate_handle.x != 0;
+}
+
+static Vec3 VoicePosition( const PlayingSound * ps, Vec3 listener ) {
+	switch( ps->type ) {
+		case PlayingSoundType_Global:
+			return listener;
+		case PlayingSoundType_Position:
+			return ps->origin;
+		case PlayingSoundType_Entity:
+			return entities[ ps->ent_num ].origin;
+		case PlayingSoundType_Line:
+			return ClosestPointOnSegment( ps->origin, ps->end, listener );
+	}
+
+	return listener;
+}
+
+// matches AL_INVERSE_DISTANCE_CLAMPED
+static float VoiceGain( const PlayingSound * ps, u8 i, Vec3 listener ) {
+	const SoundEffect::PlaybackConfig * config = &ps->sfx->sounds[ i ];
+
+	float ref = S_DEFAULT_ATTENUATION_REFDISTANCE;
+	float distance = Clamp( ref, Length( VoicePosition( ps, listener ) - listener ), S_DEFAULT_ATTENUATION_MAXDISTANCE );
+	float attenuation = ref / ( ref + config->attenuation * ( distance - ref ) );
+
+	return ps->volume * config->volume * attenuation;
+}
+
+static u32 VoiceSampleOffset( const PlayingSound * ps, const Voice * voice ) {
+	const Sound * sound = voice->sound;
+	if( sound->num_samples == 0 )
+		return 0;
+
+	u64 offset = u64( cls.monotonicTime - voice->start_time ) * sound->sample_rate / 1000;
+	if( VoiceLooping( ps ) )
+		return offset % sound->num_samples;
+	return Min2( offset, u64( sound->num_samples ) );
+}
+
+static bool VoiceFinished( const PlayingSound * ps, const Voice * voice ) {
+	if( VoiceLooping( ps ) )
+		return false;
+
+	// don't bother asking AL about sounds that can't have finished yet
+	if( VoiceSampleOffset( ps, voice ) < voice->sound->num_samples )
+		return false;
+
+	return voice->source == 0 || SourceStopped( voice->source, voice->sound->streamed );
+}
+
 static bool StartSound( PlayingSound * ps, u8 i ) {
 	SoundEffect::PlaybackConfig config = ps->sfx->sounds[ i ];
 
@@ -606,68 +1131,178 @@ static bool StartSound( PlayingSound * ps, u8 i ) {
 		idx = RandomUniform( &rng, 0, config.num_random_sounds );
 	}
 
-	Sound sound;
-	if( !FindSound( config.sounds[ idx ], &sound ) )
+	const Sound * sound = FindSound( config.sounds[ idx ] );
+	if( sound == NULL )
 		return false;
 
-	if( num_free_sound_sources == 0 ) {
-		Com_Printf( S_COLOR_YELLOW "Too many playing sounds!\n" );
+	if( !sound->mono && ps->type != PlayingSoundType_Global ) {
+		Com_Printf( S_COLOR_YELLOW "Positioned sounds must be mono!\n" );
 		return false;
 	}
 
-	if( !sound.mono && ps->type != PlayingSoundType_Global ) {
-		Com_Printf( S_COLOR_YELLOW "Positioned sounds must be mono!\n" );
+	// UpdateVoices decides whether it gets a source
+	ps->voices[ i ].sound = sound;
+	ps->voices[ i ].start_time = cls.monotonicTime;
+
+	return true;
+}
+
+// AL errors from here get picked up by the check at the end of S_Update
+static bool MakeVoiceReal( PlayingSound * ps, u8 i ) {
+	Voice * voice = &ps->voices[ i ];
+	const Sound * sound = voice->sound;
+	const SoundEffect::PlaybackConfig * config = &ps->sfx->sounds[ i ];
+
+	if( num_free_sound_sources == 0 )
 		return false;
-	}
+
+	bool looping = VoiceLooping( ps );
+	u32 offset = VoiceSampleOffset( ps, voice );
 
 	num_free_sound_sources--;
 	ALuint source = free_sound_sources[ num_free_sound_sources ];
-	ps->sources[ i ] = source;
 
-	CheckedALSource( source, AL_BUFFER, sound.buf );
-	CheckedALSource( source, AL_GAIN, ps->volume * config.volume * s_volume->value );
-	CheckedALSource( source, AL_REFERENCE_DISTANCE, S_DEFAULT_ATTENUATION_REFDISTANCE );
-	CheckedALSource( source, AL_MAX_DISTANCE, S_DEFAULT_ATTENUATION_MAXDISTANCE );
-	CheckedALSource( source, AL_ROLLOFF_FACTOR, config.attenuation );
+	if( sound->streamed ) {
+		if( !StartStream( source, *sound, looping, offset ) ) {
+			num_free_sound_sources++;
+			return false;
+		}
+	}
+	else {
+		alSourcei( source, AL_BUFFER, sound->buf );
+		alSourcei( source, AL_SAMPLE_OFFSET, offset );
+	}
+
+	voice->source = source;
+
+	alSourcef( source, AL_GAIN, ps->volume * config->volume * s_volume->value );
+	alSourcef( source, AL_REFERENCE_DISTANCE, S_DEFAULT_ATTENUATION_REFDISTANCE );
+	alSourcef( source, AL_MAX_DISTANCE, S_DEFAULT_ATTENUATION_MAXDISTANCE );
+	alSourcef( source, AL_ROLLOFF_FACTOR, config->attenuation );
 
+	Vec3 zero = Vec3( 0.0f );
 	switch( ps->type ) {
 		case PlayingSoundType_Global:
-			CheckedALSource( source, AL_POSITION, Vec3( 0.0f ) );
-			CheckedALSource( source, AL_VELOCITY, Vec3( 0.0f ) );
-			CheckedALSource( source, AL_SOURCE_RELATIVE, AL_TRUE );
+			alSourcefv( source, AL_POSITION, zero.ptr() );
+			alSourcefv( source, AL_VELOCITY, zero.ptr() );
+			alSourcei( source, AL_SOURCE_RELATIVE, AL_TRUE );
 			break;
 
 		case PlayingSoundType_Position:
-			CheckedALSource( source, AL_POSITION, ps->origin );
-			CheckedALSource( source, AL_VELOCITY, Vec3( 0.0f ) );
-			CheckedALSource( source, AL_SOURCE_RELATIVE, AL_FALSE );
+			alSourcefv( source, AL_POSITION, ps->origin.ptr() );
+			alSourcefv( source, AL_VELOCITY, zero.ptr() );
+			alSourcei( source, AL_SOURCE_RELATIVE, AL_FALSE );
 			break;
 
 		case PlayingSoundType_Entity:
-			CheckedALSource( source, AL_POSITION, entities[ ps->ent_num ].origin );
-			CheckedALSource( source, AL_VELOCITY, entities[ ps->ent_num ].velocity );
-			CheckedALSource( source, AL_SOURCE_RELATIVE, AL_FALSE );
+			alSourcefv( source, AL_POSITION, entities[ ps->ent_num ].origin.ptr() );
+			alSourcefv( source, AL_VELOCITY, entities[ ps->ent_num ].velocity.ptr() );
+			alSourcei( source, AL_SOURCE_RELATIVE, AL_FALSE );
 			break;
 
 		case PlayingSoundType_Line:
-			CheckedALSource( source, AL_POSITION, ps->origin );
-			CheckedALSource( source, AL_VELOCITY, Vec3( 0.0f ) ); // TODO
-			CheckedALSource( source, AL_SOURCE_RELATIVE, AL_FALSE );
+			alSourcefv( source, AL_POSITION, ps->origin.ptr() );
+			alSourcefv( source, AL_VELOCITY, zero.ptr() ); // TODO
+			alSourcei( source, AL_SOURCE_RELATIVE, AL_FALSE );
 			break;
 	}
 
-	CheckedALSource( source, AL_LOOPING, ps->immediate_handle.x == 0 ? AL_FALSE : AL_TRUE );
-	CheckedALSourcePlay( source );
+	// streams do their own looping
+	alSourcei( source, AL_LOOPING, looping && !sound->streamed ? AL_TRUE : AL_FALSE );
+	alSourcePlay( source );
 
 	return true;
 }
 
-static void StopSound( PlayingSound * ps, u8 i ) {
-	CheckedALSourceStop( ps->sources[ i ] );
-	CheckedALSource( ps->sources[ i ], AL_BUFFER, 0 );
-	free_sound_sources[ num_free_sound_sources ] = ps->sources[ i ];
+static void MakeVoiceVirtual( PlayingSound * ps, u8 i ) {
+	Voice * voice = &ps->voices[ i ];
+	if( voice->source == 0 )
+		return;
+
+	StopSource( voice->source, voice->sound->streamed );
+	free_sound_sources[ num_free_sound_sources ] = voice->source;
 	num_free_sound_sources++;
-	ps->stopped[ i ] = true;
+	voice->source = 0;
+}
+
+static void StopSound( PlayingSound * ps, u8 i ) {
+	MakeVoiceVirtual( ps, i );
+	ps->voices[ i ].stopped = true;
+}
+
+struct VoiceCandidate {
+	float gain;
+	u32 playing_sound;
+	u8 voice;
+};
+
+static VoiceCandidate voice_candidates[ MAX_PLAYING_SOUNDS * ARRAY_COUNT( &SoundEffect::sounds ) ];
+
+/*
+ * give sources to the MAX_VOICES loudest voices and take them away from
+ * everything else, then update the positions of the real ones
+ */
+static void UpdateVoices( Vec3 listener ) {
+	ZoneScoped;
+
+	u32 num_candidates = 0;
+	for( u32 i = 0; i < num_playing_sound_effects; i++ ) {
+		PlayingSound * ps = &playing_sound_effects[ i ];
+		for( u8 j = 0; j < ps->sfx->num_sounds; j++ ) {
+			if( !ps->voices[ j ].started || ps->voices[ j ].stopped )
+				continue;
+
+			VoiceCandidate * candidate = &voice_candidates[ num_candidates ];
+			candidate->gain = VoiceGain( ps, j, listener );
+			candidate->playing_sound = i;
+			candidate->voice = j;
+			num_candidates++;
+		}
+	}
+
+	std::sort( voice_candidates, voice_candidates + num_candidates, []( const VoiceCandidate & a, const VoiceCandidate & b ) {
+		return a.gain > b.gain;
+	} );
+
+	u32 num_real = 0;
+	while( num_real < Min2( num_candidates, MAX_VOICES ) && voice_candidates[ num_real ].gain >= MIN_AUDIBLE_GAIN ) {
+		num_real++;
+	}
+
+	// free sources up before handing them out
+	for( u32 i = num_real; i < num_candidates; i++ ) {
+		MakeVoiceVirtual( &playing_sound_effects[ voice_candidates[ i ].playing_sound ], voice_candidates[ i ].voice );
+	}
+
+	for( u32 i = 0; i < num_real; i++ ) {
+		PlayingSound * ps = &playing_sound_effects[ voice_candidates[ i ].playing_sound ];
+		u8 j = voice_candidates[ i ].voice;
+		Voice * voice = &ps->voices[ j ];
+
+		if( voice->source == 0 ) {
+			MakeVoiceReal( ps, j );
+			continue;
+		}
+
+		if( s_volume->modified ) {
+			alSourcef( voice->source, AL_GAIN, ps->volume * ps->sfx->sounds[ j ].volume * s_volume->value );
+		}
+
+		if( ps->type == PlayingSoundType_Entity ) {
+			alSourcefv( voice->source, AL_POSITION, entities[ ps->ent_num ].origin.ptr() );
+			alSourcefv( voice->source, AL_VELOCITY, entities[ ps->ent_num ].velocity.ptr() );
+		}
+		else if( ps->type == PlayingSoundType_Position ) {
+			alSourcefv( voice->source, AL_POSITION, ps->origin.ptr() );
+		}
+		else if( ps->type == PlayingSoundType_Line ) {
+			Vec3 p = ClosestPointOnSegment( ps->origin, ps->end, listener );
+			alSourcefv( voice->source, AL_POSITION, p.ptr() );
+		}
+	}
+
+	TracyPlot( "Real voices", s64( MAX_VOICES - num_free_sound_sources ) );
+	TracyPlot( "Virtual voices", s64( num_candidates - ( MAX_VOICES - num_free_sound_sources ) ) );
 }
 
 void S_Update( Vec3 origin, Vec3 velocity, const mat3_t axis ) {
@@ -700,12 +1335,13 @@ void S_Update( Vec3 origin, Vec3 velocity, const mat3_t axis ) {
 		ps->touched_since_last_update = false;
 
 		for( u8 j = 0; j < ps->sfx->num_sounds; j++ ) {
-			if( ps->started[ j ] ) {
-				if( ps->stopped[ j ] )
+			Voice * voice = &ps->voices[ j ];
+
+			if( voice->started ) {
+				if( voice->stopped )
 					continue;
 
-				ALint state = CheckedALGetSource( ps->sources[ j ], AL_SOURCE_STATE );
-				if( not_touched || state == AL_STOPPED ) {
+				if( not_touched || VoiceFinished( ps, voice ) ) {
 					StopSound( ps, j );
 				}
 				else {
@@ -717,9 +1353,9 @@ void S_Update( Vec3 origin, Vec3 velocity, const mat3_t axis ) {
 			all_stopped = false;
 
 			if( t >= ps->sfx->sounds[ j ].delay ) {
-				ps->started[ j ] = true;
+				voice->started = true;
 				if( !StartSound( ps, j ) ) {
-					ps->stopped[ j ] = true;
+					voice->stopped = true;
 				}
 			}
 		}
@@ -744,35 +1380,18 @@ void S_Update( Vec3 origin, Vec3 velocity, const mat3_t axis ) {
 			i--;
 			continue;
 		}
-
-		for( u8 j = 0; j < ps->sfx->num_sounds; j++ ) {
-			if( !ps->started[ j ] || ps->stopped[ j ] )
-				continue;
-
-			if( s_volume->modified ) {
-				CheckedALSource( ps->sources[ j ], AL_GAIN, ps->volume * ps->sfx->sounds[ j ].volume * s_volume->value );
-			}
-
-			if( ps->type == PlayingSoundType_Entity ) {
-				CheckedALSource( ps->sources[ j ], AL_POSITION, entities[ ps->ent_num ].origin );
-				CheckedALSource( ps->sources[ j ], AL_VELOCITY, entities[ ps->ent_num ].velocity );
-			}
-			else if( ps->type == PlayingSoundType_Position ) {
-				CheckedALSource( ps->sources[ j ], AL_POSITION, ps->origin );
-			}
-			else if( ps->type == PlayingSoundType_Line ) {
-				Vec3 p = ClosestPointOnSegment( ps->origin, ps->end, origin );
-				CheckedALSource( ps->sources[ j ], AL_POSITION, p );
-			}
-		}
 	}
 
+	UpdateVoices( origin );
+
 	if( ( s_volume->modified || s_musicvolume->modified ) && music_playing ) {
 		CheckedALSource( music_source, AL_GAIN, s_volume->value * s_musicvolume->value * MusicIsWayTooLoud );
 	}
 
 	s_volume->modified = false;
 	s_musicvolume->modified = false;
+
+	CheckALErrors( "S_Update" );
 }
 
 void S_UpdateEntity( int ent_num, Vec3 origin, Vec3 velocity ) {
@@ -789,7 +1408,7 @@ static PlayingSound * FindEmptyPlayingSound( int ent_num, int channel ) {
 			PlayingSound * ps = &playing_sound_effects[ i ];
 			if( ps->ent_num == ent_num && ps->channel == channel ) {
 				for( u8 j = 0; j < ps->sfx->num_sounds; j++ ) {
-					if( ps->started[ j ] && !ps->stopped[ j ] ) {
+					if( ps->voices[ j ].started && !ps->voices[ j ].stopped ) {
 						StopSound( ps, j );
 					}
 				}
@@ -945,7 +1564,7 @@ void S_StopAllSounds( bool stop_music ) {
 	for( u32 i = 0; i < num_playing_sound_effects; i++ ) {
 		PlayingSound * ps = &playing_sound_effects[ i ];
 		for( u8 j = 0; j < ps->sfx->num_sounds; j++ ) {
-			if( ps->started[ j ] && !ps->stopped[ j ] ) {
+			if( ps->voices[ j ].started && !ps->voices[ j ].stopped ) {
 				StopSound( ps, j );
 			}
 		}
@@ -964,8 +1583,8 @@ void S_StartMenuMusic() {
 	if( !initialized )
 		return;
 
-	Sound sound;
-	if( !FindSound( "sounds/music/menu_1", &sound ) )
+	const Sound * sound = FindSound( "sounds/music/menu_1" );
+	if( sound == NULL )
 		return;
 
 	if( music_playing )
@@ -973,18 +1592,25 @@ void S_StartMenuMusic() {
 
 	CheckedALSource( music_source, AL_GAIN, s_volume->value * s_musicvolume->value * MusicIsWayTooLoud );
 	CheckedALSource( music_source, AL_DIRECT_CHANNELS_SOFT, AL_TRUE );
-	CheckedALSource( music_source, AL_LOOPING, AL_TRUE );
-	CheckedALSource( music_source, AL_BUFFER, sound.buf );
+
+	if( sound->streamed ) {
+		if( !StartStream( music_source, *sound, true, 0 ) )
+			return;
+	}
+	else {
+		CheckedALSource( music_source, AL_LOOPING, AL_TRUE );
+		CheckedALSource( music_source, AL_BUFFER, sound->buf );
+	}
 
 	CheckedALSourcePlay( music_source );
 
 	music_playing = true;
+	music_streamed = sound->streamed;
 }
 
 void S_StopBackgroundTrack() {
 	if( initialized && music_playing ) {
-		CheckedALSourceStop( music_source );
-		CheckedALSource( music_source, AL_BUFFER, 0 );
+		StopSource( music_source, music_streamed );
 	}
 	music_playing = false;
 }
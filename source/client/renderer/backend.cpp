@@ -200,6 +200,43 @@ static GLenum TextureWrapToGL( TextureWrap wrap ) {
 	return GL_INVALID_ENUM;
 }
 
+static u32 UncompressedBytesPerPixel( TextureFormat format ) {
+	switch( format ) {
+		case TextureFormat_R_U8:
+		case TextureFormat_R_S8:
+		case TextureFormat_A_U8:
+			return 1;
+		case TextureFormat_R_U16:
+		case TextureFormat_RA_U8:
+			return 2;
+		case TextureFormat_RGB_U8:
+		case TextureFormat_RGB_U8_sRGB:
+			return 3;
+		case TextureFormat_RG_Half:
+		case TextureFormat_RGBA_U8:
+		case TextureFormat_RGBA_U8_sRGB:
+			return 4;
+		case TextureFormat_RGB_Half:
+			return 6;
+
+		default:
+			assert( false );
+			return 0;
+	}
+}
+
+static GLenum MipmappedTextureFilterToGL( TextureFilter filter ) {
+	switch( filter ) {
+		case TextureFilter_Linear:
+			return GL_LINEAR_MIPMAP_LINEAR;
+		case TextureFilter_Point:
+			return GL_NEAREST_MIPMAP_NEAREST;
+	}
+
+	assert( false );
+	return GL_INVALID_ENUM;
+}
+
 static GLenum TextureFilterToGL( TextureFilter filter ) {
 	switch( filter ) {
 		case TextureFilter_Linear:
@@ -810,7 +847,7 @@ static void SubmitDrawCall( const DrawCall & dc ) {
 	glBindVertexArray( dc.mesh.vao );
 	GLenum primitive = PrimitiveTypeToGL( dc.mesh.primitive_type );
 
-	if( dc.num_instances != 0 ) {
+	if( dc.num_instances != 0 && dc.instance_data.vbo != 0 ) {
 		glBindBuffer( GL_ARRAY_BUFFER, dc.instance_data.vbo );
 
 		SetupAttribute( VertexAttribute_ParticlePosition, VertexFormat_Floatx4, sizeof( GPUParticle ), offsetof( GPUParticle, position ) );
@@ -859,10 +896,20 @@ static void SubmitDrawCall( const DrawCall & dc ) {
 	else if( dc.mesh.indices.ebo != 0 ) {
 		GLenum type = dc.mesh.indices_format == IndexFormat_U16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
 		const void * offset = ( const void * ) uintptr_t( dc.index_offset );
-		glDrawElements( primitive, dc.num_vertices, type, offset );
+		if( dc.num_instances != 0 ) {
+			glDrawElementsInstanced( primitive, dc.num_vertices, type, offset, dc.num_instances );
+		}
+		else {
+			glDrawElements( primitive, dc.num_vertices, type, offset );
+		}
 	}
 	else {
-		glDrawArrays( primitive, dc.index_offset, dc.num_vertices );
+		if( dc.num_instances != 0 ) {
+			glDrawArraysInstanced( primitive, dc.index_offset, dc.num_vertices, dc.num_instances );
+		}
+		else {
+			glDrawArrays( primitive, dc.index_offset, dc.num_vertices );
+		}
 	}
 
 	glBindVertexArray( 0 );
@@ -1099,8 +1146,10 @@ static Texture NewTextureSamples( TextureConfig config, int msaa_samples ) {
 		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, TextureWrapToGL( config.wrap ) );
 
 		GLenum filter = TextureFilterToGL( config.filter );
-		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter );
+		GLenum min_filter = config.num_mipmaps > 1 ? MipmappedTextureFilterToGL( config.filter ) : filter;
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter );
 		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, config.num_mipmaps - 1 );
 
 		if( config.wrap == TextureWrap_Border ) {
 			glTexParameterfv( GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, ( GLfloat * ) &config.border_color );
@@ -1128,8 +1177,18 @@ static Texture NewTextureSamples( TextureConfig config, int msaa_samples ) {
 				glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_A, GL_GREEN );
 			}
 
-			glTexImage2D( GL_TEXTURE_2D, 0, internal_format,
-				config.width, config.height, 0, channels, type, config.data );
+			const u8 * cursor = ( const u8 * ) config.data;
+			u32 w = config.width;
+			u32 h = config.height;
+			for( u32 i = 0; i < config.num_mipmaps; i++ ) {
+				glTexImage2D( GL_TEXTURE_2D, i, internal_format, w, h, 0, channels, type, cursor );
+
+				if( i + 1 < config.num_mipmaps ) {
+					cursor += w * h * UncompressedBytesPerPixel( config.format );
+				}
+				w = Max2( u32( 1 ), w / 2 );
+				h = Max2( u32( 1 ), h / 2 );
+			}
 		}
 		else {
 			u32 size = ( BitsPerPixel( config.format ) * config.width * config.height ) / 8;
@@ -1316,6 +1375,10 @@ static GLuint CompileShader( GLenum type, Span< const char * > srcs, Span< int >
 	full_lens[ n ] = -1;
 	n++;
 
+	full_srcs[ n ] = "#define MAX_INSTANCES " STR_TOSTR( MAX_GLSL_UNIFORM_INSTANCES ) "\n";
+	full_lens[ n ] = -1;
+	n++;
+
 	assert( n + srcs.n <= ARRAY_COUNT( full_srcs ) );
 
 	for( size_t i = 0; i < srcs.n; i++ ) {
@@ -1635,6 +1698,24 @@ void DrawMesh( const Mesh & mesh, const PipelineState & pipeline, u32 num_vertic
 	num_vertices_this_frame += dc.num_vertices;
 }
 
+// instance data goes in a u_Instances uniform block, see uniforms.glsl
+void DrawInstancedMesh( const Mesh & mesh, const PipelineState & pipeline, u32 num_instances, u32 num_vertices_override, u32 index_offset ) {
+	assert( in_frame );
+	assert( pipeline.pass != U8_MAX );
+	assert( pipeline.shader != NULL );
+	assert( num_instances > 0 && num_instances <= MAX_GLSL_UNIFORM_INSTANCES );
+
+	DrawCall dc = { };
+	dc.mesh = mesh;
+	dc.pipeline = pipeline;
+	dc.num_vertices = num_vertices_override == 0 ? mesh.num_vertices : num_vertices_override;
+	dc.index_offset = index_offset;
+	dc.num_instances = num_instances;
+	draw_calls.add( dc );
+
+	num_vertices_this_frame += dc.num_vertices * num_instances;
+}
+
 u8 AddRenderPass( const RenderPass & pass ) {
 	return checked_cast< u8 >( render_passes.add( pass ) );
 }
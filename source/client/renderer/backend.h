@@ -252,6 +252,7 @@ struct TextureConfig {
 	u32 height = 0;
 
 	const void * data = NULL;
+	u32 num_mipmaps = 1; // data holds the full mip chain, largest first
 
 	TextureFormat format;
 	TextureWrap wrap = TextureWrap_Repeat;
@@ -366,6 +367,10 @@ void DeleteMesh( const Mesh & mesh );
 void DeferDeleteMesh( const Mesh & mesh );
 
 void DrawMesh( const Mesh & mesh, const PipelineState & pipeline, u32 num_vertices_override = 0, u32 first_index = 0 );
+
+#define MAX_GLSL_UNIFORM_INSTANCES 128
+void DrawInstancedMesh( const Mesh & mesh, const PipelineState & pipeline, u32 num_instances, u32 num_vertices_override = 0, u32 first_index = 0 );
+
 void UpdateParticles( const Mesh & mesh, VertexBuffer vb_in, VertexBuffer vb_out, float radius, u32 num_particles, float dt );
 void UpdateParticlesFeedback( const Mesh & mesh, VertexBuffer vb_in, VertexBuffer vb_out, VertexBuffer vb_feedback, float radius, u32 num_particles, float dt );
 void DrawInstancedParticles( const Mesh & mesh, VertexBuffer vb, BlendFunc blend_func, u32 num_particles );
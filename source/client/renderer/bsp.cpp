@@ -5,6 +5,8 @@
 #include "qcommon/array.h"
 #include "qcommon/span2d.h"
 #include "client/assets.h"
+#include "client/asset_cache.h"
+#include "client/client.h"
 #include "client/renderer/renderer.h"
 #include "client/maps.h"
 
@@ -262,7 +264,8 @@ struct BSPDrawCall {
 	u32 base_vertex;
 	u32 index_offset;
 	u32 num_vertices;
-	const Material * material;
+	u32 material;
+	u32 cell;
 
 	bool patch;
 	u32 patch_width;
@@ -339,12 +342,121 @@ static int Order2BezierSubdivisions( Vec3 control0, Vec3 control1, Vec3 control2
 	return Order2BezierSubdivisions( control0, control1, control2, max_error, control0, control2, 0.0f, 1.0f );
 }
 
-static Model LoadBSPModel( DynamicArray< BSPModelVertex > & vertices, const BSPSpans & bsp, size_t model_idx ) {
+/*
+ * faces get grouped by material and by which cell of a coarse grid they
+ * fall in, so each primitive covers a small enough area to be culled
+ */
+constexpr float WORLD_CELL_SIZE = 1024.0f;
+
+static u32 FaceCell( const DynamicArray< BSPModelVertex > & vertices, u32 first_vertex, u32 num_vertices ) {
+	Vec3 centroid = Vec3( 0.0f );
+	for( u32 i = 0; i < num_vertices; i++ ) {
+		centroid += vertices[ first_vertex + i ].position;
+	}
+	centroid /= Max2( num_vertices, u32( 1 ) );
+
+	u32 x = u32( s32( floorf( centroid.x / WORLD_CELL_SIZE ) ) ) & 1023;
+	u32 y = u32( s32( floorf( centroid.y / WORLD_CELL_SIZE ) ) ) & 1023;
+	u32 z = u32( s32( floorf( centroid.z / WORLD_CELL_SIZE ) ) ) & 1023;
+	return x | ( y << 10 ) | ( z << 20 );
+}
+
+/*
+ * building the render data means tessellating patches and running meshopt
+ * over everything, so we do it once per BSP and keep the result in the asset
+ * cache. the cache entry is laid out so loading it is just pointing spans
+ * into the mapped file and uploading them:
+ *
+ * BSPCacheHeader
+ * GPUBSPNode[ num_nodes ], GPUBSPLeaf[ num_leaves ],
+ * GPUBSPLeafBrush[ num_leafbrushes ], GPUBSPPlane[ num_planes ]
+ * then for each model:
+ *     BSPCacheModel
+ *     BSPCachePrimitive[ num_primitives ]
+ *     BSPModelVertex[ num_vertices ]
+ *     u16 or u32 indices[ num_indices ], padded to 4 bytes
+ *
+ * primitives refer to materials by their index in the BSP. faces whose
+ * materials resolve to the same Material get merged, so which materials
+ * exist is part of the cache key too
+ */
+
+constexpr u32 BSP_CACHE_VERSION = 1;
+
+struct BSPCacheHeader {
+	u32 num_models;
+	u32 num_nodes;
+	u32 num_leaves;
+	u32 num_leafbrushes;
+	u32 num_planes;
+};
+
+struct BSPCacheModel {
+	u32 num_primitives;
+	u32 num_vertices;
+	u32 num_indices;
+	u32 index_size;
+};
+
+struct BSPCachePrimitive {
+	u32 material;
+	u32 first_index;
+	u32 num_vertices;
+	MinMax3 bounds;
+};
+
+template< typename T >
+static void AppendToBlob( DynamicArray< u8 > * blob, const T * data, size_t n ) {
+	size_t offset = blob->extend( sizeof( T ) * n );
+	memcpy( blob->ptr() + offset, data, sizeof( T ) * n );
+}
+
+template< typename T >
+static bool ReadFromBlob( Span< const u8 > * blob, Span< const T > * span, size_t n ) {
+	if( blob->n / sizeof( T ) < n )
+		return false;
+
+	*span = blob->slice( 0, n * sizeof( T ) ).cast< const T >();
+	*blob = *blob + n * sizeof( T );
+	return true;
+}
+
+static const Material * FindBSPMaterial( const BSPSpans & bsp, u32 material ) {
+	if( bsp.materials[ material ].flags & CONTENTS_WALLBANGABLE ) {
+		return FindMaterial( bsp.materials[ material ].name, &wallbang_material );
+	}
+	return FindMaterial( bsp.materials[ material ].name, &world_material );
+}
+
+// maps each BSP material to the first one that resolves to the same Material
+static void MergeBSPMaterials( DynamicArray< u32 > * merged, const BSPSpans & bsp ) {
+	DynamicArray< const Material * > resolved( sys_allocator, bsp.materials.n );
+
+	for( u32 i = 0; i < bsp.materials.n; i++ ) {
+		resolved.add( FindBSPMaterial( bsp, i ) );
+
+		u32 first = i;
+		for( u32 j = 0; j < i; j++ ) {
+			if( resolved[ j ] == resolved[ i ] ) {
+				first = j;
+				break;
+			}
+		}
+
+		merged->add( first );
+	}
+}
+
+static void BuildBSPModel( DynamicArray< u8 > * blob, DynamicArray< BSPModelVertex > & vertices, const BSPSpans & bsp, Span< const u32 > materials, size_t model_idx ) {
 	ZoneScoped;
 
 	const BSPModel & bsp_model = bsp.models[ model_idx ];
-	if( bsp_model.num_faces == 0 )
-		return { };
+	if( bsp_model.num_faces == 0 ) {
+		BSPCacheModel empty = { };
+		empty.index_size = sizeof( u16 );
+		AppendToBlob( blob, &empty, 1 );
+		return;
+	}
 
 	DynamicArray< BSPDrawCall > draw_calls( sys_allocator );
 	if( bsp.idbsp ) {
@@ -355,13 +467,8 @@ static Model LoadBSPModel( DynamicArray< BSPModelVertex > & vertices, const BSPS
 			dc.base_vertex = face->first_vertex;
 			dc.index_offset = face->first_index;
 			dc.num_vertices = face->num_indices;
-			if( bsp.materials[ face->material ].flags & CONTENTS_WALLBANGABLE ) {
-				dc.material = FindMaterial( bsp.materials[ face->material ].name, &wallbang_material );
-			}
-			else {
-				dc.material = FindMaterial( bsp.materials[ face->material ].name, &world_material );
-			}
-
+			dc.material = materials[ face->material ];
+			dc.cell = FaceCell( vertices, face->first_vertex, face->num_vertices );
 			dc.patch = face->type == FaceType_Patch;
 			dc.patch_width = face->patch_width;
 			dc.patch_height = face->patch_height;
@@ -377,13 +484,8 @@ static Model LoadBSPModel( DynamicArray< BSPModelVertex > & vertices, const BSPS
 			dc.base_vertex = face->first_vertex;
 			dc.index_offset = face->first_index;
 			dc.num_vertices = face->num_indices;
-			if( bsp.materials[ face->material ].flags & CONTENTS_WALLBANGABLE ) {
-				dc.material = FindMaterial( bsp.materials[ face->material ].name, &wallbang_material );
-			}
-			else {
-				dc.material = FindMaterial( bsp.materials[ face->material ].name, &world_material );
-			}
-
+			dc.material = materials[ face->material ];
+			dc.cell = FaceCell( vertices, face->first_vertex, face->num_vertices );
 			dc.patch = face->type == FaceType_Patch;
 			dc.patch_width = face->patch_width;
 			dc.patch_height = face->patch_height;
@@ -393,27 +495,32 @@ static Model LoadBSPModel( DynamicArray< BSPModelVertex > & vertices, const BSPS
 	}
 
 	std::sort( draw_calls.begin(), draw_calls.end(), []( const BSPDrawCall & a, const BSPDrawCall & b ) {
-		return a.material < b.material;
+		if( a.material != b.material )
+			return a.material < b.material;
+		return a.cell < b.cell;
 	} );
 
 	// generate patch geometry and merge draw calls
 	// TODO: this generates terrible geometry then relies on meshopt to fix it up. maybe it could be done better
 	DynamicArray< u32 > indices( sys_allocator );
 
-	DynamicArray< Model::Primitive > primitives( sys_allocator );
-	Model::Primitive first;
+	DynamicArray< BSPCachePrimitive > primitives( sys_allocator );
+	BSPCachePrimitive first;
 	first.first_index = 0;
 	first.num_vertices = 0;
 	first.material = draw_calls[ 0 ].material;
 	primitives.add( first );
 
+	u32 cell = draw_calls[ 0 ].cell;
+
 	for( const BSPDrawCall & dc : draw_calls ) {
-		if( dc.material != primitives.top().material ) {
-			Model::Primitive prim;
+		if( dc.material != primitives.top().material || dc.cell != cell ) {
+			BSPCachePrimitive prim;
 			prim.first_index = primitives.top().first_index + primitives.top().num_vertices;
 			prim.num_vertices = 0;
 			prim.material = dc.material;
 			primitives.add( prim );
+			cell = dc.cell;
 		}
 
 		if( dc.patch ) {
@@ -491,48 +598,64 @@ static Model LoadBSPModel( DynamicArray< BSPModelVertex > & vertices, const BSPS
 		}
 	}
 
-	// TODO: meshopt
+	// pull this model's vertices out of the shared array and weld the
+	// duplicates along patch seams, then optimise each primitive
+	DynamicArray< BSPModelVertex > model_vertices( sys_allocator );
+	{
+		ZoneScopedN( "meshopt" );
 
-	Model model = { };
-	model.transform = Mat4::Identity();
+		DynamicArray< u32 > remap( sys_allocator );
+		remap.resize( vertices.size() );
 
-	model.primitives = ALLOC_MANY( sys_allocator, Model::Primitive, primitives.size() );
-	model.num_primitives = primitives.size();
-	memcpy( model.primitives, primitives.ptr(), primitives.num_bytes() );
+		size_t num_vertices = meshopt_generateVertexRemap( remap.ptr(), indices.ptr(), indices.size(), vertices.ptr(), vertices.size(), sizeof( BSPModelVertex ) );
+		model_vertices.resize( num_vertices );
+		meshopt_remapIndexBuffer( indices.ptr(), indices.ptr(), indices.size(), remap.ptr() );
+		meshopt_remapVertexBuffer( model_vertices.ptr(), vertices.ptr(), vertices.size(), sizeof( BSPModelVertex ), remap.ptr() );
 
-	MeshConfig mesh_config;
-	mesh_config.ccw_winding = false;
-	mesh_config.unified_buffer = NewVertexBuffer( vertices.ptr(), vertices.num_bytes() );
-	mesh_config.stride = sizeof( vertices[ 0 ] );
-	mesh_config.positions_offset = offsetof( BSPModelVertex, position );
-	mesh_config.normals_offset = offsetof( BSPModelVertex, normal );
-	mesh_config.tex_coords_offset = offsetof( BSPModelVertex, uv );
-	mesh_config.num_vertices = indices.size();
-
-	// if( num_verts <= U16_MAX ) {
-	// 	DynamicArray< u16 > indices_u16( sys_allocator, indices.size() );
-	// 	for( u32 i = 0; i < indices.size(); i++ ) {
-	// 		indices_u16.add( indices[ i ] );
-	// 	}
-	// 	mesh_config.indices = NewIndexBuffer( indices.ptr(), indices.num_bytes() );
-	// }
-	// else {
-		mesh_config.indices = NewIndexBuffer( indices.ptr(), indices.num_bytes() );
-		mesh_config.indices_format = IndexFormat_U32;
-	// }
+		for( const BSPCachePrimitive & prim : primitives ) {
+			u32 * prim_indices = indices.ptr() + prim.first_index;
+			meshopt_optimizeVertexCache( prim_indices, prim_indices, prim.num_vertices, num_vertices );
+		}
 
-	model.mesh = NewMesh( mesh_config );
+		meshopt_optimizeVertexFetch( model_vertices.ptr(), indices.ptr(), indices.size(), model_vertices.ptr(), num_vertices, sizeof( BSPModelVertex ) );
+	}
 
-	return model;
+	for( BSPCachePrimitive & prim : primitives ) {
+		prim.bounds = MinMax3::Empty();
+		for( u32 i = 0; i < prim.num_vertices; i++ ) {
+			prim.bounds = Extend( prim.bounds, model_vertices[ indices[ prim.first_index + i ] ].position );
+		}
+	}
+
+	BSPCacheModel header;
+	header.num_primitives = primitives.size();
+	header.num_vertices = model_vertices.size();
+	header.num_indices = indices.size();
+	header.index_size = model_vertices.size() <= U16_MAX ? sizeof( u16 ) : sizeof( u32 );
+
+	AppendToBlob( blob, &header, 1 );
+	AppendToBlob( blob, primitives.ptr(), primitives.size() );
+	AppendToBlob( blob, model_vertices.ptr(), model_vertices.size() );
+
+	if( header.index_size == sizeof( u16 ) ) {
+		DynamicArray< u16 > indices_u16( sys_allocator, indices.size() );
+		for( u32 index : indices ) {
+			indices_u16.add( u16( index ) );
+		}
+		AppendToBlob( blob, indices_u16.ptr(), indices_u16.size() );
+	}
+	else {
+		AppendToBlob( blob, indices.ptr(), indices.size() );
+	}
+
+	while( blob->size() % 4 != 0 ) {
+		blob->add( 0 );
+	}
 }
 
-bool LoadBSPRenderData( Map * map, u64 base_hash, Span< const u8 > data ) {
+static void BuildBSPRenderData( DynamicArray< u8 > * blob, const BSPSpans & bsp, Span< const u32 > materials ) {
 	ZoneScoped;
 
-	BSPSpans bsp;
-	if( !ParseBSP( &bsp, data ) )
-		return false;
-
 	// create common vertex data
 	u32 num_verts = bsp.idbsp ? bsp.vertices.n : bsp.raven_vertices.n;
 	DynamicArray< BSPModelVertex > vertices( sys_allocator, num_verts );
@@ -556,16 +679,6 @@ bool LoadBSPRenderData( Map * map, u64 base_hash, Span< const u8 > data ) {
 		}
 	}
 
-	map->base_hash = base_hash;
-	map->num_models = bsp.models.n;
-	map->fog_strength = ParseFogStrength( &bsp );
-
-	map->models = ALLOC_MANY( sys_allocator, Model, bsp.models.n );
-
-	for( size_t i = 0; i < bsp.models.n; i++ ) {
-		map->models[ i ] = LoadBSPModel( vertices, bsp, i );
-	}
-
 	DynamicArray< GPUBSPNode > nodes( sys_allocator, bsp.nodes.n );
 	DynamicArray< GPUBSPLeaf > leaves( sys_allocator, bsp.leaves.n );
 	DynamicArray< GPUBSPLeafBrush > leafbrushes( sys_allocator, bsp.leafbrushes.n );
@@ -607,26 +720,196 @@ bool LoadBSPRenderData( Map * map, u64 base_hash, Span< const u8 > data ) {
 		planes.add( gpu_plane );
 	}
 
-	TextureBuffer nodesBuffer = NewTextureBuffer( TextureBufferFormat_S32x3, nodes.size() );
-	WriteTextureBuffer( nodesBuffer, nodes.ptr(), nodes.size() * sizeof( GPUBSPNode ) );
+	BSPCacheHeader header;
+	header.num_models = bsp.models.n;
+	header.num_nodes = nodes.size();
+	header.num_leaves = leaves.size();
+	header.num_leafbrushes = leafbrushes.size();
+	header.num_planes = planes.size();
+
+	AppendToBlob( blob, &header, 1 );
+	AppendToBlob( blob, nodes.ptr(), nodes.size() );
+	AppendToBlob( blob, leaves.ptr(), leaves.size() );
+	AppendToBlob( blob, leafbrushes.ptr(), leafbrushes.size() );
+	AppendToBlob( blob, planes.ptr(), planes.size() );
+
+	for( size_t i = 0; i < bsp.models.n; i++ ) {
+		BuildBSPModel( blob, vertices, bsp, materials, i );
+	}
+}
+
+struct BSPRenderModel {
+	Span< const BSPCachePrimitive > primitives;
+	Span< const BSPModelVertex > vertices;
+	Span< const u8 > indices;
+	u32 num_indices;
+	IndexFormat indices_format;
+};
+
+struct BSPRenderData {
+	Span< const GPUBSPNode > nodes;
+	Span< const GPUBSPLeaf > leaves;
+	Span< const GPUBSPLeafBrush > leafbrushes;
+	Span< const GPUBSPPlane > planes;
+	BSPRenderModel * models;
+};
+
+// checks everything up front so we never upload half a map
+static bool ParseBSPRenderData( BSPRenderData * render_data, const BSPSpans & bsp, Span< const u8 > blob ) {
+	ZoneScoped;
+
+	Span< const BSPCacheHeader > header;
+	if( !ReadFromBlob( &blob, &header, 1 ) || header[ 0 ].num_models != bsp.models.n )
+		return false;
+
+	bool ok = true;
+	ok = ok && ReadFromBlob( &blob, &render_data->nodes, header[ 0 ].num_nodes );
+	ok = ok && ReadFromBlob( &blob, &render_data->leaves, header[ 0 ].num_leaves );
+	ok = ok && ReadFromBlob( &blob, &render_data->leafbrushes, header[ 0 ].num_leafbrushes );
+	ok = ok && ReadFromBlob( &blob, &render_data->planes, header[ 0 ].num_planes );
+	if( !ok )
+		return false;
+
+	render_data->models = ALLOC_MANY( sys_allocator, BSPRenderModel, bsp.models.n );
+
+	for( size_t i = 0; i < bsp.models.n; i++ ) {
+		BSPRenderModel * model = &render_data->models[ i ];
+
+		Span< const BSPCacheModel > model_header;
+		ok = ok && ReadFromBlob( &blob, &model_header, 1 );
+		ok = ok && ( model_header[ 0 ].index_size == sizeof( u16 ) || model_header[ 0 ].index_size == sizeof( u32 ) );
+		ok = ok && ReadFromBlob( &blob, &model->primitives, model_header[ 0 ].num_primitives );
+		ok = ok && ReadFromBlob( &blob, &model->vertices, model_header[ 0 ].num_vertices );
+		ok = ok && ReadFromBlob( &blob, &model->indices, AlignPow2( u64( model_header[ 0 ].num_indices ) * model_header[ 0 ].index_size, u64( 4 ) ) );
+		if( !ok )
+			break;
+
+		model->num_indices = model_header[ 0 ].num_indices;
+		model->indices_format = model_header[ 0 ].index_size == sizeof( u16 ) ? IndexFormat_U16 : IndexFormat_U32;
+
+		for( const BSPCachePrimitive & prim : model->primitives ) {
+			ok = ok && prim.material < bsp.materials.n && prim.first_index + prim.num_vertices <= model->num_indices;
+		}
+	}
+
+	if( !ok || blob.n != 0 ) {
+		FREE( sys_allocator, render_data->models );
+		return false;
+	}
+
+	return true;
+}
+
+static Model LoadBSPModel( const BSPSpans & bsp, const BSPRenderModel & render_model ) {
+	ZoneScoped;
+
+	if( render_model.primitives.n == 0 )
+		return { };
+
+	Model model = { };
+	model.transform = Mat4::Identity();
+	model.bounds = MinMax3::Empty();
+
+	model.primitives = ALLOC_MANY( sys_allocator, Model::Primitive, render_model.primitives.n );
+	model.num_primitives = render_model.primitives.n;
+
+	for( size_t i = 0; i < render_model.primitives.n; i++ ) {
+		const BSPCachePrimitive & cached = render_model.primitives[ i ];
+
+		Model::Primitive prim = { };
+		prim.material = FindBSPMaterial( bsp, cached.material );
+		prim.first_index = cached.first_index;
+		prim.num_vertices = cached.num_vertices;
+		prim.bounds = cached.bounds;
+		model.primitives[ i ] = prim;
+
+		model.bounds = Extend( model.bounds, prim.bounds.mins );
+		model.bounds = Extend( model.bounds, prim.bounds.maxs );
+	}
+
+	MeshConfig mesh_config;
+	mesh_config.ccw_winding = false;
+	mesh_config.unified_buffer = NewVertexBuffer( render_model.vertices.ptr, render_model.vertices.num_bytes() );
+	mesh_config.stride = sizeof( BSPModelVertex );
+	mesh_config.positions_offset = offsetof( BSPModelVertex, position );
+	mesh_config.normals_offset = offsetof( BSPModelVertex, normal );
+	mesh_config.tex_coords_offset = offsetof( BSPModelVertex, uv );
+	mesh_config.num_vertices = render_model.num_indices;
+	mesh_config.indices = NewIndexBuffer( render_model.indices.ptr, render_model.indices.num_bytes() );
+	mesh_config.indices_format = render_model.indices_format;
+
+	model.mesh = NewMesh( mesh_config );
+
+	return model;
+}
+
+static void UploadBSPRenderData( Map * map, const BSPSpans & bsp, const BSPRenderData & render_data ) {
+	map->num_models = bsp.models.n;
+	map->models = ALLOC_MANY( sys_allocator, Model, bsp.models.n );
+
+	for( size_t i = 0; i < bsp.models.n; i++ ) {
+		map->models[ i ] = LoadBSPModel( bsp, render_data.models[ i ] );
+	}
+
+	TextureBuffer nodesBuffer = NewTextureBuffer( TextureBufferFormat_S32x3, render_data.nodes.n );
+	WriteTextureBuffer( nodesBuffer, render_data.nodes.ptr, render_data.nodes.num_bytes() );
 	map->nodeBuffer = nodesBuffer;
 
-	TextureBuffer leafBuffer = NewTextureBuffer( TextureBufferFormat_S32x2, leaves.size() );
-	WriteTextureBuffer( leafBuffer, leaves.ptr(), leaves.size() * sizeof( GPUBSPLeaf ) );
+	TextureBuffer leafBuffer = NewTextureBuffer( TextureBufferFormat_S32x2, render_data.leaves.n );
+	WriteTextureBuffer( leafBuffer, render_data.leaves.ptr, render_data.leaves.num_bytes() );
 	map->leafBuffer = leafBuffer;
 
-	TextureBuffer brushBuffer = NewTextureBuffer( TextureBufferFormat_S32x2, leafbrushes.size() );
-	WriteTextureBuffer( brushBuffer, leafbrushes.ptr(), leafbrushes.size() * sizeof( GPUBSPLeafBrush ) );
+	TextureBuffer brushBuffer = NewTextureBuffer( TextureBufferFormat_S32x2, render_data.leafbrushes.n );
+	WriteTextureBuffer( brushBuffer, render_data.leafbrushes.ptr, render_data.leafbrushes.num_bytes() );
 	map->brushBuffer = brushBuffer;
 
-	TextureBuffer planeBuffer = NewTextureBuffer( TextureBufferFormat_Floatx4, planes.size() );
-	WriteTextureBuffer( planeBuffer, planes.ptr(), planes.size() * sizeof( GPUBSPPlane ) );
+	TextureBuffer planeBuffer = NewTextureBuffer( TextureBufferFormat_Floatx4, render_data.planes.n );
+	WriteTextureBuffer( planeBuffer, render_data.planes.ptr, render_data.planes.num_bytes() );
 	map->planeBuffer = planeBuffer;
+}
+
+// checksum is the collision model's hash of data, so we don't hash the BSP twice
+bool LoadBSPRenderData( Map * map, u64 base_hash, Span< const u8 > data, u32 checksum ) {
+	ZoneScoped;
+
+	BSPSpans bsp;
+	if( !ParseBSP( &bsp, data ) )
+		return false;
+
+	map->base_hash = base_hash;
+	map->fog_strength = ParseFogStrength( &bsp );
+
+	DynamicArray< u32 > materials( sys_allocator, bsp.materials.n );
+	MergeBSPMaterials( &materials, bsp );
+
+	TempAllocator temp = cls.frame_arena.temp();
+	u64 key = Hash64( materials.ptr(), materials.num_bytes(), Hash64( u64( checksum ) | ( u64( data.n ) << 32 ) ) );
+
+	BSPRenderData render_data;
+
+	AssetCacheEntry entry;
+	if( MapAssetCacheEntry( &temp, &entry, "maps", BSP_CACHE_VERSION, key ) ) {
+		bool ok = ParseBSPRenderData( &render_data, bsp, entry.data );
+		if( ok ) {
+			UploadBSPRenderData( map, bsp, render_data );
+			FREE( sys_allocator, render_data.models );
+		}
+		UnmapAssetCacheEntry( &entry );
+
+		if( ok )
+			return true;
+	}
+
+	DynamicArray< u8 > blob( sys_allocator );
+	BuildBSPRenderData( &blob, bsp, materials.span() );
+
+	if( !ParseBSPRenderData( &render_data, bsp, blob.span() ) )
+		return false;
+
+	WriteAssetCacheEntry( &temp, "maps", BSP_CACHE_VERSION, key, blob.span() );
 
-	nodes.clear();
-	leaves.clear();
-	leafbrushes.clear();
-	planes.clear();
+	UploadBSPRenderData( map, bsp, render_data );
+	FREE( sys_allocator, render_data.models );
 
 	return true;
 }
@@ -0,0 +1,189 @@
+#include "qcommon/base.h"
+#include "qcommon/qcommon.h"
+#include "qcommon/cmodel.h"
+#include "client/client.h"
+#include "client/maps.h"
+#include "client/renderer/renderer.h"
+
+static cvar_t * r_nocull;
+
+static CollisionModel * pvs_cms;
+static u8 pvs[ MAX_CM_LEAFS / 8 ];
+
+static u32 num_tested;
+static u32 num_culled_view;
+static u32 num_culled_shadows;
+
+void InitCulling() {
+	r_nocull = Cvar_Get( "r_nocull", "0", 0 );
+	pvs_cms = NULL;
+}
+
+/*
+ * Gribb/Hartmann plane extraction, for -w <= z <= w clip space
+ */
+Frustum FrustumFromMatrix( const Mat4 & VP, bool include_depth ) {
+	Vec4 r0 = VP.row0();
+	Vec4 r1 = VP.row1();
+	Vec4 r2 = VP.row2();
+	Vec4 r3 = VP.row3();
+
+	Vec4 planes[] = {
+		r3 + r0,
+		r3 - r0,
+		r3 + r1,
+		r3 - r1,
+		r3 + r2,
+		r3 - r2,
+	};
+
+	Frustum frustum;
+	frustum.num_planes = 0;
+
+	for( size_t i = 0; i < ( include_depth ? 6 : 4 ); i++ ) {
+		float length = Length( planes[ i ].xyz() );
+
+		// the far plane of an infinite projection
+		if( length < 1e-8f )
+			continue;
+
+		frustum.planes[ frustum.num_planes ] = planes[ i ] / length;
+		frustum.num_planes++;
+	}
+
+	return frustum;
+}
+
+bool BoxInFrustum( const Frustum & frustum, const MinMax3 & bounds ) {
+	for( u32 i = 0; i < frustum.num_planes; i++ ) {
+		Vec4 plane = frustum.planes[ i ];
+
+		// test the corner furthest along the plane normal
+		Vec3 p = Vec3(
+			plane.x >= 0.0f ? bounds.maxs.x : bounds.mins.x,
+			plane.y >= 0.0f ? bounds.maxs.y : bounds.mins.y,
+			plane.z >= 0.0f ? bounds.maxs.z : bounds.mins.z
+		);
+
+		if( Dot( plane.xyz(), p ) + plane.w < 0.0f )
+			return false;
+	}
+
+	return true;
+}
+
+MinMax3 TransformBounds( const Mat4 & M, const MinMax3 & bounds ) {
+	if( bounds.mins.x > bounds.maxs.x )
+		return bounds;
+
+	Vec3 center = ( bounds.mins + bounds.maxs ) * 0.5f;
+	Vec3 extents = ( bounds.maxs - bounds.mins ) * 0.5f;
+
+	Vec3 transformed_center = ( M * Vec4( center, 1.0f ) ).xyz();
+	Vec3 transformed_extents = Vec3(
+		Abs( M.col0.x ) * extents.x + Abs( M.col1.x ) * extents.y + Abs( M.col2.x ) * extents.z,
+		Abs( M.col0.y ) * extents.x + Abs( M.col1.y ) * extents.y + Abs( M.col2.y ) * extents.z,
+		Abs( M.col0.z ) * extents.x + Abs( M.col1.z ) * extents.y + Abs( M.col2.z ) * extents.z
+	);
+
+	return MinMax3( transformed_center - transformed_extents, transformed_center + transformed_extents );
+}
+
+void SetCullingView( Vec3 position ) {
+	ZoneScoped;
+
+	pvs_cms = NULL;
+
+	// maps without vis data see everything anyway
+	if( cl.map == NULL || cl.map->cms == NULL || CM_NumClusters( cl.map->cms ) == 0 )
+		return;
+
+	pvs_cms = cl.map->cms;
+	memset( pvs, 0, CM_ClusterRowSize( pvs_cms ) );
+	CM_MergePVS( pvs_cms, position, pvs );
+}
+
+static bool BoxInPVS( const MinMax3 & bounds ) {
+	if( pvs_cms == NULL )
+		return true;
+
+	int leafs[ 128 ];
+	int topnode;
+	int count = CM_BoxLeafnums( pvs_cms, bounds.mins, bounds.maxs, leafs, ARRAY_COUNT( leafs ), &topnode );
+
+	// not worth checking big things
+	if( count == ARRAY_COUNT( leafs ) )
+		return true;
+
+	for( int i = 0; i < count; i++ ) {
+		int cluster = CM_LeafCluster( pvs_cms, leafs[ i ] );
+		if( cluster == -1 )
+			continue;
+		if( pvs[ cluster >> 3 ] & ( 1 << ( cluster & 7 ) ) )
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * shadow casters outside the PVS can still throw shadows into it, so the
+ * PVS only applies to the main view
+ */
+u8 CullBounds( const MinMax3 & bounds ) {
+	num_tested++;
+
+	if( r_nocull->integer != 0 )
+		return VisibleIn_Everything;
+
+	u8 visible = 0;
+
+	if( BoxInFrustum( frame_static.frustum, bounds ) ) {
+		visible |= VisibleIn_ViewFrustum;
+		if( BoxInPVS( bounds ) ) {
+			visible |= VisibleIn_View;
+		}
+	}
+
+	if( ( visible & VisibleIn_View ) == 0 ) {
+		num_culled_view++;
+	}
+
+	if( BoxInFrustum( frame_static.near_shadowmap_frustum, bounds ) ) {
+		visible |= VisibleIn_NearShadowmap;
+	}
+	else {
+		num_culled_shadows++;
+	}
+
+	if( BoxInFrustum( frame_static.far_shadowmap_frustum, bounds ) ) {
+		visible |= VisibleIn_FarShadowmap;
+	}
+	else {
+		num_culled_shadows++;
+	}
+
+	return visible;
+}
+
+u8 CullModel( const Model * model, const Mat4 & transform, bool animated ) {
+	MinMax3 bounds = model->bounds;
+
+	// the bounds come from the bind pose so give animations some room
+	if( animated && bounds.mins.x <= bounds.maxs.x ) {
+		Vec3 padding = ( bounds.maxs - bounds.mins ) * 0.25f;
+		bounds = MinMax3( bounds.mins - padding, bounds.maxs + padding );
+	}
+
+	return CullBounds( TransformBounds( transform * model->transform, bounds ) );
+}
+
+void PlotAndResetCullingStats() {
+	TracyPlot( "Culling tests", s64( num_tested ) );
+	TracyPlot( "Culled from view", s64( num_culled_view ) );
+	TracyPlot( "Culled from shadowmaps", s64( num_culled_shadows ) );
+
+	num_tested = 0;
+	num_culled_view = 0;
+	num_culled_shadows = 0;
+}
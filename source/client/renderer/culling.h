@@ -0,0 +1,37 @@
+#pragma once
+
+#include "qcommon/types.h"
+
+struct Model;
+
+/*
+ * CPU side visibility tests, done before we build pipelines or upload
+ * uniforms for anything. The frustums and PVS get updated by RendererSetView
+ */
+
+struct Frustum {
+	Vec4 planes[ 6 ]; // normals point inwards
+	u32 num_planes;
+};
+
+enum VisibleInFlags : u8 {
+	VisibleIn_ViewFrustum = 1 << 0, // for things that get drawn through walls
+	VisibleIn_View = 1 << 1, // in the view frustum and PVS
+	VisibleIn_NearShadowmap = 1 << 2,
+	VisibleIn_FarShadowmap = 1 << 3,
+
+	VisibleIn_Everything = VisibleIn_ViewFrustum | VisibleIn_View | VisibleIn_NearShadowmap | VisibleIn_FarShadowmap,
+};
+
+void InitCulling();
+
+// include_depth = false ignores the near/far planes, for passes that use depth clamping
+Frustum FrustumFromMatrix( const Mat4 & VP, bool include_depth );
+bool BoxInFrustum( const Frustum & frustum, const MinMax3 & bounds );
+MinMax3 TransformBounds( const Mat4 & M, const MinMax3 & bounds );
+
+void SetCullingView( Vec3 position );
+void PlotAndResetCullingStats();
+
+u8 CullBounds( const MinMax3 & bounds );
+u8 CullModel( const Model * model, const Mat4 & transform, bool animated );
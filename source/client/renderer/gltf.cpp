@@ -71,6 +71,7 @@ static void LoadGeometry( Model * model, const cgltf_node * node, const Mat4 & t
 	const cgltf_primitive & prim = node->mesh->primitives[ 0 ];
 
 	MeshConfig mesh_config;
+	MinMax3 bounds = MinMax3::Empty();
 
 	for( size_t i = 0; i < prim.attributes_count; i++ ) {
 		const cgltf_attribute & attr = prim.attributes[ i ];
@@ -79,14 +80,14 @@ static void LoadGeometry( Model * model, const cgltf_node * node, const Mat4 & t
 			mesh_config.num_vertices = attr.data->count;
 			mesh_config.positions = NewVertexBuffer( AccessorToSpan( attr.data ) );
 
-			Vec3 min, max;
 			for( int j = 0; j < 3; j++ ) {
-				min[ j ] = attr.data->min[ j ];
-				max[ j ] = attr.data->max[ j ];
+				bounds.mins[ j ] = attr.data->min[ j ];
+				bounds.maxs[ j ] = attr.data->max[ j ];
 			}
 
-			model->bounds = Extend( model->bounds, ( transform * Vec4( min, 1.0f ) ).xyz() );
-			model->bounds = Extend( model->bounds, ( transform * Vec4( max, 1.0f ) ).xyz() );
+			MinMax3 transformed = TransformBounds( transform, bounds );
+			model->bounds = Extend( model->bounds, transformed.mins );
+			model->bounds = Extend( model->bounds, transformed.maxs );
 		}
 
 		if( attr.type == cgltf_attribute_type_normal ) {
@@ -125,6 +126,7 @@ static void LoadGeometry( Model * model, const cgltf_node * node, const Mat4 & t
 	primitive->mesh = NewMesh( mesh_config );
 	primitive->first_index = 0;
 	primitive->num_vertices = 0;
+	primitive->bounds = bounds;
 
 	const char * material_name = prim.material != NULL ? prim.material->name : "";
 	primitive->material = FindMaterial( material_name );
@@ -1,5 +1,3 @@
-#include <algorithm> // std::sort
-
 #include "qcommon/base.h"
 #include "qcommon/hash.h"
 #include "qcommon/hashtable.h"
@@ -8,7 +6,8 @@
 #include "gameshared/q_shared.h"
 #include "client/client.h"
 #include "client/assets.h"
-#include "client/threadpool.h"
+#include "client/asset_cache.h"
+#include "qcommon/threadpool.h"
 #include "client/renderer/renderer.h"
 #include "client/renderer/dds.h"
 #include "cgame/cg_dynamics.h"
@@ -29,7 +28,9 @@ constexpr int DECAL_ATLAS_SIZE = 2048;
 constexpr int DECAL_ATLAS_BLOCK_SIZE = DECAL_ATLAS_SIZE / 4;
 
 static Texture textures[ MAX_TEXTURES ];
-static void * texture_stb_data[ MAX_TEXTURES ];
+static const u8 * texture_pixels[ MAX_TEXTURES ];
+static u8 * texture_decoded_data[ MAX_TEXTURES ];
+static AssetCacheEntry texture_cache_entries[ MAX_TEXTURES ];
 static Span2D< const BC4Block > texture_bc4_data[ MAX_TEXTURES ];
 static u32 num_textures;
 static Hashtable< MAX_TEXTURES * 2 > textures_hashtable;
@@ -356,9 +357,11 @@ static bool ParseMaterial( Material * material, Span< const char > name, Span< c
 }
 
 static void UnloadTexture( u64 idx ) {
-	stbi_image_free( texture_stb_data[ idx ] );
+	FREE( sys_allocator, texture_decoded_data[ idx ] );
+	UnmapAssetCacheEntry( &texture_cache_entries[ idx ] );
 
-	texture_stb_data[ idx ] = NULL;
+	texture_pixels[ idx ] = NULL;
+	texture_decoded_data[ idx ] = NULL;
 	texture_bc4_data[ idx ] = Span2D< const BC4Block >();
 
 	DeleteTexture( textures[ idx ] );
@@ -438,12 +441,187 @@ static void LoadBuiltinTextures() {
 	}
 }
 
-static void LoadSTBTexture( const char * path, u8 * pixels, int w, int h, int channels ) {
+struct DecodeTextureJob {
+	struct {
+		const char * path;
+		Span< const u8 > data; // filled in by DecodeTexture so the file gets loaded on the thread pool
+	} in;
+
+	struct {
+		u32 width, height;
+		u32 channels;
+		u32 num_mipmaps;
+		const u8 * pixels;
+
+		// exactly one of these owns pixels
+		u8 * decoded;
+		AssetCacheEntry cache_entry;
+	} out;
+};
+
+// bump this when the decoded texture format changes
+static constexpr u32 TEXTURE_CACHE_VERSION = 1;
+
+struct TextureCacheHeader {
+	u32 width, height;
+	u32 channels;
+	u32 num_mipmaps;
+};
+
+static u32 NumMipmaps( u32 w, u32 h ) {
+	u32 n = 1;
+	while( w > 1 || h > 1 ) {
+		w = Max2( u32( 1 ), w / 2 );
+		h = Max2( u32( 1 ), h / 2 );
+		n++;
+	}
+	return n;
+}
+
+static size_t MipChainSize( u32 w, u32 h, u32 channels, u32 num_mipmaps ) {
+	size_t size = 0;
+	for( u32 i = 0; i < num_mipmaps; i++ ) {
+		size += size_t( w ) * size_t( h ) * channels;
+		w = Max2( u32( 1 ), w / 2 );
+		h = Max2( u32( 1 ), h / 2 );
+	}
+	return size;
+}
+
+// 2x2 box filter. RGB and RGBA textures are sRGB so average those in linear space
+static void GenerateMipmaps( u8 * pixels, u32 w, u32 h, u32 channels, u32 num_mipmaps ) {
+	ZoneScoped;
+
+	float srgb_to_linear[ 256 ];
+	for( int i = 0; i < 256; i++ ) {
+		srgb_to_linear[ i ] = sRGBToLinear( i / 255.0f );
+	}
+
+	u32 num_srgb_channels = channels >= 3 ? 3 : 0;
+
+	const u8 * src = pixels;
+	for( u32 level = 1; level < num_mipmaps; level++ ) {
+		u32 src_w = w;
+		u32 src_h = h;
+		w = Max2( u32( 1 ), w / 2 );
+		h = Max2( u32( 1 ), h / 2 );
+
+		u8 * dst = const_cast< u8 * >( src ) + size_t( src_w ) * size_t( src_h ) * channels;
+
+		for( u32 y = 0; y < h; y++ ) {
+			u32 y0 = Min2( y * 2, src_h - 1 );
+			u32 y1 = Min2( y * 2 + 1, src_h - 1 );
+
+			for( u32 x = 0; x < w; x++ ) {
+				u32 x0 = Min2( x * 2, src_w - 1 );
+				u32 x1 = Min2( x * 2 + 1, src_w - 1 );
+
+				const u8 * p00 = src + ( size_t( y0 ) * src_w + x0 ) * channels;
+				const u8 * p01 = src + ( size_t( y0 ) * src_w + x1 ) * channels;
+				const u8 * p10 = src + ( size_t( y1 ) * src_w + x0 ) * channels;
+				const u8 * p11 = src + ( size_t( y1 ) * src_w + x1 ) * channels;
+				u8 * out = dst + ( size_t( y ) * w + x ) * channels;
+
+				for( u32 c = 0; c < channels; c++ ) {
+					if( c < num_srgb_channels ) {
+						float linear = srgb_to_linear[ p00[ c ] ] + srgb_to_linear[ p01[ c ] ] + srgb_to_linear[ p10[ c ] ] + srgb_to_linear[ p11[ c ] ];
+						out[ c ] = u8( LinearTosRGB( linear * 0.25f ) * 255.0f + 0.5f );
+					}
+					else {
+						out[ c ] = u8( ( u32( p00[ c ] ) + p01[ c ] + p10[ c ] + p11[ c ] + 2 ) / 4 );
+					}
+				}
+			}
+		}
+
+		src = dst;
+	}
+}
+
+static bool LoadCachedTexture( TempAllocator * temp, DecodeTextureJob * job, u64 key ) {
+	AssetCacheEntry entry;
+	if( !MapAssetCacheEntry( temp, &entry, "textures", TEXTURE_CACHE_VERSION, key ) )
+		return false;
+
+	TextureCacheHeader header;
+	bool ok = entry.data.n >= sizeof( header );
+	if( ok ) {
+		memcpy( &header, entry.data.ptr, sizeof( header ) );
+		ok = header.channels >= 1 && header.channels <= 4
+			&& header.num_mipmaps == NumMipmaps( header.width, header.height )
+			&& entry.data.n - sizeof( header ) == MipChainSize( header.width, header.height, header.channels, header.num_mipmaps );
+	}
+
+	if( !ok ) {
+		UnmapAssetCacheEntry( &entry );
+		return false;
+	}
+
+	job->out.width = header.width;
+	job->out.height = header.height;
+	job->out.channels = header.channels;
+	job->out.num_mipmaps = header.num_mipmaps;
+	job->out.pixels = entry.data.ptr + sizeof( header );
+	job->out.cache_entry = entry;
+
+	return true;
+}
+
+// runs on the thread pool
+static void DecodeTexture( TempAllocator * temp, void * data ) {
 	ZoneScoped;
-	ZoneText( path, strlen( path ) );
 
-	if( pixels == NULL ) {
-		Com_Printf( S_COLOR_YELLOW "WARNING: couldn't load texture from %s\n", path );
+	DecodeTextureJob * job = ( DecodeTextureJob * ) data;
+	ZoneText( job->in.path, strlen( job->in.path ) );
+
+	job->out = { };
+
+	job->in.data = AssetBinary( job->in.path );
+	u64 key = Hash64( job->in.data );
+	if( LoadCachedTexture( temp, job, key ) )
+		return;
+
+	int w, h, channels;
+	u8 * stb_pixels;
+	{
+		ZoneScopedN( "stbi_load_from_memory" );
+		stb_pixels = stbi_load_from_memory( job->in.data.ptr, job->in.data.num_bytes(), &w, &h, &channels, 0 );
+	}
+	if( stb_pixels == NULL )
+		return;
+	defer { stbi_image_free( stb_pixels ); };
+
+	TextureCacheHeader header;
+	header.width = checked_cast< u32 >( w );
+	header.height = checked_cast< u32 >( h );
+	header.channels = checked_cast< u32 >( channels );
+	header.num_mipmaps = NumMipmaps( header.width, header.height );
+
+	// store the header in front of the pixels so we can write it straight to the cache
+	size_t pixels_size = MipChainSize( header.width, header.height, header.channels, header.num_mipmaps );
+	u8 * decoded = ALLOC_MANY( sys_allocator, u8, sizeof( header ) + pixels_size );
+	u8 * pixels = decoded + sizeof( header );
+
+	memcpy( decoded, &header, sizeof( header ) );
+	memcpy( pixels, stb_pixels, size_t( w ) * size_t( h ) * channels );
+	GenerateMipmaps( pixels, header.width, header.height, header.channels, header.num_mipmaps );
+
+	WriteAssetCacheEntry( temp, "textures", TEXTURE_CACHE_VERSION, key, Span< const u8 >( decoded, sizeof( header ) + pixels_size ) );
+
+	job->out.width = header.width;
+	job->out.height = header.height;
+	job->out.channels = header.channels;
+	job->out.num_mipmaps = header.num_mipmaps;
+	job->out.pixels = pixels;
+	job->out.decoded = decoded;
+}
+
+static void LoadDecodedTexture( DecodeTextureJob * job ) {
+	ZoneScoped;
+	ZoneText( job->in.path, strlen( job->in.path ) );
+
+	if( job->out.pixels == NULL ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: couldn't load texture from %s\n", job->in.path );
 		return;
 	}
 
@@ -455,13 +633,22 @@ static void LoadSTBTexture( const char * path, u8 * pixels, int w, int h, int ch
 	};
 
 	TextureConfig config;
-	config.width = checked_cast< u32 >( w );
-	config.height = checked_cast< u32 >( h );
-	config.data = pixels;
-	config.format = formats[ channels - 1 ];
+	config.width = job->out.width;
+	config.height = job->out.height;
+	config.data = job->out.pixels;
+	config.num_mipmaps = job->out.num_mipmaps;
+	config.format = formats[ job->out.channels - 1 ];
+
+	u64 idx = AddTexture( Hash64( StripExtension( job->in.path ) ), config );
+	if( idx == U64_MAX ) {
+		FREE( sys_allocator, job->out.decoded );
+		UnmapAssetCacheEntry( &job->out.cache_entry );
+		return;
+	}
 
-	size_t idx = AddTexture( Hash64( StripExtension( path ) ), config );
-	texture_stb_data[ idx ] = pixels;
+	texture_pixels[ idx ] = job->out.pixels;
+	texture_decoded_data[ idx ] = job->out.decoded;
+	texture_cache_entries[ idx ] = job->out.cache_entry;
 }
 
 static void LoadDDSTexture( const char * path ) {
@@ -547,19 +734,6 @@ static void LoadMaterialFile( const char * path, Span< const char > * material_n
 	}
 }
 
-struct DecodeTextureJob {
-	struct {
-		const char * path;
-		Span< const u8 > data;
-	} in;
-
-	struct {
-		int width, height;
-		int channels;
-		u8 * pixels;
-	} out;
-};
-
 struct DecalAtlasLayer {
 	BC4Block blocks[ DECAL_ATLAS_BLOCK_SIZE * DECAL_ATLAS_BLOCK_SIZE ];
 };
@@ -704,7 +878,7 @@ static void PackDecalAtlas( Span< const char > * material_names ) {
 		defer { FREE( sys_allocator, bc4_from_rgba.ptr ); };
 
 		if( material->texture->format == TextureFormat_RGBA_U8_sRGB ) {
-			Span2D< const RGBA8 > rgba = Span2D< const RGBA8 >( ( const RGBA8 * ) texture_stb_data[ texture_idx ], material->texture->width, material->texture->height );
+			Span2D< const RGBA8 > rgba = Span2D< const RGBA8 >( ( const RGBA8 * ) texture_pixels[ texture_idx ], material->texture->width, material->texture->height );
 			bc4_from_rgba = RGBAToBC4( rgba );
 			bc4 = bc4_from_rgba;
 		}
@@ -756,6 +930,8 @@ void InitMaterials() {
 	{
 		ZoneScopedN( "Load disk textures" );
 
+		u64 start = Sys_Microseconds();
+
 		DynamicArray< DecodeTextureJob > jobs( sys_allocator );
 		{
 			ZoneScopedN( "Build job list" );
@@ -764,9 +940,8 @@ void InitMaterials() {
 				Span< const char > ext = FileExtension( path );
 
 				if( ext == ".png" || ext == ".jpg" ) {
-					DecodeTextureJob job;
+					DecodeTextureJob job = { };
 					job.in.path = path;
-					job.in.data = AssetBinary( path );
 
 					jobs.add( job );
 				}
@@ -775,24 +950,20 @@ void InitMaterials() {
 					LoadDDSTexture( path );
 				}
 			}
-
-			std::sort( jobs.begin(), jobs.end(), []( const DecodeTextureJob & a, const DecodeTextureJob & b ) {
-				return a.in.data.n > b.in.data.n;
-			} );
 		}
 
-		ParallelFor( jobs.span(), []( TempAllocator * temp, void * data ) {
-			DecodeTextureJob * job = ( DecodeTextureJob * ) data;
-
-			ZoneScopedN( "stbi_load_from_memory" );
-			ZoneText( job->in.path, strlen( job->in.path ) );
+		ParallelFor( jobs.span(), DecodeTexture );
 
-			job->out.pixels = stbi_load_from_memory( job->in.data.ptr, job->in.data.num_bytes(), &job->out.width, &job->out.height, &job->out.channels, 0 );
-		} );
-
-		for( DecodeTextureJob job : jobs ) {
-			LoadSTBTexture( job.in.path, job.out.pixels, job.out.width, job.out.height, job.out.channels );
+		u32 num_cached = 0;
+		for( DecodeTextureJob & job : jobs ) {
+			bool cached = job.out.cache_entry.mapped.ptr != NULL;
+			LoadDecodedTexture( &job );
+			if( cached ) {
+				num_cached++;
+			}
 		}
+
+		Com_Printf( "Loaded %u textures (%u from cache) in %.2fms\n", u32( jobs.size() ), num_cached, ( Sys_Microseconds() - start ) / 1000.0 );
 	}
 
 	Span< const char > material_names[ MAX_MATERIALS ];
@@ -825,17 +996,12 @@ void HotloadMaterials() {
 		Span< const char > ext = FileExtension( path );
 
 		if( ext == ".png" || ext == ".jpg" ) {
-			Span< const u8 > data = AssetBinary( path );
-
-			int w, h, channels;
-			u8 * pixels;
-			{
-				ZoneScopedN( "stbi_load_from_memory" );
-				ZoneText( path, strlen( path ) );
-				pixels = stbi_load_from_memory( data.ptr, data.num_bytes(), &w, &h, &channels, 0 );
-			}
+			DecodeTextureJob job = { };
+			job.in.path = path;
 
-			LoadSTBTexture( path, pixels, w, h, channels );
+			TempAllocator temp = cls.frame_arena.temp();
+			DecodeTexture( &temp, &job );
+			LoadDecodedTexture( &job );
 
 			changes = true;
 		}
@@ -928,33 +1094,7 @@ static float EvaluateWaveFunc( Wave wave ) {
 	return wave.args[ 0 ] + wave.args[ 1 ] * v;
 }
 
-PipelineState MaterialToPipelineState( const Material * material, Vec4 color, bool skinned ) {
-	if( material == &world_material || material == &wallbang_material ) {
-		PipelineState pipeline;
-		pipeline.shader = &shaders.world;
-		pipeline.pass = frame_static.world_opaque_pass;
-		pipeline.set_uniform( "u_Fog", frame_static.fog_uniforms );
-		pipeline.set_texture( "u_BlueNoiseTexture", BlueNoiseTexture() );
-		pipeline.set_uniform( "u_BlueNoiseTextureParams", frame_static.blue_noise_uniforms );
-		color.x = material->rgbgen.args[ 0 ];
-		color.y = material->rgbgen.args[ 1 ];
-		color.z = material->rgbgen.args[ 2 ];
-		pipeline.set_uniform( "u_Material", UploadMaterialUniforms( color, Vec2( 0.0f ), material->alpha_cutoff, material->specular, material->shininess, Vec3( 0.0f ), Vec3( 0.0f ) ) );
-		pipeline.set_texture( "u_NearShadowmapTexture", &frame_static.near_shadowmap_fb.depth_texture );
-		pipeline.set_texture( "u_FarShadowmapTexture", &frame_static.far_shadowmap_fb.depth_texture );
-		pipeline.set_texture_array( "u_DecalAtlases", DecalAtlasTextureArray() );
-		AddDynamicsToPipeline( &pipeline );
-		return pipeline;
-	}
-
-	if( material->mask_outlines ) {
-		PipelineState pipeline;
-		pipeline.pass = frame_static.world_opaque_pass;
-		pipeline.shader = &shaders.depth_only;
-		return pipeline;
-	}
-
-	// evaluate rgbgen/alphagen
+Vec4 EvaluateMaterialColor( const Material * material, Vec4 color ) {
 	if( material->rgbgen.type == ColorGenType_Constant ) {
 		color.x = material->rgbgen.args[ 0 ];
 		color.y = material->rgbgen.args[ 1 ];
@@ -987,6 +1127,37 @@ PipelineState MaterialToPipelineState( const Material * material, Vec4 color, bo
 		}
 	}
 
+	return color;
+}
+
+PipelineState MaterialToPipelineState( const Material * material, Vec4 color, bool skinned ) {
+	if( material == &world_material || material == &wallbang_material ) {
+		PipelineState pipeline;
+		pipeline.shader = &shaders.world;
+		pipeline.pass = frame_static.world_opaque_pass;
+		pipeline.set_uniform( "u_Fog", frame_static.fog_uniforms );
+		pipeline.set_texture( "u_BlueNoiseTexture", BlueNoiseTexture() );
+		pipeline.set_uniform( "u_BlueNoiseTextureParams", frame_static.blue_noise_uniforms );
+		color.x = material->rgbgen.args[ 0 ];
+		color.y = material->rgbgen.args[ 1 ];
+		color.z = material->rgbgen.args[ 2 ];
+		pipeline.set_uniform( "u_Material", UploadMaterialUniforms( color, Vec2( 0.0f ), material->alpha_cutoff, material->specular, material->shininess, Vec3( 0.0f ), Vec3( 0.0f ) ) );
+		pipeline.set_texture( "u_NearShadowmapTexture", &frame_static.near_shadowmap_fb.depth_texture );
+		pipeline.set_texture( "u_FarShadowmapTexture", &frame_static.far_shadowmap_fb.depth_texture );
+		pipeline.set_texture_array( "u_DecalAtlases", DecalAtlasTextureArray() );
+		AddDynamicsToPipeline( &pipeline );
+		return pipeline;
+	}
+
+	if( material->mask_outlines ) {
+		PipelineState pipeline;
+		pipeline.pass = frame_static.world_opaque_pass;
+		pipeline.shader = &shaders.depth_only;
+		return pipeline;
+	}
+
+	color = EvaluateMaterialColor( material, color );
+
 	// evaluate tcmod
 	Vec3 tcmod_row0 = Vec3( 1.0f, 0.0f, 0.0f );
 	Vec3 tcmod_row1 = Vec3( 0.0f, 1.0f, 0.0f );
@@ -1,16 +1,52 @@
+#include <algorithm>
+#include <xmmintrin.h>
+
 #include "qcommon/base.h"
 #include "qcommon/qcommon.h"
+#include "qcommon/array.h"
 #include "qcommon/hashtable.h"
 #include "client/assets.h"
 #include "client/renderer/renderer.h"
 #include "client/renderer/model.h"
 
 constexpr u32 MAX_MODELS = 1024;
+constexpr u32 MAX_INSTANCE_POSE_MATRICES = 8192;
 
 static Model gltf_models[ MAX_MODELS ];
 static u32 num_gltf_models;
 static Hashtable< MAX_MODELS * 2 > gltf_models_hashtable;
 
+enum InstancePass : u8 {
+	InstancePass_View,
+	InstancePass_NearShadowmap,
+	InstancePass_FarShadowmap,
+};
+
+struct QueuedInstance {
+	const Model * model;
+	u8 primitive;
+	InstancePass pass;
+	bool skinned;
+	s32 pose;
+	Mat4 M;
+	Vec4 color;
+};
+
+// matches Instance in uniforms.glsl
+struct GPUModelInstance {
+	Mat4 M;
+	Vec4 color;
+	s32 pose;
+	s32 padding[ 3 ];
+};
+
+static cvar_t * r_instancing;
+static NonRAIIDynamicArray< QueuedInstance > queued_instances;
+
+// skinning matrices of the queued instances, uploaded to instance_poses
+static NonRAIIDynamicArray< Mat4 > queued_poses;
+static TextureBuffer instance_poses;
+
 static void LoadGLTF( const char * path ) {
 	Span< const char > ext = FileExtension( path );
 	if( ext != ".glb" )
@@ -38,7 +74,12 @@ static void LoadGLTF( const char * path ) {
 void InitModels() {
 	ZoneScoped;
 
+	r_instancing = Cvar_Get( "r_instancing", "1", 0 );
+
 	num_gltf_models = 0;
+	queued_instances.init( sys_allocator );
+	queued_poses.init( sys_allocator );
+	instance_poses = NewTextureBuffer( TextureBufferFormat_Floatx4, MAX_INSTANCE_POSE_MATRICES * 4 );
 
 	for( const char * path : AssetPaths() ) {
 		LoadGLTF( path );
@@ -77,6 +118,10 @@ void ShutdownModels() {
 	for( u32 i = 0; i < num_gltf_models; i++ ) {
 		DeleteModel( &gltf_models[ i ] );
 	}
+
+	queued_instances.shutdown();
+	queued_poses.shutdown();
+	DeleteTextureBuffer( instance_poses );
 }
 
 const Model * FindModel( StringHash name ) {
@@ -101,6 +146,81 @@ void DrawModelPrimitive( const Model * model, const Model::Primitive * primitive
 	}
 }
 
+static bool Animated( MatrixPalettes palettes ) {
+	return palettes.node_transforms.ptr != NULL;
+}
+
+/*
+ * models get queued up and drawn instanced at the end of the frame, so a map
+ * full of the same prop or a server full of players costs one draw call per
+ * primitive. skinned instances look up their own pose in instance_poses. the
+ * transparent pass draws in submission order so those go straight through
+ */
+static bool QueueModelInstances( const Model * model, const Mat4 & transform, const Vec4 & color, MatrixPalettes palettes, Span< const InstancePass > passes ) {
+	if( r_instancing->integer == 0 || passes.n == 0 )
+		return false;
+
+	for( InstancePass pass : passes ) {
+		if( pass != InstancePass_View )
+			continue;
+
+		for( u8 i = 0; i < model->num_nodes; i++ ) {
+			const Model::Node * node = &model->nodes[ i ];
+			if( node->primitive == U8_MAX )
+				continue;
+			if( model->primitives[ node->primitive ].material->blend_func != BlendFunc_Disabled )
+				return false;
+		}
+	}
+
+	s32 pose = 0;
+	Span< const Mat4 > skinning_matrices = palettes.skinning_matrices;
+	if( skinning_matrices.ptr != NULL ) {
+		if( queued_poses.size() + skinning_matrices.n > MAX_INSTANCE_POSE_MATRICES )
+			return false;
+
+		pose = checked_cast< s32 >( queued_poses.size() );
+		for( const Mat4 & m : skinning_matrices ) {
+			queued_poses.add( m );
+		}
+	}
+
+	bool animated = Animated( palettes );
+
+	for( InstancePass pass : passes ) {
+		for( u8 i = 0; i < model->num_nodes; i++ ) {
+			const Model::Node * node = &model->nodes[ i ];
+			if( node->primitive == U8_MAX )
+				continue;
+
+			bool skinned = animated && node->skinned;
+
+			Mat4 primitive_transform;
+			if( skinned ) {
+				primitive_transform = Mat4::Identity();
+			}
+			else if( animated ) {
+				primitive_transform = palettes.node_transforms[ i ];
+			}
+			else {
+				primitive_transform = node->global_transform;
+			}
+
+			QueuedInstance instance;
+			instance.model = model;
+			instance.primitive = node->primitive;
+			instance.pass = pass;
+			instance.skinned = skinned;
+			instance.pose = pose;
+			instance.M = transform * model->transform * primitive_transform;
+			instance.color = color;
+			queued_instances.add( instance );
+		}
+	}
+
+	return true;
+}
+
 template< typename F >
 static void DrawNode( const Model * model, u8 node_idx, const Mat4 & transform, const Vec4 & color, MatrixPalettes palettes, UniformBlock pose_uniforms, F transform_pipeline ) {
 	if( node_idx == U8_MAX )
@@ -109,7 +229,7 @@ static void DrawNode( const Model * model, u8 node_idx, const Mat4 & transform,
 	const Model::Node * node = &model->nodes[ node_idx ];
 
 	if( node->primitive != U8_MAX ) {
-		bool animated = palettes.node_transforms.ptr != NULL;
+		bool animated = Animated( palettes );
 		bool skinned = animated && node->skinned;
 
 		Mat4 primitive_transform;
@@ -141,6 +261,13 @@ static void DrawNode( const Model * model, u8 node_idx, const Mat4 & transform,
 }
 
 void DrawModel( const Model * model, const Mat4 & transform, const Vec4 & color, MatrixPalettes palettes ) {
+	if( ( CullModel( model, transform, Animated( palettes ) ) & VisibleIn_View ) == 0 )
+		return;
+
+	InstancePass view = InstancePass_View;
+	if( QueueModelInstances( model, transform, color, palettes, Span< const InstancePass >( &view, 1 ) ) )
+		return;
+
 	UniformBlock pose_uniforms = { };
 	if( palettes.skinning_matrices.ptr != NULL ) {
 		pose_uniforms = UploadUniforms( palettes.skinning_matrices.ptr, palettes.skinning_matrices.num_bytes() );
@@ -166,6 +293,9 @@ void DrawViewWeapon( const Model * model, const Mat4 & transform ) {
 }
 
 void DrawOutlinedModel( const Model * model, const Mat4 & transform, const Vec4 & color, float outline_height, MatrixPalettes palettes ) {
+	if( ( CullModel( model, transform, Animated( palettes ) ) & VisibleIn_View ) == 0 )
+		return;
+
 	UniformBlock outline_uniforms = UploadUniformBlock( color, outline_height );
 
 	auto MakeOutlinePipeline = [ &outline_uniforms ]( PipelineState * pipeline, bool skinned ) {
@@ -188,6 +318,10 @@ void DrawOutlinedModel( const Model * model, const Mat4 & transform, const Vec4
 }
 
 void DrawModelSilhouette( const Model * model, const Mat4 & transform, const Vec4 & color, MatrixPalettes palettes ) {
+	// silhouettes show through walls so ignore the PVS
+	if( ( CullModel( model, transform, Animated( palettes ) ) & VisibleIn_ViewFrustum ) == 0 )
+		return;
+
 	UniformBlock material_uniforms = UploadMaterialUniforms( color, Vec2( 0 ), 0.0f, 0.0f, 64.0f );
 
 	auto MakeSilhouettePipeline = [ &material_uniforms ]( PipelineState * pipeline, bool skinned ) {
@@ -210,6 +344,24 @@ void DrawModelSilhouette( const Model * model, const Mat4 & transform, const Vec
 }
 
 void DrawModelShadow( const Model * model, const Mat4 & transform, const Vec4 & color, MatrixPalettes palettes ) {
+	u8 visible = CullModel( model, transform, Animated( palettes ) );
+	if( ( visible & ( VisibleIn_NearShadowmap | VisibleIn_FarShadowmap ) ) == 0 )
+		return;
+
+	InstancePass passes[ 2 ];
+	size_t num_passes = 0;
+	if( visible & VisibleIn_NearShadowmap ) {
+		passes[ num_passes ] = InstancePass_NearShadowmap;
+		num_passes++;
+	}
+	if( visible & VisibleIn_FarShadowmap ) {
+		passes[ num_passes ] = InstancePass_FarShadowmap;
+		num_passes++;
+	}
+
+	if( QueueModelInstances( model, transform, color, palettes, Span< const InstancePass >( passes, num_passes ) ) )
+		return;
+
 	auto MakeNearShadowPipeline = []( PipelineState * pipeline, bool skinned ) {
 		pipeline->shader = skinned ? &shaders.depth_only_skinned : &shaders.depth_only;
 		pipeline->pass = frame_static.near_shadowmap_pass;
@@ -234,12 +386,163 @@ void DrawModelShadow( const Model * model, const Mat4 & transform, const Vec4 &
 
 	for( u8 i = 0; i < model->num_nodes; i++ ) {
 		if( model->nodes[ i ].parent == U8_MAX ) {
-			DrawNode( model, i, transform, color, palettes, pose_uniforms, MakeNearShadowPipeline );
-			DrawNode( model, i, transform, color, palettes, pose_uniforms, MakeFarShadowPipeline );
+			if( visible & VisibleIn_NearShadowmap ) {
+				DrawNode( model, i, transform, color, palettes, pose_uniforms, MakeNearShadowPipeline );
+			}
+			if( visible & VisibleIn_FarShadowmap ) {
+				DrawNode( model, i, transform, color, palettes, pose_uniforms, MakeFarShadowPipeline );
+			}
 		}
 	}
 }
 
+static const Shader * InstancedShader( const Shader * shader ) {
+	if( shader == &shaders.standard )
+		return &shaders.standard_instanced;
+	if( shader == &shaders.standard_shaded )
+		return &shaders.standard_shaded_instanced;
+	if( shader == &shaders.standard_alphatest )
+		return &shaders.standard_alphatest_instanced;
+	if( shader == &shaders.standard_skinned )
+		return &shaders.standard_skinned_instanced;
+	if( shader == &shaders.standard_skinned_shaded )
+		return &shaders.standard_skinned_shaded_instanced;
+	if( shader == &shaders.depth_only )
+		return &shaders.depth_only_instanced;
+	if( shader == &shaders.depth_only_skinned )
+		return &shaders.depth_only_skinned_instanced;
+	return NULL;
+}
+
+static bool SameBatch( const QueuedInstance & a, const QueuedInstance & b ) {
+	return a.model == b.model && a.primitive == b.primitive && a.pass == b.pass && a.skinned == b.skinned;
+}
+
+static void DrawInstancedModelPrimitive( const Model * model, const Model::Primitive * primitive, const PipelineState & pipeline, u32 num_instances ) {
+	if( primitive->num_vertices != 0 ) {
+		u32 index_size = model->mesh.indices_format == IndexFormat_U16 ? sizeof( u16 ) : sizeof( u32 );
+		DrawInstancedMesh( model->mesh, pipeline, num_instances, primitive->num_vertices, primitive->first_index * index_size );
+	}
+	else {
+		DrawInstancedMesh( primitive->mesh, pipeline, num_instances );
+	}
+}
+
+static void DrawBatch( Span< const QueuedInstance > batch, u32 * num_draw_calls ) {
+	const Model * model = batch[ 0 ].model;
+	const Model::Primitive * primitive = &model->primitives[ batch[ 0 ].primitive ];
+
+	bool skinned = batch[ 0 ].skinned;
+
+	PipelineState pipeline;
+	if( batch[ 0 ].pass == InstancePass_View ) {
+		// the instance colors replace the material color
+		pipeline = MaterialToPipelineState( primitive->material, vec4_white, skinned );
+		pipeline.set_uniform( "u_View", frame_static.view_uniforms );
+	}
+	else {
+		bool near = batch[ 0 ].pass == InstancePass_NearShadowmap;
+		pipeline.shader = skinned ? &shaders.depth_only_skinned : &shaders.depth_only;
+		pipeline.pass = near ? frame_static.near_shadowmap_pass : frame_static.far_shadowmap_pass;
+		pipeline.clamp_depth = true;
+		pipeline.cull_face = CullFace_Disabled;
+		pipeline.write_depth = true;
+		pipeline.set_uniform( "u_View", near ? frame_static.near_shadowmap_view_uniforms : frame_static.far_shadowmap_view_uniforms );
+	}
+
+	const Shader * instanced_shader = InstancedShader( pipeline.shader );
+
+	// map models use the world shader, which has no instanced variant
+	if( instanced_shader == NULL ) {
+		for( const QueuedInstance & instance : batch ) {
+			PipelineState single = pipeline;
+			if( instance.pass == InstancePass_View ) {
+				single = MaterialToPipelineState( primitive->material, instance.color );
+				single.set_uniform( "u_View", frame_static.view_uniforms );
+			}
+			single.set_uniform( "u_Model", UploadModelUniforms( instance.M ) );
+			DrawModelPrimitive( model, primitive, single );
+			*num_draw_calls += 1;
+		}
+		return;
+	}
+
+	pipeline.shader = instanced_shader;
+	if( skinned ) {
+		pipeline.set_texture_buffer( "u_InstancePoses", instance_poses );
+	}
+
+	for( size_t i = 0; i < batch.n; i += MAX_GLSL_UNIFORM_INSTANCES ) {
+		GPUModelInstance instances[ MAX_GLSL_UNIFORM_INSTANCES ];
+		u32 num_instances = checked_cast< u32 >( Min2( batch.n - i, size_t( MAX_GLSL_UNIFORM_INSTANCES ) ) );
+
+		for( u32 j = 0; j < num_instances; j++ ) {
+			instances[ j ].M = batch[ i + j ].M;
+			instances[ j ].color = EvaluateMaterialColor( primitive->material, batch[ i + j ].color );
+			instances[ j ].pose = batch[ i + j ].pose;
+		}
+
+		PipelineState chunk = pipeline;
+		chunk.set_uniform( "u_Instances", UploadUniforms( instances, sizeof( instances[ 0 ] ) * num_instances ) );
+		DrawInstancedModelPrimitive( model, primitive, chunk, num_instances );
+		*num_draw_calls += 1;
+	}
+}
+
+void FlushModelInstances() {
+	ZoneScoped;
+
+	std::sort( queued_instances.begin(), queued_instances.end(), []( const QueuedInstance & a, const QueuedInstance & b ) {
+		if( a.model != b.model )
+			return a.model < b.model;
+		if( a.primitive != b.primitive )
+			return a.primitive < b.primitive;
+		if( a.pass != b.pass )
+			return a.pass < b.pass;
+		return a.skinned < b.skinned;
+	} );
+
+	if( queued_poses.size() > 0 ) {
+		WriteTextureBuffer( instance_poses, queued_poses.begin(), queued_poses.size() * sizeof( Mat4 ) );
+	}
+
+	u32 num_draw_calls = 0;
+
+	size_t i = 0;
+	while( i < queued_instances.size() ) {
+		size_t j = i + 1;
+		while( j < queued_instances.size() && SameBatch( queued_instances[ i ], queued_instances[ j ] ) ) {
+			j++;
+		}
+
+		DrawBatch( queued_instances.span().slice( i, j ), &num_draw_calls );
+		i = j;
+	}
+
+	TracyPlot( "Model instances", s64( queued_instances.size() ) );
+	TracyPlot( "Instanced draw calls", s64( num_draw_calls ) );
+	TracyPlot( "Instanced pose matrices", s64( queued_poses.size() ) );
+
+	queued_instances.clear();
+	queued_poses.clear();
+}
+
+// returns the keyframe index i such that times[ i ] < t <= times[ i + 1 ]
+static u32 FindKeyframe( const float * times, u32 num_samples, float t ) {
+	u32 lo = 1;
+	u32 hi = num_samples - 1;
+	while( lo < hi ) {
+		u32 mid = lo + ( hi - lo ) / 2;
+		if( times[ mid ] >= t ) {
+			hi = mid;
+		}
+		else {
+			lo = mid + 1;
+		}
+	}
+	return lo - 1;
+}
+
 template< typename T, typename F >
 static T SampleAnimationChannel( const Model::AnimationChannel< T > & channel, float t, T def, F lerp ) {
 	if( channel.samples == NULL )
@@ -249,13 +552,7 @@ static T SampleAnimationChannel( const Model::AnimationChannel< T > & channel, f
 
 	t = Clamp( channel.times[ 0 ], t, channel.times[ channel.num_samples - 1 ] );
 
-	u32 sample = 0;
-	for( u32 i = 1; i < channel.num_samples; i++ ) {
-		if( channel.times[ i ] >= t ) {
-			sample = i - 1;
-			break;
-		}
-	}
+	u32 sample = FindKeyframe( channel.times, channel.num_samples, t );
 
 	// TODO: cubic
 	if( channel.interpolation == InterpolationMode_Step ) {
@@ -266,22 +563,47 @@ static T SampleAnimationChannel( const Model::AnimationChannel< T > & channel, f
 	return lerp( channel.samples[ sample ], lerp_frac, channel.samples[ sample + 1 ] );
 }
 
+static __m128 DotSSE( __m128 a, __m128 b ) {
+	__m128 m = _mm_mul_ps( a, b );
+	m = _mm_add_ps( m, _mm_shuffle_ps( m, m, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+	return _mm_add_ps( m, _mm_shuffle_ps( m, m, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+}
+
+static Quaternion NLerpSSE( Quaternion from, float t, Quaternion to ) {
+	__m128 a = _mm_loadu_ps( &from.x );
+	__m128 b = _mm_loadu_ps( &to.x );
+
+	float lt = 1.0f - t;
+	float rt = _mm_cvtss_f32( DotSSE( a, b ) ) > 0 ? t : -t;
+
+	__m128 q = _mm_add_ps( _mm_mul_ps( a, _mm_set1_ps( lt ) ), _mm_mul_ps( b, _mm_set1_ps( rt ) ) );
+	q = _mm_div_ps( q, _mm_sqrt_ps( DotSSE( q, q ) ) );
+
+	Quaternion result;
+	_mm_storeu_ps( &result.x, q );
+	return result;
+}
+
 // can't use overloaded function as a template parameter
 static Vec3 LerpVec3( Vec3 a, float t, Vec3 b ) { return Lerp( a, t, b ); }
 static float LerpFloat( float a, float t, float b ) { return Lerp( a, t, b ); }
 
-Span< TRS > SampleAnimation( Allocator * a, const Model * model, float t ) {
-	ZoneScoped;
-
-	Span< TRS > local_poses = ALLOC_SPAN( a, TRS, model->num_nodes );
+void SampleAnimation( Span< TRS > local_poses, const Model * model, float t ) {
+	assert( local_poses.n == model->num_nodes );
 
 	for( u8 i = 0; i < model->num_nodes; i++ ) {
 		const Model::Node * node = &model->nodes[ i ];
-		local_poses[ i ].rotation = SampleAnimationChannel( node->rotations, t, node->local_transform.rotation, NLerp );
+		local_poses[ i ].rotation = SampleAnimationChannel( node->rotations, t, node->local_transform.rotation, NLerpSSE );
 		local_poses[ i ].translation = SampleAnimationChannel( node->translations, t, node->local_transform.translation, LerpVec3 );
 		local_poses[ i ].scale = SampleAnimationChannel( node->scales, t, node->local_transform.scale, LerpFloat );
 	}
+}
+
+Span< TRS > SampleAnimation( Allocator * a, const Model * model, float t ) {
+	ZoneScoped;
 
+	Span< TRS > local_poses = ALLOC_SPAN( a, TRS, model->num_nodes );
+	SampleAnimation( local_poses, model, t );
 	return local_poses;
 }
 
@@ -311,32 +633,67 @@ static Mat4 TRSToMat4( const TRS & trs ) {
 	);
 }
 
-MatrixPalettes ComputeMatrixPalettes( Allocator * a, const Model * model, Span< const TRS > local_poses ) {
-	ZoneScoped;
+static __m128 Mat4MulColumnSSE( __m128 c0, __m128 c1, __m128 c2, __m128 c3, const Vec4 & v ) {
+	__m128 r = _mm_mul_ps( c0, _mm_set1_ps( v.x ) );
+	r = _mm_add_ps( r, _mm_mul_ps( c1, _mm_set1_ps( v.y ) ) );
+	r = _mm_add_ps( r, _mm_mul_ps( c2, _mm_set1_ps( v.z ) ) );
+	return _mm_add_ps( r, _mm_mul_ps( c3, _mm_set1_ps( v.w ) ) );
+}
 
-	assert( local_poses.n == model->num_nodes );
+// Mat4 is 16 byte aligned so we can load/store columns directly
+static void Mat4MulSSE( Mat4 * result, const Mat4 & lhs, const Mat4 & rhs ) {
+	__m128 c0 = _mm_load_ps( lhs.col0.ptr() );
+	__m128 c1 = _mm_load_ps( lhs.col1.ptr() );
+	__m128 c2 = _mm_load_ps( lhs.col2.ptr() );
+	__m128 c3 = _mm_load_ps( lhs.col3.ptr() );
+
+	__m128 r0 = Mat4MulColumnSSE( c0, c1, c2, c3, rhs.col0 );
+	__m128 r1 = Mat4MulColumnSSE( c0, c1, c2, c3, rhs.col1 );
+	__m128 r2 = Mat4MulColumnSSE( c0, c1, c2, c3, rhs.col2 );
+	__m128 r3 = Mat4MulColumnSSE( c0, c1, c2, c3, rhs.col3 );
+
+	_mm_store_ps( result->col0.ptr(), r0 );
+	_mm_store_ps( result->col1.ptr(), r1 );
+	_mm_store_ps( result->col2.ptr(), r2 );
+	_mm_store_ps( result->col3.ptr(), r3 );
+}
 
+MatrixPalettes AllocMatrixPalettes( Allocator * a, const Model * model ) {
 	MatrixPalettes palettes = { };
 	palettes.node_transforms = ALLOC_SPAN( a, Mat4, model->num_nodes );
 	if( model->num_joints != 0 ) {
 		palettes.skinning_matrices = ALLOC_SPAN( a, Mat4, model->num_joints );
 	}
+	return palettes;
+}
+
+void ComputeMatrixPalettes( MatrixPalettes * palettes, const Model * model, Span< const TRS > local_poses ) {
+	assert( local_poses.n == model->num_nodes );
+	assert( palettes->node_transforms.n == model->num_nodes );
+	assert( palettes->skinning_matrices.n == model->num_joints );
 
+	// nodes are sorted so parents always come before their children
 	for( u8 i = 0; i < model->num_nodes; i++ ) {
 		u8 parent = model->nodes[ i ].parent;
 		if( parent == U8_MAX ) {
-			palettes.node_transforms[ i ] = TRSToMat4( local_poses[ i ] );
+			palettes->node_transforms[ i ] = TRSToMat4( local_poses[ i ] );
 		}
 		else {
-			palettes.node_transforms[ i ] = palettes.node_transforms[ parent ] * TRSToMat4( local_poses[ i ] );
+			Mat4MulSSE( &palettes->node_transforms[ i ], palettes->node_transforms[ parent ], TRSToMat4( local_poses[ i ] ) );
 		}
 	}
 
 	for( u8 i = 0; i < model->num_joints; i++ ) {
 		u8 node_idx = model->skin[ i ].node_idx;
-		palettes.skinning_matrices[ i ] = palettes.node_transforms[ node_idx ] * model->skin[ i ].joint_to_bind;
+		Mat4MulSSE( &palettes->skinning_matrices[ i ], palettes->node_transforms[ node_idx ], model->skin[ i ].joint_to_bind );
 	}
+}
+
+MatrixPalettes ComputeMatrixPalettes( Allocator * a, const Model * model, Span< const TRS > local_poses ) {
+	ZoneScoped;
 
+	MatrixPalettes palettes = AllocMatrixPalettes( a, model );
+	ComputeMatrixPalettes( &palettes, model, local_poses );
 	return palettes;
 }
 
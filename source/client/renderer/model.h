@@ -15,6 +15,7 @@ struct Model {
 		Mesh mesh;
 		u32 first_index;
 		u32 num_vertices;
+		MinMax3 bounds;
 	};
 
 	template< typename T >
@@ -75,7 +76,7 @@ void DeleteModel( Model * model );
 bool LoadGLTFModel( Model * model, const char * path );
 
 struct Map;
-bool LoadBSPRenderData( Map * map, u64 base_hash, Span< const u8 > data );
+bool LoadBSPRenderData( Map * map, u64 base_hash, Span< const u8 > data, u32 checksum );
 void DeleteBSPRenderData( Map * map );
 
 void DrawModelPrimitive( const Model * model, const Model::Primitive * primitive, const PipelineState & pipeline );
@@ -85,8 +86,12 @@ void DrawOutlinedViewWeapon( const Model * model, const Mat4 & transform, const
 void DrawModelSilhouette( const Model * model, const Mat4 & transform, const Vec4 & color, MatrixPalettes palettes = MatrixPalettes() );
 void DrawOutlinedModel( const Model * model, const Mat4 & transform, const Vec4 & color, float outline_height, MatrixPalettes palettes = MatrixPalettes() );
 void DrawModelShadow( const Model * model, const Mat4 & transform, const Vec4 & color, MatrixPalettes palettes = MatrixPalettes() );
+void FlushModelInstances();
 
 Span< TRS > SampleAnimation( Allocator * a, const Model * model, float t );
+void SampleAnimation( Span< TRS > local_poses, const Model * model, float t );
 MatrixPalettes ComputeMatrixPalettes( Allocator * a, const Model * model, Span< const TRS > local_poses );
+MatrixPalettes AllocMatrixPalettes( Allocator * a, const Model * model );
+void ComputeMatrixPalettes( MatrixPalettes * palettes, const Model * model, Span< const TRS > local_poses );
 bool FindNodeByName( const Model * model, u32 name, u8 * idx );
 void MergeLowerUpperPoses( Span< TRS > lower, Span< const TRS > upper, const Model * model, u8 upper_root_joint );
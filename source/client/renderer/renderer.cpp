@@ -129,6 +129,8 @@ void InitRenderer() {
 	strcpy( last_screenshot_date, "" );
 	same_date_count = 0;
 
+	InitCulling();
+
 	InitShaders();
 	InitMaterials();
 	InitText();
@@ -524,6 +526,12 @@ void RendererSetView( Vec3 position, EulerDegrees3 angles, float vertical_fov )
 	frame_static.near_shadowmap_VP = near_shadow_projection * shadow_view;
 	frame_static.far_shadowmap_VP = far_shadow_projection * shadow_view;
 
+	// shadowmaps clamp depth so only the sides matter
+	frame_static.frustum = FrustumFromMatrix( frame_static.P * frame_static.V, true );
+	frame_static.near_shadowmap_frustum = FrustumFromMatrix( frame_static.near_shadowmap_VP, false );
+	frame_static.far_shadowmap_frustum = FrustumFromMatrix( frame_static.far_shadowmap_VP, false );
+	SetCullingView( position );
+
 	frame_static.near_shadowmap_view_uniforms = UploadViewUniforms( shadow_view, Mat4::Identity(), near_shadow_projection, Mat4::Identity(), Vec3(), frame_static.viewport, near_plane, frame_static.msaa_samples, Mat4::Identity(), Mat4::Identity(), frame_static.light_direction );
 	frame_static.far_shadowmap_view_uniforms = UploadViewUniforms( shadow_view, Mat4::Identity(), far_shadow_projection, Mat4::Identity(), Vec3(), frame_static.viewport, near_plane, frame_static.msaa_samples, Mat4::Identity(), Mat4::Identity(), frame_static.light_direction );
 
@@ -533,6 +541,8 @@ void RendererSetView( Vec3 position, EulerDegrees3 angles, float vertical_fov )
 }
 
 void RendererSubmitFrame() {
+	FlushModelInstances();
+	PlotAndResetCullingStats();
 	RenderBackendSubmitFrame();
 }
 
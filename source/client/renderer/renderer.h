@@ -2,6 +2,7 @@
 
 #include "qcommon/types.h"
 #include "client/renderer/backend.h"
+#include "client/renderer/culling.h"
 #include "client/renderer/material.h"
 #include "client/renderer/model.h"
 #include "client/renderer/shader.h"
@@ -31,6 +32,8 @@ struct FrameStatic {
 	Mat4 P, inverse_P;
 	Vec3 light_direction;
 	Mat4 near_shadowmap_VP, far_shadowmap_VP;
+	Frustum frustum;
+	Frustum near_shadowmap_frustum, far_shadowmap_frustum;
 	Vec3 position;
 	float vertical_fov;
 	float near_plane;
@@ -89,6 +92,7 @@ void RendererSubmitFrame();
 const Texture * BlueNoiseTexture();
 void DrawFullscreenMesh( const PipelineState & pipeline );
 
+Vec4 EvaluateMaterialColor( const Material * material, Vec4 color );
 PipelineState MaterialToPipelineState( const Material * material, Vec4 color = vec4_white, bool skinned = false );
 
 void Draw2DBox( float x, float y, float w, float h, const Material * material, Vec4 color = vec4_white );
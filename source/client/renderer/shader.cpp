@@ -92,6 +92,21 @@ static void LoadShaders() {
 	BuildShaderSrcs( "glsl/standard.glsl", "#define ALPHA_TEST 1\n", &srcs, &lengths );
 	ReplaceShader( &shaders.standard_alphatest, srcs.span(), lengths.span() );
 
+	BuildShaderSrcs( "glsl/standard.glsl", "#define INSTANCED 1\n", &srcs, &lengths );
+	ReplaceShader( &shaders.standard_instanced, srcs.span(), lengths.span() );
+
+	BuildShaderSrcs( "glsl/standard.glsl", "#define INSTANCED 1\n#define SHADED 1\n", &srcs, &lengths );
+	ReplaceShader( &shaders.standard_shaded_instanced, srcs.span(), lengths.span() );
+
+	BuildShaderSrcs( "glsl/standard.glsl", "#define INSTANCED 1\n#define ALPHA_TEST 1\n", &srcs, &lengths );
+	ReplaceShader( &shaders.standard_alphatest_instanced, srcs.span(), lengths.span() );
+
+	BuildShaderSrcs( "glsl/standard.glsl", "#define INSTANCED 1\n#define SKINNED 1\n", &srcs, &lengths );
+	ReplaceShader( &shaders.standard_skinned_instanced, srcs.span(), lengths.span() );
+
+	BuildShaderSrcs( "glsl/standard.glsl", "#define INSTANCED 1\n#define SKINNED 1\n#define SHADED 1\n", &srcs, &lengths );
+	ReplaceShader( &shaders.standard_skinned_shaded_instanced, srcs.span(), lengths.span() );
+
 	const char * world_defines = temp(
 		"#define APPLY_DRAWFLAT 1\n"
 		"#define APPLY_FOG 1\n"
@@ -110,6 +125,12 @@ static void LoadShaders() {
 	BuildShaderSrcs( "glsl/depth_only.glsl", "#define SKINNED 1\n", &srcs, &lengths );
 	ReplaceShader( &shaders.depth_only_skinned, srcs.span(), lengths.span() );
 
+	BuildShaderSrcs( "glsl/depth_only.glsl", "#define INSTANCED 1\n", &srcs, &lengths );
+	ReplaceShader( &shaders.depth_only_instanced, srcs.span(), lengths.span() );
+
+	BuildShaderSrcs( "glsl/depth_only.glsl", "#define INSTANCED 1\n#define SKINNED 1\n", &srcs, &lengths );
+	ReplaceShader( &shaders.depth_only_skinned_instanced, srcs.span(), lengths.span() );
+
 	BuildShaderSrcs( "glsl/postprocess_world_gbuffer.glsl", NULL, &srcs, &lengths );
 	ReplaceShader( &shaders.postprocess_world_gbuffer, srcs.span(), lengths.span() );
 
@@ -13,8 +13,16 @@ struct Shaders {
 
 	Shader standard_alphatest;
 
+	Shader standard_instanced;
+	Shader standard_shaded_instanced;
+	Shader standard_alphatest_instanced;
+	Shader standard_skinned_instanced;
+	Shader standard_skinned_shaded_instanced;
+
 	Shader depth_only;
 	Shader depth_only_skinned;
+	Shader depth_only_instanced;
+	Shader depth_only_skinned_instanced;
 
 	Shader world;
 	Shader postprocess_world_gbuffer;
@@ -1,6 +1,30 @@
 #include "game/g_local.h"
 #include "gameshared/gs_public.h"
 
+static constexpr float AI_NODE_RADIUS = 24.0f;
+static constexpr u32 AI_PATH_LOOKAHEAD = 4;
+static constexpr int64_t AI_STUCK_TIME = 3000;
+static constexpr int64_t AI_WANDER_TIME = 1000;
+static constexpr int64_t AI_ENEMY_CHECK_INTERVAL = 250;
+static constexpr float AI_SIGHT_RANGE = 2048.0f;
+
+struct BotState {
+	u32 goal;
+	u32 path[ NAV_MAX_PATH ];
+	u32 path_len;
+	u32 path_pos;
+	int64_t progress_time;
+
+	int64_t wander_until;
+	float wander_yaw;
+
+	int enemy;
+	int64_t next_enemy_check;
+};
+
+static BotState bots[ MAX_CLIENTS ];
+static u64 bot_think_time;
+
 static const char * bot_names[] = {
 	"vic",
 	"crizis",
@@ -56,7 +80,7 @@ void AI_SpawnBot() {
 		return;
 
 	ent->think = NULL;
-	ent->nextThink = level.time + 500 + RandomUniform( &svs.rng, 0, 2000 );
+	G_SetNextThink( ent, level.time + 500 + RandomUniform( &svs.rng, 0, 2000 ) );
 	ent->classname = "bot";
 	ent->die = player_die;
 
@@ -66,6 +90,15 @@ void AI_SpawnBot() {
 }
 
 void AI_Respawn( edict_t * ent ) {
+	BotState * bot = &bots[ PLAYERNUM( ent ) ];
+	bot->goal = NAV_NONE;
+	bot->path_len = 0;
+	bot->path_pos = 0;
+	bot->progress_time = level.time;
+	bot->wander_until = 0;
+	bot->enemy = 0;
+	bot->next_enemy_check = level.time + RandomUniform( &svs.rng, 0, AI_ENEMY_CHECK_INTERVAL );
+
 	ent->r.client->ps.pmove.delta_angles[ 0 ] = 0;
 	ent->r.client->ps.pmove.delta_angles[ 1 ] = 0;
 	ent->r.client->ps.pmove.delta_angles[ 2 ] = 0;
@@ -73,7 +106,7 @@ void AI_Respawn( edict_t * ent ) {
 }
 
 static void AI_SpecThink( edict_t * self ) {
-	self->nextThink = level.time + 100;
+	G_SetNextThink( self, level.time + 100 );
 
 	if( !level.canSpawnEntities )
 		return;
@@ -85,9 +118,9 @@ static void AI_SpecThink( edict_t * self ) {
 		}
 
 		if( self->r.client->team == TEAM_SPECTATOR ) { // couldn't join, delay the next think
-			self->nextThink = level.time + 100;
+			G_SetNextThink( self, level.time + 100 );
 		} else {
-			self->nextThink = level.time + 1;
+			G_SetNextThink( self, level.time + 1 );
 		}
 		return;
 	}
@@ -102,18 +135,170 @@ static void AI_SpecThink( edict_t * self ) {
 	ClientThink( self, &ucmd, 0 );
 }
 
+static void AI_PlanPath( edict_t * self, BotState * bot ) {
+	u32 start = Nav_StartNode( self->s.origin );
+	if( start == NAV_NONE )
+		return;
+
+	if( bot->goal == NAV_NONE ) {
+		bot->goal = Nav_RandomGoal( &svs.rng );
+	}
+
+	NavPathResult result = Nav_FindPath( start, bot->goal, bot->path, &bot->path_len );
+	if( result == NavPath_NoPath ) {
+		bot->goal = NAV_NONE;
+		bot->path_len = 0;
+	}
+
+	bot->path_pos = 0;
+	bot->progress_time = level.time;
+}
+
+/*
+* AI_FollowPath
+* returns the direction we want to run in, or zero if we're waiting on a path
+*/
+static Vec3 AI_FollowPath( edict_t * self, BotState * bot, usercmd_t * ucmd ) {
+	// run off in some random direction and try again from wherever we end
+	// up. this also gets us off spots that aren't near the graph
+	if( level.time - bot->progress_time > AI_STUCK_TIME ) {
+		bot->goal = NAV_NONE;
+		bot->path_len = 0;
+		bot->path_pos = 0;
+		bot->progress_time = level.time + AI_WANDER_TIME;
+		bot->wander_until = level.time + AI_WANDER_TIME;
+		bot->wander_yaw = RandomUniformFloat( &svs.rng, 0.0f, 360.0f );
+	}
+
+	if( level.time < bot->wander_until ) {
+		return Vec3( cosf( Radians( bot->wander_yaw ) ), sinf( Radians( bot->wander_yaw ) ), 0.0f );
+	}
+
+	if( bot->path_pos >= bot->path_len ) {
+		AI_PlanPath( self, bot );
+		if( bot->path_pos >= bot->path_len )
+			return Vec3( 0.0f );
+	}
+
+	// skip ahead if we got past a node, e.g. by overshooting a jump
+	Vec3 origin = self->s.origin;
+	u32 nearest = Nav_NearestNode( origin );
+	u32 lookahead = Min2( bot->path_pos + AI_PATH_LOOKAHEAD, bot->path_len );
+	for( u32 i = bot->path_pos; i < lookahead; i++ ) {
+		Vec3 d = Nav_NodeOrigin( bot->path[ i ] ) - origin;
+		bool reached = Length( d.xy() ) < AI_NODE_RADIUS && Abs( d.z ) < STEPSIZE * 2;
+		if( reached || ( i > bot->path_pos && bot->path[ i ] == nearest ) ) {
+			bot->path_pos = i + 1;
+			bot->progress_time = level.time;
+		}
+	}
+
+	if( bot->path_pos >= bot->path_len ) {
+		// long paths get cut short, keep going to the same goal
+		if( bot->path[ bot->path_len - 1 ] == bot->goal ) {
+			bot->goal = NAV_NONE;
+		}
+		return Vec3( 0.0f );
+	}
+
+	if( bot->path_pos > 0 ) {
+		NavLinkType type = Nav_LinkType( bot->path[ bot->path_pos - 1 ], bot->path[ bot->path_pos ] );
+		if( type == NavLink_Jump ) {
+			ucmd->upmove = 127;
+		}
+		else if( type == NavLink_Dash ) {
+			ucmd->buttons |= BUTTON_SPECIAL;
+		}
+	}
+
+	Vec3 dir = Nav_NodeOrigin( bot->path[ bot->path_pos ] ) - origin;
+	dir.z = 0.0f;
+	return dir;
+}
+
+static bool AI_IsEnemy( const edict_t * self, const edict_t * other ) {
+	if( other == self || !other->r.inuse || G_ISGHOSTING( other ) || G_IsDead( other ) )
+		return false;
+	return !GS_TeamBasedGametype( &server_gs ) || other->s.team != self->s.team;
+}
+
+/*
+* AI_UpdateEnemy
+* looking for enemies costs a trace per player, so only do it a few times a
+* second and keep shooting at whoever we saw last in between
+*/
+static edict_t * AI_UpdateEnemy( edict_t * self, BotState * bot, Vec3 eye ) {
+	if( level.time >= bot->next_enemy_check ) {
+		bot->next_enemy_check = level.time + AI_ENEMY_CHECK_INTERVAL;
+		bot->enemy = 0;
+
+		float best_dist = AI_SIGHT_RANGE;
+		for( int i = 0; i < server_gs.maxclients; i++ ) {
+			edict_t * other = game.edicts + 1 + i;
+			if( !AI_IsEnemy( self, other ) )
+				continue;
+
+			float dist = Length( other->s.origin - self->s.origin );
+			if( dist >= best_dist )
+				continue;
+
+			trace_t tr;
+			G_Trace( &tr, eye, Vec3( 0.0f ), Vec3( 0.0f ), other->s.origin, self, MASK_SHOT );
+			if( tr.fraction < 1.0f && tr.ent != ENTNUM( other ) )
+				continue;
+
+			bot->enemy = ENTNUM( other );
+			best_dist = dist;
+		}
+	}
+
+	if( bot->enemy == 0 || !AI_IsEnemy( self, &game.edicts[ bot->enemy ] ) )
+		return NULL;
+
+	return &game.edicts[ bot->enemy ];
+}
+
 static void AI_GameThink( edict_t * self ) {
 	if( server_gs.gameState.match_state <= MATCH_STATE_WARMUP ) {
 		G_Match_Ready( self );
 	}
 
+	u64 think_start = Sys_Microseconds();
+
 	usercmd_t ucmd;
 	memset( &ucmd, 0, sizeof( usercmd_t ) );
 
+	Vec3 angles = self->s.angles;
+
+	if( !G_IsDead( self ) ) {
+		BotState * bot = &bots[ PLAYERNUM( self ) ];
+		Vec3 move = AI_FollowPath( self, bot, &ucmd );
+
+		Vec3 eye = self->s.origin + Vec3( 0.0f, 0.0f, self->r.client->ps.viewheight );
+		const edict_t * enemy = AI_UpdateEnemy( self, bot, eye );
+		if( enemy != NULL ) {
+			Vec3 jitter = Vec3( RandomFloat11( &svs.rng ), RandomFloat11( &svs.rng ), RandomFloat11( &svs.rng ) ) * 16.0f;
+			angles = VecToAngles( enemy->s.origin + jitter - eye );
+			ucmd.buttons |= BUTTON_ATTACK;
+		}
+		else if( Length( move ) > 0.0f ) {
+			angles = Vec3( 0.0f, VecToAngles( move ).y, 0.0f );
+		}
+
+		// run where we're going while looking wherever we're shooting
+		if( Length( move ) > 0.0f ) {
+			float delta = Radians( VecToAngles( move ).y - angles.y );
+			ucmd.forwardmove = s8( 127.0f * cosf( delta ) );
+			ucmd.sidemove = s8( -127.0f * sinf( delta ) );
+		}
+	}
+
+	bot_think_time += Sys_Microseconds() - think_start;
+
 	// set up for pmove
-	ucmd.angles[ 0 ] = (short)ANGLE2SHORT( self->s.angles.x ) - self->r.client->ps.pmove.delta_angles[ 0 ];
-	ucmd.angles[ 1 ] = (short)ANGLE2SHORT( self->s.angles.y ) - self->r.client->ps.pmove.delta_angles[ 1 ];
-	ucmd.angles[ 2 ] = (short)ANGLE2SHORT( self->s.angles.z ) - self->r.client->ps.pmove.delta_angles[ 2 ];
+	ucmd.angles[ 0 ] = (short)ANGLE2SHORT( angles.x ) - self->r.client->ps.pmove.delta_angles[ 0 ];
+	ucmd.angles[ 1 ] = (short)ANGLE2SHORT( angles.y ) - self->r.client->ps.pmove.delta_angles[ 1 ];
+	ucmd.angles[ 2 ] = (short)ANGLE2SHORT( angles.z ) - self->r.client->ps.pmove.delta_angles[ 2 ];
 
 	self->r.client->ps.pmove.delta_angles[ 0 ] = 0;
 	self->r.client->ps.pmove.delta_angles[ 1 ] = 0;
@@ -124,7 +309,7 @@ static void AI_GameThink( edict_t * self ) {
 	ucmd.serverTimeStamp = svs.gametime;
 
 	ClientThink( self, &ucmd, 0 );
-	self->nextThink = level.time + 1;
+	G_SetNextThink( self, level.time + 1 );
 }
 
 void AI_Think( edict_t * self ) {
@@ -135,3 +320,14 @@ void AI_Think( edict_t * self ) {
 		AI_GameThink( self );
 	}
 }
+
+/*
+* AI_Frame
+* plots what the bots cost last frame, path planning runs on its own
+*/
+void AI_Frame() {
+	TracyPlot( "Bot think time (us)", s64( bot_think_time ) );
+	bot_think_time = 0;
+
+	Nav_Frame();
+}
@@ -1,5 +1,37 @@
 #pragma once
 
+struct RNG;
+
 void AI_SpawnBot();
 void AI_Respawn( edict_t * ent );
 void AI_Think( edict_t * self );
+void AI_Frame();
+
+// g_nav.cpp
+
+constexpr u32 NAV_NONE = U32_MAX;
+constexpr u32 NAV_MAX_PATH = 256;
+
+enum NavLinkType : u8 {
+	NavLink_Walk,
+	NavLink_Jump,
+	NavLink_Dash,
+};
+
+enum NavPathResult {
+	NavPath_Found,
+	NavPath_Pending,
+	NavPath_NoPath,
+};
+
+void Nav_Init();
+void Nav_Shutdown();
+void Nav_BuildForLevel();
+void Nav_Frame();
+
+u32 Nav_NearestNode( Vec3 origin );
+u32 Nav_StartNode( Vec3 origin );
+u32 Nav_RandomGoal( RNG * rng );
+Vec3 Nav_NodeOrigin( u32 node );
+NavLinkType Nav_LinkType( u32 from, u32 to );
+NavPathResult Nav_FindPath( u32 start, u32 goal, u32 * path, u32 * path_len );
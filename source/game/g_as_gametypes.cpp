@@ -64,7 +64,7 @@ void GT_asCallSpawn() {
 		return;
 	}
 
-	error = ctx->Execute();
+	error = G_ExecuteScript( ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -86,7 +86,7 @@ void GT_asCallMatchStateStarted() {
 		return;
 	}
 
-	error = ctx->Execute();
+	error = G_ExecuteScript( ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -112,7 +112,7 @@ bool GT_asCallMatchStateFinished( int incomingMatchState ) {
 	// Now we need to pass the parameters to the script function.
 	ctx->SetArgDWord( 0, incomingMatchState );
 
-	error = ctx->Execute();
+	error = G_ExecuteScript( ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -139,7 +139,7 @@ void GT_asCallThinkRules() {
 		return;
 	}
 
-	error = ctx->Execute();
+	error = G_ExecuteScript( ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -166,7 +166,7 @@ void GT_asCallPlayerRespawn( edict_t *ent, int old_team, int new_team ) {
 	ctx->SetArgDWord( 1, old_team );
 	ctx->SetArgDWord( 2, new_team );
 
-	error = ctx->Execute();
+	error = G_ExecuteScript( ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -205,7 +205,7 @@ void GT_asCallScoreEvent( gclient_t *client, const char *score_event, const char
 	ctx->SetArgObject( 1, s1 );
 	ctx->SetArgObject( 2, s2 );
 
-	error = ctx->Execute();
+	error = G_ExecuteScript( ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -232,7 +232,7 @@ edict_t *GT_asCallSelectSpawnPoint( edict_t *ent ) {
 	// Now we need to pass the parameters to the script function.
 	ctx->SetArgObject( 0, ent );
 
-	error = ctx->Execute();
+	error = G_ExecuteScript( ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -272,7 +272,7 @@ bool GT_asCallGameCommand( gclient_t *client, const char *cmd, const char *args,
 	ctx->SetArgObject( 2, s2 );
 	ctx->SetArgDWord( 3, argc );
 
-	error = ctx->Execute();
+	error = G_ExecuteScript( ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -300,7 +300,7 @@ void GT_asCallShutdown() {
 		return;
 	}
 
-	error = ctx->Execute();
+	error = G_ExecuteScript( ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -425,7 +425,7 @@ static bool G_asInitializeGametypeScript( asIScriptModule *asModule ) {
 		return false;
 	}
 
-	error = ctx->Execute();
+	error = G_ExecuteScript( ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		return false;
 	}
@@ -31,3 +31,4 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 asIScriptModule *G_LoadGameScript( const char *dir, const char *filename, const char *ext );
 bool G_ExecutionErrorReport( int error );
+int G_ExecuteScript( asIScriptContext *ctx );
@@ -21,6 +21,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "game/g_local.h"
 #include "game/g_as_local.h"
 #include "qcommon/cmodel.h"
+#include "qcommon/metrics.h"
 #include "qcommon/string.h"
 
 #include "game/angelwrap/qas_public.h"
@@ -957,6 +958,22 @@ static void objectGameEntity_SetVelocity( asvec3_t *vel, edict_t *self ) {
 	}
 }
 
+static int objectGameEntity_GetMoveType( edict_t *obj ) {
+	return obj->movetype;
+}
+
+static void objectGameEntity_SetMoveType( int movetype, edict_t *self ) {
+	G_SetMovetype( self, movetype );
+}
+
+static int64_t objectGameEntity_GetNextThink( edict_t *obj ) {
+	return obj->nextThink;
+}
+
+static void objectGameEntity_SetNextThink( int64_t nextThink, edict_t *self ) {
+	G_SetNextThink( self, nextThink );
+}
+
 static asvec3_t objectGameEntity_GetAVelocity( edict_t *obj ) {
 	asvec3_t avelocity;
 
@@ -1153,6 +1170,10 @@ static const asMethod_t gedict_Methods[] =
 {
 	{ ASLIB_FUNCTION_DECL( Vec3, get_velocity, ( ) const ), asFUNCTION( objectGameEntity_GetVelocity ), asCALL_CDECL_OBJLAST },
 	{ ASLIB_FUNCTION_DECL( void, set_velocity, ( const Vec3 &in ) ), asFUNCTION( objectGameEntity_SetVelocity ), asCALL_CDECL_OBJLAST },
+	{ ASLIB_FUNCTION_DECL( int, get_moveType, ( ) const ), asFUNCTION( objectGameEntity_GetMoveType ), asCALL_CDECL_OBJLAST },
+	{ ASLIB_FUNCTION_DECL( void, set_moveType, ( int ) ), asFUNCTION( objectGameEntity_SetMoveType ), asCALL_CDECL_OBJLAST },
+	{ ASLIB_FUNCTION_DECL( int64, get_nextThink, ( ) const ), asFUNCTION( objectGameEntity_GetNextThink ), asCALL_CDECL_OBJLAST },
+	{ ASLIB_FUNCTION_DECL( void, set_nextThink, ( int64 ) ), asFUNCTION( objectGameEntity_SetNextThink ), asCALL_CDECL_OBJLAST },
 	{ ASLIB_FUNCTION_DECL( Vec3, get_avelocity, ( ) const ), asFUNCTION( objectGameEntity_GetAVelocity ), asCALL_CDECL_OBJLAST },
 	{ ASLIB_FUNCTION_DECL( void, set_avelocity, ( const Vec3 &in ) ), asFUNCTION( objectGameEntity_SetAVelocity ), asCALL_CDECL_OBJLAST },
 	{ ASLIB_FUNCTION_DECL( Vec3, get_origin, ( ) const ), asFUNCTION( objectGameEntity_GetOrigin ), asCALL_CDECL_OBJLAST },
@@ -1212,8 +1233,6 @@ static const asProperty_t gedict_Properties[] =
 	{ ASLIB_PROPERTY_DECL( int, clipMask ), offsetof( edict_t, r.clipmask ) },
 	{ ASLIB_PROPERTY_DECL( int, spawnFlags ), offsetof( edict_t, spawnflags ) },
 	{ ASLIB_PROPERTY_DECL( int, style ), offsetof( edict_t, style ) },
-	{ ASLIB_PROPERTY_DECL( int, moveType ), offsetof( edict_t, movetype ) },
-	{ ASLIB_PROPERTY_DECL( int64, nextThink ), offsetof( edict_t, nextThink ) },
 	{ ASLIB_PROPERTY_DECL( float, health ), offsetof( edict_t, health ) },
 	{ ASLIB_PROPERTY_DECL( int, viewHeight ), offsetof( edict_t, viewheight ) },
 	{ ASLIB_PROPERTY_DECL( int, takeDamage ), offsetof( edict_t, takedamage ) },
@@ -1727,7 +1746,7 @@ bool G_asCallMapEntitySpawnScript( Span< const char > classname, edict_t *ent )
 	// Now we need to pass the parameters to the script function.
 	asContext->SetArgObject( 0, ent );
 
-	error = asContext->Execute();
+	error = G_ExecuteScript( asContext );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 		ent->asSpawnFunc = NULL;
@@ -1796,7 +1815,7 @@ void G_asCallMapEntityThink( edict_t *ent ) {
 	// Now we need to pass the parameters to the script function.
 	ctx->SetArgObject( 0, ent );
 
-	error = ctx->Execute();
+	error = G_ExecuteScript( ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -1831,7 +1850,7 @@ void G_asCallMapEntityTouch( edict_t *ent, edict_t *other, cplane_t *plane, int
 	ctx->SetArgObject( 2, &normal );
 	ctx->SetArgDWord( 3, surfFlags );
 
-	error = ctx->Execute();
+	error = G_ExecuteScript( ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -1858,7 +1877,7 @@ void G_asCallMapEntityUse( edict_t *ent, edict_t *other, edict_t *activator ) {
 	ctx->SetArgObject( 1, other );
 	ctx->SetArgObject( 2, activator );
 
-	error = ctx->Execute();
+	error = G_ExecuteScript( ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -1886,7 +1905,7 @@ void G_asCallMapEntityPain( edict_t *ent, edict_t *other, float kick, float dama
 	ctx->SetArgFloat( 2, kick );
 	ctx->SetArgFloat( 3, damage );
 
-	error = ctx->Execute();
+	error = G_ExecuteScript( ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -1913,7 +1932,7 @@ void G_asCallMapEntityDie( edict_t *ent, edict_t *inflicter, edict_t *attacker,
 	ctx->SetArgObject( 1, inflicter );
 	ctx->SetArgObject( 2, attacker );
 
-	error = ctx->Execute();
+	error = G_ExecuteScript( ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -1938,7 +1957,7 @@ void G_asCallMapEntityStop( edict_t *ent ) {
 	// Now we need to pass the parameters to the script function.
 	ctx->SetArgObject( 0, ent );
 
-	error = ctx->Execute();
+	error = G_ExecuteScript( ctx );
 	if( G_ExecutionErrorReport( error ) ) {
 		GT_asShutdownScript();
 	}
@@ -1954,6 +1973,33 @@ bool G_ExecutionErrorReport( int error ) {
 	return true;
 }
 
+static Metric *metric_script_seconds;
+static int script_depth;
+
+/*
+* G_ExecuteScript
+*
+* Execute with the time spent counted towards game_script_seconds_total.
+* Scripts can call back into the game and run more script, so only the
+* outermost call is timed.
+*/
+int G_ExecuteScript( asIScriptContext *ctx ) {
+	if( script_depth > 0 ) {
+		return ctx->Execute();
+	}
+
+	s64 start = Sys_Microseconds();
+	script_depth++;
+	int error = ctx->Execute();
+	script_depth--;
+
+	if( metric_script_seconds != NULL ) {
+		Increment( metric_script_seconds, ( Sys_Microseconds() - start ) / 1000000.0 );
+	}
+
+	return error;
+}
+
 /*
 * G_LoadGameScript
 */
@@ -2171,6 +2217,8 @@ void G_asInitGameModuleEngine() {
 
 	game.asEngine = asEngine;
 
+	metric_script_seconds = NewCounter( "game_script_seconds_total", "Time spent running gametype scripts" );
+
 	G_InitializeGameModuleSyntax( asEngine );
 }
 
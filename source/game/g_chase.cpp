@@ -230,7 +230,7 @@ void G_ChasePlayer( edict_t *ent, const char *name, bool teamonly, int followmod
 	} else {
 		// stay as observer
 		if( !teamonly ) {
-			ent->movetype = MOVETYPE_NOCLIP;
+			G_SetMovetype( ent, MOVETYPE_NOCLIP );
 		}
 		client->level.showscores = false;
 		G_Chase_SetChaseActive( ent, false );
@@ -394,7 +394,7 @@ void G_SpectatorMode( edict_t *ent ) {
 		ent->r.client->ps.pmove.dash_speed = DEFAULT_DASHSPEED;
 	}
 
-	ent->movetype = MOVETYPE_NOCLIP;
+	G_SetMovetype( ent, MOVETYPE_NOCLIP );
 }
 
 /*
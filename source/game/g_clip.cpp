@@ -43,15 +43,26 @@ typedef struct
 	Vec3 mins;
 	Vec3 maxs;
 	Vec3 size;
-	int marknumber;
-
-	// since the areagrid can have multiple references to one entity,
-	// we should avoid extensive checking on entities already encountered
-	int entmarknumber[MAX_EDICTS];
 } areagrid_t;
 
 static areagrid_t g_areagrid;
 
+// bumped when the world changes so cached entity leafs get thrown away
+static int leafs_generation = 1;
+
+// bumped when something other than a client that traces can hit is linked
+// or unlinked, so predicted client moves know the world changed under them
+static int solid_links_generation;
+
+struct relinkstats_t {
+	u32 links;
+	u32 leaf_walks;
+	u32 grid_relinks;
+};
+
+static relinkstats_t relink_frame_stats;
+static relinkstats_t relink_total_stats;
+
 #define CFRAME_UPDATE_BACKUP    64  // copies of SyncEntityState to keep buffered (1 second of backup at 62 fps).
 #define CFRAME_UPDATE_MASK  ( CFRAME_UPDATE_BACKUP - 1 )
 
@@ -60,9 +71,19 @@ struct c4clipedict_t {
 	entity_shared_t r;
 };
 
+// compact copy of what the broadphase needs, so rejecting candidates at a
+// rewound time doesn't touch the full backed up entity
+struct c4cliprecord_t {
+	Vec3 absmin, absmax;
+	solid_t solid;
+	bool inuse;
+	int64_t state_framenum; // first backed up frame with this solid/inuse
+};
+
 //backups of all server frames areas and edicts
 struct c4frame_t {
 	c4clipedict_t clipEdicts[MAX_EDICTS];
+	c4cliprecord_t records[MAX_EDICTS];
 	int numedicts;
 
 	int64_t timestamp;
@@ -72,73 +93,68 @@ struct c4frame_t {
 static c4frame_t sv_collisionframes[CFRAME_UPDATE_BACKUP];
 static int64_t sv_collisionFrameNum = 0;
 
+static c4frame_t *GClip_CollisionFrame( int64_t framenum ) {
+	return &sv_collisionframes[framenum & CFRAME_UPDATE_MASK];
+}
+
 void GClip_BackUpCollisionFrame() {
-	c4frame_t *cframe;
-	edict_t *svedict;
-	int i;
+	ZoneScoped;
 
 	// fixme: should check for any validation here?
 
-	cframe = &sv_collisionframes[sv_collisionFrameNum & CFRAME_UPDATE_MASK];
+	const c4frame_t *prev = sv_collisionFrameNum > 0 ? GClip_CollisionFrame( sv_collisionFrameNum - 1 ) : NULL;
+
+	c4frame_t *cframe = GClip_CollisionFrame( sv_collisionFrameNum );
 	cframe->timestamp = svs.gametime;
 	cframe->framenum = sv_collisionFrameNum;
 	sv_collisionFrameNum++;
 
-	//memset( cframe->clipEdicts, 0, sizeof(cframe->clipEdicts) );
-
 	//backup edicts
-	for( i = 0; i < game.numentities; i++ ) {
-		svedict = &game.edicts[i];
+	for( int i = 0; i < game.numentities; i++ ) {
+		const edict_t *svedict = &game.edicts[i];
+		c4cliprecord_t *record = &cframe->records[i];
+
+		record->inuse = svedict->r.inuse;
+		record->solid = svedict->r.solid;
+
+		bool same_state = prev != NULL && i < prev->numedicts
+			&& prev->records[i].inuse == record->inuse && prev->records[i].solid == record->solid;
+		record->state_framenum = same_state ? prev->records[i].state_framenum : cframe->framenum;
 
-		cframe->clipEdicts[i].r.inuse = svedict->r.inuse;
-		cframe->clipEdicts[i].r.solid = svedict->r.solid;
 		if( !svedict->r.inuse || svedict->r.solid == SOLID_NOT
 			|| ( svedict->r.solid == SOLID_TRIGGER && !( i >= 1 && i <= server_gs.maxclients ) ) ) {
 			continue;
 		}
 
+		record->absmin = svedict->r.absmin;
+		record->absmax = svedict->r.absmax;
 		cframe->clipEdicts[i].r = svedict->r;
 		cframe->clipEdicts[i].s = svedict->s;
 	}
 	cframe->numedicts = game.numentities;
 }
 
-static c4clipedict_t *GClip_GetClipEdictForDeltaTime( int entNum, int deltaTime ) {
-	static int index = 0;
-	static c4clipedict_t clipEnts[8];
-	static c4clipedict_t *clipent;
-	static c4clipedict_t clipentNewer; // for interpolation
-	c4frame_t *cframe = NULL;
-	int64_t backTime, cframenum;
-	unsigned bf;
-	edict_t *ent = game.edicts + entNum;
-
-	// pick one of the 8 slots to prevent overwritings
-	clipent = &clipEnts[index];
-	index = ( index + 1 ) & 7;
-
-	if( !entNum || deltaTime >= 0 ) { // current time entity
-		clipent->r = ent->r;
-		clipent->s = ent->s;
-		return clipent;
-	}
+/*
+* the backed up frame to use for a given time delta, which is the same for
+* every entity. entities whose solid/inuse changed since then fall back to
+* the oldest frame in their current state in GClip_RewindFrameForEntity
+*/
+struct cliprewind_t {
+	const c4frame_t *frame; // NULL means use the live entities
+	const c4frame_t *newer; // NULL means interpolate towards the live entities
+	bool interpolate;
+	float lerpFrac;
+};
 
-	if( !ent->r.inuse || ent->r.solid == SOLID_NOT
-		|| ( ent->r.solid == SOLID_TRIGGER && !( entNum >= 1 && entNum <= server_gs.maxclients ) ) ) {
-		clipent->r = ent->r;
-		clipent->s = ent->s;
-		return clipent;
-	}
+static cliprewind_t GClip_FindRewind( int deltaTime ) {
+	cliprewind_t rewind = { };
 
-	// always use the latest information about moving world brushes
-	if( ent->movetype == MOVETYPE_PUSH ) {
-		clipent->r = ent->r;
-		clipent->s = ent->s;
-		return clipent;
+	if( deltaTime >= 0 ) {
+		return rewind;
 	}
 
 	// clamp delta time inside the backed up limits
-	backTime = Abs( deltaTime );
+	int64_t backTime = Abs( deltaTime );
 	if( g_antilag_maxtimedelta->integer ) {
 		if( g_antilag_maxtimedelta->integer < 0 ) {
 			Cvar_SetValue( "g_antilag_maxtimedelta", Abs( g_antilag_maxtimedelta->integer ) );
@@ -149,30 +165,75 @@ static c4clipedict_t *GClip_GetClipEdictForDeltaTime( int entNum, int deltaTime
 	}
 
 	// find the first snap with timestamp < than realtime - backtime
-	cframenum = sv_collisionFrameNum;
+	unsigned bf;
 	for( bf = 1; bf < CFRAME_UPDATE_BACKUP && bf < sv_collisionFrameNum; bf++ ) { // never overpass limits
-		cframe = &sv_collisionframes[( cframenum - bf ) & CFRAME_UPDATE_MASK];
-
-		// if solid has changed, we can't keep moving backwards
-		if( ent->r.solid != cframe->clipEdicts[entNum].r.solid
-			|| ent->r.inuse != cframe->clipEdicts[entNum].r.inuse ) {
-			bf--;
-			if( bf == 0 ) {
-				// we can't step back from first
-				cframe = NULL;
-			} else {
-				cframe = &sv_collisionframes[( cframenum - bf ) & CFRAME_UPDATE_MASK];
-			}
+		rewind.frame = GClip_CollisionFrame( sv_collisionFrameNum - bf );
+		if( svs.gametime >= rewind.frame->timestamp + backTime ) {
 			break;
 		}
+	}
 
-		if( svs.gametime >= cframe->timestamp + backTime ) {
-			break;
+	// if we found an older than desired backtime frame, interpolate to find a more precise position.
+	if( rewind.frame != NULL && svs.gametime > rewind.frame->timestamp + backTime ) {
+		int64_t newer_timestamp = svs.gametime;
+		if( bf > 1 ) {
+			rewind.newer = GClip_CollisionFrame( sv_collisionFrameNum - ( bf - 1 ) );
+			newer_timestamp = rewind.newer->timestamp;
 		}
+
+		rewind.interpolate = true;
+		rewind.lerpFrac = (float)( ( svs.gametime - backTime ) - rewind.frame->timestamp )
+			/ (float)( newer_timestamp - rewind.frame->timestamp );
+	}
+
+	return rewind;
+}
+
+static const c4frame_t *GClip_RewindFrameForEntity( const cliprewind_t &rewind, int entNum, bool *interpolate ) {
+	const edict_t *ent = game.edicts + entNum;
+
+	*interpolate = false;
+
+	if( !entNum || rewind.frame == NULL ) { // current time entity
+		return NULL;
+	}
+
+	if( !ent->r.inuse || ent->r.solid == SOLID_NOT
+		|| ( ent->r.solid == SOLID_TRIGGER && !( entNum >= 1 && entNum <= server_gs.maxclients ) ) ) {
+		return NULL;
+	}
+
+	// always use the latest information about moving world brushes
+	if( ent->movetype == MOVETYPE_PUSH ) {
+		return NULL;
 	}
 
-	if( !cframe ) {
-		// current time entity
+	// if solid has changed, we can't keep moving backwards
+	const c4cliprecord_t *newest = &GClip_CollisionFrame( sv_collisionFrameNum - 1 )->records[entNum];
+	if( newest->solid != ent->r.solid || newest->inuse != ent->r.inuse ) {
+		return NULL;
+	}
+
+	if( newest->state_framenum > rewind.frame->framenum ) {
+		return GClip_CollisionFrame( newest->state_framenum );
+	}
+
+	*interpolate = rewind.interpolate;
+	return rewind.frame;
+}
+
+static c4clipedict_t *GClip_GetClipEdict( const cliprewind_t &rewind, int entNum ) {
+	static thread_local int index = 0;
+	static thread_local c4clipedict_t clipEnts[8];
+	const edict_t *ent = game.edicts + entNum;
+
+	// pick one of the 8 slots to prevent overwritings
+	c4clipedict_t *clipent = &clipEnts[index];
+	index = ( index + 1 ) & 7;
+
+	bool interpolate;
+	const c4frame_t *cframe = GClip_RewindFrameForEntity( rewind, entNum, &interpolate );
+	if( cframe == NULL ) {
 		clipent->r = ent->r;
 		clipent->s = ent->s;
 		return clipent;
@@ -181,35 +242,50 @@ static c4clipedict_t *GClip_GetClipEdictForDeltaTime( int entNum, int deltaTime
 	// setup with older for the data that is not interpolated
 	*clipent = cframe->clipEdicts[entNum];
 
-	// if we found an older than desired backtime frame, interpolate to find a more precise position.
-	if( svs.gametime > cframe->timestamp + backTime ) {
-		float lerpFrac;
-
-		if( bf == 1 ) {
-			// interpolate from 1st backed up to current
-			lerpFrac = (float)( ( svs.gametime - backTime ) - cframe->timestamp )
-					   / (float)( svs.gametime - cframe->timestamp );
-			clipentNewer.r = ent->r;
-			clipentNewer.s = ent->s;
-		} else {
-			// interpolate between 2 backed up
-			c4frame_t *cframeNewer = &sv_collisionframes[( cframenum - ( bf - 1 ) ) & CFRAME_UPDATE_MASK];
-			lerpFrac = (float)( ( svs.gametime - backTime ) - cframe->timestamp )
-					   / (float)( cframeNewer->timestamp - cframe->timestamp );
-			clipentNewer = cframeNewer->clipEdicts[entNum];
-		}
+	if( interpolate ) {
+		const entity_shared_t *newer_r = rewind.newer != NULL ? &rewind.newer->clipEdicts[entNum].r : &ent->r;
+		const SyncEntityState *newer_s = rewind.newer != NULL ? &rewind.newer->clipEdicts[entNum].s : &ent->s;
 
-		// interpolate
-		clipent->s.origin = Lerp( clipent->s.origin, lerpFrac, clipentNewer.s.origin );
-		clipent->r.mins = Lerp( clipent->r.mins, lerpFrac, clipentNewer.r.mins );
-		clipent->r.maxs = Lerp( clipent->r.maxs, lerpFrac, clipentNewer.r.maxs );
-		clipent->s.angles = LerpAngles( clipent->s.angles, lerpFrac, clipentNewer.s.angles );
+		clipent->s.origin = Lerp( clipent->s.origin, rewind.lerpFrac, newer_s->origin );
+		clipent->r.mins = Lerp( clipent->r.mins, rewind.lerpFrac, newer_r->mins );
+		clipent->r.maxs = Lerp( clipent->r.maxs, rewind.lerpFrac, newer_r->maxs );
+		clipent->s.angles = LerpAngles( clipent->s.angles, rewind.lerpFrac, newer_s->angles );
 	}
 
 	// back time entity
 	return clipent;
 }
 
+static c4clipedict_t *GClip_GetClipEdictForDeltaTime( int entNum, int deltaTime ) {
+	return GClip_GetClipEdict( GClip_FindRewind( deltaTime ), entNum );
+}
+
+static c4cliprecord_t GClip_GetClipRecord( const cliprewind_t &rewind, int entNum ) {
+	const edict_t *ent = game.edicts + entNum;
+
+	bool interpolate;
+	const c4frame_t *cframe = GClip_RewindFrameForEntity( rewind, entNum, &interpolate );
+	if( cframe == NULL ) {
+		c4cliprecord_t record;
+		record.absmin = ent->r.absmin;
+		record.absmax = ent->r.absmax;
+		record.solid = ent->r.solid;
+		record.inuse = ent->r.inuse;
+		return record;
+	}
+
+	c4cliprecord_t record = cframe->records[entNum];
+
+	if( interpolate ) {
+		Vec3 newer_absmin = rewind.newer != NULL ? rewind.newer->records[entNum].absmin : ent->r.absmin;
+		Vec3 newer_absmax = rewind.newer != NULL ? rewind.newer->records[entNum].absmax : ent->r.absmax;
+		record.absmin = Lerp( record.absmin, rewind.lerpFrac, newer_absmin );
+		record.absmax = Lerp( record.absmax, rewind.lerpFrac, newer_absmax );
+	}
+
+	return record;
+}
+
 // ClearLink is used for new headnodes
 static void GClip_ClearLink( link_t *l ) {
 	l->prev = l->next = l;
@@ -234,11 +310,6 @@ static void GClip_InsertLinkBefore( link_t *l, link_t *before, int entNum ) {
 * GClip_Init_AreaGrid
 */
 static void GClip_Init_AreaGrid( areagrid_t *areagrid, Vec3 world_mins, Vec3 world_maxs ) {
-	// the areagrid_marknumber is not allowed to be 0
-	if( areagrid->marknumber < 1 ) {
-		areagrid->marknumber = 1;
-	}
-
 	// choose either the world box size, or a larger box to ensure the grid isn't too fine
 	areagrid->size.x = Max2( world_maxs.x - world_mins.x, AREA_GRID * AREA_GRIDMINSIZE );
 	areagrid->size.y = Max2( world_maxs.y - world_mins.y, AREA_GRID * AREA_GRIDMINSIZE );
@@ -261,8 +332,6 @@ static void GClip_Init_AreaGrid( areagrid_t *areagrid, Vec3 world_mins, Vec3 wor
 		GClip_ClearLink( &areagrid->grid[i] );
 	}
 
-	memset( areagrid->entmarknumber, 0, sizeof( areagrid->entmarknumber ) );
-
 	if( developer->integer ) {
 		Com_Printf( "areagrid settings: divisions %ix%ix1 : box %f %f %f "
 					": %f %f %f size %f %f %f grid %f %f %f (mingrid %f)\n",
@@ -288,6 +357,17 @@ static void GClip_UnlinkEntity_AreaGrid( edict_t *ent ) {
 	}
 }
 
+/*
+* GClip_AreaGridCells
+* computes the range of cells an entity covers as mins.x, mins.y, maxs.x, maxs.y
+*/
+static void GClip_AreaGridCells( const areagrid_t *areagrid, const edict_t *ent, int *cells ) {
+	cells[0] = (int) floorf( ( ent->r.absmin.x + areagrid->bias.x ) * areagrid->scale.x );
+	cells[1] = (int) floorf( ( ent->r.absmin.y + areagrid->bias.y ) * areagrid->scale.y );
+	cells[2] = (int) floorf( ( ent->r.absmax.x + areagrid->bias.x ) * areagrid->scale.x ) + 1;
+	cells[3] = (int) floorf( ( ent->r.absmax.y + areagrid->bias.y ) * areagrid->scale.y ) + 1;
+}
+
 /*
 * GClip_LinkEntity_AreaGrid
 */
@@ -303,14 +383,11 @@ static void GClip_LinkEntity_AreaGrid( areagrid_t *areagrid, edict_t *ent ) {
 		return;
 	}
 
-	igridmins[0] = (int) floorf( ( ent->r.absmin.x + areagrid->bias.x ) * areagrid->scale.x );
-	igridmins[1] = (int) floorf( ( ent->r.absmin.y + areagrid->bias.y ) * areagrid->scale.y );
-
-	//igridmins[2] = (int) floorf( (ent->r.absmin[2] + areagrid->bias[2]) * areagrid->scale[2] );
-	igridmaxs[0] = (int) floorf( ( ent->r.absmax.x + areagrid->bias.x ) * areagrid->scale.x ) + 1;
-	igridmaxs[1] = (int) floorf( ( ent->r.absmax.y + areagrid->bias.y ) * areagrid->scale.y ) + 1;
+	igridmins[0] = ent->areagrid_cells[0];
+	igridmins[1] = ent->areagrid_cells[1];
+	igridmaxs[0] = ent->areagrid_cells[2];
+	igridmaxs[1] = ent->areagrid_cells[3];
 
-	//igridmaxs[2] = (int) floorf( (ent->r.absmax[2] + areagrid->bias[2]) * areagrid->scale[2] ) + 1;
 	if( igridmins[0] < 0 || igridmaxs[0] > AREA_GRID
 		|| igridmins[1] < 0 || igridmaxs[1] > AREA_GRID
 		|| ( ( igridmaxs[0] - igridmins[0] ) * ( igridmaxs[1] - igridmins[1] ) ) > MAX_ENT_AREAS ) {
@@ -327,75 +404,104 @@ static void GClip_LinkEntity_AreaGrid( areagrid_t *areagrid, edict_t *ent ) {
 	}
 }
 
+static bool GClip_MatchesAreaType( bool inuse, solid_t solid, int areatype ) {
+	if( !inuse ) {
+		return false; // deactivated
+	}
+	if( areatype == AREA_TRIGGERS && solid != SOLID_TRIGGER ) {
+		return false;
+	}
+	if( areatype == AREA_SOLID && ( solid == SOLID_TRIGGER || solid == SOLID_NOT ) ) {
+		return false;
+	}
+	return true;
+}
+
+static void GClip_AddCandidate( int entNum, Vec3 mins, Vec3 maxs, int areatype, int *list, int maxcount, int *numlist ) {
+	const entity_shared_t *r = &game.edicts[entNum].r;
+	if( !GClip_MatchesAreaType( r->inuse, r->solid, areatype ) ) {
+		return;
+	}
+
+	if( BoundsOverlap( mins, maxs, r->absmin, r->absmax ) ) {
+		if( *numlist < maxcount ) {
+			list[*numlist] = entNum;
+		}
+		( *numlist )++;
+	}
+}
+
+/*
+* GClip_EntitiesInBox_Rewound
+* the areagrid only knows where entities are now, so rewound queries test
+* every linked entity against its backed up bounds instead
+*/
+static int GClip_EntitiesInBox_Rewound( Vec3 mins, Vec3 maxs, int *list, int maxcount, int areatype, int timeDelta ) {
+	ZoneScoped;
+
+	cliprewind_t rewind = GClip_FindRewind( timeDelta );
+	int numlist = 0;
+
+	for( int i = 1; i < game.numentities; i++ ) {
+		if( !game.edicts[i].linked ) {
+			continue;
+		}
+
+		c4cliprecord_t record = GClip_GetClipRecord( rewind, i );
+		if( !GClip_MatchesAreaType( record.inuse, record.solid, areatype ) ) {
+			continue;
+		}
+
+		if( BoundsOverlap( mins, maxs, record.absmin, record.absmax ) ) {
+			if( numlist < maxcount ) {
+				list[numlist] = i;
+			}
+			numlist++;
+		}
+	}
+
+	return numlist;
+}
+
 /*
 * GClip_EntitiesInBox_AreaGrid
 */
-static int GClip_EntitiesInBox_AreaGrid( areagrid_t *areagrid, Vec3 mins, Vec3 maxs, int *list, int maxcount, int areatype, int timeDelta ) {
-	int numlist;
-	link_t *grid;
-	link_t *l;
-	c4clipedict_t *clipEnt;
-	Vec3 paddedmins, paddedmaxs;
+static int GClip_EntitiesInBox_AreaGrid( const areagrid_t *areagrid, Vec3 mins, Vec3 maxs, int *list, int maxcount, int areatype ) {
+	const link_t *grid;
+	const link_t *l;
 	int igrid[3], igridmins[3], igridmaxs[3];
 
-	paddedmins = mins;
-	paddedmaxs = maxs;
-
-	// FIXME: if areagrid_marknumber wraps, all entities need their
-	// ent->priv.server->areagridmarknumber reset
-	areagrid->marknumber++;
+	// since the areagrid can have multiple references to one entity,
+	// we should avoid extensive checking on entities already encountered.
+	// this is kept on the stack so movement can query from several threads
+	u64 seen[ MAX_EDICTS / 64 ] = { };
 
-	igridmins[0] = (int) floorf( ( paddedmins.x + areagrid->bias.x ) * areagrid->scale.x );
-	igridmins[1] = (int) floorf( ( paddedmins.y + areagrid->bias.y ) * areagrid->scale.y );
+	igridmins[0] = (int) floorf( ( mins.x + areagrid->bias.x ) * areagrid->scale.x );
+	igridmins[1] = (int) floorf( ( mins.y + areagrid->bias.y ) * areagrid->scale.y );
 
-	//igridmins[2] = (int) ( (paddedmins[2] + areagrid->bias[2]) * areagrid->scale[2] );
-	igridmaxs[0] = (int) floorf( ( paddedmaxs.x + areagrid->bias.x ) * areagrid->scale.x ) + 1;
-	igridmaxs[1] = (int) floorf( ( paddedmaxs.y + areagrid->bias.y ) * areagrid->scale.y ) + 1;
+	igridmaxs[0] = (int) floorf( ( maxs.x + areagrid->bias.x ) * areagrid->scale.x ) + 1;
+	igridmaxs[1] = (int) floorf( ( maxs.y + areagrid->bias.y ) * areagrid->scale.y ) + 1;
 
-	//igridmaxs[2] = (int) ( (paddedmaxs[2] + areagrid->bias[2]) * areagrid->scale[2] ) + 1;
 	igridmins[0] = Max2( 0, igridmins[0] );
 	igridmins[1] = Max2( 0, igridmins[1] );
 
-	//igridmins[2] = max( 0, igridmins[2] );
 	igridmaxs[0] = Min2( AREA_GRID, igridmaxs[0] );
 	igridmaxs[1] = Min2( AREA_GRID, igridmaxs[1] );
 
-	//igridmaxs[2] = min( AREA_GRID, igridmaxs[2] );
-
-	// paranoid debugging
-	//VectorSet( igridmins, 0, 0, 0 );VectorSet( igridmaxs, AREA_GRID, AREA_GRID, AREA_GRID );
-
-	numlist = 0;
+	int numlist = 0;
 
 	// add entities not linked into areagrid because they are too big or
 	// outside the grid bounds
 	if( areagrid->outside.next ) {
 		grid = &areagrid->outside;
 		for( l = grid->next; l != grid; l = l->next ) {
-			clipEnt = GClip_GetClipEdictForDeltaTime( l->entNum, timeDelta );
-
-			if( areagrid->entmarknumber[l->entNum] == areagrid->marknumber ) {
+			u64 bit = u64( 1 ) << ( l->entNum % 64 );
+			if( seen[ l->entNum / 64 ] & bit ) {
 				continue;
 			}
-			areagrid->entmarknumber[l->entNum] = areagrid->marknumber;
+			seen[ l->entNum / 64 ] |= bit;
 
-			if( !clipEnt->r.inuse ) {
-				continue; // deactivated
-			}
-			if( areatype == AREA_TRIGGERS && clipEnt->r.solid != SOLID_TRIGGER ) {
-				continue;
-			}
-			if( areatype == AREA_SOLID &&
-				( clipEnt->r.solid == SOLID_TRIGGER || clipEnt->r.solid == SOLID_NOT ) ) {
-				continue;
-			}
-
-			if( BoundsOverlap( paddedmins, paddedmaxs, clipEnt->r.absmin, clipEnt->r.absmax ) ) {
-				if( numlist < maxcount ) {
-					list[numlist] = l->entNum;
-				}
-				numlist++;
-			}
+			GClip_AddCandidate( l->entNum, mins, maxs, areatype, list, maxcount, &numlist );
 		}
 	}
 
@@ -409,30 +515,13 @@ static int GClip_EntitiesInBox_AreaGrid( areagrid_t *areagrid, Vec3 mins, Vec3 m
 			}
 
 			for( l = grid->next; l != grid; l = l->next ) {
-				clipEnt = GClip_GetClipEdictForDeltaTime( l->entNum, timeDelta );
-
-				if( areagrid->entmarknumber[l->entNum] == areagrid->marknumber ) {
-					continue;
-				}
-				areagrid->entmarknumber[l->entNum] = areagrid->marknumber;
-
-				if( !clipEnt->r.inuse ) {
-					continue; // deactivated
-				}
-				if( areatype == AREA_TRIGGERS && clipEnt->r.solid != SOLID_TRIGGER ) {
-					continue;
-				}
-				if( areatype == AREA_SOLID &&
-					( clipEnt->r.solid == SOLID_TRIGGER || clipEnt->r.solid == SOLID_NOT ) ) {
+				u64 bit = u64( 1 ) << ( l->entNum % 64 );
+				if( seen[ l->entNum / 64 ] & bit ) {
 					continue;
 				}
+				seen[ l->entNum / 64 ] |= bit;
 
-				if( BoundsOverlap( paddedmins, paddedmaxs, clipEnt->r.absmin, clipEnt->r.absmax ) ) {
-					if( numlist < maxcount ) {
-						list[numlist] = l->entNum;
-					}
-					numlist++;
-				}
+				GClip_AddCandidate( l->entNum, mins, maxs, areatype, list, maxcount, &numlist );
 			}
 		}
 	}
@@ -452,6 +541,34 @@ void GClip_ClearWorld() {
 	CM_InlineModelBounds( svs.cms, world_model, &world_mins, &world_maxs );
 
 	GClip_Init_AreaGrid( &g_areagrid, world_mins, world_maxs );
+
+	// edicts that survive the clear, like clients, aren't in the new grid,
+	// so GClip_LinkEntity mustn't think they're already in the right cells
+	for( int i = 0; i < game.maxentities; i++ ) {
+		game.edicts[ i ].linked = false;
+		game.edicts[ i ].linked_solid = false;
+	}
+
+	leafs_generation++;
+}
+
+/*
+* GClip_UpdateLinkedSolid
+*/
+static void GClip_UpdateLinkedSolid( edict_t *ent, bool solid ) {
+	int entNum = ENTNUM( ent );
+	bool client = entNum >= 1 && entNum <= server_gs.maxclients;
+	if( !client && ( solid || ent->linked_solid ) ) {
+		solid_links_generation++;
+	}
+	ent->linked_solid = solid;
+}
+
+/*
+* GClip_SolidLinksGeneration
+*/
+int GClip_SolidLinksGeneration() {
+	return solid_links_generation;
 }
 
 /*
@@ -464,6 +581,7 @@ void GClip_UnlinkEntity( edict_t *ent ) {
 		return; // not linked in anywhere
 	}
 	GClip_UnlinkEntity_AreaGrid( ent );
+	GClip_UpdateLinkedSolid( ent, false );
 	ent->linked = false;
 }
 
@@ -479,14 +597,10 @@ void GClip_LinkEntity( edict_t *ent ) {
 	int leafs[MAX_TOTAL_ENT_LEAFS];
 	int clusters[MAX_TOTAL_ENT_LEAFS];
 
-	GClip_UnlinkEntity( ent ); // unlink from old position
-
-	if( ent == game.edicts ) {
+	if( ent == game.edicts || !ent->r.inuse ) {
+		GClip_UnlinkEntity( ent );
 		return; // don't add the world
 	}
-	if( !ent->r.inuse ) {
-		return;
-	}
 
 	// set the size
 	ent->r.size = ent->r.maxs - ent->r.mins;
@@ -511,61 +625,71 @@ void GClip_LinkEntity( edict_t *ent ) {
 	ent->r.absmin -= Vec3( 1.0f );
 	ent->r.absmax += Vec3( 1.0f );
 
-	// link to PVS leafs
-	ent->r.num_clusters = 0;
-	ent->r.areanum = ent->r.areanum2 = -1;
-
-	// get all leafs, including solids
-	int topnode;
-	int num_leafs = CM_BoxLeafnums( svs.cms, ent->r.absmin, ent->r.absmax,
-									 leafs, MAX_TOTAL_ENT_LEAFS, &topnode );
-
-	// set areas
-	for( int i = 0; i < num_leafs; i++ ) {
-		clusters[i] = CM_LeafCluster( svs.cms, leafs[i] );
-		int area = CM_LeafArea( svs.cms, leafs[i] );
-		if( area > -1 ) {
-			// doors may legally straggle two areas,
-			// but nothing should ever need more than that
-			if( ent->r.areanum > -1 && ent->r.areanum != area ) {
-				if( ent->r.areanum2 > -1 && ent->r.areanum2 != area ) {
-					if( developer->integer ) {
-						Com_Printf( "Object touching 3 areas at %f %f %f\n",
-								  ent->r.absmin.x, ent->r.absmin.y, ent->r.absmin.z );
+	relink_frame_stats.links++;
+
+	// most entities move a few units per frame and stay in the same leafs,
+	// in which case the clusters and areas from the last link are still valid
+	bool same_leafs = ent->leafs_generation == leafs_generation && CM_SameBoxLeafnums( &ent->leaf_bounds, ent->r.absmin, ent->r.absmax );
+	if( !same_leafs ) {
+		relink_frame_stats.leaf_walks++;
+		ent->leafs_generation = leafs_generation;
+
+		// link to PVS leafs
+		ent->r.num_clusters = 0;
+		ent->r.areanum = ent->r.areanum2 = -1;
+
+		// get all leafs, including solids
+		int topnode;
+		int num_leafs = CM_BoxLeafnums( svs.cms, ent->r.absmin, ent->r.absmax,
+										 leafs, MAX_TOTAL_ENT_LEAFS, &topnode, &ent->leaf_bounds );
+
+		// set areas
+		for( int i = 0; i < num_leafs; i++ ) {
+			clusters[i] = CM_LeafCluster( svs.cms, leafs[i] );
+			int area = CM_LeafArea( svs.cms, leafs[i] );
+			if( area > -1 ) {
+				// doors may legally straggle two areas,
+				// but nothing should ever need more than that
+				if( ent->r.areanum > -1 && ent->r.areanum != area ) {
+					if( ent->r.areanum2 > -1 && ent->r.areanum2 != area ) {
+						if( developer->integer ) {
+							Com_Printf( "Object touching 3 areas at %f %f %f\n",
+									  ent->r.absmin.x, ent->r.absmin.y, ent->r.absmin.z );
+						}
 					}
+					ent->r.areanum2 = area;
+				} else {
+					ent->r.areanum = area;
 				}
-				ent->r.areanum2 = area;
-			} else {
-				ent->r.areanum = area;
 			}
 		}
-	}
 
-	if( num_leafs >= MAX_TOTAL_ENT_LEAFS ) {
-		// assume we missed some leafs, and mark by headnode
-		ent->r.num_clusters = -1;
-		ent->r.headnode = topnode;
-	} else {
-		ent->r.num_clusters = 0;
-		for( int i = 0; i < num_leafs; i++ ) {
-			if( clusters[i] == -1 ) {
-				continue; // not a visible leaf
-			}
-			int j;
-			for( j = 0; j < i; j++ ) {
-				if( clusters[j] == clusters[i] ) {
-					break;
+		if( num_leafs >= MAX_TOTAL_ENT_LEAFS ) {
+			// assume we missed some leafs, and mark by headnode
+			ent->r.num_clusters = -1;
+			ent->r.headnode = topnode;
+		} else {
+			ent->r.num_clusters = 0;
+			for( int i = 0; i < num_leafs; i++ ) {
+				if( clusters[i] == -1 ) {
+					continue; // not a visible leaf
 				}
-			}
-			if( j == i ) {
-				if( ent->r.num_clusters == MAX_ENT_CLUSTERS ) {
-					// assume we missed some leafs, and mark by headnode
-					ent->r.num_clusters = -1;
-					ent->r.headnode = topnode;
-					break;
+				int j;
+				for( j = 0; j < i; j++ ) {
+					if( clusters[j] == clusters[i] ) {
+						break;
+					}
+				}
+				if( j == i ) {
+					if( ent->r.num_clusters == MAX_ENT_CLUSTERS ) {
+						// assume we missed some leafs, and mark by headnode
+						ent->r.num_clusters = -1;
+						ent->r.headnode = topnode;
+						break;
+					}
+					ent->r.clusternums[ent->r.num_clusters] = clusters[i];
+					ent->r.num_clusters++;
 				}
-				ent->r.clusternums[ent->r.num_clusters] = clusters[i];
-				ent->r.num_clusters++;
 			}
 		}
 	}
@@ -575,11 +699,51 @@ void GClip_LinkEntity( edict_t *ent ) {
 		ent->olds = ent->s;
 	}
 	ent->linkcount++;
+
+	// traces never hit projectiles, see GClip_ClipMoveToEntities
+	GClip_UpdateLinkedSolid( ent, ent->r.solid == SOLID_YES && !( ent->r.svflags & SVF_PROJECTILE ) );
+
+	int cells[4];
+	GClip_AreaGridCells( &g_areagrid, ent, cells );
+	if( ent->linked && memcmp( cells, ent->areagrid_cells, sizeof( cells ) ) == 0 ) {
+		return;
+	}
+
+	relink_frame_stats.grid_relinks++;
+
+	if( ent->linked ) {
+		GClip_UnlinkEntity_AreaGrid( ent ); // unlink from old position
+	}
+	memcpy( ent->areagrid_cells, cells, sizeof( cells ) );
 	ent->linked = true;
 
 	GClip_LinkEntity_AreaGrid( &g_areagrid, ent );
 }
 
+/*
+* GClip_PlotRelinkStats
+*/
+void GClip_PlotRelinkStats() {
+	TracyPlot( "Entity links", s64( relink_frame_stats.links ) );
+	TracyPlot( "Entity leaf walks", s64( relink_frame_stats.leaf_walks ) );
+	TracyPlot( "Entity grid relinks", s64( relink_frame_stats.grid_relinks ) );
+
+	relink_total_stats.links += relink_frame_stats.links;
+	relink_total_stats.leaf_walks += relink_frame_stats.leaf_walks;
+	relink_total_stats.grid_relinks += relink_frame_stats.grid_relinks;
+	relink_frame_stats = { };
+}
+
+/*
+* GClip_PrintRelinkStats
+*/
+void GClip_PrintRelinkStats() {
+	const relinkstats_t & t = relink_total_stats;
+	float links = Max2( 1.0f, float( t.links ) );
+	Com_Printf( "%u links, %u leaf walks (%.1f%%), %u grid relinks (%.1f%%)\n",
+		t.links, t.leaf_walks, 100.0f * t.leaf_walks / links, t.grid_relinks, 100.0f * t.grid_relinks / links );
+}
+
 /*
 * GClip_SetAreaPortalState
 *
@@ -608,7 +772,12 @@ void GClip_SetAreaPortalState( edict_t *ent, bool open ) {
 * ??? does this always return the world?
 */
 int GClip_AreaEdicts( Vec3 mins, Vec3 maxs, int *list, int maxcount, int areatype, int timeDelta ) {
-	int count = GClip_EntitiesInBox_AreaGrid( &g_areagrid, mins, maxs, list, maxcount, areatype, timeDelta );
+	int count;
+	if( timeDelta < 0 && sv_collisionFrameNum > 0 ) {
+		count = GClip_EntitiesInBox_Rewound( mins, maxs, list, maxcount, areatype, timeDelta );
+	} else {
+		count = GClip_EntitiesInBox_AreaGrid( &g_areagrid, mins, maxs, list, maxcount, areatype );
+	}
 	return Min2( count, maxcount );
 }
 
@@ -618,7 +787,7 @@ int GClip_AreaEdicts( Vec3 mins, Vec3 maxs, int *list, int maxcount, int areatyp
 * Returns a collision model that can be used for testing or clipping an
 * object of mins/maxs size.
 */
-static cmodel_t *GClip_CollisionModelForEntity( SyncEntityState *s, entity_shared_t *r ) {
+static cmodel_t *GClip_CollisionModelForEntity( const SyncEntityState *s, const entity_shared_t *r ) {
 	cmodel_t * model = CM_TryFindCModel( CM_Server, s->model );
 	if( model != NULL ) {
 		return model;
@@ -653,8 +822,9 @@ static int GClip_PointContents( Vec3 p, int timeDelta ) {
 	// or in contents from all the other entities
 	num = GClip_AreaEdicts( p, p, touch, MAX_EDICTS, AREA_SOLID, timeDelta );
 
+	cliprewind_t rewind = GClip_FindRewind( timeDelta );
 	for( i = 0; i < num; i++ ) {
-		clipEnt = GClip_GetClipEdictForDeltaTime( touch[i], timeDelta );
+		clipEnt = GClip_GetClipEdict( rewind, touch[i] );
 
 		// might intersect, so do an exact clip
 		cmodel = GClip_CollisionModelForEntity( &clipEnt->s, &clipEnt->r );
@@ -686,72 +856,80 @@ typedef struct {
 } moveclip_t;
 
 /*
-* GClip_ClipMoveToEntities
+* GClip_ClipMoveToEntity
 */
-static void GClip_ClipMoveToEntities( moveclip_t *clip, int timeDelta ) {
-	ZoneScoped;
+static void GClip_ClipMoveToEntity( moveclip_t *clip, const c4clipedict_t *touch ) {
+	if( clip->passent >= 0 ) {
+		// when they are offseted in time, they can be a different pointer but be the same entity
+		if( touch->s.number == clip->passent ) {
+			return;
+		}
+		if( touch->r.owner && ( touch->r.owner->s.number == clip->passent ) ) {
+			return;
+		}
+		if( game.edicts[clip->passent].r.owner
+			&& ( game.edicts[clip->passent].r.owner->s.number == touch->s.number ) ) {
+			return;
+		}
 
-	int touchlist[MAX_EDICTS];
-	int num = GClip_AreaEdicts( clip->boxmins, clip->boxmaxs, touchlist, MAX_EDICTS, AREA_SOLID, timeDelta );
+		// wsw : jal : never clipmove against SVF_PROJECTILE entities
+		if( touch->r.svflags & SVF_PROJECTILE ) {
+			return;
+		}
+	}
 
-	// be careful, it is possible to have an entity in this
-	// list removed before we get to it (killtriggered)
-	for( int i = 0; i < num; i++ ) {
-		c4clipedict_t * touch = GClip_GetClipEdictForDeltaTime( touchlist[i], timeDelta );
-		if( clip->passent >= 0 ) {
-			// when they are offseted in time, they can be a different pointer but be the same entity
-			if( touch->s.number == clip->passent ) {
-				continue;
-			}
-			if( touch->r.owner && ( touch->r.owner->s.number == clip->passent ) ) {
-				continue;
-			}
-			if( game.edicts[clip->passent].r.owner
-				&& ( game.edicts[clip->passent].r.owner->s.number == touch->s.number ) ) {
-				continue;
-			}
+	if( ( touch->r.svflags & SVF_CORPSE ) && !( clip->contentmask & CONTENTS_CORPSE ) ) {
+		return;
+	}
 
-			// wsw : jal : never clipmove against SVF_PROJECTILE entities
-			if( touch->r.svflags & SVF_PROJECTILE ) {
-				continue;
-			}
+	if( touch->r.client != NULL ) {
+		int teammask = clip->contentmask & ( CONTENTS_TEAMALPHA | CONTENTS_TEAMBETA );
+		if( teammask != 0 ) {
+			int team = teammask == CONTENTS_TEAMALPHA ? TEAM_ALPHA : TEAM_BETA;
+			if( touch->s.team != team )
+				return;
 		}
+	}
 
-		if( ( touch->r.svflags & SVF_CORPSE ) && !( clip->contentmask & CONTENTS_CORPSE ) ) {
-			continue;
-		}
+	// might intersect, so do an exact clip
+	cmodel_t * cmodel = GClip_CollisionModelForEntity( &touch->s, &touch->r );
 
-		if( touch->r.client != NULL ) {
-			int teammask = clip->contentmask & ( CONTENTS_TEAMALPHA | CONTENTS_TEAMBETA );
-			if( teammask != 0 ) {
-				int team = teammask == CONTENTS_TEAMALPHA ? TEAM_ALPHA : TEAM_BETA;
-				if( touch->s.team != team )
-					continue;
-			}
-		}
+	Vec3 angles;
+	if( CM_IsBrushModel( CM_Server, touch->s.model ) ) {
+		angles = touch->s.angles;
+	} else {
+		angles = Vec3( 0.0f ); // boxes don't rotate
 
-		// might intersect, so do an exact clip
-		cmodel_t * cmodel = GClip_CollisionModelForEntity( &touch->s, &touch->r );
+	}
 
-		Vec3 angles;
-		if( CM_IsBrushModel( CM_Server, touch->s.model ) ) {
-			angles = touch->s.angles;
-		} else {
-			angles = Vec3( 0.0f ); // boxes don't rotate
+	trace_t trace;
+	CM_TransformedBoxTrace( CM_Server, svs.cms, &trace, clip->start, clip->end,
+								 clip->mins, clip->maxs, cmodel, clip->contentmask,
+								 touch->s.origin, angles );
 
-		}
+	if( trace.allsolid || trace.fraction < clip->trace->fraction ) {
+		trace.ent = touch->s.number;
+		*( clip->trace ) = trace;
+	} else if( trace.startsolid ) {
+		clip->trace->startsolid = true;
+	}
+}
+
+/*
+* GClip_ClipMoveToEntities
+*/
+static void GClip_ClipMoveToEntities( moveclip_t *clip, int timeDelta ) {
+	ZoneScoped;
 
-		trace_t trace;
-		CM_TransformedBoxTrace( CM_Server, svs.cms, &trace, clip->start, clip->end,
-									 clip->mins, clip->maxs, cmodel, clip->contentmask,
-									 touch->s.origin, angles );
+	int touchlist[MAX_EDICTS];
+	int num = GClip_AreaEdicts( clip->boxmins, clip->boxmaxs, touchlist, MAX_EDICTS, AREA_SOLID, timeDelta );
 
-		if( trace.allsolid || trace.fraction < clip->trace->fraction ) {
-			trace.ent = touch->s.number;
-			*( clip->trace ) = trace;
-		} else if( trace.startsolid ) {
-			clip->trace->startsolid = true;
-		}
+	cliprewind_t rewind = GClip_FindRewind( timeDelta );
+
+	// be careful, it is possible to have an entity in this
+	// list removed before we get to it (killtriggered)
+	for( int i = 0; i < num; i++ ) {
+		GClip_ClipMoveToEntity( clip, GClip_GetClipEdict( rewind, touchlist[i] ) );
 		if( clip->trace->allsolid ) {
 			return;
 		}
@@ -836,6 +1014,96 @@ void G_Trace4D( trace_t *tr, Vec3 start, Vec3 mins, Vec3 maxs, Vec3 end, edict_t
 	GClip_Trace( tr, start, mins, maxs, end, passedict, contentmask, timeDelta );
 }
 
+/*
+* G_TraceBatch4D
+*
+* same as calling G_Trace4D for each start/end pair, but the world is
+* traced with a single BSP walk and entities are gathered once for the
+* whole batch
+*/
+void G_TraceBatch4D( trace_t *traces, const Vec3 *starts, const Vec3 *ends, int n, Vec3 mins, Vec3 maxs, edict_t *passedict, int contentmask, int timeDelta ) {
+	ZoneScoped;
+
+	for( int first = 0; first < n; first += MAX_TRACE_BATCH ) {
+		int count = Min2( n - first, MAX_TRACE_BATCH );
+		trace_t *batch = traces + first;
+
+		// clip to world
+		if( passedict == world ) {
+			for( int i = 0; i < count; i++ ) {
+				memset( &batch[i], 0, sizeof( trace_t ) );
+				batch[i].fraction = 1;
+				batch[i].ent = -1;
+			}
+		} else {
+			CM_BoxTraceBatch( CM_Server, svs.cms, batch, starts + first, ends + first, count, mins, maxs, contentmask );
+			for( int i = 0; i < count; i++ ) {
+				batch[i].ent = batch[i].fraction < 1.0 ? world->s.number : -1;
+			}
+		}
+
+		moveclip_t clips[MAX_TRACE_BATCH];
+		int num_clips = 0;
+
+		Vec3 batchmins, batchmaxs;
+		ClearBounds( &batchmins, &batchmaxs );
+
+		for( int i = 0; i < count; i++ ) {
+			if( batch[i].fraction == 0 ) {
+				continue; // blocked by the world
+			}
+
+			moveclip_t *clip = &clips[num_clips];
+			memset( clip, 0, sizeof( moveclip_t ) );
+			clip->trace = &batch[i];
+			clip->contentmask = contentmask;
+			clip->start = starts[first + i];
+			clip->end = ends[first + i];
+			clip->mins = mins;
+			clip->maxs = maxs;
+			clip->passent = passedict ? ENTNUM( passedict ) : -1;
+			GClip_TraceBounds( clip->start, mins, maxs, clip->end, &clip->boxmins, &clip->boxmaxs );
+			num_clips++;
+
+			AddPointToBounds( clip->boxmins, &batchmins, &batchmaxs );
+			AddPointToBounds( clip->boxmaxs, &batchmins, &batchmaxs );
+		}
+
+		if( num_clips == 0 ) {
+			continue;
+		}
+
+		// gather candidates for the whole batch, then give each trace the
+		// ones the broadphase would have returned for its own bounds
+		int touchlist[MAX_EDICTS];
+		int num = GClip_AreaEdicts( batchmins, batchmaxs, touchlist, MAX_EDICTS, AREA_SOLID, timeDelta );
+		num = Min2( num, MAX_EDICTS );
+
+		cliprewind_t rewind = GClip_FindRewind( timeDelta );
+
+		TempAllocator temp = svs.frame_arena.temp();
+		c4clipedict_t *touches = ALLOC_MANY( &temp, c4clipedict_t, num );
+		c4cliprecord_t *records = ALLOC_MANY( &temp, c4cliprecord_t, num );
+		for( int i = 0; i < num; i++ ) {
+			touches[i] = *GClip_GetClipEdict( rewind, touchlist[i] );
+			records[i] = GClip_GetClipRecord( rewind, touchlist[i] );
+		}
+
+		for( int i = 0; i < num_clips; i++ ) {
+			moveclip_t *clip = &clips[i];
+			for( int j = 0; j < num; j++ ) {
+				if( !BoundsOverlap( clip->boxmins, clip->boxmaxs, records[j].absmin, records[j].absmax ) ) {
+					continue;
+				}
+				GClip_ClipMoveToEntity( clip, &touches[j] );
+				if( clip->trace->allsolid ) {
+					break;
+				}
+			}
+		}
+	}
+}
+
 bool IsHeadshot( int entNum, Vec3 hit, int timeDelta ) {
 	const c4clipedict_t * clip = GClip_GetClipEdictForDeltaTime( entNum, timeDelta );
 	return clip->r.absmax.z - hit.z <= 16.0f;
@@ -105,10 +105,10 @@ static void Cmd_Noclip_f( edict_t *ent ) {
 	}
 
 	if( ent->movetype == MOVETYPE_NOCLIP ) {
-		ent->movetype = MOVETYPE_PLAYER;
+		G_SetMovetype( ent, MOVETYPE_PLAYER );
 		msg = "noclip OFF\n";
 	} else {
-		ent->movetype = MOVETYPE_NOCLIP;
+		G_SetMovetype( ent, MOVETYPE_NOCLIP );
 		msg = "noclip ON\n";
 	}
 
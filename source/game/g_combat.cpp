@@ -49,42 +49,29 @@ static bool G_CanSplashDamage( edict_t *targ, edict_t *inflictor, cplane_t *plan
 		origin += plane->normal * 9.0f;
 	}
 
-	// This is for players
+	// This is for players, check the centre first since it's usually enough
 	G_Trace4D( &trace, origin, Vec3( 0.0f ), Vec3( 0.0f ), targ->s.origin, inflictor, MASK_SOLID, timeDelta );
 	if( trace.fraction >= 1.0 - SPLASH_DAMAGE_TRACE_FRAC_EPSILON || trace.ent == ENTNUM( targ ) ) {
 		return true;
 	}
 
-	Vec3 dest = targ->s.origin;
-	dest.x += 15.0;
-	dest.y += 15.0;
-	G_Trace4D( &trace, origin, Vec3( 0.0f ), Vec3( 0.0f ), dest, inflictor, MASK_SOLID, timeDelta );
-	if( trace.fraction >= 1.0 - SPLASH_DAMAGE_TRACE_FRAC_EPSILON || trace.ent == ENTNUM( targ ) ) {
-		return true;
-	}
+	// then the four corners at once
+	Vec3 origins[4];
+	Vec3 dests[4];
+	trace_t traces[4];
 
-	dest = targ->s.origin;
-	dest.x += 15.0;
-	dest.y -= 15.0;
-	G_Trace4D( &trace, origin, Vec3( 0.0f ), Vec3( 0.0f ), dest, inflictor, MASK_SOLID, timeDelta );
-	if( trace.fraction >= 1.0 - SPLASH_DAMAGE_TRACE_FRAC_EPSILON || trace.ent == ENTNUM( targ ) ) {
-		return true;
+	Vec3 corners[] = { Vec3( 15.0f, 15.0f, 0.0f ), Vec3( 15.0f, -15.0f, 0.0f ), Vec3( -15.0f, 15.0f, 0.0f ), Vec3( -15.0f, -15.0f, 0.0f ) };
+	for( int i = 0; i < 4; i++ ) {
+		origins[i] = origin;
+		dests[i] = targ->s.origin + corners[i];
 	}
 
-	dest = targ->s.origin;
-	dest.x -= 15.0;
-	dest.y += 15.0;
-	G_Trace4D( &trace, origin, Vec3( 0.0f ), Vec3( 0.0f ), dest, inflictor, MASK_SOLID, timeDelta );
-	if( trace.fraction >= 1.0 - SPLASH_DAMAGE_TRACE_FRAC_EPSILON || trace.ent == ENTNUM( targ ) ) {
-		return true;
-	}
+	G_TraceBatch4D( traces, origins, dests, 4, Vec3( 0.0f ), Vec3( 0.0f ), inflictor, MASK_SOLID, timeDelta );
 
-	dest = targ->s.origin;
-	dest.x -= 15.0;
-	dest.y -= 15.0;
-	G_Trace4D( &trace, origin, Vec3( 0.0f ), Vec3( 0.0f ), dest, inflictor, MASK_SOLID, timeDelta );
-	if( trace.fraction >= 1.0 - SPLASH_DAMAGE_TRACE_FRAC_EPSILON || trace.ent == ENTNUM( targ ) ) {
-		return true;
+	for( int i = 0; i < 4; i++ ) {
+		if( traces[i].fraction >= 1.0 - SPLASH_DAMAGE_TRACE_FRAC_EPSILON || traces[i].ent == ENTNUM( targ ) ) {
+			return true;
+		}
 	}
 
 	return false;
@@ -229,7 +229,18 @@ void G_SnapClients() {
 static void G_SnapEntities() {
 	for( int i = 0; i < game.numentities; i++ ) {
 		edict_t * ent = &game.edicts[ i ];
-		if( !ent->r.inuse || ( ent->r.svflags & SVF_NOCLIENT ) ) {
+		if( !ent->r.inuse ) {
+			continue;
+		}
+
+		// idle entities don't run every frame, so sync this here
+		if( ent->takedamage ) {
+			ent->s.effects |= EF_TAKEDAMAGE;
+		} else {
+			ent->s.effects &= ~EF_TAKEDAMAGE;
+		}
+
+		if( ent->r.svflags & SVF_NOCLIENT ) {
 			continue;
 		}
 
@@ -273,7 +284,7 @@ static StringHash entity_sound_backup[MAX_EDICTS];
 void G_ClearSnap() {
 	edict_t *ent;
 
-	svs.realtime = Sys_Milliseconds(); // level.time etc. might not be real time
+	svs.realtime = PF_Milliseconds(); // level.time etc. might not be real time
 
 	// clear gametype's clock override
 	server_gs.gameState.clock_override = 0;
@@ -317,7 +328,7 @@ void G_ClearSnap() {
 */
 void G_SnapFrame() {
 	edict_t *ent;
-	svs.realtime = Sys_Milliseconds(); // level.time etc. might not be real time
+	svs.realtime = PF_Milliseconds(); // level.time etc. might not be real time
 
 	//others
 	G_UpdateServerInfo();
@@ -366,42 +377,21 @@ void G_SnapFrame() {
 //		WORLD FRAMES
 //===================================================================
 
-static void G_RunEntities() {
+static void G_RunClients() {
 	ZoneScoped;
 
-	edict_t *ent;
-
-	for( ent = &game.edicts[0]; ENTNUM( ent ) < game.numentities; ent++ ) {
-		if( !ent->r.inuse ) {
+	// queue up what the clients sent us. bots decide what to do when it's
+	// their turn below, after the clients before them have moved
+	for( int i = 0; i < server_gs.maxclients; i++ ) {
+		edict_t *ent = game.edicts + 1 + i;
+		if( !ent->r.inuse || ( ent->r.svflags & SVF_FAKECLIENT ) ) {
 			continue;
 		}
-		if( ISEVENTENTITY( &ent->s ) ) {
-			continue; // events do not think
-		}
-		level.current_entity = ent;
 
-		// backup oldstate ( for world frame ).
-		ent->olds = ent->s;
-
-		// if the ground entity moved, make sure we are still on it
-		if( !ent->r.client ) {
-			if( ( ent->groundentity ) && ( ent->groundentity->linkcount != ent->groundentity_linkcount ) ) {
-				G_CheckGround( ent );
-			}
-		}
-
-		G_RunEntity( ent );
-
-		if( ent->takedamage ) {
-			ent->s.effects |= EF_TAKEDAMAGE;
-		} else {
-			ent->s.effects &= ~EF_TAKEDAMAGE;
-		}
+		G_ClientThink( ent );
 	}
-}
 
-static void G_RunClients() {
-	ZoneScoped;
+	G_PredictClientMoves();
 
 	for( int i = 0; i < server_gs.maxclients; i++ ) {
 		edict_t *ent = game.edicts + 1 + i;
@@ -409,7 +399,11 @@ static void G_RunClients() {
 			continue;
 		}
 
-		G_ClientThink( ent );
+		if( ent->r.svflags & SVF_FAKECLIENT ) {
+			G_ClientThink( ent );
+		}
+
+		G_RunClientMoves( ent );
 
 		if( ent->takedamage ) {
 			ent->s.effects |= EF_TAKEDAMAGE;
@@ -429,6 +423,8 @@ void G_RunFrame( unsigned int msec ) {
 
 	G_CallVotes_Think();
 
+	AI_Frame();
+
 	if( GS_MatchPaused( &server_gs ) ) {
 		unsigned int serverTimeDelta = svs.gametime - game.prevServerTime;
 		// freeze match clock and linear projectiles
@@ -459,6 +455,7 @@ void G_RunFrame( unsigned int msec ) {
 	G_RunEntities();
 	G_RunGametype();
 	GClip_BackUpCollisionFrame();
+	GClip_PlotRelinkStats();
 
 	game.prevServerTime = svs.gametime;
 }
@@ -93,12 +93,12 @@ static void Move_Watch( edict_t *ent ) {
 	moveTime = svs.gametime - ent->s.linearMovementTimeStamp;
 	if( moveTime >= (int)ent->s.linearMovementDuration ) {
 		ent->think = Move_Done;
-		ent->nextThink = level.time + 1;
+		G_SetNextThink( ent, level.time + 1 );
 		return;
 	}
 
 	ent->think = Move_Watch;
-	ent->nextThink = level.time + 1;
+	G_SetNextThink( ent, level.time + 1 );
 }
 
 static void Move_Begin( edict_t *ent ) {
@@ -107,7 +107,7 @@ static void Move_Begin( edict_t *ent ) {
 	float dist = Length( dir );
 	dir = Normalize( dir );
 	ent->velocity = dir * ent->moveinfo.speed;
-	ent->nextThink = level.time + 1;
+	G_SetNextThink( ent, level.time + 1 );
 	ent->think = Move_Watch;
 	Move_UpdateLinearVelocity( ent, dist, ent->moveinfo.speed );
 }
@@ -121,7 +121,7 @@ static void Move_Calc( edict_t *ent, Vec3 dest, void ( *func )( edict_t * ) ) {
 	if( level.current_entity == ent ) {
 		Move_Begin( ent );
 	} else {
-		ent->nextThink = level.time + 1;
+		G_SetNextThink( ent, level.time + 1 );
 		ent->think = Move_Begin;
 	}
 }
@@ -162,20 +162,20 @@ static void AngleMove_Watch( edict_t *ent ) {
 
 	if( AngleMove_AdjustFinalStep( ent ) ) {
 		ent->think = AngleMove_Done;
-		ent->nextThink = level.time + 1;
+		G_SetNextThink( ent, level.time + 1 );
 		return;
 	} else {
 		ent->avelocity = destdelta * ent->moveinfo.speed;
 	}
 
 	ent->think =  AngleMove_Watch;
-	ent->nextThink = level.time + 1;
+	G_SetNextThink( ent, level.time + 1 );
 }
 
 static void AngleMove_Begin( edict_t *ent ) {
 	if( AngleMove_AdjustFinalStep( ent ) ) {
 		ent->think = AngleMove_Done;
-		ent->nextThink = level.time + 1;
+		G_SetNextThink( ent, level.time + 1 );
 		return;
 	}
 
@@ -183,7 +183,7 @@ static void AngleMove_Begin( edict_t *ent ) {
 	Vec3 destdelta = Normalize( ent->moveinfo.destangles - ent->s.angles );
 
 	ent->avelocity = destdelta * ent->moveinfo.speed;
-	ent->nextThink = level.time + 1;
+	G_SetNextThink( ent, level.time + 1 );
 	ent->think = AngleMove_Watch;
 }
 
@@ -195,7 +195,7 @@ static void AngleMove_Calc( edict_t *ent, Vec3 destangles, void ( *func )( edict
 	if( level.current_entity == ent ) {
 		AngleMove_Begin( ent );
 	} else {
-		ent->nextThink = level.time + 1;
+		G_SetNextThink( ent, level.time + 1 );
 		ent->think = AngleMove_Begin;
 	}
 }
@@ -244,7 +244,7 @@ static void door_hit_top( edict_t *self ) {
 	}
 	if( self->moveinfo.wait >= 0 ) {
 		self->think = door_go_down;
-		self->nextThink = level.time + ( self->moveinfo.wait * 1000 );
+		G_SetNextThink( self, level.time + ( self->moveinfo.wait * 1000 ) );
 	}
 }
 
@@ -280,7 +280,7 @@ static void door_go_up( edict_t *self, edict_t *activator ) {
 
 	if( self->moveinfo.state == STATE_TOP ) { // reset top wait time
 		if( self->moveinfo.wait >= 0 ) {
-			self->nextThink = level.time + self->moveinfo.wait * 1000;
+			G_SetNextThink( self, level.time + self->moveinfo.wait * 1000 );
 		}
 		return;
 	}
@@ -349,7 +349,7 @@ static void Think_SpawnDoorTrigger( edict_t *ent ) {
 	other->r.owner = ent;
 	other->s.team = ent->s.team;
 	other->r.solid = SOLID_TRIGGER;
-	other->movetype = MOVETYPE_NONE;
+	G_SetMovetype( other, MOVETYPE_NONE );
 	other->touch = Touch_DoorTrigger;
 	GClip_LinkEntity( other );
 
@@ -444,7 +444,7 @@ void SP_func_door( edict_t *ent ) {
 	door_use_areaportals( ent, ( ent->spawnflags & DOOR_START_OPEN ) != 0 );
 
 	if( ent->name == EMPTY_HASH ) {
-		ent->nextThink = level.time + 1;
+		G_SetNextThink( ent, level.time + 1 );
 		ent->think = Think_SpawnDoorTrigger;
 	}
 }
@@ -512,7 +512,7 @@ void SP_func_door_rotating( edict_t *ent ) {
 	GClip_LinkEntity( ent );
 
 	if( ent->name == EMPTY_HASH ) {
-		ent->nextThink = level.time + 1;
+		G_SetNextThink( ent, level.time + 1 );
 		ent->think = Think_SpawnDoorTrigger;
 	}
 }
@@ -541,7 +541,7 @@ static void Think_RotateAccel( edict_t *self ) {
 	// add acceleration value to current speed to cause accel
 	self->moveinfo.current_speed += self->accel;
 	self->avelocity = self->moveinfo.movedir * self->moveinfo.current_speed;
-	self->nextThink = level.time + 1;
+	G_SetNextThink( self, level.time + 1 );
 }
 
 static void Think_RotateDecel( edict_t *self ) {
@@ -561,7 +561,7 @@ static void Think_RotateDecel( edict_t *self ) {
 	// subtract deceleration value from current speed to cause decel
 	self->moveinfo.current_speed -= self->decel;
 	self->avelocity = self->moveinfo.movedir * self->moveinfo.current_speed;
-	self->nextThink = level.time + 1;
+	G_SetNextThink( self, level.time + 1 );
 }
 
 static void rotating_blocked( edict_t *self, edict_t *other ) {
@@ -587,7 +587,7 @@ static void rotating_use( edict_t *self, edict_t *other, edict_t *activator ) {
 		} else {
 			// otherwise decelerate
 			self->think = Think_RotateDecel;
-			self->nextThink = level.time + 1;
+			G_SetNextThink( self, level.time + 1 );
 			self->moveinfo.state = STATE_DECEL;
 		} // decelerate
 	} else {
@@ -600,7 +600,7 @@ static void rotating_use( edict_t *self, edict_t *other, edict_t *activator ) {
 		} else {
 			// accelerate baybee
 			self->think = Think_RotateAccel;
-			self->nextThink = level.time + 1;
+			G_SetNextThink( self, level.time + 1 );
 			self->moveinfo.state = STATE_ACCEL;
 		}
 	}
@@ -615,9 +615,9 @@ void SP_func_rotating( edict_t *ent ) {
 	G_InitMover( ent );
 
 	if( ent->spawnflags & 32 ) {
-		ent->movetype = MOVETYPE_STOP;
+		G_SetMovetype( ent, MOVETYPE_STOP );
 	} else {
-		ent->movetype = MOVETYPE_PUSH;
+		G_SetMovetype( ent, MOVETYPE_PUSH );
 	}
 
 	ent->moveinfo.state = STATE_STOPPED; // rotating thingy starts out idle
@@ -699,7 +699,7 @@ static void button_wait( edict_t *self ) {
 
 	G_UseTargets( self, self->activator );
 	if( self->moveinfo.wait >= 0 ) {
-		self->nextThink = level.time + ( self->moveinfo.wait * 1000 );
+		G_SetNextThink( self, level.time + ( self->moveinfo.wait * 1000 ) );
 		self->think = button_return;
 	}
 }
@@ -833,13 +833,13 @@ static void train_wait( edict_t *self ) {
 
 	if( self->moveinfo.wait ) {
 		if( self->moveinfo.wait > 0 ) {
-			self->nextThink = level.time + ( self->moveinfo.wait * 1000 );
+			G_SetNextThink( self, level.time + ( self->moveinfo.wait * 1000 ) );
 			self->think = train_next;
 		} else if( self->spawnflags & TRAIN_TOGGLE ) {   // && wait < 0
 			train_next( self );
 			self->spawnflags &= ~TRAIN_START_ON;
 			self->velocity = Vec3( 0.0f );
-			self->nextThink = 0;
+			G_SetNextThink( self, 0 );
 		}
 
 		if( self->moveinfo.sound_end != EMPTY_HASH ) {
@@ -946,7 +946,7 @@ static void func_train_find( edict_t *self ) {
 	}
 
 	if( self->spawnflags & TRAIN_START_ON ) {
-		self->nextThink = level.time + 1;
+		G_SetNextThink( self, level.time + 1 );
 		self->think = train_next;
 		self->activator = self;
 	}
@@ -961,7 +961,7 @@ static void train_use( edict_t *self, edict_t *other, edict_t *activator ) {
 		}
 		self->spawnflags &= ~TRAIN_START_ON;
 		self->velocity = Vec3( 0.0f );
-		self->nextThink = 0;
+		G_SetNextThink( self, 0 );
 	} else {
 		if( self->target_ent ) {
 			train_resume( self );
@@ -998,7 +998,7 @@ void SP_func_train( edict_t *self ) {
 	if( self->target != EMPTY_HASH ) {
 		// start trains on the second frame, to make sure their targets have had
 		// a chance to spawn
-		self->nextThink = level.time + 1;
+		G_SetNextThink( self, level.time + 1 );
 		self->think = func_train_find;
 	} else {
 		Com_GGPrint( "func_train without a target at {}", self->s.origin );
@@ -1007,7 +1007,7 @@ void SP_func_train( edict_t *self ) {
 
 void func_timer_think( edict_t *self ) {
 	G_UseTargets( self, self->activator );
-	self->nextThink = level.time + 1000 * ( self->wait + RandomFloat11( &svs.rng ) * self->random );
+	G_SetNextThink( self, level.time + 1000 * ( self->wait + RandomFloat11( &svs.rng ) * self->random ) );
 }
 
 void func_timer_use( edict_t *self, edict_t *other, edict_t *activator ) {
@@ -1015,13 +1015,13 @@ void func_timer_use( edict_t *self, edict_t *other, edict_t *activator ) {
 
 	// if on, turn it off
 	if( self->nextThink ) {
-		self->nextThink = 0;
+		G_SetNextThink( self, 0 );
 		return;
 	}
 
 	// turn it on
 	if( self->delay ) {
-		self->nextThink = level.time + self->delay * 1000;
+		G_SetNextThink( self, level.time + self->delay * 1000 );
 	} else {
 		func_timer_think( self );
 	}
@@ -1043,8 +1043,8 @@ void SP_func_timer( edict_t *self ) {
 	}
 
 	if( self->spawnflags & 1 ) {
-		self->nextThink = level.time + 1000 *
-						  ( 1.0f + st.pausetime + self->delay + self->wait + RandomFloat11( &svs.rng ) * self->random );
+		G_SetNextThink( self, level.time + 1000 *
+						( 1.0f + st.pausetime + self->delay + self->wait + RandomFloat11( &svs.rng ) * self->random ) );
 		self->activator = self;
 	}
 }
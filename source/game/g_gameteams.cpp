@@ -50,7 +50,7 @@ void G_Teams_Init() {
 
 			ent->s.team = ent->r.client->team = TEAM_SPECTATOR;
 			G_GhostClient( ent );
-			ent->movetype = MOVETYPE_NOCLIP; // allow freefly
+			G_SetMovetype( ent, MOVETYPE_NOCLIP ); // allow freefly
 			ent->r.client->teamstate.timeStamp = level.time;
 			ent->r.client->resp.timeStamp = level.time;
 		}
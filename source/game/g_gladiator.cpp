@@ -12,11 +12,11 @@ static void SpikesDeploy( edict_t * self ) {
 		AngleVectors( self->s.angles, NULL, NULL, &dir );
 		Vec3 knockback = dir * 30.0f;
 		KillBox( self, MeanOfDeath_Spike, knockback );
-		self->nextThink = level.time + 1;
+		G_SetNextThink( self, level.time + 1 );
 	}
 	else {
 		self->think = SpikesRearm;
-		self->nextThink = level.time + 500;
+		G_SetNextThink( self, level.time + 500 );
 	}
 }
 
@@ -30,7 +30,7 @@ static void SpikesTouched( edict_t * self, edict_t * other, cplane_t * plane, in
 	}
 
 	if( self->s.linearMovementTimeStamp == 0 ) {
-		self->nextThink = level.time + 1000;
+		G_SetNextThink( self, level.time + 1000 );
 		self->think = SpikesDeploy;
 		self->s.linearMovementTimeStamp = Max2( s64( 1 ), svs.gametime );
 	}
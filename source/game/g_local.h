@@ -21,6 +21,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "qcommon/qcommon.h"
 #include "qcommon/hash.h"
+#include "qcommon/cmodel.h"
 #include "gameshared/gs_public.h"
 #include "gameshared/gs_weapons.h"
 #include "game/g_public.h"
@@ -211,6 +212,7 @@ extern cvar_t *g_respawn_delay_min;
 extern cvar_t *g_respawn_delay_max;
 extern cvar_t *g_deadbody_followkiller;
 extern cvar_t *g_antilag_timenudge;
+extern cvar_t *g_parallel_pmove;
 extern cvar_t *g_antilag_maxtimedelta;
 
 extern cvar_t *g_teams_maxplayers;
@@ -368,6 +370,7 @@ void G_InitMover( edict_t *ent );
 void G_InitEdict( edict_t *e );
 edict_t *G_Spawn();
 void G_FreeEdict( edict_t *e );
+void G_ResetFreeEdicts();
 
 char *_G_CopyString( const char *in, const char *filename, int fileline );
 #define G_CopyString( in ) _G_CopyString( in, __FILE__, __LINE__ )
@@ -455,6 +458,7 @@ int G_PointContents( Vec3 p );
 void G_Trace( trace_t *tr, Vec3 start, Vec3 mins, Vec3 maxs, Vec3 end, edict_t *passedict, int contentmask );
 int G_PointContents4D( Vec3 p, int timeDelta );
 void G_Trace4D( trace_t *tr, Vec3 start, Vec3 mins, Vec3 maxs, Vec3 end, edict_t *passedict, int contentmask, int timeDelta );
+void G_TraceBatch4D( trace_t *traces, const Vec3 *starts, const Vec3 *ends, int n, Vec3 mins, Vec3 maxs, edict_t *passedict, int contentmask, int timeDelta );
 void GClip_BackUpCollisionFrame();
 int GClip_FindInRadius4D( Vec3 org, float rad, int *list, int maxcount, int timeDelta );
 void G_SplashFrac4D( const edict_t *ent, Vec3 hitpoint, float maxradius, Vec3 * pushdir, float *frac, int timeDelta, bool selfdamage );
@@ -463,6 +467,9 @@ void GClip_SetBrushModel( edict_t * ent );
 void GClip_SetAreaPortalState( edict_t *ent, bool open );
 void GClip_LinkEntity( edict_t *ent );
 void GClip_UnlinkEntity( edict_t *ent );
+int GClip_SolidLinksGeneration();
+void GClip_PlotRelinkStats();
+void GClip_PrintRelinkStats();
 void GClip_TouchTriggers( edict_t *ent );
 void G_PMoveTouchTriggers( pmove_t *pm, Vec3 previous_origin );
 SyncEntityState *G_GetEntityStateForDeltaTime( int entNum, int deltaTime );
@@ -535,6 +542,8 @@ void G_ClientClearStats( edict_t *ent );
 void G_GhostClient( edict_t *self );
 void ClientThink( edict_t *ent, usercmd_t *cmd, int timeDelta );
 void G_ClientThink( edict_t *ent );
+void G_PredictClientMoves();
+void G_RunClientMoves( edict_t *ent );
 void G_CheckClientRespawnClick( edict_t *ent );
 bool ClientConnect( edict_t *ent, char *userinfo, bool fakeClient );
 void ClientDisconnect( edict_t *ent, const char *reason );
@@ -593,9 +602,41 @@ void G_Snap_UpdateWeaponListMessages();
 // g_phys.c
 //
 void SV_Impact( edict_t *e1, trace_t *trace );
-void G_RunEntity( edict_t *ent );
+void G_SetNextThink( edict_t *ent, int64_t time );
+void G_SetMovetype( edict_t *ent, int movetype );
+void G_UnscheduleEntity( edict_t *ent );
+void G_ResetEntitySchedule();
+void G_RunEntities();
 int G_BoxSlideMove( edict_t *ent, int contentmask, float slideBounce, float friction );
 
+template< typename T, typename F >
+inline void HeapSiftUp( T * heap, size_t i, F less ) {
+	while( i > 0 ) {
+		size_t parent = ( i - 1 ) / 2;
+		if( !less( heap[i], heap[parent] ) )
+			break;
+		Swap2( &heap[i], &heap[parent] );
+		i = parent;
+	}
+}
+
+template< typename T, typename F >
+inline void HeapSiftDown( T * heap, size_t n, size_t i, F less ) {
+	while( true ) {
+		size_t smallest = i;
+		size_t l = i * 2 + 1;
+		size_t r = i * 2 + 2;
+		if( l < n && less( heap[l], heap[smallest] ) )
+			smallest = l;
+		if( r < n && less( heap[r], heap[smallest] ) )
+			smallest = r;
+		if( smallest == i )
+			break;
+		Swap2( &heap[i], &heap[smallest] );
+		i = smallest;
+	}
+}
+
 //
 // g_main.c
 //
@@ -907,6 +948,13 @@ struct edict_t {
 	int64_t trigger_timeout;
 
 	bool linked;
+	bool linked_solid; // linked somewhere traces can hit it
+
+	// cached results of the last link, reused while the entity stays in the
+	// same leafs/grid cells
+	int leafs_generation;
+	BoxLeafnumsBounds leaf_bounds;
+	int areagrid_cells[4];
 
 	asIScriptFunction *asSpawnFunc, *asThinkFunc, *asUseFunc, *asTouchFunc, *asPainFunc, *asDieFunc, *asStopFunc;
 
@@ -172,7 +172,7 @@ void SP_func_wall( edict_t *self ) {
 
 void SP_func_static( edict_t *ent ) {
 	G_InitMover( ent );
-	ent->movetype = MOVETYPE_NONE;
+	G_SetMovetype( ent, MOVETYPE_NONE );
 	ent->r.svflags = SVF_BROADCAST;
 	GClip_LinkEntity( ent );
 }
@@ -238,7 +238,7 @@ static void func_explosive_use( edict_t *self, edict_t *other, edict_t *activato
 
 	if( self->delay ) {
 		self->think = func_explosive_think;
-		self->nextThink = level.time + self->delay * 1000;
+		G_SetNextThink( self, level.time + self->delay * 1000 );
 		return;
 	}
 
@@ -0,0 +1,965 @@
+#include "game/g_local.h"
+#include "qcommon/array.h"
+#include "qcommon/cmodel.h"
+#include "qcommon/hashtable.h"
+#include "qcommon/threads.h"
+
+/*
+ * bot navigation
+ *
+ * the nav graph is a grid of standing spots, found by dropping a player box
+ * down every column of the map and keeping the walkable surfaces it lands on.
+ * neighbouring spots get walk links when a player box can step from one to
+ * the other, and jump/dash links when running Pmove from one lands on the
+ * other. spots that can't be reached from a spawn point get thrown away.
+ *
+ * paths are planned with A* on worker threads. finished paths go into a cache
+ * shared by all bots, and lookups that miss it return NavPath_Pending. paths
+ * are handed over NAV_REQUEST_FRAMES frames after they were asked for, in the
+ * order they were asked for, however quickly the workers got to them. if a
+ * worker hasn't started one by then the main thread plans it, and if it's
+ * still running the main thread waits for it, so the game plays out the same
+ * whatever the threads are up to. with ai_nav_threads 0 the main thread
+ * plans everything.
+ */
+
+static constexpr float NAV_CELL_SIZE = 48.0f;
+static constexpr int NAV_MAX_LEVELS = 16;
+static constexpr float NAV_MAX_DROP = 256.0f;
+static constexpr float NAV_MAX_JUMP = 96.0f;
+static constexpr int NAV_SIM_FRAMES = 64;
+static constexpr int NAV_SIM_MSEC = 16;
+
+static constexpr u32 NAV_CACHE_SIZE = 1024;
+static constexpr u32 NAV_MAX_REQUESTS = 64;
+static constexpr u32 NAV_MAX_THREADS = 8;
+static constexpr s64 NAV_REQUEST_FRAMES = 2;
+
+struct NavNode {
+	Vec3 origin;
+	u32 first_link;
+	u32 num_links;
+};
+
+struct NavLink {
+	u32 target;
+	float cost;
+	NavLinkType type;
+};
+
+struct NavPath {
+	u64 key;
+	bool found;
+	u32 len;
+	u32 nodes[ NAV_MAX_PATH ];
+};
+
+struct NavRequest {
+	u64 key;
+	s64 due_frame;
+	bool done;
+	NavPath result;
+};
+
+struct OpenNode {
+	float f;
+	float g;
+	u32 node;
+};
+
+struct NavSearch {
+	float * cost;
+	u32 * parent;
+	u32 * visited; // search id that last touched the node
+	u32 search;
+
+	OpenNode * open;
+	size_t max_open;
+
+	NavPath result;
+};
+
+struct NavGraph {
+	u32 checksum;
+
+	NavNode * nodes;
+	u32 num_nodes;
+
+	NavLink * links;
+	u32 num_links;
+
+	Vec3 mins;
+	int cells_x, cells_y;
+	u32 * cell_first_node; // nodes are sorted by cell, cells_x * cells_y + 1 entries
+
+	u32 * spawn_nodes;
+	u32 num_spawn_nodes;
+};
+
+static NavGraph nav;
+static gs_state_t nav_gs;
+
+static cvar_t * ai_nav_threads;
+
+// main thread only
+static NavPath path_cache[ NAV_CACHE_SIZE ];
+static Hashtable< NAV_CACHE_SIZE * 2 > path_cache_index;
+static u32 path_cache_next;
+
+static Hashtable< NAV_MAX_REQUESTS * 2 > pending_paths;
+static u32 num_pending_paths;
+
+static NavSearch main_search;
+static s64 nav_frame;
+
+static struct {
+	u32 hits;
+	u32 misses;
+	u32 planned;
+} nav_frame_stats;
+
+// shared with the workers. requests are started in order, so the first
+// num_started requests from requests_head are being planned or done
+static Mutex * nav_mutex;
+static Semaphore * nav_requests_sem;
+static Semaphore * nav_done_sem;
+static NavRequest requests[ NAV_MAX_REQUESTS ];
+static u32 requests_head;
+static u32 num_requests;
+static u32 num_started;
+static bool waiting_for_workers;
+static bool workers_quit;
+
+static Thread * workers[ NAV_MAX_THREADS ];
+static NavSearch worker_searches[ NAV_MAX_THREADS ];
+static u32 num_workers;
+
+static u64 PathKey( u32 start, u32 goal ) {
+	return ( ( u64( start ) << 32 ) | goal ) + 1;
+}
+
+/*
+==============================================================================
+
+GRAPH CONSTRUCTION
+
+==============================================================================
+*/
+
+/*
+* the graph is built from the world and brush entities, but not players who
+* happen to be standing around when the map loads
+*/
+static constexpr int NAV_CONTENTS_MASK = MASK_PLAYERSOLID & ~CONTENTS_BODY;
+
+static void Nav_GS_Trace( trace_t * t, Vec3 start, Vec3 mins, Vec3 maxs, Vec3 end, int ignore, int contentmask, int timeDelta ) {
+	G_Trace( t, start, mins, maxs, end, NULL, contentmask & ~CONTENTS_BODY );
+}
+
+static void Nav_GS_PredictedEvent( int entNum, int ev, u64 parm ) { }
+static void Nav_GS_PredictedFireWeapon( int entNum, u64 weapon_and_entropy ) { }
+static void Nav_GS_PMoveTouchTriggers( pmove_t * pm, Vec3 previous_origin ) { }
+
+static trace_t Nav_Trace( Vec3 start, Vec3 end ) {
+	trace_t tr;
+	G_Trace( &tr, start, playerbox_stand_mins, playerbox_stand_maxs, end, NULL, NAV_CONTENTS_MASK );
+	return tr;
+}
+
+static bool Nav_Standable( Vec3 origin ) {
+	trace_t tr = Nav_Trace( origin, origin );
+	if( tr.startsolid )
+		return false;
+
+	Vec3 feet = origin + Vec3( 0.0f, 0.0f, playerbox_stand_mins.z + 1.0f );
+	int contents = G_PointContents( feet );
+	return ( contents & ( CONTENTS_LAVA | CONTENTS_SLIME | CONTENTS_NODROP ) ) == 0;
+}
+
+/*
+* Nav_AddColumnNodes
+*
+* traces that start inside a brush ignore it, so starting each trace just
+* below the floor we found last finds the next floor down
+*/
+static void Nav_AddColumnNodes( NonRAIIDynamicArray< NavNode > * nodes, Vec3 top, float bottom ) {
+	Vec3 start = top;
+	for( int i = 0; i < NAV_MAX_LEVELS; i++ ) {
+		trace_t tr = Nav_Trace( start, Vec3( start.x, start.y, bottom ) );
+		if( tr.allsolid || tr.fraction == 1.0f )
+			break;
+
+		if( ISWALKABLEPLANE( &tr.plane ) && Nav_Standable( tr.endpos ) ) {
+			nodes->add( { tr.endpos, 0, 0 } );
+		}
+
+		start = tr.endpos - Vec3( 0.0f, 0.0f, 2.0f );
+	}
+}
+
+static bool Nav_CanWalk( Vec3 from, Vec3 to ) {
+	if( to.z - from.z > STEPSIZE )
+		return false;
+
+	Vec3 above = Vec3( to.x, to.y, from.z + STEPSIZE );
+	trace_t tr = Nav_Trace( from + Vec3( 0.0f, 0.0f, STEPSIZE ), above );
+	if( tr.startsolid || tr.fraction < 1.0f )
+		return false;
+
+	tr = Nav_Trace( above, to - Vec3( 0.0f, 0.0f, 1.0f ) );
+	if( tr.startsolid || Abs( tr.endpos.z - to.z ) > 1.0f )
+		return false;
+
+	// walking off a ledge is fine, walking over a hole isn't
+	if( from.z - to.z <= STEPSIZE ) {
+		Vec3 mid = ( from + to ) * 0.5f;
+		mid.z = Max2( from.z, to.z );
+		tr = Nav_Trace( mid, mid - Vec3( 0.0f, 0.0f, STEPSIZE * 2 ) );
+		if( tr.fraction == 1.0f )
+			return false;
+	}
+
+	return true;
+}
+
+/*
+* Nav_CanJump
+*
+* runs Pmove like a bot would follow the link, holding jump or dash and
+* running at the target. overshooting is fine as long as we land at the
+* target's height past the target
+*/
+static bool Nav_CanJump( Vec3 from, Vec3 to, NavLinkType type ) {
+	float h = Max2( to.z - from.z, 0.0f ) + STEPSIZE;
+	trace_t tr = Nav_Trace( from + Vec3( 0.0f, 0.0f, h ), Vec3( to.x, to.y, from.z + h ) );
+	if( tr.startsolid || tr.fraction < 1.0f )
+		return false;
+
+	SyncPlayerState ps = { };
+	ps.POVnum = 1;
+	ps.pmove.pm_type = PM_NORMAL;
+	ps.pmove.origin = from;
+	ps.pmove.features = PMFEAT_DEFAULT;
+	ps.pmove.max_speed = DEFAULT_PLAYERSPEED;
+	ps.pmove.jump_speed = DEFAULT_JUMPSPEED;
+	ps.pmove.dash_speed = DEFAULT_DASHSPEED;
+
+	pmove_t pm = { };
+	pm.playerState = &ps;
+
+	Vec3 dir = to - from;
+	dir.z = 0.0f;
+	float dist = Length( dir );
+	dir = Normalize( dir );
+	short yaw = ANGLE2SHORT( Degrees( atan2f( dir.y, dir.x ) ) );
+
+	for( int i = 0; i < NAV_SIM_FRAMES; i++ ) {
+		pm.cmd = { };
+		pm.cmd.msec = NAV_SIM_MSEC;
+		pm.cmd.angles[ YAW ] = yaw;
+		pm.cmd.forwardmove = 127;
+		if( type == NavLink_Jump ) {
+			pm.cmd.upmove = 127;
+		}
+		else {
+			pm.cmd.buttons = BUTTON_SPECIAL;
+		}
+
+		Pmove( &nav_gs, &pm );
+
+		if( i > 0 && pm.groundentity != -1 ) {
+			float progress = Dot( ps.pmove.origin - from, dir );
+			return progress >= dist - NAV_CELL_SIZE * 0.5f && Abs( ps.pmove.origin.z - to.z ) <= STEPSIZE;
+		}
+	}
+
+	return false;
+}
+
+static u32 Nav_CellIndex( int x, int y ) {
+	return u32( y * nav.cells_x + x );
+}
+
+static bool Nav_TryLink( NonRAIIDynamicArray< NavLink > * links, u32 from, u32 to, bool adjacent, u32 * num_jumps, u32 * num_dashes ) {
+	Vec3 a = nav.nodes[ from ].origin;
+	Vec3 b = nav.nodes[ to ].origin;
+	float dz = b.z - a.z;
+	if( dz > NAV_MAX_JUMP || dz < -NAV_MAX_DROP )
+		return false;
+
+	float dist = Length( b - a );
+
+	if( adjacent && Nav_CanWalk( a, b ) ) {
+		links->add( { to, dist, NavLink_Walk } );
+		return true;
+	}
+
+	if( Nav_CanJump( a, b, NavLink_Jump ) ) {
+		links->add( { to, dist * 1.5f, NavLink_Jump } );
+		( *num_jumps )++;
+		return true;
+	}
+
+	if( Nav_CanJump( a, b, NavLink_Dash ) ) {
+		links->add( { to, dist * 1.5f, NavLink_Dash } );
+		( *num_dashes )++;
+		return true;
+	}
+
+	return false;
+}
+
+static void Nav_AddLinks( NonRAIIDynamicArray< NavLink > * links, u32 n, u32 * num_jumps, u32 * num_dashes ) {
+	constexpr int dirs[ 8 ][ 2 ] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }, { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+
+	Vec3 origin = nav.nodes[ n ].origin;
+	int cx = int( ( origin.x - nav.mins.x ) / NAV_CELL_SIZE );
+	int cy = int( ( origin.y - nav.mins.y ) / NAV_CELL_SIZE );
+
+	for( const auto & d : dirs ) {
+		bool linked = false;
+
+		// try the neighbouring cell, then jump the gap to the one after it
+		for( int step = 1; step <= 2 && !linked; step++ ) {
+			int x = cx + d[ 0 ] * step;
+			int y = cy + d[ 1 ] * step;
+			if( x < 0 || y < 0 || x >= nav.cells_x || y >= nav.cells_y )
+				break;
+
+			u32 cell = Nav_CellIndex( x, y );
+			for( u32 m = nav.cell_first_node[ cell ]; m < nav.cell_first_node[ cell + 1 ]; m++ ) {
+				linked = Nav_TryLink( links, n, m, step == 1, num_jumps, num_dashes ) || linked;
+			}
+		}
+	}
+}
+
+static void Nav_FreeGraph() {
+	FREE( sys_allocator, nav.nodes );
+	FREE( sys_allocator, nav.links );
+	FREE( sys_allocator, nav.cell_first_node );
+	FREE( sys_allocator, nav.spawn_nodes );
+	nav = { };
+}
+
+/*
+* Nav_LinkReachable
+*
+* links get built walking out from the spawn points, so spots bots can't get
+* to (inside clip brushes, under the map, etc) never get linked and are
+* thrown away at the end
+*/
+static void Nav_LinkReachable( NonRAIIDynamicArray< NavLink > * links, u32 * num_jumps, u32 * num_dashes ) {
+	u32 * remap = ALLOC_MANY( sys_allocator, u32, nav.num_nodes );
+	u32 * queue = ALLOC_MANY( sys_allocator, u32, nav.num_nodes );
+	defer { FREE( sys_allocator, remap ); };
+	defer { FREE( sys_allocator, queue ); };
+
+	for( u32 i = 0; i < nav.num_nodes; i++ ) {
+		remap[ i ] = NAV_NONE;
+	}
+
+	u32 queue_head = 0;
+	u32 queue_tail = 0;
+
+	for( int i = server_gs.maxclients + 1; i < game.numentities; i++ ) {
+		const edict_t * ent = &game.edicts[ i ];
+		if( !ent->r.inuse )
+			continue;
+
+		bool spawn = ent->classname == "spawn_gladiator";
+		spawn = spawn || ent->classname == "spawn_bomb_attacking";
+		spawn = spawn || ent->classname == "spawn_bomb_defending";
+		spawn = spawn || ent->classname == "info_player_deathmatch";
+		if( !spawn )
+			continue;
+
+		u32 node = Nav_StartNode( ent->s.origin );
+		if( node != NAV_NONE && remap[ node ] == NAV_NONE ) {
+			remap[ node ] = 0;
+			queue[ queue_tail ] = node;
+			queue_tail++;
+		}
+	}
+
+	u32 num_spawn_nodes = queue_tail;
+
+	// no spawn points, keep the whole thing
+	if( queue_tail == 0 ) {
+		for( u32 i = 0; i < nav.num_nodes; i++ ) {
+			remap[ i ] = 0;
+			queue[ i ] = i;
+		}
+		queue_tail = nav.num_nodes;
+	}
+
+	while( queue_head < queue_tail ) {
+		u32 n = queue[ queue_head ];
+		queue_head++;
+
+		NavNode * node = &nav.nodes[ n ];
+		node->first_link = u32( links->size() );
+		Nav_AddLinks( links, n, num_jumps, num_dashes );
+		node->num_links = u32( links->size() ) - node->first_link;
+
+		for( u32 i = node->first_link; i < links->size(); i++ ) {
+			u32 target = ( *links )[ i ].target;
+			if( remap[ target ] == NAV_NONE ) {
+				remap[ target ] = 0;
+				queue[ queue_tail ] = target;
+				queue_tail++;
+			}
+		}
+	}
+
+	u32 num_nodes = 0;
+	for( u32 i = 0; i < nav.num_nodes; i++ ) {
+		if( remap[ i ] != NAV_NONE ) {
+			remap[ i ] = num_nodes;
+			nav.nodes[ num_nodes ] = nav.nodes[ i ];
+			num_nodes++;
+		}
+	}
+
+	for( NavLink & link : *links ) {
+		link.target = remap[ link.target ];
+	}
+
+	// nodes kept their order so they're still sorted by cell
+	u32 num_cells = u32( nav.cells_x * nav.cells_y );
+	for( u32 i = 0; i <= num_cells; i++ ) {
+		nav.cell_first_node[ i ] = 0;
+	}
+	for( u32 i = 0; i < num_nodes; i++ ) {
+		Vec3 origin = nav.nodes[ i ].origin;
+		int cx = int( ( origin.x - nav.mins.x ) / NAV_CELL_SIZE );
+		int cy = int( ( origin.y - nav.mins.y ) / NAV_CELL_SIZE );
+		nav.cell_first_node[ Nav_CellIndex( cx, cy ) + 1 ]++;
+	}
+	for( u32 i = 0; i < num_cells; i++ ) {
+		nav.cell_first_node[ i + 1 ] += nav.cell_first_node[ i ];
+	}
+
+	nav.num_nodes = num_nodes;
+
+	nav.spawn_nodes = ALLOC_MANY( sys_allocator, u32, Max2( num_spawn_nodes, u32( 1 ) ) );
+	nav.num_spawn_nodes = num_spawn_nodes;
+	for( u32 i = 0; i < num_spawn_nodes; i++ ) {
+		nav.spawn_nodes[ i ] = remap[ queue[ i ] ];
+	}
+}
+
+static void Nav_BuildGraph() {
+	ZoneScoped;
+
+	nav_gs = { };
+	nav_gs.module = GS_MODULE_CGAME;
+	nav_gs.maxclients = server_gs.maxclients;
+	nav_gs.gameState = server_gs.gameState;
+	nav_gs.api.Trace = Nav_GS_Trace;
+	nav_gs.api.GetEntityState = server_gs.api.GetEntityState;
+	nav_gs.api.PointContents = server_gs.api.PointContents;
+	nav_gs.api.PredictedEvent = Nav_GS_PredictedEvent;
+	nav_gs.api.PredictedFireWeapon = Nav_GS_PredictedFireWeapon;
+	nav_gs.api.PMoveTouchTriggers = Nav_GS_PMoveTouchTriggers;
+
+	cmodel_t * world_model = CM_FindCModel( CM_Server, StringHash( svs.cms->world_hash ) );
+	Vec3 world_mins, world_maxs;
+	CM_InlineModelBounds( svs.cms, world_model, &world_mins, &world_maxs );
+
+	nav.checksum = svs.cms->checksum;
+	nav.mins = world_mins;
+	nav.cells_x = Max2( 1, int( ceilf( ( world_maxs.x - world_mins.x ) / NAV_CELL_SIZE ) ) );
+	nav.cells_y = Max2( 1, int( ceilf( ( world_maxs.y - world_mins.y ) / NAV_CELL_SIZE ) ) );
+
+	u32 num_cells = u32( nav.cells_x * nav.cells_y );
+	nav.cell_first_node = ALLOC_MANY( sys_allocator, u32, num_cells + 1 );
+
+	NonRAIIDynamicArray< NavNode > nodes;
+	nodes.init( sys_allocator );
+	defer { nodes.shutdown(); };
+
+	{
+		ZoneScopedN( "Find standing spots" );
+
+		float top = world_maxs.z + 64.0f;
+		float bottom = world_mins.z - 64.0f;
+		for( int y = 0; y < nav.cells_y; y++ ) {
+			for( int x = 0; x < nav.cells_x; x++ ) {
+				nav.cell_first_node[ Nav_CellIndex( x, y ) ] = u32( nodes.size() );
+				Vec3 column = world_mins + Vec3( ( x + 0.5f ) * NAV_CELL_SIZE, ( y + 0.5f ) * NAV_CELL_SIZE, 0.0f );
+				Nav_AddColumnNodes( &nodes, Vec3( column.x, column.y, top ), bottom );
+			}
+		}
+		nav.cell_first_node[ num_cells ] = u32( nodes.size() );
+	}
+
+	nav.num_nodes = u32( nodes.size() );
+	nav.nodes = ALLOC_MANY( sys_allocator, NavNode, nav.num_nodes );
+	memcpy( nav.nodes, nodes.ptr(), nodes.num_bytes() );
+
+	NonRAIIDynamicArray< NavLink > links;
+	links.init( sys_allocator );
+	defer { links.shutdown(); };
+
+	u32 num_jumps = 0;
+	u32 num_dashes = 0;
+	u32 num_spots = nav.num_nodes;
+
+	{
+		ZoneScopedN( "Link standing spots" );
+		Nav_LinkReachable( &links, &num_jumps, &num_dashes );
+	}
+
+	nav.num_links = u32( links.size() );
+	nav.links = ALLOC_MANY( sys_allocator, NavLink, Max2( nav.num_links, u32( 1 ) ) );
+	memcpy( nav.links, links.ptr(), links.num_bytes() );
+
+	Com_Printf( "Nav graph: %u of %u spots reachable, %u links (%u jumps, %u dashes)\n",
+		nav.num_nodes, num_spots, nav.num_links, num_jumps, num_dashes );
+}
+
+/*
+==============================================================================
+
+PATH PLANNING
+
+==============================================================================
+*/
+
+static bool OpenNodeLess( OpenNode a, OpenNode b ) {
+	return a.f < b.f;
+}
+
+static void Nav_InitSearch( NavSearch * search ) {
+	*search = { };
+	search->cost = ALLOC_MANY( sys_allocator, float, Max2( nav.num_nodes, u32( 1 ) ) );
+	search->parent = ALLOC_MANY( sys_allocator, u32, Max2( nav.num_nodes, u32( 1 ) ) );
+	search->visited = ALLOC_MANY( sys_allocator, u32, Max2( nav.num_nodes, u32( 1 ) ) );
+	memset( search->visited, 0, sizeof( u32 ) * nav.num_nodes );
+
+	// with a consistent heuristic every link gets relaxed at most once
+	search->max_open = nav.num_links + 1;
+	search->open = ALLOC_MANY( sys_allocator, OpenNode, search->max_open );
+}
+
+static void Nav_ShutdownSearch( NavSearch * search ) {
+	FREE( sys_allocator, search->cost );
+	FREE( sys_allocator, search->parent );
+	FREE( sys_allocator, search->visited );
+	FREE( sys_allocator, search->open );
+	*search = { };
+}
+
+/*
+* Nav_AStar
+*
+* only reads the graph, so it's safe to run on any thread with its own
+* NavSearch. paths longer than NAV_MAX_PATH get cut short and bots plan the
+* rest when they get to the end
+*/
+static void Nav_AStar( NavSearch * s, u64 key ) {
+	ZoneScoped;
+
+	u32 start = u32( ( key - 1 ) >> 32 );
+	u32 goal = u32( key - 1 );
+
+	NavPath * result = &s->result;
+	result->key = key;
+	result->found = false;
+	result->len = 0;
+
+	s->search++;
+	if( s->search == 0 ) {
+		memset( s->visited, 0, sizeof( u32 ) * nav.num_nodes );
+		s->search = 1;
+	}
+
+	Vec3 goal_origin = nav.nodes[ goal ].origin;
+
+	size_t num_open = 0;
+	s->cost[ start ] = 0.0f;
+	s->parent[ start ] = NAV_NONE;
+	s->visited[ start ] = s->search;
+	s->open[ num_open ] = { Length( nav.nodes[ start ].origin - goal_origin ), 0.0f, start };
+	num_open++;
+
+	while( num_open > 0 ) {
+		OpenNode top = s->open[ 0 ];
+		num_open--;
+		s->open[ 0 ] = s->open[ num_open ];
+		HeapSiftDown( s->open, num_open, 0, OpenNodeLess );
+
+		if( top.g > s->cost[ top.node ] )
+			continue;
+
+		if( top.node == goal ) {
+			result->found = true;
+			break;
+		}
+
+		const NavNode * node = &nav.nodes[ top.node ];
+		for( u32 i = 0; i < node->num_links; i++ ) {
+			const NavLink * link = &nav.links[ node->first_link + i ];
+			float g = top.g + link->cost;
+			if( s->visited[ link->target ] == s->search && s->cost[ link->target ] <= g )
+				continue;
+			if( num_open == s->max_open )
+				continue;
+
+			s->visited[ link->target ] = s->search;
+			s->cost[ link->target ] = g;
+			s->parent[ link->target ] = top.node;
+
+			s->open[ num_open ] = { g + Length( nav.nodes[ link->target ].origin - goal_origin ), g, link->target };
+			num_open++;
+			HeapSiftUp( s->open, num_open - 1, OpenNodeLess );
+		}
+	}
+
+	if( !result->found )
+		return;
+
+	u32 len = 0;
+	for( u32 n = goal; n != NAV_NONE; n = s->parent[ n ] ) {
+		len++;
+	}
+
+	result->len = Min2( len, NAV_MAX_PATH );
+	u32 i = len;
+	for( u32 n = goal; n != NAV_NONE; n = s->parent[ n ] ) {
+		i--;
+		if( i < NAV_MAX_PATH ) {
+			result->nodes[ i ] = n;
+		}
+	}
+}
+
+static void Nav_WorkerThread( void * data ) {
+	NavSearch * search = ( NavSearch * ) data;
+
+	while( true ) {
+		Wait( nav_requests_sem );
+
+		Lock( nav_mutex );
+		if( workers_quit ) {
+			Unlock( nav_mutex );
+			return;
+		}
+
+		// the main thread got to it first, or a leftover signal from
+		// before the graph was rebuilt
+		if( num_started == num_requests ) {
+			Unlock( nav_mutex );
+			continue;
+		}
+
+		NavRequest * request = &requests[ ( requests_head + num_started ) % NAV_MAX_REQUESTS ];
+		num_started++;
+		Unlock( nav_mutex );
+
+		Nav_AStar( search, request->key );
+
+		Lock( nav_mutex );
+		request->result = search->result;
+		request->done = true;
+		if( waiting_for_workers ) {
+			Signal( nav_done_sem );
+		}
+		Unlock( nav_mutex );
+	}
+}
+
+static void Nav_StartWorkers() {
+	num_workers = Min2( u32( Max2( ai_nav_threads->integer, 0 ) ), NAV_MAX_THREADS );
+	workers_quit = false;
+
+	Nav_InitSearch( &main_search );
+	for( u32 i = 0; i < num_workers; i++ ) {
+		Nav_InitSearch( &worker_searches[ i ] );
+		workers[ i ] = NewThread( Nav_WorkerThread, &worker_searches[ i ] );
+	}
+}
+
+static void Nav_StopWorkers() {
+	Lock( nav_mutex );
+	workers_quit = true;
+	Unlock( nav_mutex );
+
+	Signal( nav_requests_sem, num_workers );
+	for( u32 i = 0; i < num_workers; i++ ) {
+		JoinThread( workers[ i ] );
+		Nav_ShutdownSearch( &worker_searches[ i ] );
+	}
+	num_workers = 0;
+	Nav_ShutdownSearch( &main_search );
+
+	requests_head = 0;
+	num_requests = 0;
+	num_started = 0;
+	pending_paths.clear();
+	num_pending_paths = 0;
+}
+
+static void Nav_CachePath( const NavPath * path ) {
+	u64 idx;
+	if( path_cache_index.get( path->key, &idx ) )
+		return;
+
+	NavPath * slot = &path_cache[ path_cache_next ];
+	if( slot->key != 0 ) {
+		path_cache_index.remove( slot->key );
+	}
+
+	slot->key = path->key;
+	slot->found = path->found;
+	slot->len = path->len;
+	memcpy( slot->nodes, path->nodes, sizeof( path->nodes[ 0 ] ) * path->len );
+
+	path_cache_index.add( path->key, path_cache_next );
+	path_cache_next = ( path_cache_next + 1 ) % NAV_CACHE_SIZE;
+}
+
+static void Nav_FinishRequest( const NavPath * path ) {
+	Nav_CachePath( path );
+	pending_paths.remove( path->key );
+	num_pending_paths--;
+	nav_frame_stats.planned++;
+}
+
+static void Nav_ClearPathCache() {
+	for( NavPath & path : path_cache ) {
+		path.key = 0;
+	}
+	path_cache_index.clear();
+	path_cache_next = 0;
+}
+
+/*
+==============================================================================
+
+PUBLIC API
+
+==============================================================================
+*/
+
+void Nav_Init() {
+	ai_nav_threads = Cvar_Get( "ai_nav_threads", "2", CVAR_ARCHIVE );
+
+	nav_mutex = NewMutex();
+	nav_requests_sem = NewSemaphore();
+	nav_done_sem = NewSemaphore();
+
+	nav = { };
+	Nav_ClearPathCache();
+}
+
+void Nav_Shutdown() {
+	if( nav.cell_first_node != NULL ) {
+		Nav_StopWorkers();
+	}
+	Nav_FreeGraph();
+
+	DeleteSemaphore( nav_done_sem );
+	DeleteSemaphore( nav_requests_sem );
+	DeleteMutex( nav_mutex );
+}
+
+/*
+* Nav_BuildForLevel
+* rounds reset the level all the time, only rebuild when the map changes
+*/
+void Nav_BuildForLevel() {
+	if( svs.cms == NULL )
+		return;
+	if( nav.cell_first_node != NULL && nav.checksum == svs.cms->checksum )
+		return;
+
+	if( nav.cell_first_node != NULL ) {
+		Nav_StopWorkers();
+	}
+	Nav_FreeGraph();
+	Nav_ClearPathCache();
+
+	u64 start = Sys_Microseconds();
+	Nav_BuildGraph();
+	Com_Printf( "Built nav graph in %.2fs\n", ( Sys_Microseconds() - start ) / 1000000.0f );
+
+	Nav_StartWorkers();
+}
+
+void Nav_Frame() {
+	ZoneScoped;
+
+	if( nav.num_nodes == 0 )
+		return;
+
+	Lock( nav_mutex );
+	while( num_requests > 0 && requests[ requests_head ].due_frame <= nav_frame ) {
+		NavRequest * request = &requests[ requests_head ];
+
+		if( num_started == 0 ) {
+			num_started++;
+			Unlock( nav_mutex );
+
+			Nav_AStar( &main_search, request->key );
+
+			Lock( nav_mutex );
+			request->result = main_search.result;
+			request->done = true;
+		}
+
+		while( !request->done ) {
+			waiting_for_workers = true;
+			Unlock( nav_mutex );
+			Wait( nav_done_sem );
+			Lock( nav_mutex );
+		}
+		waiting_for_workers = false;
+
+		Nav_FinishRequest( &request->result );
+		request->done = false;
+		requests_head = ( requests_head + 1 ) % NAV_MAX_REQUESTS;
+		num_requests--;
+		num_started--;
+	}
+	Unlock( nav_mutex );
+
+	nav_frame++;
+
+	TracyPlot( "Nav paths pending", s64( num_pending_paths ) );
+	TracyPlot( "Nav paths planned", s64( nav_frame_stats.planned ) );
+	TracyPlot( "Nav path cache hits", s64( nav_frame_stats.hits ) );
+	TracyPlot( "Nav path cache misses", s64( nav_frame_stats.misses ) );
+	nav_frame_stats = { };
+}
+
+static u32 Nav_FindNearestNode( Vec3 origin, bool reachable ) {
+	if( nav.cell_first_node == NULL )
+		return NAV_NONE;
+
+	int cx = int( floorf( ( origin.x - nav.mins.x ) / NAV_CELL_SIZE ) );
+	int cy = int( floorf( ( origin.y - nav.mins.y ) / NAV_CELL_SIZE ) );
+
+	u32 best = NAV_NONE;
+	float best_score = FLT_MAX;
+
+	// prefer our own cell, but players standing near walls can be over an
+	// empty one
+	for( int ring = 0; ring <= 1 && best == NAV_NONE; ring++ ) {
+		for( int y = cy - ring; y <= cy + ring; y++ ) {
+			for( int x = cx - ring; x <= cx + ring; x++ ) {
+				if( x < 0 || y < 0 || x >= nav.cells_x || y >= nav.cells_y )
+					continue;
+
+				u32 cell = Nav_CellIndex( x, y );
+				for( u32 n = nav.cell_first_node[ cell ]; n < nav.cell_first_node[ cell + 1 ]; n++ ) {
+					Vec3 d = nav.nodes[ n ].origin - origin;
+					// spots above us are probably a different floor
+					float score = Length( d ) + ( d.z > STEPSIZE ? 1000.0f : 0.0f );
+					if( score >= best_score )
+						continue;
+
+					if( reachable ) {
+						Vec3 step = Vec3( 0.0f, 0.0f, STEPSIZE );
+						trace_t tr = Nav_Trace( origin + step, nav.nodes[ n ].origin + step );
+						if( tr.startsolid || tr.fraction < 1.0f )
+							continue;
+					}
+
+					best = n;
+					best_score = score;
+				}
+			}
+		}
+	}
+
+	return best;
+}
+
+u32 Nav_NearestNode( Vec3 origin ) {
+	return Nav_FindNearestNode( origin, false );
+}
+
+/*
+* Nav_StartNode
+* like Nav_NearestNode but only returns nodes we can run straight to
+*/
+u32 Nav_StartNode( Vec3 origin ) {
+	return Nav_FindNearestNode( origin, true );
+}
+
+/*
+* Nav_RandomGoal
+* half the time head for a spawn area, so bots bump into each other and
+* share cached paths
+*/
+u32 Nav_RandomGoal( RNG * rng ) {
+	if( nav.num_nodes == 0 )
+		return NAV_NONE;
+	if( nav.num_spawn_nodes > 0 && Probability( rng, 0.5f ) )
+		return nav.spawn_nodes[ RandomUniform( rng, 0, int( nav.num_spawn_nodes ) ) ];
+	return u32( RandomUniform( rng, 0, int( nav.num_nodes ) ) );
+}
+
+Vec3 Nav_NodeOrigin( u32 node ) {
+	return nav.nodes[ node ].origin;
+}
+
+NavLinkType Nav_LinkType( u32 from, u32 to ) {
+	const NavNode * node = &nav.nodes[ from ];
+	for( u32 i = 0; i < node->num_links; i++ ) {
+		const NavLink * link = &nav.links[ node->first_link + i ];
+		if( link->target == to ) {
+			return link->type;
+		}
+	}
+	return NavLink_Walk;
+}
+
+NavPathResult Nav_FindPath( u32 start, u32 goal, u32 * path, u32 * path_len ) {
+	if( start >= nav.num_nodes || goal >= nav.num_nodes )
+		return NavPath_NoPath;
+
+	if( start == goal ) {
+		path[ 0 ] = start;
+		*path_len = 1;
+		return NavPath_Found;
+	}
+
+	u64 key = PathKey( start, goal );
+	u64 idx;
+	if( path_cache_index.get( key, &idx ) ) {
+		nav_frame_stats.hits++;
+
+		const NavPath * cached = &path_cache[ idx ];
+		if( !cached->found )
+			return NavPath_NoPath;
+
+		memcpy( path, cached->nodes, sizeof( cached->nodes[ 0 ] ) * cached->len );
+		*path_len = cached->len;
+		return NavPath_Found;
+	}
+
+	nav_frame_stats.misses++;
+
+	if( pending_paths.get( key, &idx ) || num_pending_paths == NAV_MAX_REQUESTS )
+		return NavPath_Pending;
+
+	pending_paths.add( key, 0 );
+	num_pending_paths++;
+
+	Lock( nav_mutex );
+	NavRequest * request = &requests[ ( requests_head + num_requests ) % NAV_MAX_REQUESTS ];
+	request->key = key;
+	request->due_frame = nav_frame + NAV_REQUEST_FRAMES;
+	request->done = false;
+	num_requests++;
+	Unlock( nav_mutex );
+
+	if( num_workers > 0 ) {
+		Signal( nav_requests_sem );
+	}
+
+	return NavPath_Pending;
+}
@@ -70,7 +70,7 @@ static void SV_RunThink( edict_t *ent ) {
 		return;
 	}
 
-	ent->nextThink = 0;
+	G_SetNextThink( ent, 0 );
 
 	if( ISEVENTENTITY( &ent->s ) ) { // events do not think
 		return;
@@ -341,7 +341,7 @@ static void SV_Physics_Pusher( edict_t *ent ) {
 	if( blocked ) {
 		// the move failed, bump all nextthink times and back out moves
 		if( ent->nextThink > 0 ) {
-			ent->nextThink += game.frametime;
+			G_SetNextThink( ent, ent->nextThink + game.frametime );
 		}
 
 		// if the pusher has a "blocked" function, call it
@@ -555,7 +555,7 @@ static void SV_Physics_LinearProjectile( edict_t *ent ) {
 * G_RunEntity
 *
 */
-void G_RunEntity( edict_t *ent ) {
+static void G_RunEntity( edict_t *ent ) {
 	if( !level.canSpawnEntities ) { // don't try to think before map entities are spawned
 		return;
 	}
@@ -593,3 +593,242 @@ void G_RunEntity( edict_t *ent ) {
 			Com_Error( ERR_DROP, "SV_Physics: bad movetype %i", (int)ent->movetype );
 	}
 }
+
+//============================================================================
+
+/*
+* entity scheduling
+*
+* entities only run when their think is due or their movetype needs physics,
+* so idle world entities cost nothing per frame. due thinks come out of a
+* min-heap keyed on nextThink, and everything that needs to run this frame
+* goes through a second heap keyed on entity number so they still run in the
+* same order as a plain walk over the edicts would.
+*
+* think heap entries are not removed when nextThink changes, they get
+* checked against nextThink when they come out instead.
+*/
+
+struct ThinkEvent {
+	int64_t time;
+	int entNum;
+};
+
+static constexpr size_t MAX_THINK_EVENTS = MAX_EDICTS * 2;
+
+static ThinkEvent think_heap[MAX_THINK_EVENTS];
+static size_t think_heap_size;
+static int64_t think_heap_times[MAX_EDICTS]; // nextThink with an entry in the heap, 0 if none
+
+static int physics_ents[MAX_EDICTS];
+static int physics_slots[MAX_EDICTS]; // index into physics_ents + 1, 0 if absent
+static int num_physics_ents;
+
+static int run_heap[MAX_EDICTS];
+static int run_heap_size;
+static int64_t run_queued_frame[MAX_EDICTS];
+static int64_t run_frame;
+static bool running_entities;
+static int run_cursor;
+
+static bool ThinkEventLess( ThinkEvent a, ThinkEvent b ) {
+	return a.time < b.time || ( a.time == b.time && a.entNum < b.entNum );
+}
+
+static bool ThinkEventValid( ThinkEvent e ) {
+	const edict_t * ent = &game.edicts[e.entNum];
+	return ent->r.inuse && ent->nextThink == e.time;
+}
+
+/*
+* G_CompactThinkHeap
+* drop entries that no longer match their entity's nextThink
+*/
+static void G_CompactThinkHeap() {
+	size_t n = 0;
+	for( size_t i = 0; i < think_heap_size; i++ ) {
+		ThinkEvent e = think_heap[i];
+		if( ThinkEventValid( e ) ) {
+			think_heap[n] = e;
+			n++;
+		}
+		else if( think_heap_times[e.entNum] == e.time ) {
+			think_heap_times[e.entNum] = 0;
+		}
+	}
+
+	think_heap_size = n;
+	for( size_t i = n / 2; i-- > 0; ) {
+		HeapSiftDown( think_heap, think_heap_size, i, ThinkEventLess );
+	}
+}
+
+static void G_PushThink( edict_t *ent ) {
+	int entNum = ENTNUM( ent );
+	if( think_heap_times[entNum] == ent->nextThink ) {
+		return;
+	}
+
+	if( think_heap_size == MAX_THINK_EVENTS ) {
+		G_CompactThinkHeap();
+		if( think_heap_size == MAX_THINK_EVENTS ) {
+			Com_Error( ERR_DROP, "G_PushThink: think heap overflow" );
+		}
+	}
+
+	think_heap_times[entNum] = ent->nextThink;
+	think_heap[think_heap_size] = { ent->nextThink, entNum };
+	think_heap_size++;
+	HeapSiftUp( think_heap, think_heap_size - 1, ThinkEventLess );
+}
+
+static ThinkEvent G_PopThink() {
+	ThinkEvent top = think_heap[0];
+	think_heap_size--;
+	think_heap[0] = think_heap[think_heap_size];
+	HeapSiftDown( think_heap, think_heap_size, 0, ThinkEventLess );
+
+	if( think_heap_times[top.entNum] == top.time ) {
+		think_heap_times[top.entNum] = 0;
+	}
+
+	return top;
+}
+
+static bool EntNumLess( int a, int b ) {
+	return a < b;
+}
+
+/*
+* G_QueueRun
+* entities behind the cursor already had their turn this frame, like they
+* would in a plain walk over the edicts
+*/
+static void G_QueueRun( int entNum ) {
+	if( !running_entities || entNum <= run_cursor || run_queued_frame[entNum] == run_frame ) {
+		return;
+	}
+
+	run_queued_frame[entNum] = run_frame;
+	run_heap[run_heap_size] = entNum;
+	run_heap_size++;
+	HeapSiftUp( run_heap, run_heap_size - 1, EntNumLess );
+}
+
+static bool MovetypeNeedsPhysics( int movetype ) {
+	return movetype != MOVETYPE_NONE && movetype != MOVETYPE_PLAYER && movetype != MOVETYPE_NOCLIP;
+}
+
+static void G_UpdatePhysicsList( edict_t *ent ) {
+	int entNum = ENTNUM( ent );
+	bool listed = physics_slots[entNum] != 0;
+	bool needs_physics = ent->r.inuse && MovetypeNeedsPhysics( ent->movetype );
+
+	if( needs_physics && !listed ) {
+		physics_ents[num_physics_ents] = entNum;
+		num_physics_ents++;
+		physics_slots[entNum] = num_physics_ents;
+		G_QueueRun( entNum );
+	}
+	else if( !needs_physics && listed ) {
+		int slot = physics_slots[entNum] - 1;
+		num_physics_ents--;
+		physics_ents[slot] = physics_ents[num_physics_ents];
+		physics_slots[physics_ents[slot]] = slot + 1;
+		physics_slots[entNum] = 0;
+	}
+}
+
+void G_SetNextThink( edict_t *ent, int64_t time ) {
+	ent->nextThink = time;
+	if( time <= 0 ) {
+		return;
+	}
+
+	G_PushThink( ent );
+	if( time <= level.time ) {
+		G_QueueRun( ENTNUM( ent ) );
+	}
+}
+
+void G_SetMovetype( edict_t *ent, int movetype ) {
+	ent->movetype = movetype;
+	G_UpdatePhysicsList( ent );
+}
+
+/*
+* G_UnscheduleEntity
+* called when an edict gets freed
+*/
+void G_UnscheduleEntity( edict_t *ent ) {
+	G_UpdatePhysicsList( ent );
+}
+
+void G_ResetEntitySchedule() {
+	think_heap_size = 0;
+	memset( think_heap_times, 0, sizeof( think_heap_times ) );
+	num_physics_ents = 0;
+	memset( physics_slots, 0, sizeof( physics_slots ) );
+	run_heap_size = 0;
+}
+
+/*
+* G_RunEntities
+*/
+void G_RunEntities() {
+	ZoneScoped;
+
+	run_frame++;
+	running_entities = true;
+	run_cursor = -1;
+
+	while( think_heap_size > 0 && think_heap[0].time <= level.time ) {
+		ThinkEvent e = G_PopThink();
+		if( ThinkEventValid( e ) ) {
+			G_QueueRun( e.entNum );
+		}
+	}
+
+	for( int i = 0; i < num_physics_ents; i++ ) {
+		G_QueueRun( physics_ents[i] );
+	}
+
+	TracyPlot( "Entities run", s64( run_heap_size ) );
+
+	while( run_heap_size > 0 ) {
+		int entNum = run_heap[0];
+		run_heap_size--;
+		run_heap[0] = run_heap[run_heap_size];
+		HeapSiftDown( run_heap, run_heap_size, 0, EntNumLess );
+
+		run_cursor = entNum;
+
+		edict_t * ent = &game.edicts[entNum];
+		if( !ent->r.inuse ) {
+			continue;
+		}
+		if( ISEVENTENTITY( &ent->s ) ) {
+			continue; // events do not think
+		}
+		level.current_entity = ent;
+
+		// backup oldstate ( for world frame ).
+		ent->olds = ent->s;
+
+		// if the ground entity moved, make sure we are still on it
+		if( !ent->r.client ) {
+			if( ( ent->groundentity ) && ( ent->groundentity->linkcount != ent->groundentity_linkcount ) ) {
+				G_CheckGround( ent );
+			}
+		}
+
+		G_RunEntity( ent );
+
+		// the think didn't run, try again next frame
+		if( ent->r.inuse && ent->nextThink > 0 && ent->nextThink <= level.time ) {
+			G_PushThink( ent );
+		}
+	}
+
+	running_entities = false;
+}
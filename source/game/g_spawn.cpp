@@ -250,6 +250,8 @@ static void G_FreeEntities() {
 	}
 
 	game.numentities = server_gs.maxclients + 1;
+	G_ResetFreeEdicts();
+	G_ResetEntitySchedule();
 }
 
 static void SpawnMapEntities() {
@@ -291,6 +293,8 @@ static void SpawnMapEntities() {
 
 	// make sure server got the edicts data
 	SV_LocateEntities( game.edicts, game.numentities, game.maxentities );
+
+	Nav_BuildForLevel();
 }
 
 /*
@@ -428,7 +432,7 @@ void G_Aasdf() {
 }
 
 static void SP_worldspawn( edict_t *ent ) {
-	ent->movetype = MOVETYPE_PUSH;
+	G_SetMovetype( ent, MOVETYPE_PUSH );
 	ent->r.solid = SOLID_YES;
 	ent->r.inuse = true;       // since the world doesn't use G_Spawn()
 	ent->s.origin = Vec3( 0.0f );
@@ -326,6 +326,153 @@ static void Cmd_WriteIP_f() {
 	SV_WriteIPList();
 }
 
+/*
+* Cmd_AntilagBenchmark_f
+* every player fires shotgun blasts at every other player through the lag
+* compensated trace path
+*/
+static void Cmd_AntilagBenchmark_f() {
+	constexpr int blasts = 100;
+	constexpr int pellets = 20;
+	constexpr float spread = 0.05f;
+	constexpr int timeDelta = -100;
+
+	edict_t * players[ MAX_CLIENTS ];
+	int num_players = 0;
+	for( int i = 0; i < server_gs.maxclients; i++ ) {
+		edict_t * ent = PLAYERENT( i );
+		if( ent->r.inuse && ent->r.client != NULL && ent->s.team != TEAM_SPECTATOR && !G_IsDead( ent ) ) {
+			players[ num_players ] = ent;
+			num_players++;
+		}
+	}
+
+	if( num_players < 2 ) {
+		Com_Printf( "Need at least two live players to run the antilag benchmark\n" );
+		return;
+	}
+
+	RNG rng = NewRNG( 0, 0 );
+	int traces = 0;
+	int hits = 0;
+
+	s64 start = Sys_Microseconds();
+	for( int i = 0; i < blasts; i++ ) {
+		for( int j = 0; j < num_players; j++ ) {
+			edict_t * shooter = players[ j ];
+			edict_t * target = players[ ( j + 1 + i % ( num_players - 1 ) ) % num_players ];
+
+			Vec3 eye = shooter->s.origin + Vec3( 0.0f, 0.0f, shooter->viewheight );
+			Vec3 dir = Normalize( target->s.origin - eye );
+
+			for( int k = 0; k < pellets; k++ ) {
+				Vec3 jitter = Vec3( RandomFloat11( &rng ), RandomFloat11( &rng ), RandomFloat11( &rng ) ) * spread;
+				Vec3 end = eye + Normalize( dir + jitter ) * 8192.0f;
+
+				trace_t trace;
+				G_Trace4D( &trace, eye, Vec3( 0.0f ), Vec3( 0.0f ), end, shooter, MASK_SHOT, timeDelta );
+				traces++;
+				if( trace.ent > 0 && trace.ent <= server_gs.maxclients ) {
+					hits++;
+				}
+			}
+		}
+	}
+	s64 dt = Sys_Microseconds() - start;
+
+	Com_Printf( "%d players, %d traces (%d hit players): %.3fus per trace\n", num_players, traces, hits, double( dt ) / traces );
+}
+
+/*
+* Cmd_TraceBenchmark_f
+* fires shotgun blasts from every player at every other player, one pellet
+* at a time and batched, and checks both give the same results
+*/
+static void Cmd_TraceBenchmark_f() {
+	constexpr int blasts = 100;
+	constexpr int timeDelta = -100;
+
+	const WeaponDef * def = GS_GetWeaponDef( Weapon_Shotgun );
+	int pellets = def->projectile_count;
+
+	edict_t * players[ MAX_CLIENTS ];
+	int num_players = 0;
+	for( int i = 0; i < server_gs.maxclients; i++ ) {
+		edict_t * ent = PLAYERENT( i );
+		if( ent->r.inuse && ent->r.client != NULL && ent->s.team != TEAM_SPECTATOR && !G_IsDead( ent ) ) {
+			players[ num_players ] = ent;
+			num_players++;
+		}
+	}
+
+	if( num_players < 2 ) {
+		Com_Printf( "Need at least two live players to run the trace benchmark\n" );
+		return;
+	}
+
+	int shots = blasts * num_players;
+	Vec3 * starts = ALLOC_MANY( sys_allocator, Vec3, shots * pellets );
+	Vec3 * ends = ALLOC_MANY( sys_allocator, Vec3, shots * pellets );
+	edict_t ** shooters = ALLOC_MANY( sys_allocator, edict_t *, shots );
+	trace_t * single = ALLOC_MANY( sys_allocator, trace_t, shots * pellets );
+	trace_t * batched = ALLOC_MANY( sys_allocator, trace_t, shots * pellets );
+	defer {
+		FREE( sys_allocator, starts );
+		FREE( sys_allocator, ends );
+		FREE( sys_allocator, shooters );
+		FREE( sys_allocator, single );
+		FREE( sys_allocator, batched );
+	};
+
+	RNG rng = NewRNG( 0, 0 );
+	for( int i = 0; i < shots; i++ ) {
+		edict_t * shooter = players[ i % num_players ];
+		edict_t * target = players[ ( i + 1 + RandomUniform( &rng, 0, num_players - 1 ) ) % num_players ];
+		shooters[ i ] = shooter;
+
+		Vec3 eye = shooter->s.origin + Vec3( 0.0f, 0.0f, shooter->viewheight );
+		Vec3 dir = Normalize( target->s.origin - eye );
+		Vec3 right, up;
+		ViewVectors( dir, &right, &up );
+
+		for( int j = 0; j < pellets; j++ ) {
+			Vec2 spread = FixedSpreadPattern( j, def->spread );
+			starts[ i * pellets + j ] = eye;
+			ends[ i * pellets + j ] = eye + dir * def->range + right * spread.x + up * spread.y;
+		}
+	}
+
+	s64 single_start = Sys_Microseconds();
+	for( int i = 0; i < shots * pellets; i++ ) {
+		G_Trace4D( &single[ i ], starts[ i ], Vec3( 0.0f ), Vec3( 0.0f ), ends[ i ], shooters[ i / pellets ], MASK_WALLBANG, timeDelta );
+	}
+	s64 single_time = Sys_Microseconds() - single_start;
+
+	s64 batched_start = Sys_Microseconds();
+	for( int i = 0; i < shots; i++ ) {
+		G_TraceBatch4D( &batched[ i * pellets ], &starts[ i * pellets ], &ends[ i * pellets ], pellets, Vec3( 0.0f ), Vec3( 0.0f ), shooters[ i ], MASK_WALLBANG, timeDelta );
+	}
+	s64 batched_time = Sys_Microseconds() - batched_start;
+
+	int mismatches = 0;
+	for( int i = 0; i < shots * pellets; i++ ) {
+		const trace_t & a = single[ i ];
+		const trace_t & b = batched[ i ];
+		bool same = a.fraction == b.fraction && a.endpos == b.endpos && a.ent == b.ent
+			&& a.startsolid == b.startsolid && a.allsolid == b.allsolid && a.contents == b.contents;
+		if( a.fraction < 1.0f ) {
+			same = same && a.plane.normal == b.plane.normal && a.plane.dist == b.plane.dist && a.surfFlags == b.surfFlags;
+		}
+		if( !same ) {
+			mismatches++;
+		}
+	}
+
+	Com_Printf( "%d players, %d shots of %d pellets, %d mismatches\n", num_players, shots, pellets, mismatches );
+	Com_Printf( "Per pellet: %.2f shots/ms\n", shots / Max2( 0.001, single_time / 1000.0 ) );
+	Com_Printf( "Batched:    %.2f shots/ms\n", shots / Max2( 0.001, batched_time / 1000.0 ) );
+}
+
 /*
 * G_AddCommands
 */
@@ -343,6 +490,10 @@ void G_AddServerCommands() {
 	Cmd_AddCommand( "removeip", Cmd_RemoveIP_f );
 	Cmd_AddCommand( "listip", Cmd_ListIP_f );
 	Cmd_AddCommand( "writeip", Cmd_WriteIP_f );
+
+	Cmd_AddCommand( "antilagbenchmark", Cmd_AntilagBenchmark_f );
+	Cmd_AddCommand( "relinkstats", GClip_PrintRelinkStats );
+	Cmd_AddCommand( "tracebenchmark", Cmd_TraceBenchmark_f );
 }
 
 /*
@@ -362,4 +513,8 @@ void G_RemoveCommands() {
 	Cmd_RemoveCommand( "removeip" );
 	Cmd_RemoveCommand( "listip" );
 	Cmd_RemoveCommand( "writeip" );
+
+	Cmd_RemoveCommand( "antilagbenchmark" );
+	Cmd_RemoveCommand( "relinkstats" );
+	Cmd_RemoveCommand( "tracebenchmark" );
 }
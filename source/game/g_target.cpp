@@ -54,7 +54,7 @@ static void use_target_explosion( edict_t *self, edict_t *other, edict_t *activa
 	}
 
 	self->think = target_explosion_explode;
-	self->nextThink = level.time + self->delay * 1000;
+	G_SetNextThink( self, level.time + self->delay * 1000 );
 }
 
 void SP_target_explosion( edict_t *self ) {
@@ -148,7 +148,7 @@ static void target_laser_think( edict_t *self ) {
 
 	GClip_LinkEntity( self );
 
-	self->nextThink = level.time + 1;
+	G_SetNextThink( self, level.time + 1 );
 }
 
 static void target_laser_on( edict_t *self ) {
@@ -164,7 +164,7 @@ static void target_laser_on( edict_t *self ) {
 static void target_laser_off( edict_t *self ) {
 	self->spawnflags &= ~1;
 	self->r.svflags |= SVF_NOCLIENT;
-	self->nextThink = 0;
+	G_SetNextThink( self, 0 );
 }
 
 static void target_laser_use( edict_t *self, edict_t *other, edict_t *activator ) {
@@ -177,7 +177,7 @@ static void target_laser_use( edict_t *self, edict_t *other, edict_t *activator
 }
 
 void target_laser_start( edict_t *self ) {
-	self->movetype = MOVETYPE_NONE;
+	G_SetMovetype( self, MOVETYPE_NONE );
 	self->r.solid = SOLID_NOT;
 	self->s.type = ET_LASER;
 	self->r.svflags = 0;
@@ -214,7 +214,7 @@ void target_laser_start( edict_t *self ) {
 void SP_target_laser( edict_t *self ) {
 	// let everything else get spawned before we start firing
 	self->think = target_laser_start;
-	self->nextThink = level.time + 1;
+	G_SetNextThink( self, level.time + 1 );
 	self->count = MeanOfDeath_Laser;
 }
 
@@ -269,7 +269,7 @@ static void target_delay_think( edict_t *ent ) {
 }
 
 static void target_delay_use( edict_t *ent, edict_t *other, edict_t *activator ) {
-	ent->nextThink = level.time + 1000 * ( ent->wait + ent->random * RandomFloat11( &svs.rng ) );
+	G_SetNextThink( ent, level.time + 1000 * ( ent->wait + ent->random * RandomFloat11( &svs.rng ) ) );
 	ent->think = target_delay_think;
 	ent->activator = activator;
 }
@@ -38,7 +38,7 @@ static bool G_TriggerWait( edict_t *ent, edict_t *other ) {
 
 static void InitTrigger( edict_t *self ) {
 	self->r.solid = SOLID_TRIGGER;
-	self->movetype = MOVETYPE_NONE;
+	G_SetMovetype( self, MOVETYPE_NONE );
 	GClip_SetBrushModel( self );
 	self->r.svflags = SVF_NOCLIENT;
 }
@@ -57,7 +57,7 @@ static void multi_trigger( edict_t *ent ) {
 		// we can't just remove (self) here, because this is a touch function
 		// called while looping through area links...
 		ent->touch = NULL;
-		ent->nextThink = level.time + 1;
+		G_SetNextThink( ent, level.time + 1 );
 		ent->think = G_FreeEdict;
 	}
 }
@@ -109,7 +109,7 @@ void SP_trigger_multiple( edict_t *ent ) {
 	}
 
 	ent->touch = Touch_Multi;
-	ent->movetype = MOVETYPE_NONE;
+	G_SetMovetype( ent, MOVETYPE_NONE );
 	ent->r.svflags |= SVF_NOCLIENT;
 
 	if( ent->spawnflags & 4 ) {
@@ -146,7 +146,7 @@ void SP_trigger_always( edict_t *ent ) {
 	}
 
 	ent->think = trigger_always_think;
-	ent->nextThink = level.time + 1000 * ent->delay;
+	G_SetNextThink( ent, level.time + 1000 * ent->delay );
 }
 
 //==============================================================================
@@ -232,7 +232,7 @@ void SP_trigger_push( edict_t *self ) {
 
 	self->touch = trigger_push_touch;
 	self->think = trigger_push_setup;
-	self->nextThink = level.time + 1;
+	G_SetNextThink( self, level.time + 1 );
 	self->r.svflags &= ~SVF_NOCLIENT;
 	self->s.type = ( self->spawnflags & 1 ) ? ET_PAINKILLER_JUMPPAD : ET_JUMPPAD;
 	GClip_LinkEntity( self );
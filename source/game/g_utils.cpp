@@ -93,7 +93,7 @@ void G_UseTargets( edict_t *ent, edict_t *activator ) {
 		// create a temp object to fire at a later time
 		t = G_Spawn();
 		t->classname = "delayed_use";
-		t->nextThink = level.time + 1000 * ent->delay;
+		G_SetNextThink( t, level.time + 1000 * ent->delay );
 		t->think = Think_Delay;
 		t->activator = activator;
 		if( !activator ) {
@@ -162,8 +162,53 @@ char *_G_CopyString( const char *in, const char *filename, int fileline ) {
 	return out;
 }
 
+/*
+* free edict lists
+*
+* edicts freed without a reuse delay go on a stack, everything else goes on
+* a queue in the order it was freed. freetime only ever grows so the head of
+* the queue is always the edict that becomes reusable first, and G_Spawn
+* never has to walk the edicts looking for a slot.
+*/
+static int free_edicts_now[MAX_EDICTS];
+static int num_free_edicts_now;
+
+static int free_edicts_timed[MAX_EDICTS];
+static int free_edicts_timed_head;
+static int num_free_edicts_timed;
+
+void G_ResetFreeEdicts() {
+	num_free_edicts_now = 0;
+	free_edicts_timed_head = 0;
+	num_free_edicts_timed = 0;
+}
+
+static void G_PushFreeEdict( edict_t *ed ) {
+	int entNum = ENTNUM( ed );
+	if( ed->freetime == 0 ) {
+		if( num_free_edicts_now < MAX_EDICTS ) {
+			free_edicts_now[num_free_edicts_now] = entNum;
+			num_free_edicts_now++;
+		}
+		return;
+	}
+
+	if( num_free_edicts_timed < MAX_EDICTS ) {
+		free_edicts_timed[( free_edicts_timed_head + num_free_edicts_timed ) % MAX_EDICTS] = entNum;
+		num_free_edicts_timed++;
+	}
+}
+
+static edict_t *G_PopFreeEdictTimed() {
+	edict_t * e = &game.edicts[free_edicts_timed[free_edicts_timed_head]];
+	free_edicts_timed_head = ( free_edicts_timed_head + 1 ) % MAX_EDICTS;
+	num_free_edicts_timed--;
+	return e;
+}
+
 void G_FreeEdict( edict_t *ed ) {
 	bool evt = ISEVENTENTITY( &ed->s );
+	bool was_inuse = ed->r.inuse;
 
 	GClip_UnlinkEntity( ed );   // unlink from world
 
@@ -173,9 +218,15 @@ void G_FreeEdict( edict_t *ed ) {
 	ed->s.number = ENTNUM( ed );
 	ed->r.svflags = SVF_NOCLIENT;
 
+	G_UnscheduleEntity( ed );
+
 	if( !evt && ( level.spawnedTimeStamp != svs.realtime ) ) {
 		ed->freetime = svs.realtime; // ET_EVENT or ET_SOUND don't need to wait to be reused
 	}
+
+	if( was_inuse && ENTNUM( ed ) > server_gs.maxclients && ENTNUM( ed ) < game.numentities ) {
+		G_PushFreeEdict( ed );
+	}
 }
 
 void G_InitEdict( edict_t *e ) {
@@ -200,7 +251,7 @@ void G_InitEdict( edict_t *e ) {
 /*
 * G_Spawn
 *
-* Either finds a free edict, or allocates a new one.
+* Either takes an edict off the free lists, or allocates a new one.
 * Try to avoid reusing an entity that was recently freed, because it
 * can cause the client to think the entity morphed into something else
 * instead of being removed and recreated, which can cause interpolated
@@ -211,36 +262,43 @@ edict_t *G_Spawn() {
 		Com_Printf( "WARNING: Spawning entity before map entities have been spawned\n" );
 	}
 
-	int i;
-	edict_t * freed = NULL;
-	edict_t * e = &game.edicts[server_gs.maxclients + 1];
-	for( i = server_gs.maxclients + 1; i < game.numentities; i++, e++ ) {
-		if( e->r.inuse ) {
-			continue;
-		}
-
-		// the first couple seconds of server time can involve a lot of
-		// freeing and allocating, so relax the replacement policy
-		if( e->freetime < level.spawnedTimeStamp + 2000 || svs.realtime > e->freetime + 500 ) {
+	// entries can go stale if something other than G_Spawn brought the edict back
+	while( num_free_edicts_now > 0 ) {
+		num_free_edicts_now--;
+		edict_t * e = &game.edicts[free_edicts_now[num_free_edicts_now]];
+		if( !e->r.inuse ) {
 			G_InitEdict( e );
 			return e;
 		}
+	}
 
-		// this is going to be our second chance to spawn an entity in case all free
-		// entities have been freed only recently
-		if( !freed ) {
-			freed = e;
+	while( num_free_edicts_timed > 0 && game.edicts[free_edicts_timed[free_edicts_timed_head]].r.inuse ) {
+		G_PopFreeEdictTimed();
+	}
+
+	// the first couple seconds of server time can involve a lot of
+	// freeing and allocating, so relax the replacement policy
+	if( num_free_edicts_timed > 0 ) {
+		const edict_t * e = &game.edicts[free_edicts_timed[free_edicts_timed_head]];
+		if( e->freetime < level.spawnedTimeStamp + 2000 || svs.realtime > e->freetime + 500 ) {
+			edict_t * freed = G_PopFreeEdictTimed();
+			G_InitEdict( freed );
+			return freed;
 		}
 	}
 
-	if( i == game.maxentities ) {
-		if( freed ) {
+	if( game.numentities == game.maxentities ) {
+		// this is going to be our second chance to spawn an entity in case all free
+		// entities have been freed only recently
+		if( num_free_edicts_timed > 0 ) {
+			edict_t * freed = G_PopFreeEdictTimed();
 			G_InitEdict( freed );
 			return freed;
 		}
 		Com_Error( ERR_DROP, "G_Spawn: no free edicts" );
 	}
 
+	edict_t * e = &game.edicts[game.numentities];
 	game.numentities++;
 
 	SV_LocateEntities( game.edicts, game.numentities, game.maxentities );
@@ -299,7 +357,7 @@ void G_MorphEntityIntoEvent( edict_t *ent, int event, u64 parm ) {
 
 void G_InitMover( edict_t *ent ) {
 	ent->r.solid = SOLID_YES;
-	ent->movetype = MOVETYPE_PUSH;
+	G_SetMovetype( ent, MOVETYPE_PUSH );
 	ent->r.svflags &= ~SVF_NOCLIENT;
 
 	GClip_SetBrushModel( ent );
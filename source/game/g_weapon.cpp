@@ -122,7 +122,7 @@ static void W_Think_ARBullet(edict_t *ent)
 
 	if (ent->r.inuse)
 	{
-		ent->nextThink = level.time + 1;
+		G_SetNextThink( ent, level.time + 1 );
 	}
 
 	Vec3 start = ent->s.origin - ent->velocity * game.frametime * 0.001f;
@@ -207,7 +207,7 @@ static edict_t *FireProjectile(
 
 	projectile->velocity = dir * def->speed;
 
-	projectile->movetype = MOVETYPE_LINEARPROJECTILE;
+	G_SetMovetype( projectile, MOVETYPE_LINEARPROJECTILE );
 
 	projectile->r.solid = SOLID_YES;
 	projectile->r.clipmask = clipmask;
@@ -218,7 +218,7 @@ static edict_t *FireProjectile(
 
 	projectile->r.owner = owner;
 	projectile->touch = touch;
-	projectile->nextThink = level.time + def->range;
+	G_SetNextThink( projectile, level.time + def->range );
 	projectile->think = G_FreeEdict;
 	projectile->timeout = level.time + def->range;
 	projectile->timeStamp = level.time;
@@ -246,7 +246,7 @@ static edict_t *FireLinearProjectile(
 {
 	edict_t *projectile = FireProjectile(owner, start, angles, timeDelta, weapon, touch, ent_type, clipmask);
 
-	projectile->movetype = MOVETYPE_LINEARPROJECTILE;
+	G_SetMovetype( projectile, MOVETYPE_LINEARPROJECTILE );
 	projectile->s.linearMovement = true;
 	projectile->s.linearMovementBegin = projectile->s.origin;
 	projectile->s.linearMovementVelocity = projectile->velocity;
@@ -328,15 +328,52 @@ static void W_Fire_Shotgun(edict_t *self, Vec3 start, Vec3 angles, int timeDelta
 	Vec3 dir, right, up;
 	AngleVectors(angles, &dir, &right, &up);
 
-	float damage_dealt[MAX_CLIENTS + 1] = {};
-	for (int i = 0; i < def->projectile_count; i++)
+	// trace every pellet up front the same way GS_TraceBullet does
+	TempAllocator temp = svs.frame_arena.temp();
+	int pellets = def->projectile_count;
+	int range = def->range;
+	Vec3 *starts = ALLOC_MANY(&temp, Vec3, pellets);
+	Vec3 *ends = ALLOC_MANY(&temp, Vec3, pellets);
+	trace_t *traces = ALLOC_MANY(&temp, trace_t, pellets);
+	trace_t *wallbangs = ALLOC_MANY(&temp, trace_t, pellets);
+
+	for (int i = 0; i < pellets; i++)
 	{
 		Vec2 spread = FixedSpreadPattern(i, def->spread);
+		starts[i] = start;
+		ends[i] = start + dir * range + right * spread.x + up * spread.y;
+	}
+
+	G_TraceBatch4D(traces, starts, ends, pellets, Vec3(0.0f), Vec3(0.0f), self, MASK_WALLBANG, timeDelta);
+
+	for (int i = 0; i < pellets; i++)
+	{
+		ends[i] = traces[i].endpos;
+	}
+
+	G_TraceBatch4D(wallbangs, starts, ends, pellets, Vec3(0.0f), Vec3(0.0f), self, MASK_SHOT, timeDelta);
+
+	// once a pellet kills something the rest of the batch might go through
+	// it, so trace those one at a time again
+	bool stale = false;
+
+	float damage_dealt[MAX_CLIENTS + 1] = {};
+	for (int i = 0; i < pellets; i++)
+	{
+		trace_t trace = traces[i];
+		trace_t wallbang = wallbangs[i];
+		if (stale)
+		{
+			Vec2 spread = FixedSpreadPattern(i, def->spread);
+			GS_TraceBullet(&server_gs, &trace, &wallbang, start, dir, right, up, spread, range, ENTNUM(self), timeDelta);
+		}
 
-		trace_t trace, wallbang;
-		GS_TraceBullet(&server_gs, &trace, &wallbang, start, dir, right, up, spread, def->range, ENTNUM(self), timeDelta);
 		if (trace.ent != -1 && game.edicts[trace.ent].takedamage)
 		{
+			edict_t *target = &game.edicts[trace.ent];
+			solid_t solid = target->r.solid;
+			bool dead = G_IsDead(target);
+
 			int dmgflags = trace.endpos == wallbang.endpos ? 0 : DAMAGE_WALLBANG;
 			float damage = def->damage;
 
@@ -346,7 +383,12 @@ static void W_Fire_Shotgun(edict_t *self, Vec3 start, Vec3 angles, int timeDelta
 				damage *= def->wallbangdamage;
 			}
 
-			G_Damage(&game.edicts[trace.ent], self, self, dir, dir, trace.endpos, damage, def->knockback, dmgflags, Weapon_Shotgun);
+			G_Damage(target, self, self, dir, dir, trace.endpos, damage, def->knockback, dmgflags, Weapon_Shotgun);
+
+			if (!target->r.inuse || target->r.solid != solid || G_IsDead(target) != dead)
+			{
+				stale = true;
+			}
 
 			if (!G_IsTeamDamage(&game.edicts[trace.ent].s, &self->s) && trace.ent <= MAX_CLIENTS)
 			{
@@ -421,7 +463,7 @@ static void W_Fire_Grenade(edict_t *self, Vec3 start, Vec3 angles, int timeDelta
 	edict_t *grenade = FireProjectile(self, start, angles, timeDelta, Weapon_GrenadeLauncher, W_Touch_Grenade, ET_GRENADE, MASK_SHOT);
 
 	grenade->classname = "grenade";
-	grenade->movetype = MOVETYPE_BOUNCEGRENADE;
+	G_SetMovetype( grenade, MOVETYPE_BOUNCEGRENADE );
 	grenade->s.model = "weapons/gl/grenade";
 	// grenade->s.sound = "weapons/gl/trail";
 
@@ -454,7 +496,7 @@ static void W_Touch_Stake(edict_t *ent, edict_t *other, cplane_t *plane, int sur
 		ent->s.type = ET_GENERIC;
 		// ent->think = G_FreeEdict;
 		// ent->nextThink = level.time + def->range;
-		ent->movetype = MOVETYPE_NONE;
+		G_SetMovetype( ent, MOVETYPE_NONE );
 		ent->s.sound = "";
 		edict_t *event = G_SpawnEvent(EV_STAKE_IMPACT, DirToU64(-SafeNormalize(ent->velocity)), &ent->s.origin);
 		event->s.team = ent->s.team;
@@ -466,7 +508,7 @@ static void W_Fire_Stake(edict_t *self, Vec3 start, Vec3 angles, int timeDelta)
 	edict_t *stake = FireProjectile(self, start, angles, timeDelta, Weapon_StakeGun, W_Touch_Stake, ET_STAKE, MASK_SHOT);
 
 	stake->classname = "stake";
-	stake->movetype = MOVETYPE_BOUNCEGRENADE;
+	G_SetMovetype( stake, MOVETYPE_BOUNCEGRENADE );
 	stake->s.model = "weapons/stake/stake";
 	stake->s.sound = "weapons/stake/trail";
 }
@@ -518,7 +560,7 @@ static void W_Fire_ARBullet(edict_t *self, Vec3 start, Vec3 angles, int timeDelt
 	arbullet->s.sound = "weapons/ar/trail";
 
 	arbullet->think = W_Think_ARBullet;
-	arbullet->nextThink = level.time + 1;
+	G_SetNextThink( arbullet, level.time + 1 );
 }
 
 static void FireBubble(edict_t *owner, Vec3 start, Vec3 angles, int timeDelta)
@@ -529,7 +571,7 @@ static void FireBubble(edict_t *owner, Vec3 start, Vec3 angles, int timeDelta)
 	bubble->s.sound = "weapons/bg/trail";
 
 	bubble->think = W_Think_ARBullet;
-	bubble->nextThink = level.time + 1;
+	G_SetNextThink( bubble, level.time + 1 );
 }
 
 void W_Fire_BubbleGun(edict_t *self, Vec3 start, Vec3 angles, int timeDelta)
@@ -647,7 +689,7 @@ static void G_Laser_Think(edict_t *ent)
 		return;
 	}
 
-	ent->nextThink = level.time + 1;
+	G_SetNextThink( ent, level.time + 1 );
 }
 
 struct LaserBeamTraceData
@@ -691,7 +733,7 @@ static edict_t *FindOrSpawnLaser(edict_t *owner)
 	edict_t *laser = G_Spawn();
 	laser->s.type = ET_LASERBEAM;
 	laser->s.ownerNum = ownerNum;
-	laser->movetype = MOVETYPE_NONE;
+	G_SetMovetype( laser, MOVETYPE_NONE );
 	laser->r.solid = SOLID_NOT;
 	laser->r.svflags &= ~SVF_NOCLIENT;
 	return laser;
@@ -719,7 +761,7 @@ static void W_Fire_Lasergun(edict_t *self, Vec3 start, Vec3 angles, int timeDelt
 	laser->s.origin2 = laser->s.origin + dir * def->range;
 
 	laser->think = G_Laser_Think;
-	laser->nextThink = level.time + 1;
+	G_SetNextThink( laser, level.time + 1 );
 
 	// calculate laser's mins and maxs for linkEntity
 	G_SetBoundsForSpanEntity(laser, 8);
@@ -811,7 +853,7 @@ void W_Fire_Blast(edict_t *self, Vec3 start, Vec3 angles, int timeDelta)
 		edict_t *blast = FireProjectile(self, start, blast_angles, timeDelta, Weapon_MasterBlaster, W_Touch_Blast, ET_BLAST, MASK_SHOT);
 
 		blast->classname = "blast";
-		blast->movetype = MOVETYPE_BOUNCEGRENADE;
+		G_SetMovetype( blast, MOVETYPE_BOUNCEGRENADE );
 		blast->stop = G_FreeEdict;
 		blast->s.sound = "weapons/mb/trail";
 	}
@@ -822,7 +864,7 @@ void W_Fire_Road(edict_t *self, Vec3 start, Vec3 angles, int timeDelta)
 	edict_t *bullet = FireProjectile(self, start, angles, timeDelta, Weapon_RoadGun, W_Touch_Blast, ET_BLAST, MASK_SHOT);
 
 	bullet->classname = "zorg";
-	bullet->movetype = MOVETYPE_BOUNCEGRENADE;
+	G_SetMovetype( bullet, MOVETYPE_BOUNCEGRENADE );
 	bullet->stop = G_FreeEdict;
 	bullet->s.sound = "weapons/road/trail";
 }
@@ -18,6 +18,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 
 #include "game/g_local.h"
+#include "qcommon/threadpool.h"
 
 constexpr int PLAYER_MASS = 200;
 
@@ -95,7 +96,7 @@ static edict_t *CreateCorpse( edict_t *ent, edict_t *attacker, int damage ) {
 
 	body->r.solid = SOLID_NOT;
 	body->takedamage = DAMAGE_NO;
-	body->movetype = MOVETYPE_TOSS;
+	G_SetMovetype( body, MOVETYPE_TOSS );
 
 	body->s.teleported = true;
 	body->s.ownerNum = ent->s.number;
@@ -108,7 +109,7 @@ static edict_t *CreateCorpse( edict_t *ent, edict_t *attacker, int damage ) {
 	if( gib ) {
 		ThrowSmallPileOfGibs( body, knockbackOfDeath, damage );
 
-		body->nextThink = level.time + 3000 + RandomFloat01( &svs.rng ) * 3000;
+		G_SetNextThink( body, level.time + 3000 + RandomFloat01( &svs.rng ) * 3000 );
 		body->deadflag = DEAD_DEAD;
 	}
 
@@ -126,7 +127,7 @@ static edict_t *CreateCorpse( edict_t *ent, edict_t *attacker, int damage ) {
 	// bit of a hack, if we're not in warmup, leave the body with no think. think self destructs
 	// after a timeout, but if we leave, next bomb round will call G_ResetLevel() cleaning up
 	if( server_gs.gameState.match_state != MATCH_STATE_PLAYTIME ) {
-		body->nextThink = level.time + 3500;
+		G_SetNextThink( body, level.time + 3500 );
 		body->think = G_FreeEdict; // body self destruction countdown
 	}
 
@@ -239,7 +240,7 @@ void G_ClientClearStats( edict_t * ent ) {
 }
 
 void G_GhostClient( edict_t *ent ) {
-	ent->movetype = MOVETYPE_NONE;
+	G_SetMovetype( ent, MOVETYPE_NONE );
 	ent->r.solid = SOLID_NOT;
 
 	memset( &ent->snap, 0, sizeof( ent->snap ) );
@@ -342,11 +343,11 @@ void G_ClientRespawn( edict_t *self, bool ghost ) {
 	if( ghost ) {
 		self->s.type = ET_GHOST;
 		self->r.solid = SOLID_NOT;
-		self->movetype = MOVETYPE_NOCLIP;
+		G_SetMovetype( self, MOVETYPE_NOCLIP );
 	} else {
 		self->s.type = ET_PLAYER;
 		self->r.solid = SOLID_YES;
-		self->movetype = MOVETYPE_PLAYER;
+		G_SetMovetype( self, MOVETYPE_PLAYER );
 		client->ps.pmove.features = PMFEAT_DEFAULT;
 	}
 
@@ -493,7 +494,7 @@ void ClientBegin( edict_t *ent ) {
 	} else {
 		G_ClientRespawn( ent, true ); // respawn as ghost
 	}
-	ent->movetype = MOVETYPE_NOCLIP; // allow freefly
+	G_SetMovetype( ent, MOVETYPE_NOCLIP ); // allow freefly
 
 	G_PrintMsg( NULL, "%s entered the game\n", client->netname );
 
@@ -805,7 +806,7 @@ void ClientDisconnect( edict_t *ent, const char *reason ) {
 
 	ent->r.client->team = TEAM_SPECTATOR;
 	G_ClientRespawn( ent, true ); // respawn as ghost
-	ent->movetype = MOVETYPE_NOCLIP; // allow freefly
+	G_SetMovetype( ent, MOVETYPE_NOCLIP ); // allow freefly
 
 	// let the gametype scripts know this client just disconnected
 	G_Gametype_ScoreEvent( ent->r.client, "disconnect", NULL );
@@ -858,19 +859,103 @@ void G_PredictedFireWeapon( int entNum, u64 parm ) {
 	event->s.team = ent->s.team;
 }
 
+struct ClientMoveQueue {
+	usercmd_t cmds[CMD_BACKUP];
+	int timeDeltas[CMD_BACKUP];
+	int numcmds;
+};
+
+struct ClientMove {
+	pmove_t pm;
+	SyncPlayerState before; // what the playerstate looked like when the move started
+	SyncPlayerState ps;     // the move works on this copy
+	MinMax3 swept;          // everything the move could have traced against
+	int solid_links_generation;
+	bool predicted;
+};
+
+// what traces can see of a client
+struct ClientClipState {
+	bool inuse;
+	solid_t solid;
+	int svflags;
+	int team;
+	Vec3 absmin, absmax;
+};
+
+static ClientMoveQueue client_move_queues[MAX_CLIENTS];
+static ClientMove client_moves[MAX_CLIENTS];
+
+// every client as G_PredictClientMoves saw them
+static ClientClipState predicted_clip_states[MAX_CLIENTS];
+
+/*
+* ClientThink
+* queue up a usercmd, G_RunClientMoves does the actual moving
+*/
 void ClientThink( edict_t *ent, usercmd_t *ucmd, int timeDelta ) {
-	ZoneScoped;
+	ClientMoveQueue *queue = &client_move_queues[PLAYERNUM( ent )];
+
+	// SV_ExecuteClientThinks can't hand out more than CMD_BACKUP usercmds a
+	// frame and bots only make one, so this means something is queueing
+	// usercmds that never get run
+	if( queue->numcmds == CMD_BACKUP ) {
+		Com_GGPrint( "Dropping usercmd for {}, their move queue is full", ent->r.client->netname );
+		return;
+	}
+
+	queue->cmds[queue->numcmds] = *ucmd;
+	queue->timeDeltas[queue->numcmds] = timeDelta;
+	queue->numcmds++;
+}
+
+/*
+* G_ClientRefreshPlayerState
+*/
+static void G_ClientRefreshPlayerState( const edict_t *ent, SyncPlayerState *ps ) {
+	ps->POVnum = ENTNUM( ent );
+	ps->playerNum = PLAYERNUM( ent );
+
+	// (is this really needed?:only if not cared enough about ps in the rest of the code)
+	// refresh player state position from the entity
+	ps->pmove.origin = ent->s.origin;
+	ps->pmove.velocity = ent->velocity;
+	ps->viewangles = ent->s.angles;
+
+	if( server_gs.gameState.match_state >= MATCH_STATE_POSTMATCH || GS_MatchPaused( &server_gs )
+		|| ( ent->movetype != MOVETYPE_PLAYER && ent->movetype != MOVETYPE_NOCLIP ) ) {
+		ps->pmove.pm_type = PM_FREEZE;
+	} else if( ent->movetype == MOVETYPE_NOCLIP ) {
+		ps->pmove.pm_type = PM_SPECTATOR;
+	} else {
+		ps->pmove.pm_type = PM_NORMAL;
+	}
+}
+
+/*
+* G_ClientSetupMove
+*/
+static void G_ClientSetupMove( const edict_t *ent, ClientMove *move, const usercmd_t *ucmd ) {
+	move->before = ent->r.client->ps;
+	G_ClientRefreshPlayerState( ent, &move->before );
+	move->ps = move->before;
+
+	// set up for pmove
+	memset( &move->pm, 0, sizeof( pmove_t ) );
+	move->pm.playerState = &move->ps;
+	move->pm.cmd = *ucmd;
+}
 
+/*
+* G_ClientBeginMove
+*/
+static void G_ClientBeginMove( edict_t *ent, const usercmd_t *ucmd, int timeDelta ) {
 	gclient_t *client;
-	int i, j;
-	static pmove_t pm;
+	int i;
 	int delta, count;
 
 	client = ent->r.client;
 
-	client->ps.POVnum = ENTNUM( ent );
-	client->ps.playerNum = PLAYERNUM( ent );
-
 	// anti-lag
 	if( ent->r.svflags & SVF_FAKECLIENT ) {
 		client->timeDelta = 0;
@@ -914,28 +999,83 @@ void ClientThink( edict_t *ent, usercmd_t *ucmd, int timeDelta ) {
 
 	client->ucmd = *ucmd;
 
-	// (is this really needed?:only if not cared enough about ps in the rest of the code)
-	// refresh player state position from the entity
-	client->ps.pmove.origin = ent->s.origin;
-	client->ps.pmove.velocity = ent->velocity;
-	client->ps.viewangles = ent->s.angles;
+	G_ClientRefreshPlayerState( ent, &client->ps );
+}
 
-	if( server_gs.gameState.match_state >= MATCH_STATE_POSTMATCH || GS_MatchPaused( &server_gs )
-		|| ( ent->movetype != MOVETYPE_PLAYER && ent->movetype != MOVETYPE_NOCLIP ) ) {
-		client->ps.pmove.pm_type = PM_FREEZE;
-	} else if( ent->movetype == MOVETYPE_NOCLIP ) {
-		client->ps.pmove.pm_type = PM_SPECTATOR;
-	} else {
-		client->ps.pmove.pm_type = PM_NORMAL;
+/*
+* G_GetClientClipState
+*/
+static ClientClipState G_GetClientClipState( const edict_t *ent ) {
+	ClientClipState state = { };
+	state.inuse = ent->r.inuse && ent->r.solid != SOLID_NOT;
+	if( state.inuse ) {
+		state.solid = ent->r.solid;
+		state.svflags = ent->r.svflags;
+		state.team = ent->s.team;
+		state.absmin = ent->r.absmin;
+		state.absmax = ent->r.absmax;
 	}
+	return state;
+}
 
-	// set up for pmove
-	memset( &pm, 0, sizeof( pmove_t ) );
-	pm.playerState = &client->ps;
-	pm.cmd = *ucmd;
+static bool G_SameClipState( const ClientClipState *a, const ClientClipState *b ) {
+	return a->inuse == b->inuse && a->solid == b->solid && a->svflags == b->svflags && a->team == b->team
+		&& a->absmin == b->absmin && a->absmax == b->absmax;
+}
+
+static bool G_ClipStateTouches( const ClientClipState *state, const MinMax3 *bounds ) {
+	return state->inuse && BoundsOverlap( state->absmin, state->absmax, bounds->mins, bounds->maxs );
+}
+
+/*
+* G_ClientMoveIsStale
+* a predicted move was made against the world as it was at the start of the
+* frame. clients that moved before us can have walked into where we went,
+* or pushed, hurt, killed or teleported us, and anything they did can have
+* made entities appear, disappear or move, in which case it has to be made again
+*/
+static bool G_ClientMoveIsStale( const edict_t *ent, const ClientMove *move ) {
+	if( memcmp( &ent->r.client->ps, &move->before, sizeof( move->before ) ) != 0 ) {
+		return true;
+	}
+
+	if( GClip_SolidLinksGeneration() != move->solid_links_generation ) {
+		return true;
+	}
+
+	for( int i = 0; i < server_gs.maxclients; i++ ) {
+		const edict_t *other = game.edicts + 1 + i;
+		if( other == ent ) {
+			continue;
+		}
+
+		const ClientClipState *then = &predicted_clip_states[i];
+		ClientClipState now = G_GetClientClipState( other );
+		if( G_SameClipState( &now, then ) ) {
+			continue;
+		}
+
+		if( G_ClipStateTouches( then, &move->swept ) || G_ClipStateTouches( &now, &move->swept ) ) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+* G_ClientEndMove
+* apply a move's results to the world
+*/
+static void G_ClientEndMove( edict_t *ent, ClientMove *move ) {
+	gclient_t *client = ent->r.client;
+	pmove_t *pm = &move->pm;
+	int i, j;
 
-	// perform a pmove
-	Pmove( &server_gs, &pm );
+	client->ps = move->ps;
+	pm->playerState = &client->ps;
+
+	PmoveFinish( pm );
 
 	// save results of pmove
 	client->old_pmove = client->ps.pmove;
@@ -945,15 +1085,15 @@ void ClientThink( edict_t *ent, usercmd_t *ucmd, int timeDelta ) {
 	ent->velocity = client->ps.pmove.velocity;
 	ent->s.angles = client->ps.viewangles;
 	ent->viewheight = client->ps.viewheight;
-	ent->r.mins = pm.mins;
-	ent->r.maxs = pm.maxs;
+	ent->r.mins = pm->mins;
+	ent->r.maxs = pm->maxs;
 
-	ent->waterlevel = pm.waterlevel;
-	ent->watertype = pm.watertype;
-	if( pm.groundentity == -1 ) {
+	ent->waterlevel = pm->waterlevel;
+	ent->watertype = pm->watertype;
+	if( pm->groundentity == -1 ) {
 		ent->groundentity = NULL;
 	} else {
-		ent->groundentity = &game.edicts[pm.groundentity];
+		ent->groundentity = &game.edicts[pm->groundentity];
 		ent->groundentity_linkcount = ent->groundentity->linkcount;
 	}
 
@@ -964,10 +1104,10 @@ void ClientThink( edict_t *ent, usercmd_t *ucmd, int timeDelta ) {
 		edict_t *other;
 
 		// touch other objects
-		for( i = 0; i < pm.numtouch; i++ ) {
-			other = &game.edicts[pm.touchents[i]];
+		for( i = 0; i < pm->numtouch; i++ ) {
+			other = &game.edicts[pm->touchents[i]];
 			for( j = 0; j < i; j++ ) {
-				if( &game.edicts[pm.touchents[j]] == other ) {
+				if( &game.edicts[pm->touchents[j]] == other ) {
 					break;
 				}
 			}
@@ -986,9 +1126,109 @@ void ClientThink( edict_t *ent, usercmd_t *ucmd, int timeDelta ) {
 		}
 	}
 
-	UpdateWeapons( &server_gs, &client->ps, ucmd, client->timeDelta );
+	UpdateWeapons( &server_gs, &client->ps, &pm->cmd, client->timeDelta );
+
+	client->resp.snap.buttons |= pm->cmd.buttons;
+}
+
+static void G_ClientMoveJob( TempAllocator * temp, void * data ) {
+	PmoveMove( &server_gs, &( *( ClientMove ** ) data )->pm );
+}
+
+/*
+* G_PredictClientMoves
+*
+* makes every client's first queued move at the same time, against the world
+* as it was at the start of the frame. G_RunClientMoves throws a prediction
+* away if it didn't turn out to be what the move would have done had it been
+* made in turn. later usercmds always start from where the previous one's
+* triggers and weapons left the client, so only the first can be predicted
+*/
+void G_PredictClientMoves() {
+	ZoneScoped;
+
+	bool parallel = g_parallel_pmove->integer != 0;
+	ClientMove *moves[MAX_CLIENTS];
+	int num_moves = 0;
+
+	for( int i = 0; i < server_gs.maxclients; i++ ) {
+		const ClientMoveQueue *queue = &client_move_queues[i];
+		const edict_t *ent = game.edicts + 1 + i;
+		ClientMove *move = &client_moves[i];
+
+		predicted_clip_states[i] = G_GetClientClipState( ent );
+
+		move->predicted = false;
+		if( !parallel || queue->numcmds == 0 || !ent->r.inuse || ent->r.client == NULL ) {
+			continue;
+		}
+
+		G_ClientSetupMove( ent, move, &queue->cmds[0] );
+		move->swept = MinMax3( ent->s.origin + ent->r.mins, ent->s.origin + ent->r.maxs );
+		move->solid_links_generation = GClip_SolidLinksGeneration();
+		moves[num_moves] = move;
+		num_moves++;
+	}
+
+	if( num_moves < 2 ) {
+		return;
+	}
+
+	ParallelFor( Span< ClientMove * >( moves, num_moves ), G_ClientMoveJob );
+
+	for( int i = 0; i < num_moves; i++ ) {
+		ClientMove *move = moves[i];
+		const pmove_t *pm = &move->pm;
+		Vec3 origin = move->ps.pmove.origin;
+
+		AddPointToBounds( origin + pm->mins, &move->swept.mins, &move->swept.maxs );
+		AddPointToBounds( origin + pm->maxs, &move->swept.mins, &move->swept.maxs );
+
+		// the traces can go further than where the move started and
+		// ended: sliding along walls, stepping and looking for walls to jump off
+		float speed = Max2( Length( move->before.pmove.velocity ), Length( move->ps.pmove.velocity ) );
+		float reach = speed * ( pm->cmd.msec * 0.001f + 0.015f ) + STEPSIZE + Max2( pm->maxs.x, pm->maxs.y );
+		move->swept.mins -= reach;
+		move->swept.maxs += reach;
+
+		move->predicted = true;
+	}
+}
+
+/*
+* G_RunClientMoves
+*
+* runs ent's queued usercmds, in the same order ClientThink got them. clients
+* have to be run one at a time in client order, the same as if every usercmd
+* was moved as soon as it was queued, so a move made by G_PredictClientMoves
+* is only used if it can't have been affected by the clients before us
+*/
+void G_RunClientMoves( edict_t *ent ) {
+	ZoneScoped;
+
+	ClientMoveQueue *queue = &client_move_queues[PLAYERNUM( ent )];
+	ClientMove *move = &client_moves[PLAYERNUM( ent )];
+
+	if( queue->numcmds == 0 ) {
+		return;
+	}
+
+	for( int i = 0; i < queue->numcmds; i++ ) {
+		if( !ent->r.inuse || ent->r.client == NULL ) {
+			break;
+		}
+
+		G_ClientBeginMove( ent, &queue->cmds[i], queue->timeDeltas[i] );
+
+		if( i > 0 || !move->predicted || G_ClientMoveIsStale( ent, move ) ) {
+			G_ClientSetupMove( ent, move, &queue->cmds[i] );
+			PmoveMove( &server_gs, &move->pm );
+		}
+
+		G_ClientEndMove( ent, move );
+	}
 
-	client->resp.snap.buttons |= ucmd->buttons;
+	queue->numcmds = 0;
 }
 
 /*
@@ -34,40 +34,6 @@ static constexpr s16 TBAG_AMOUNT_PER_CROUCH = 500;
 
 //===============================================================
 
-// all of the locals will be zeroed before each
-// pmove, just to make damn sure we don't have
-// any differences when running on client or server
-
-typedef struct {
-	Vec3 origin;          // full float precision
-	Vec3 velocity;        // full float precision
-
-	Vec3 forward, right, up;
-	Vec3 flatforward;     // normalized forward without z component, saved here because it needs
-	// special handling for looking straight up or down
-	float frametime;
-
-	int groundsurfFlags;
-	cplane_t groundplane;
-	int groundcontents;
-
-	Vec3 previous_origin;
-	bool ladder;
-
-	float forwardPush, sidePush, upPush;
-
-	float maxPlayerSpeed;
-	float maxWalkSpeed;
-	float maxCrouchedSpeed;
-	float jumpPlayerSpeed;
-	float jumpPlayerSpeedWater;
-	float dashPlayerSpeed;
-} pml_t;
-
-static pmove_t *pm;
-static pml_t pml;
-static const gs_state_t * pmove_gs;
-
 // movement parameters
 
 #define DEFAULT_WALKSPEED 160.0f
@@ -95,8 +61,8 @@ constexpr float pm_dashupspeed = ( 174.0f * GRAVITY_COMPENSATE );
 constexpr float pm_wjupspeed = ( 350.0f * GRAVITY_COMPENSATE );
 constexpr float pm_wjbouncefactor = 0.4f;
 
-static float pm_wjminspeed() {
-	return ( pml.maxWalkSpeed + pml.maxPlayerSpeed ) * 0.5f;
+static float pm_wjminspeed( pmove_t *pm ) {
+	return ( pm->pml.maxWalkSpeed + pm->pml.maxPlayerSpeed ) * 0.5f;
 }
 
 static float Normalize2D( Vec3 * v ) {
@@ -111,7 +77,7 @@ static float Normalize2D( Vec3 * v ) {
 // nbTestDir is the number of directions to test around the player
 // maxZnormal is the max Z value of the normal of a poly to consider it a wall
 // normal becomes a pointer to the normal of the most appropriate wall
-static void PlayerTouchWall( int nbTestDir, float maxZnormal, Vec3 * normal ) {
+static void PlayerTouchWall( pmove_t *pm, int nbTestDir, float maxZnormal, Vec3 * normal ) {
 	ZoneScoped;
 
 	float dist = 1.0;
@@ -123,14 +89,14 @@ static void PlayerTouchWall( int nbTestDir, float maxZnormal, Vec3 * normal ) {
 		float t = float( i ) / float( nbTestDir );
 
 		Vec3 dir = Vec3(
-			pm->maxs.x * cosf( PI * 2.0f * t ) + pml.velocity.x * 0.015f,
-			pm->maxs.y * sinf( PI * 2.0f * t ) + pml.velocity.y * 0.015f,
+			pm->maxs.x * cosf( PI * 2.0f * t ) + pm->pml.velocity.x * 0.015f,
+			pm->maxs.y * sinf( PI * 2.0f * t ) + pm->pml.velocity.y * 0.015f,
 			0.0f
 		);
-		Vec3 end = pml.origin + dir;
+		Vec3 end = pm->pml.origin + dir;
 
 		trace_t trace;
-		pmove_gs->api.Trace( &trace, pml.origin, mins, maxs, end, pm->playerState->POVnum, pm->contentmask, 0 );
+		pm->gs->api.Trace( &trace, pm->pml.origin, mins, maxs, end, pm->playerState->POVnum, pm->contentmask, 0 );
 
 		if( trace.allsolid )
 			return;
@@ -142,7 +108,7 @@ static void PlayerTouchWall( int nbTestDir, float maxZnormal, Vec3 * normal ) {
 			continue;
 
 		if( trace.ent > 0 ) {
-			const SyncEntityState * state = pmove_gs->api.GetEntityState( trace.ent, 0 );
+			const SyncEntityState * state = pm->gs->api.GetEntityState( trace.ent, 0 );
 			if( state->type == ET_PLAYER )
 				continue;
 		}
@@ -167,7 +133,7 @@ static void PlayerTouchWall( int nbTestDir, float maxZnormal, Vec3 * normal ) {
 
 #define MAX_CLIP_PLANES 5
 
-static void PM_AddTouchEnt( int entNum ) {
+static void PM_AddTouchEnt( pmove_t *pm, int entNum ) {
 	if( pm->numtouch >= MAXTOUCH || entNum < 0 ) {
 		return;
 	}
@@ -185,38 +151,53 @@ static void PM_AddTouchEnt( int entNum ) {
 }
 
 
-static int PM_SlideMove() {
+/*
+* PM_PredictedEvent
+* events can make the game touch other entities, so they wait for PmoveFinish
+*/
+static void PM_PredictedEvent( pmove_t *pm, int ev, u64 parm ) {
+	assert( pm->numevents < MAX_PMOVE_EVENTS );
+	if( pm->numevents == MAX_PMOVE_EVENTS ) {
+		return;
+	}
+
+	pm->events[pm->numevents].ev = ev;
+	pm->events[pm->numevents].parm = parm;
+	pm->numevents++;
+}
+
+static int PM_SlideMove( pmove_t *pm ) {
 	ZoneScoped;
 
 	Vec3 planes[MAX_CLIP_PLANES];
 	constexpr int maxmoves = 4;
-	float remainingTime = pml.frametime;
+	float remainingTime = pm->pml.frametime;
 	int blockedmask = 0;
 
-	Vec3 old_velocity = pml.velocity;
-	Vec3 last_valid_origin = pml.origin;
+	Vec3 old_velocity = pm->pml.velocity;
+	Vec3 last_valid_origin = pm->pml.origin;
 
 	if( pm->groundentity != -1 ) { // clip velocity to ground, no need to wait
 		// if the ground is not horizontal (a ramp) clipping will slow the player down
-		if( pml.groundplane.normal.z == 1.0f && pml.velocity.z < 0.0f ) {
-			pml.velocity.z = 0.0f;
+		if( pm->pml.groundplane.normal.z == 1.0f && pm->pml.velocity.z < 0.0f ) {
+			pm->pml.velocity.z = 0.0f;
 		}
 	}
 
 	int numplanes = 0; // clean up planes count for checking
 
 	for( int moves = 0; moves < maxmoves; moves++ ) {
-		Vec3 end = pml.origin + pml.velocity * remainingTime;
+		Vec3 end = pm->pml.origin + pm->pml.velocity * remainingTime;
 
 		trace_t trace;
-		pmove_gs->api.Trace( &trace, pml.origin, pm->mins, pm->maxs, end, pm->playerState->POVnum, pm->contentmask, 0 );
+		pm->gs->api.Trace( &trace, pm->pml.origin, pm->mins, pm->maxs, end, pm->playerState->POVnum, pm->contentmask, 0 );
 		if( trace.allsolid ) { // trapped into a solid
-			pml.origin = last_valid_origin;
+			pm->pml.origin = last_valid_origin;
 			return SLIDEMOVEFLAG_TRAPPED;
 		}
 
 		if( trace.fraction > 0 ) { // actually covered some distance
-			pml.origin = trace.endpos;
+			pm->pml.origin = trace.endpos;
 			last_valid_origin = trace.endpos;
 		}
 
@@ -225,7 +206,7 @@ static int PM_SlideMove() {
 		}
 
 		// save touched entity for return output
-		PM_AddTouchEnt( trace.ent );
+		PM_AddTouchEnt( pm, trace.ent );
 
 		// at this point we are blocked but not trapped.
 
@@ -244,7 +225,7 @@ static int PM_SlideMove() {
 			int i;
 			for( i = 0; i < numplanes; i++ ) {
 				if( Dot( trace.plane.normal, planes[i] ) > ( 1.0f - SLIDEMOVE_PLANEINTERACT_EPSILON ) ) {
-					pml.velocity = trace.plane.normal + pml.velocity;
+					pm->pml.velocity = trace.plane.normal + pm->pml.velocity;
 					break;
 				}
 			}
@@ -255,7 +236,7 @@ static int PM_SlideMove() {
 
 		// security check: we can't store more planes
 		if( numplanes >= MAX_CLIP_PLANES ) {
-			pml.velocity = Vec3( 0.0f );
+			pm->pml.velocity = Vec3( 0.0f );
 			return SLIDEMOVEFLAG_TRAPPED;
 		}
 
@@ -268,42 +249,42 @@ static int PM_SlideMove() {
 		//
 
 		for( int i = 0; i < numplanes; i++ ) {
-			if( Dot( pml.velocity, planes[i] ) >= SLIDEMOVE_PLANEINTERACT_EPSILON ) { // would not touch it
+			if( Dot( pm->pml.velocity, planes[i] ) >= SLIDEMOVE_PLANEINTERACT_EPSILON ) { // would not touch it
 				continue;
 			}
 
-			pml.velocity = GS_ClipVelocity( pml.velocity, planes[i], PM_OVERBOUNCE );
+			pm->pml.velocity = GS_ClipVelocity( pm->pml.velocity, planes[i], PM_OVERBOUNCE );
 			// see if we enter a second plane
 			for( int j = 0; j < numplanes; j++ ) {
 				if( j == i ) { // it's the same plane
 					continue;
 				}
-				if( Dot( pml.velocity, planes[j] ) >= SLIDEMOVE_PLANEINTERACT_EPSILON ) {
+				if( Dot( pm->pml.velocity, planes[j] ) >= SLIDEMOVE_PLANEINTERACT_EPSILON ) {
 					continue; // not with this one
 				}
 
 				//there was a second one. Try to slide along it too
-				pml.velocity = GS_ClipVelocity( pml.velocity, planes[j], PM_OVERBOUNCE );
+				pm->pml.velocity = GS_ClipVelocity( pm->pml.velocity, planes[j], PM_OVERBOUNCE );
 
 				// check if the slide sent it back to the first plane
-				if( Dot( pml.velocity, planes[i] ) >= SLIDEMOVE_PLANEINTERACT_EPSILON ) {
+				if( Dot( pm->pml.velocity, planes[i] ) >= SLIDEMOVE_PLANEINTERACT_EPSILON ) {
 					continue;
 				}
 
 				// bad luck: slide the original velocity along the crease
 				Vec3 dir = SafeNormalize( Cross( planes[i], planes[j] ) );
-				float value = Dot( dir, pml.velocity );
-				pml.velocity = dir * value;
+				float value = Dot( dir, pm->pml.velocity );
+				pm->pml.velocity = dir * value;
 
 				// check if there is a third plane, in that case we're trapped
 				for( int k = 0; k < numplanes; k++ ) {
 					if( j == k || i == k ) { // it's the same plane
 						continue;
 					}
-					if( Dot( pml.velocity, planes[k] ) >= SLIDEMOVE_PLANEINTERACT_EPSILON ) {
+					if( Dot( pm->pml.velocity, planes[k] ) >= SLIDEMOVE_PLANEINTERACT_EPSILON ) {
 						continue; // not with this one
 					}
-					pml.velocity = Vec3( 0.0f );
+					pm->pml.velocity = Vec3( 0.0f );
 					break;
 				}
 			}
@@ -311,7 +292,7 @@ static int PM_SlideMove() {
 	}
 
 	if( pm->playerState->pmove.pm_time ) {
-		pml.velocity = old_velocity;
+		pm->pml.velocity = old_velocity;
 	}
 
 	return blockedmask;
@@ -323,64 +304,64 @@ static int PM_SlideMove() {
 * Each intersection will try to step over the obstruction instead of
 * sliding along it.
 */
-static void PM_StepSlideMove() {
+static void PM_StepSlideMove( pmove_t *pm ) {
 	ZoneScoped;
 
 	trace_t trace;
 
-	Vec3 start_o = pml.origin;
-	Vec3 start_v = pml.velocity;
+	Vec3 start_o = pm->pml.origin;
+	Vec3 start_v = pm->pml.velocity;
 
-	int blocked = PM_SlideMove();
+	int blocked = PM_SlideMove( pm );
 
-	Vec3 down_o = pml.origin;
-	Vec3 down_v = pml.velocity;
+	Vec3 down_o = pm->pml.origin;
+	Vec3 down_v = pm->pml.velocity;
 
 	Vec3 up = start_o + Vec3( 0.0f, 0.0f, STEPSIZE );
 
-	pmove_gs->api.Trace( &trace, up, pm->mins, pm->maxs, up, pm->playerState->POVnum, pm->contentmask, 0 );
+	pm->gs->api.Trace( &trace, up, pm->mins, pm->maxs, up, pm->playerState->POVnum, pm->contentmask, 0 );
 	if( trace.allsolid ) {
 		return; // can't step up
 	}
 
 	// try sliding above
-	pml.origin = up;
-	pml.velocity = start_v;
+	pm->pml.origin = up;
+	pm->pml.velocity = start_v;
 
-	PM_SlideMove();
+	PM_SlideMove( pm );
 
 	// push down the final amount
-	Vec3 down = pml.origin - Vec3( 0.0f, 0.0f, STEPSIZE );
-	pmove_gs->api.Trace( &trace, pml.origin, pm->mins, pm->maxs, down, pm->playerState->POVnum, pm->contentmask, 0 );
+	Vec3 down = pm->pml.origin - Vec3( 0.0f, 0.0f, STEPSIZE );
+	pm->gs->api.Trace( &trace, pm->pml.origin, pm->mins, pm->maxs, down, pm->playerState->POVnum, pm->contentmask, 0 );
 	if( !trace.allsolid ) {
-		pml.origin = trace.endpos;
+		pm->pml.origin = trace.endpos;
 	}
 
-	up = pml.origin;
+	up = pm->pml.origin;
 
 	// decide which one went farther
 	float down_dist = LengthSquared( down_o.xy() - start_o.xy() );
 	float up_dist = LengthSquared( up.xy() - start_o.xy() );
 
 	if( down_dist >= up_dist || trace.allsolid || ( trace.fraction != 1.0 && !ISWALKABLEPLANE( &trace.plane ) ) ) {
-		pml.origin = down_o;
-		pml.velocity = down_v;
+		pm->pml.origin = down_o;
+		pm->pml.velocity = down_v;
 		return;
 	}
 
 	// only add the stepping output when it was a vertical step (second case is at the exit of a ramp)
 	if( ( blocked & SLIDEMOVEFLAG_WALL_BLOCKED ) || trace.plane.normal.z == 1.0f - SLIDEMOVE_PLANEINTERACT_EPSILON ) {
-		pm->step = pml.origin.z - pml.previous_origin.z;
+		pm->step = pm->pml.origin.z - pm->pml.previous_origin.z;
 	}
 
 	// Preserve speed when sliding up ramps
 	float hspeed = Length( start_v.xy() );
 	if( hspeed && ISWALKABLEPLANE( &trace.plane ) ) {
 		if( trace.plane.normal.z >= 1.0f - SLIDEMOVE_PLANEINTERACT_EPSILON ) {
-			pml.velocity = start_v;
+			pm->pml.velocity = start_v;
 		} else {
-			Normalize2D( &pml.velocity );
-			pml.velocity = Vec3( pml.velocity.xy() * hspeed, pml.velocity.z );
+			Normalize2D( &pm->pml.velocity );
+			pm->pml.velocity = Vec3( pm->pml.velocity.xy() * hspeed, pm->pml.velocity.z );
 		}
 	}
 
@@ -388,7 +369,7 @@ static void PM_StepSlideMove() {
 
 	//!! Special case
 	// if we were walking along a plane, then we need to copy the Z over
-	pml.velocity.z = down_v.z;
+	pm->pml.velocity.z = down_v.z;
 }
 
 /*
@@ -396,11 +377,11 @@ static void PM_StepSlideMove() {
 *
 * Handles both ground friction and water friction
 */
-static void PM_Friction() {
-	float speed = LengthSquared( pml.velocity );
+static void PM_Friction( pmove_t *pm ) {
+	float speed = LengthSquared( pm->pml.velocity );
 	if( speed < 1 ) {
-		pml.velocity.x = 0.0f;
-		pml.velocity.y = 0.0f;
+		pm->pml.velocity.x = 0.0f;
+		pm->pml.velocity.y = 0.0f;
 		return;
 	}
 
@@ -408,17 +389,17 @@ static void PM_Friction() {
 	float drop = 0.0f;
 
 	// apply ground friction
-	if( ( pm->groundentity != -1 && !( pml.groundsurfFlags & SURF_SLICK ) ) || pml.ladder ) {
+	if( ( pm->groundentity != -1 && !( pm->pml.groundsurfFlags & SURF_SLICK ) ) || pm->pml.ladder ) {
 		if( pm->playerState->pmove.knockback_time <= 0 ) {
 			float friction = pm_friction;
 			float control = speed < pm_decelerate ? pm_decelerate : speed;
-			drop += control * friction * pml.frametime;
+			drop += control * friction * pm->pml.frametime;
 		}
 	}
 
 	// scale the velocity
 	float newspeed = Max2( 0.0f, speed - drop );
-	pml.velocity *= newspeed / speed;
+	pm->pml.velocity *= newspeed / speed;
 }
 
 /*
@@ -426,60 +407,60 @@ static void PM_Friction() {
 *
 * Handles user intended acceleration
 */
-static void PM_Accelerate( Vec3 wishdir, float wishspeed, float accel ) {
-	float currentspeed = Dot( pml.velocity, wishdir );
+static void PM_Accelerate( pmove_t *pm, Vec3 wishdir, float wishspeed, float accel ) {
+	float currentspeed = Dot( pm->pml.velocity, wishdir );
 	float addspeed = wishspeed - currentspeed;
 	if( addspeed <= 0 ) {
 		return;
 	}
 
-	float accelspeed = accel * pml.frametime * wishspeed;
+	float accelspeed = accel * pm->pml.frametime * wishspeed;
 	if( accelspeed > addspeed ) {
 		accelspeed = addspeed;
 	}
 
-	pml.velocity += wishdir * accelspeed;
+	pm->pml.velocity += wishdir * accelspeed;
 }
 
 // when using +strafe convert the inertia to forward speed.
-static void PM_Aircontrol( Vec3 wishdir, float wishspeed ) {
+static void PM_Aircontrol( pmove_t *pm, Vec3 wishdir, float wishspeed ) {
 	// accelerate
-	float smove = pml.sidePush;
+	float smove = pm->pml.sidePush;
 
 	if( smove != 0.0f || wishspeed == 0.0f ) {
 		return; // can't control movement if not moving forward or backward
 	}
 
-	float zspeed = pml.velocity.z;
-	pml.velocity.z = 0;
-	float speed = Length( pml.velocity );
-	pml.velocity = Normalize( pml.velocity );
+	float zspeed = pm->pml.velocity.z;
+	pm->pml.velocity.z = 0;
+	float speed = Length( pm->pml.velocity );
+	pm->pml.velocity = Normalize( pm->pml.velocity );
 
-	float dot = Dot( pml.velocity, wishdir );
-	float k = 32.0f * pm_aircontrol * dot * dot * pml.frametime;
+	float dot = Dot( pm->pml.velocity, wishdir );
+	float k = 32.0f * pm_aircontrol * dot * dot * pm->pml.frametime;
 
 	if( dot > 0 ) {
 		// we can't change direction while slowing down
-		pml.velocity.x = pml.velocity.x * speed + wishdir.x * k;
-		pml.velocity.y = pml.velocity.y * speed + wishdir.y * k;
+		pm->pml.velocity.x = pm->pml.velocity.x * speed + wishdir.x * k;
+		pm->pml.velocity.y = pm->pml.velocity.y * speed + wishdir.y * k;
 
-		pml.velocity = Normalize( pml.velocity );
+		pm->pml.velocity = Normalize( pm->pml.velocity );
 	}
 
-	pml.velocity.x *= speed;
-	pml.velocity.y *= speed;
-	pml.velocity.z = zspeed;
+	pm->pml.velocity.x *= speed;
+	pm->pml.velocity.y *= speed;
+	pm->pml.velocity.z = zspeed;
 }
 
-static Vec3 PM_LadderMove( Vec3 wishvel ) {
-	if( pml.ladder && Abs( pml.velocity.z ) <= DEFAULT_LADDERSPEED ) {
-		if( pml.forwardPush > 0 ) {
+static Vec3 PM_LadderMove( pmove_t *pm, Vec3 wishvel ) {
+	if( pm->pml.ladder && Abs( pm->pml.velocity.z ) <= DEFAULT_LADDERSPEED ) {
+		if( pm->pml.forwardPush > 0 ) {
 			wishvel.z = Lerp( -float( DEFAULT_LADDERSPEED ), Unlerp01( 15.0f, pm->playerState->viewangles[PITCH], -15.0f ), float( DEFAULT_LADDERSPEED ) );
 		}
-		else if( pml.upPush > 0 ) {
+		else if( pm->pml.upPush > 0 ) {
 			wishvel.z = DEFAULT_LADDERSPEED;
 		}
-		else if( pml.upPush < 0 ) {
+		else if( pm->pml.upPush < 0 ) {
 			wishvel.z = -DEFAULT_LADDERSPEED;
 		}
 		else {
@@ -494,39 +475,39 @@ static Vec3 PM_LadderMove( Vec3 wishvel ) {
 	return wishvel;
 }
 
-static void PM_WaterMove() {
+static void PM_WaterMove( pmove_t *pm ) {
 	ZoneScoped;
 
 	// user intentions
-	Vec3 wishvel = pml.forward * pml.forwardPush + pml.right * pml.sidePush;
+	Vec3 wishvel = pm->pml.forward * pm->pml.forwardPush + pm->pml.right * pm->pml.sidePush;
 	wishvel.z -= pm_waterfriction;
 
-	wishvel = PM_LadderMove( wishvel );
+	wishvel = PM_LadderMove( pm, wishvel );
 
 	Vec3 wishdir = wishvel;
 	float wishspeed = Length( wishdir );
 	wishdir = SafeNormalize( wishdir );
 
-	if( wishspeed > pml.maxPlayerSpeed ) {
-		wishspeed = pml.maxPlayerSpeed / wishspeed;
+	if( wishspeed > pm->pml.maxPlayerSpeed ) {
+		wishspeed = pm->pml.maxPlayerSpeed / wishspeed;
 		wishvel *= wishspeed;
-		wishspeed = pml.maxPlayerSpeed;
+		wishspeed = pm->pml.maxPlayerSpeed;
 	}
 
-	PM_Accelerate( wishdir, wishspeed, pm_wateraccelerate );
-	PM_StepSlideMove();
+	PM_Accelerate( pm, wishdir, wishspeed, pm_wateraccelerate );
+	PM_StepSlideMove( pm );
 }
 
-static void PM_Move() {
+static void PM_Move( pmove_t *pm ) {
 	ZoneScoped;
 
-	float fmove = pml.forwardPush;
-	float smove = pml.sidePush;
+	float fmove = pm->pml.forwardPush;
+	float smove = pm->pml.sidePush;
 
-	Vec3 wishvel = pml.forward * fmove + pml.right * smove;
+	Vec3 wishvel = pm->pml.forward * fmove + pm->pml.right * smove;
 	wishvel.z = 0;
 
-	wishvel = PM_LadderMove( wishvel );
+	wishvel = PM_LadderMove( pm, wishvel );
 
 	Vec3 wishdir = wishvel;
 	float wishspeed = Length( wishdir );
@@ -536,11 +517,11 @@ static void PM_Move() {
 
 	float maxspeed;
 	if( pm->playerState->pmove.crouch_time ) {
-		maxspeed = pml.maxCrouchedSpeed;
+		maxspeed = pm->pml.maxCrouchedSpeed;
 	} else if( ( pm->cmd.buttons & BUTTON_WALK ) && ( pm->playerState->pmove.features & PMFEAT_WALK ) ) {
-		maxspeed = pml.maxWalkSpeed;
+		maxspeed = pm->pml.maxWalkSpeed;
 	} else {
-		maxspeed = pml.maxPlayerSpeed;
+		maxspeed = pm->pml.maxPlayerSpeed;
 	}
 
 	if( wishspeed > maxspeed ) {
@@ -549,42 +530,42 @@ static void PM_Move() {
 		wishspeed = maxspeed;
 	}
 
-	if( pml.ladder ) {
-		PM_Accelerate( wishdir, wishspeed, pm_accelerate );
+	if( pm->pml.ladder ) {
+		PM_Accelerate( pm, wishdir, wishspeed, pm_accelerate );
 
 		if( wishvel.z == 0.0f ) {
-			float decel = GRAVITY * pml.frametime;
-			if( pml.velocity.z > 0 ) {
-				pml.velocity.z = Max2( 0.0f, pml.velocity.z - decel );
+			float decel = GRAVITY * pm->pml.frametime;
+			if( pm->pml.velocity.z > 0 ) {
+				pm->pml.velocity.z = Max2( 0.0f, pm->pml.velocity.z - decel );
 			}
 			else {
-				pml.velocity.z = Min2( 0.0f, pml.velocity.z + decel );
+				pm->pml.velocity.z = Min2( 0.0f, pm->pml.velocity.z + decel );
 			}
 		}
 
-		PM_StepSlideMove();
+		PM_StepSlideMove( pm );
 	}
 	else if( pm->groundentity != -1 ) {
 		// walking on ground
-		if( pml.velocity.z > 0 ) {
-			pml.velocity.z = 0; //!!! this is before the accel
+		if( pm->pml.velocity.z > 0 ) {
+			pm->pml.velocity.z = 0; //!!! this is before the accel
 		}
 
-		PM_Accelerate( wishdir, wishspeed, pm_accelerate );
+		PM_Accelerate( pm, wishdir, wishspeed, pm_accelerate );
 
-		pml.velocity.z = Min2( 0.0f, pml.velocity.z );
+		pm->pml.velocity.z = Min2( 0.0f, pm->pml.velocity.z );
 
-		if( pml.velocity.xy() == Vec2( 0.0f ) ) {
+		if( pm->pml.velocity.xy() == Vec2( 0.0f ) ) {
 			return;
 		}
 
-		PM_StepSlideMove();
+		PM_StepSlideMove( pm );
 	}
 	else {
 		// Air Control
 		float wishspeed2 = wishspeed;
 		float accel;
-		if( Dot( pml.velocity, wishdir ) < 0 && !( pm->playerState->pmove.pm_flags & PMF_WALLJUMPING ) && pm->playerState->pmove.knockback_time <= 0 ) {
+		if( Dot( pm->pml.velocity, wishdir ) < 0 && !( pm->playerState->pmove.pm_flags & PMF_WALLJUMPING ) && pm->playerState->pmove.knockback_time <= 0 ) {
 			accel = pm_airdecelerate;
 		} else {
 			accel = pm_airaccelerate;
@@ -601,14 +582,14 @@ static void PM_Move() {
 		}
 
 		// Air control
-		PM_Accelerate( wishdir, wishspeed, accel );
+		PM_Accelerate( pm, wishdir, wishspeed, accel );
 		if( !( pm->playerState->pmove.pm_flags & PMF_WALLJUMPING ) && pm->playerState->pmove.knockback_time <= 0 ) { // no air ctrl while wjing
-			PM_Aircontrol( wishdir, wishspeed2 );
+			PM_Aircontrol( pm, wishdir, wishspeed2 );
 		}
 
 		// add gravity
-		pml.velocity.z -= GRAVITY * pml.frametime;
-		PM_StepSlideMove();
+		pm->pml.velocity.z -= GRAVITY * pm->pml.frametime;
+		PM_StepSlideMove( pm );
 	}
 }
 
@@ -617,49 +598,49 @@ static void PM_Move() {
 *
 * If the player hull point one-quarter unit down is solid, the player is on ground
 */
-static void PM_GroundTrace( trace_t *trace ) {
-	Vec3 point = pml.origin - Vec3( 0.0f, 0.0f, 0.25f );
-	pmove_gs->api.Trace( trace, pml.origin, pm->mins, pm->maxs, point, pm->playerState->POVnum, pm->contentmask, 0 );
+static void PM_GroundTrace( pmove_t *pm, trace_t *trace ) {
+	Vec3 point = pm->pml.origin - Vec3( 0.0f, 0.0f, 0.25f );
+	pm->gs->api.Trace( trace, pm->pml.origin, pm->mins, pm->maxs, point, pm->playerState->POVnum, pm->contentmask, 0 );
 }
 
-static bool PM_GoodPosition( Vec3 origin, trace_t *trace ) {
+static bool PM_GoodPosition( pmove_t *pm, Vec3 origin, trace_t *trace ) {
 	if( pm->playerState->pmove.pm_type == PM_SPECTATOR ) {
 		return true;
 	}
 
-	pmove_gs->api.Trace( trace, origin, pm->mins, pm->maxs, origin, pm->playerState->POVnum, pm->contentmask, 0 );
+	pm->gs->api.Trace( trace, origin, pm->mins, pm->maxs, origin, pm->playerState->POVnum, pm->contentmask, 0 );
 
 	return !trace->allsolid;
 }
 
-static void PM_UnstickPosition( trace_t *trace ) {
+static void PM_UnstickPosition( pmove_t *pm, trace_t *trace ) {
 	ZoneScoped;
 
-	Vec3 origin = pml.origin;
+	Vec3 origin = pm->pml.origin;
 
 	// try all combinations
 	for( int j = 0; j < 8; j++ ) {
-		origin = pml.origin;
+		origin = pm->pml.origin;
 
 		origin.x += ( j & 1 ) ? -1.0f : 1.0f;
 		origin.y += ( j & 2 ) ? -1.0f : 1.0f;
 		origin.z += ( j & 4 ) ? -1.0f : 1.0f;
 
-		if( PM_GoodPosition( origin, trace ) ) {
-			pml.origin = origin;
-			PM_GroundTrace( trace );
+		if( PM_GoodPosition( pm, origin, trace ) ) {
+			pm->pml.origin = origin;
+			PM_GroundTrace( pm, trace );
 			return;
 		}
 	}
 
 	// go back to the last position
-	pml.origin = pml.previous_origin;
+	pm->pml.origin = pm->pml.previous_origin;
 }
 
-static void PM_CategorizePosition() {
+static void PM_CategorizePosition( pmove_t *pm ) {
 	ZoneScoped;
 
-	if( pml.velocity.z > 180 ) { // !!ZOID changed from 100 to 180 (ramp accel)
+	if( pm->pml.velocity.z > 180 ) { // !!ZOID changed from 100 to 180 (ramp accel)
 		pm->playerState->pmove.pm_flags &= ~PMF_ON_GROUND;
 		pm->groundentity = -1;
 	}
@@ -667,16 +648,16 @@ static void PM_CategorizePosition() {
 		trace_t trace;
 
 		// see if standing on something solid
-		PM_GroundTrace( &trace );
+		PM_GroundTrace( pm, &trace );
 
 		if( trace.allsolid ) {
 			// try to unstick position
-			PM_UnstickPosition( &trace );
+			PM_UnstickPosition( pm, &trace );
 		}
 
-		pml.groundplane = trace.plane;
-		pml.groundsurfFlags = trace.surfFlags;
-		pml.groundcontents = trace.contents;
+		pm->pml.groundplane = trace.plane;
+		pm->pml.groundsurfFlags = trace.surfFlags;
+		pm->pml.groundcontents = trace.contents;
 
 		if( trace.fraction == 1 || ( !ISWALKABLEPLANE( &trace.plane ) && !trace.startsolid ) ) {
 			pm->groundentity = -1;
@@ -711,19 +692,19 @@ static void PM_CategorizePosition() {
 	int sample2 = pm->playerState->viewheight - pm->mins.z;
 	int sample1 = sample2 / 2;
 
-	Vec3 point = pml.origin;
+	Vec3 point = pm->pml.origin;
 	point.z += pm->mins.z + 1.0f;
-	int cont = pmove_gs->api.PointContents( point, 0 );
+	int cont = pm->gs->api.PointContents( point, 0 );
 
 	if( cont & MASK_WATER ) {
 		pm->watertype = cont;
 		pm->waterlevel = 1;
-		point.z = pml.origin.z + pm->mins.z + sample1;
-		cont = pmove_gs->api.PointContents( point, 0 );
+		point.z = pm->pml.origin.z + pm->mins.z + sample1;
+		cont = pm->gs->api.PointContents( point, 0 );
 		if( cont & MASK_WATER ) {
 			pm->waterlevel = 2;
-			point.z = pml.origin.z + pm->mins.z + sample2;
-			cont = pmove_gs->api.PointContents( point, 0 );
+			point.z = pm->pml.origin.z + pm->mins.z + sample2;
+			cont = pm->gs->api.PointContents( point, 0 );
 			if( cont & MASK_WATER ) {
 				pm->waterlevel = 3;
 			}
@@ -731,19 +712,19 @@ static void PM_CategorizePosition() {
 	}
 }
 
-static void PM_ClearDash() {
+static void PM_ClearDash( pmove_t *pm ) {
 	pm->playerState->pmove.pm_flags &= ~PMF_DASHING;
 	pm->playerState->pmove.dash_time = 0;
 }
 
-static void PM_ClearWallJump() {
+static void PM_ClearWallJump( pmove_t *pm ) {
 	pm->playerState->pmove.pm_flags &= ~PMF_WALLJUMPING;
 	pm->playerState->pmove.pm_flags &= ~PMF_WALLJUMPCOUNT;
 	pm->playerState->pmove.walljump_time = 0;
 }
 
-static void PM_CheckJump() {
-	if( pml.upPush < 10 ) {
+static void PM_CheckJump( pmove_t *pm ) {
+	if( pm->pml.upPush < 10 ) {
 		return;
 	}
 
@@ -762,23 +743,23 @@ static void PM_CheckJump() {
 	pm->groundentity = -1;
 
 	// clip against the ground when jumping if moving that direction
-	if( pml.groundplane.normal.z > 0 && pml.velocity.z < 0 && Dot( pml.groundplane.normal.xy(), pml.velocity.xy() ) > 0 ) {
-		pml.velocity = GS_ClipVelocity( pml.velocity, pml.groundplane.normal, PM_OVERBOUNCE );
+	if( pm->pml.groundplane.normal.z > 0 && pm->pml.velocity.z < 0 && Dot( pm->pml.groundplane.normal.xy(), pm->pml.velocity.xy() ) > 0 ) {
+		pm->pml.velocity = GS_ClipVelocity( pm->pml.velocity, pm->pml.groundplane.normal, PM_OVERBOUNCE );
 	}
 
 
-	float jumpSpeed = ( pm->waterlevel >= 2 ? pml.jumpPlayerSpeedWater : pml.jumpPlayerSpeed );
+	float jumpSpeed = ( pm->waterlevel >= 2 ? pm->pml.jumpPlayerSpeedWater : pm->pml.jumpPlayerSpeed );
 
-	pmove_gs->api.PredictedEvent( pm->playerState->POVnum, EV_JUMP, 0 );
-	pml.velocity.z = Max2( 0.0f, pml.velocity.z ) + jumpSpeed;
+	PM_PredictedEvent( pm, EV_JUMP, 0 );
+	pm->pml.velocity.z = Max2( 0.0f, pm->pml.velocity.z ) + jumpSpeed;
 
 	// remove wj count
 	pm->playerState->pmove.pm_flags &= ~PMF_JUMPPAD_TIME;
-	PM_ClearDash();
-	PM_ClearWallJump();
+	PM_ClearDash( pm );
+	PM_ClearWallJump( pm );
 }
 
-static void PM_CheckDash() {
+static void PM_CheckDash( pmove_t *pm ) {
 	bool pressed = pm->cmd.buttons & BUTTON_SPECIAL;
 
 	if( !pressed ) {
@@ -795,55 +776,55 @@ static void PM_CheckDash() {
 
 	if( pm->groundentity != -1 && pressed && ( pm->playerState->pmove.features & PMFEAT_SPECIAL ) ) {
 		pm->playerState->pmove.pm_flags &= ~PMF_JUMPPAD_TIME;
-		PM_ClearWallJump();
+		PM_ClearWallJump( pm );
 
 		pm->playerState->pmove.pm_flags |= PMF_DASHING;
 		pm->playerState->pmove.pm_flags |= PMF_SPECIAL_HELD;
 		pm->groundentity = -1;
 
 		// clip against the ground when jumping if moving that direction
-		if( pml.groundplane.normal.z > 0 && pml.velocity.z < 0 && Dot( pml.groundplane.normal.xy(), pml.velocity.xy() ) > 0 ) {
-			pml.velocity = GS_ClipVelocity( pml.velocity, pml.groundplane.normal, PM_OVERBOUNCE );
+		if( pm->pml.groundplane.normal.z > 0 && pm->pml.velocity.z < 0 && Dot( pm->pml.groundplane.normal.xy(), pm->pml.velocity.xy() ) > 0 ) {
+			pm->pml.velocity = GS_ClipVelocity( pm->pml.velocity, pm->pml.groundplane.normal, PM_OVERBOUNCE );
 		}
 
-		float upspeed = Max2( 0.0f, pml.velocity.z ) + pm_dashupspeed;
+		float upspeed = Max2( 0.0f, pm->pml.velocity.z ) + pm_dashupspeed;
 
 		// ch : we should do explicit forwardPush here, and ignore sidePush ?
-		Vec3 dashdir = pml.flatforward * pml.forwardPush + pml.right * pml.sidePush;
+		Vec3 dashdir = pm->pml.flatforward * pm->pml.forwardPush + pm->pml.right * pm->pml.sidePush;
 		dashdir.z = 0.0f;
 
 		if( Length( dashdir ) < 0.01f ) { // if not moving, dash like a "forward dash"
-			dashdir = pml.flatforward;
-			pml.forwardPush = pml.dashPlayerSpeed;
+			dashdir = pm->pml.flatforward;
+			pm->pml.forwardPush = pm->pml.dashPlayerSpeed;
 		}
 
 		dashdir = Normalize( dashdir );
 
-		float actual_velocity = Normalize2D( &pml.velocity );
-		if( actual_velocity <= pml.dashPlayerSpeed ) {
-			dashdir *= pml.dashPlayerSpeed;
+		float actual_velocity = Normalize2D( &pm->pml.velocity );
+		if( actual_velocity <= pm->pml.dashPlayerSpeed ) {
+			dashdir *= pm->pml.dashPlayerSpeed;
 		} else {
 			dashdir *= actual_velocity;
 		}
 
-		pml.velocity = dashdir;
-		pml.velocity.z = upspeed;
+		pm->pml.velocity = dashdir;
+		pm->pml.velocity.z = upspeed;
 
 		// return sound events only when the dashes weren't too close to each other
 		if( pm->playerState->pmove.dash_time == 0 ) {
-			if( Abs( pml.sidePush ) >= Abs( pml.forwardPush ) ) {
-				if( pml.sidePush > 0 ) {
-					pmove_gs->api.PredictedEvent( pm->playerState->POVnum, EV_DASH, 2 );
+			if( Abs( pm->pml.sidePush ) >= Abs( pm->pml.forwardPush ) ) {
+				if( pm->pml.sidePush > 0 ) {
+					PM_PredictedEvent( pm, EV_DASH, 2 );
 				}
 				else {
-					pmove_gs->api.PredictedEvent( pm->playerState->POVnum, EV_DASH, 1 );
+					PM_PredictedEvent( pm, EV_DASH, 1 );
 				}
 			}
-			else if( pml.forwardPush < 0 ) {
-				pmove_gs->api.PredictedEvent( pm->playerState->POVnum, EV_DASH, 3 );
+			else if( pm->pml.forwardPush < 0 ) {
+				PM_PredictedEvent( pm, EV_DASH, 3 );
 			}
 			else {
-				pmove_gs->api.PredictedEvent( pm->playerState->POVnum, EV_DASH, 0 );
+				PM_PredictedEvent( pm, EV_DASH, 0 );
 			}
 		}
 
@@ -853,7 +834,7 @@ static void PM_CheckDash() {
 	}
 }
 
-static void PM_CheckWallJump() {
+static void PM_CheckWallJump( pmove_t *pm ) {
 	ZoneScoped;
 
 	bool pressed = pm->cmd.buttons & BUTTON_SPECIAL;
@@ -867,7 +848,7 @@ static void PM_CheckWallJump() {
 		pm->playerState->pmove.pm_flags &= ~PMF_WALLJUMPCOUNT;
 	}
 
-	if( pm->playerState->pmove.pm_flags & PMF_WALLJUMPING && pml.velocity.z < 0.0 ) {
+	if( pm->playerState->pmove.pm_flags & PMF_WALLJUMPING && pm->pml.velocity.z < 0.0 ) {
 		pm->playerState->pmove.pm_flags &= ~PMF_WALLJUMPING;
 	}
 
@@ -892,44 +873,44 @@ static void PM_CheckWallJump() {
 		pm->playerState->pmove.walljump_time <= 0 )
 	{
 		trace_t trace;
-		Vec3 point = pml.origin;
+		Vec3 point = pm->pml.origin;
 		point.z -= STEPSIZE;
 
 		// don't walljump if our height is smaller than a step
 		// unless jump is pressed or the player is moving faster than dash speed and upwards
-		float hspeed = Length( Vec3( pml.velocity.x, pml.velocity.y, 0 ) );
-		pmove_gs->api.Trace( &trace, pml.origin, pm->mins, pm->maxs, point, pm->playerState->POVnum, pm->contentmask, 0 );
+		float hspeed = Length( Vec3( pm->pml.velocity.x, pm->pml.velocity.y, 0 ) );
+		pm->gs->api.Trace( &trace, pm->pml.origin, pm->mins, pm->maxs, point, pm->playerState->POVnum, pm->contentmask, 0 );
 
-		if( pml.upPush >= 10
-			|| ( hspeed > pm->playerState->pmove.dash_speed && pml.velocity.z > 8 )
+		if( pm->pml.upPush >= 10
+			|| ( hspeed > pm->playerState->pmove.dash_speed && pm->pml.velocity.z > 8 )
 			|| ( trace.fraction == 1 ) || ( !ISWALKABLEPLANE( &trace.plane ) && !trace.startsolid ) ) {
 			Vec3 normal( 0.0f );
-			PlayerTouchWall( 12, 0.3f, &normal );
+			PlayerTouchWall( pm, 12, 0.3f, &normal );
 			if( !Length( normal ) ) {
 				return;
 			}
 
 			if( !( pm->playerState->pmove.pm_flags & PMF_SPECIAL_HELD )
 				&& !( pm->playerState->pmove.pm_flags & PMF_WALLJUMPING ) ) {
-				float oldupvelocity = pml.velocity.z;
-				pml.velocity.z = 0.0;
+				float oldupvelocity = pm->pml.velocity.z;
+				pm->pml.velocity.z = 0.0;
 
-				hspeed = Normalize2D( &pml.velocity );
+				hspeed = Normalize2D( &pm->pml.velocity );
 
-				pml.velocity = GS_ClipVelocity( pml.velocity, normal, 1.0005f );
-				pml.velocity = pml.velocity + normal * pm_wjbouncefactor;
+				pm->pml.velocity = GS_ClipVelocity( pm->pml.velocity, normal, 1.0005f );
+				pm->pml.velocity = pm->pml.velocity + normal * pm_wjbouncefactor;
 
-				if( hspeed < pm_wjminspeed() ) {
-					hspeed = pm_wjminspeed();
+				if( hspeed < pm_wjminspeed( pm ) ) {
+					hspeed = pm_wjminspeed( pm );
 				}
 
-				pml.velocity = Normalize( pml.velocity );
+				pm->pml.velocity = Normalize( pm->pml.velocity );
 
-				pml.velocity *= hspeed;
-				pml.velocity.z = ( oldupvelocity > pm_wjupspeed ) ? oldupvelocity : pm_wjupspeed; // jal: if we had a faster upwards speed, keep it
+				pm->pml.velocity *= hspeed;
+				pm->pml.velocity.z = ( oldupvelocity > pm_wjupspeed ) ? oldupvelocity : pm_wjupspeed; // jal: if we had a faster upwards speed, keep it
 
 				// set the walljumping state
-				PM_ClearDash();
+				PM_ClearDash( pm );
 				pm->playerState->pmove.pm_flags &= ~PMF_JUMPPAD_TIME;
 
 				pm->playerState->pmove.pm_flags |= PMF_WALLJUMPING;
@@ -940,7 +921,7 @@ static void PM_CheckWallJump() {
 				pm->playerState->pmove.walljump_time = PM_WALLJUMP_TIMEDELAY;
 
 				// Create the event
-				pmove_gs->api.PredictedEvent( pm->playerState->POVnum, EV_WALLJUMP, DirToU64( normal ) );
+				PM_PredictedEvent( pm, EV_WALLJUMP, DirToU64( normal ) );
 			}
 		}
 	} else {
@@ -948,7 +929,7 @@ static void PM_CheckWallJump() {
 	}
 }
 
-static void PM_CheckSpecialMovement() {
+static void PM_CheckSpecialMovement( pmove_t *pm ) {
 	int cont;
 
 	pm->ladder = false;
@@ -957,14 +938,14 @@ static void PM_CheckSpecialMovement() {
 		return;
 	}
 
-	pml.ladder = false;
+	pm->pml.ladder = false;
 
 	// check for ladder
-	Vec3 spot = pml.origin + pml.flatforward;
+	Vec3 spot = pm->pml.origin + pm->pml.flatforward;
 	trace_t trace;
-	pmove_gs->api.Trace( &trace, pml.origin, pm->mins, pm->maxs, spot, pm->playerState->POVnum, pm->contentmask, 0 );
+	pm->gs->api.Trace( &trace, pm->pml.origin, pm->mins, pm->maxs, spot, pm->playerState->POVnum, pm->contentmask, 0 );
 	if( trace.fraction < 1 && ( trace.surfFlags & SURF_LADDER ) ) {
-		pml.ladder = true;
+		pm->pml.ladder = true;
 		pm->ladder = true;
 	}
 
@@ -973,62 +954,62 @@ static void PM_CheckSpecialMovement() {
 		return;
 	}
 
-	spot = pml.origin + pml.flatforward * 30;
+	spot = pm->pml.origin + pm->pml.flatforward * 30;
 	spot.z += 4;
-	cont = pmove_gs->api.PointContents( spot, 0 );
+	cont = pm->gs->api.PointContents( spot, 0 );
 	if( !( cont & CONTENTS_SOLID ) ) {
 		return;
 	}
 
 	spot.z += 16;
-	cont = pmove_gs->api.PointContents( spot, 0 );
+	cont = pm->gs->api.PointContents( spot, 0 );
 	if( cont ) {
 		return;
 	}
 	// jump out of water
-	pml.velocity = pml.flatforward * 50;
-	pml.velocity.z = 350;
+	pm->pml.velocity = pm->pml.flatforward * 50;
+	pm->pml.velocity.z = 350;
 
 	pm->playerState->pmove.pm_flags |= PMF_TIME_WATERJUMP;
 	pm->playerState->pmove.pm_time = 255;
 }
 
-static void PM_FlyMove( bool doclip ) {
+static void PM_FlyMove( pmove_t *pm, bool doclip ) {
 	trace_t trace;
 
-	float maxspeed = pml.maxPlayerSpeed * 1.5f;
+	float maxspeed = pm->pml.maxPlayerSpeed * 1.5f;
 
 	if( pm->cmd.buttons & BUTTON_SPECIAL ) {
 		maxspeed *= 2;
 	}
 
 	// friction
-	float speed = Length( pml.velocity );
+	float speed = Length( pm->pml.velocity );
 	if( speed < 1 ) {
-		pml.velocity = Vec3( 0.0f );
+		pm->pml.velocity = Vec3( 0.0f );
 	} else {
 		float drop = 0;
 
 		float friction = pm_friction * 1.5f; // extra friction
 		float control = speed < pm_decelerate ? pm_decelerate : speed;
-		drop += control * friction * pml.frametime;
+		drop += control * friction * pm->pml.frametime;
 
 		// scale the velocity
 		float newspeed = Max2( 0.0f, speed - drop );
-		pml.velocity *= newspeed / speed;
+		pm->pml.velocity *= newspeed / speed;
 	}
 
 	// accelerate
-	float fmove = pml.forwardPush;
-	float smove = pml.sidePush;
+	float fmove = pm->pml.forwardPush;
+	float smove = pm->pml.sidePush;
 
 	if( pm->cmd.buttons & BUTTON_SPECIAL ) {
 		fmove *= 2;
 		smove *= 2;
 	}
 
-	Vec3 wishvel = pml.forward * fmove + pml.right * smove;
-	wishvel.z += pml.upPush;
+	Vec3 wishvel = pm->pml.forward * fmove + pm->pml.right * smove;
+	wishvel.z += pm->pml.upPush;
 
 	Vec3 wishdir = wishvel;
 	float wishspeed = Length( wishdir );
@@ -1041,30 +1022,30 @@ static void PM_FlyMove( bool doclip ) {
 		wishspeed = maxspeed;
 	}
 
-	float currentspeed = Dot( pml.velocity, wishdir );
+	float currentspeed = Dot( pm->pml.velocity, wishdir );
 	float addspeed = wishspeed - currentspeed;
 	if( addspeed > 0 ) {
-		float accelspeed = pm_accelerate * pml.frametime * wishspeed;
+		float accelspeed = pm_accelerate * pm->pml.frametime * wishspeed;
 		if( accelspeed > addspeed ) {
 			accelspeed = addspeed;
 		}
 
-		pml.velocity += accelspeed * wishdir;
+		pm->pml.velocity += accelspeed * wishdir;
 	}
 
 	if( doclip ) {
-		Vec3 end = pml.origin + pml.frametime * pml.velocity;
+		Vec3 end = pm->pml.origin + pm->pml.frametime * pm->pml.velocity;
 
-		pmove_gs->api.Trace( &trace, pml.origin, pm->mins, pm->maxs, end, pm->playerState->POVnum, pm->contentmask, 0 );
+		pm->gs->api.Trace( &trace, pm->pml.origin, pm->mins, pm->maxs, end, pm->playerState->POVnum, pm->contentmask, 0 );
 
-		pml.origin = trace.endpos;
+		pm->pml.origin = trace.endpos;
 	} else {
 		// move
-		pml.origin += pml.velocity * pml.frametime;
+		pm->pml.origin += pm->pml.velocity * pm->pml.frametime;
 	}
 }
 
-static void PM_AdjustBBox() {
+static void PM_AdjustBBox( pmove_t *pm ) {
 	float crouchFrac;
 	trace_t trace;
 
@@ -1079,13 +1060,13 @@ static void PM_AdjustBBox() {
 		pm->playerState->viewheight = playerbox_stand_viewheight;
 	}
 
-	if( pml.upPush < 0 && ( pm->playerState->pmove.features & PMFEAT_CROUCH ) ) {
-		if( pm->playerState->pmove.crouch_time == 0 && pmove_gs->gameState.round_state >= RoundState_Finished ) {
+	if( pm->pml.upPush < 0 && ( pm->playerState->pmove.features & PMFEAT_CROUCH ) ) {
+		if( pm->playerState->pmove.crouch_time == 0 && pm->gs->gameState.round_state >= RoundState_Finished ) {
 			pm->playerState->pmove.tbag_time = Min2( pm->playerState->pmove.tbag_time + TBAG_AMOUNT_PER_CROUCH, int( MAX_TBAG_TIME ) );
 
 			if( pm->playerState->pmove.tbag_time >= TBAG_THRESHOLD ) {
 				float frac = Unlerp( TBAG_THRESHOLD, pm->playerState->pmove.tbag_time, MAX_TBAG_TIME );
-				pmove_gs->api.PredictedEvent( pm->playerState->POVnum, EV_TBAG, frac * 255 );
+				PM_PredictedEvent( pm, EV_TBAG, frac * 255 );
 			}
 		}
 
@@ -1127,7 +1108,7 @@ static void PM_AdjustBBox() {
 		wishviewheight = playerbox_stand_viewheight - ( crouchFrac * ( playerbox_stand_viewheight - playerbox_crouch_viewheight ) );
 
 		// check that the head is not blocked
-		pmove_gs->api.Trace( &trace, pml.origin, wishmins, wishmaxs, pml.origin, pm->playerState->POVnum, pm->contentmask, 0 );
+		pm->gs->api.Trace( &trace, pm->pml.origin, wishmins, wishmaxs, pm->pml.origin, pm->playerState->POVnum, pm->contentmask, 0 );
 		if( trace.allsolid || trace.startsolid ) {
 			// can't do the uncrouching, let the time alone and use old position
 			pm->mins = curmins;
@@ -1150,8 +1131,8 @@ static void PM_AdjustBBox() {
 	pm->playerState->viewheight = playerbox_stand_viewheight;
 }
 
-static void PM_UpdateDeltaAngles() {
-	if( pmove_gs->module != GS_MODULE_GAME ) {
+static void PM_UpdateDeltaAngles( pmove_t *pm ) {
+	if( pm->gs->module != GS_MODULE_GAME ) {
 		return;
 	}
 
@@ -1160,7 +1141,7 @@ static void PM_UpdateDeltaAngles() {
 	}
 }
 
-static void PM_ApplyMouseAnglesClamp() {
+static void PM_ApplyMouseAnglesClamp( pmove_t *pm ) {
 	for( int i = 0; i < 3; i++ ) {
 		s16 temp = pm->cmd.angles[i] + pm->playerState->pmove.delta_angles[i];
 		if( i == PITCH ) {
@@ -1177,12 +1158,12 @@ static void PM_ApplyMouseAnglesClamp() {
 		pm->playerState->viewangles[i] = SHORT2ANGLE( (short)temp );
 	}
 
-	AngleVectors( pm->playerState->viewangles, &pml.forward, &pml.right, &pml.up );
+	AngleVectors( pm->playerState->viewangles, &pm->pml.forward, &pm->pml.right, &pm->pml.up );
 
-	pml.flatforward = Normalize( Vec3( pml.forward.xy(), 0.0f ) );
+	pm->pml.flatforward = Normalize( Vec3( pm->pml.forward.xy(), 0.0f ) );
 }
 
-static void PM_BeginMove() {
+static void PM_BeginMove( pmove_t *pm ) {
 	// clear results
 	pm->numtouch = 0;
 	pm->groundentity = -1;
@@ -1191,78 +1172,79 @@ static void PM_BeginMove() {
 	pm->step = 0;
 
 	// clear all pmove local vars
-	memset( &pml, 0, sizeof( pml ) );
+	memset( &pm->pml, 0, sizeof( pm->pml ) );
 
-	pml.origin = pm->playerState->pmove.origin;
-	pml.velocity = pm->playerState->pmove.velocity;
+	pm->pml.origin = pm->playerState->pmove.origin;
+	pm->pml.velocity = pm->playerState->pmove.velocity;
 
 	// save old org in case we get stuck
-	pml.previous_origin = pm->playerState->pmove.origin;
+	pm->pml.previous_origin = pm->playerState->pmove.origin;
 }
 
-static void PM_EndMove() {
-	pm->playerState->pmove.origin = pml.origin;
-	pm->playerState->pmove.velocity = pml.velocity;
+static void PM_EndMove( pmove_t *pm ) {
+	pm->playerState->pmove.origin = pm->pml.origin;
+	pm->playerState->pmove.velocity = pm->pml.velocity;
 }
 
-void Pmove( const gs_state_t * gs, pmove_t *pmove ) {
+void PmoveMove( const gs_state_t * gs, pmove_t *pm ) {
 	ZoneScoped;
 
-	if( !pmove->playerState ) {
+	pm->gs = gs;
+	pm->numevents = 0;
+	pm->touchTriggers = false;
+
+	if( !pm->playerState ) {
 		return;
 	}
 
-	pm = pmove;
-	pmove_gs = gs;
-
 	SyncPlayerState * ps = pm->playerState;
 
 	// clear all pmove local vars
-	PM_BeginMove();
+	PM_BeginMove( pm );
 
-	float fallvelocity = Max2( 0.0f, -pml.velocity.z );
+	pm->fallvelocity = Max2( 0.0f, -pm->pml.velocity.z );
 
-	pml.frametime = pm->cmd.msec * 0.001;
+	pm->pml.frametime = pm->cmd.msec * 0.001;
 
-	pml.maxPlayerSpeed = ps->pmove.max_speed;
-	if( pml.maxPlayerSpeed < 0 ) {
-		pml.maxPlayerSpeed = DEFAULT_PLAYERSPEED;
+	pm->pml.maxPlayerSpeed = ps->pmove.max_speed;
+	if( pm->pml.maxPlayerSpeed < 0 ) {
+		pm->pml.maxPlayerSpeed = DEFAULT_PLAYERSPEED;
 	}
 
-	pml.jumpPlayerSpeed = (float)ps->pmove.jump_speed * GRAVITY_COMPENSATE;
-	pml.jumpPlayerSpeedWater = pml.jumpPlayerSpeed * 2;
+	pm->pml.jumpPlayerSpeed = (float)ps->pmove.jump_speed * GRAVITY_COMPENSATE;
+	pm->pml.jumpPlayerSpeedWater = pm->pml.jumpPlayerSpeed * 2;
 
-	if( pml.jumpPlayerSpeed < 0 ) {
-		pml.jumpPlayerSpeed = DEFAULT_JUMPSPEED * GRAVITY_COMPENSATE;
+	if( pm->pml.jumpPlayerSpeed < 0 ) {
+		pm->pml.jumpPlayerSpeed = DEFAULT_JUMPSPEED * GRAVITY_COMPENSATE;
 	}
 
-	pml.dashPlayerSpeed = ps->pmove.dash_speed;
-	if( pml.dashPlayerSpeed < 0 ) {
-		pml.dashPlayerSpeed = DEFAULT_DASHSPEED;
+	pm->pml.dashPlayerSpeed = ps->pmove.dash_speed;
+	if( pm->pml.dashPlayerSpeed < 0 ) {
+		pm->pml.dashPlayerSpeed = DEFAULT_DASHSPEED;
 	}
 
-	pml.maxWalkSpeed = DEFAULT_WALKSPEED;
-	if( pml.maxWalkSpeed > pml.maxPlayerSpeed * 0.66f ) {
-		pml.maxWalkSpeed = pml.maxPlayerSpeed * 0.66f;
+	pm->pml.maxWalkSpeed = DEFAULT_WALKSPEED;
+	if( pm->pml.maxWalkSpeed > pm->pml.maxPlayerSpeed * 0.66f ) {
+		pm->pml.maxWalkSpeed = pm->pml.maxPlayerSpeed * 0.66f;
 	}
 
-	pml.maxCrouchedSpeed = DEFAULT_CROUCHEDSPEED;
-	if( pml.maxCrouchedSpeed > pml.maxPlayerSpeed * 0.5f ) {
-		pml.maxCrouchedSpeed = pml.maxPlayerSpeed * 0.5f;
+	pm->pml.maxCrouchedSpeed = DEFAULT_CROUCHEDSPEED;
+	if( pm->pml.maxCrouchedSpeed > pm->pml.maxPlayerSpeed * 0.5f ) {
+		pm->pml.maxCrouchedSpeed = pm->pml.maxPlayerSpeed * 0.5f;
 	}
 
 	// assign a contentmask for the movement type
 	switch( ps->pmove.pm_type ) {
 		case PM_FREEZE:
 		case PM_CHASECAM:
-			if( pmove_gs->module == GS_MODULE_GAME ) {
+			if( pm->gs->module == GS_MODULE_GAME ) {
 				ps->pmove.pm_flags |= PMF_NO_PREDICTION;
 			}
 			pm->contentmask = 0;
 			break;
 
 		case PM_SPECTATOR:
-			if( pmove_gs->module == GS_MODULE_GAME ) {
+			if( pm->gs->module == GS_MODULE_GAME ) {
 				ps->pmove.pm_flags &= ~PMF_NO_PREDICTION;
 			}
 			pm->contentmask = MASK_DEADSOLID;
@@ -1270,13 +1252,13 @@ void Pmove( const gs_state_t * gs, pmove_t *pmove ) {
 
 		default:
 		case PM_NORMAL:
-			if( pmove_gs->module == GS_MODULE_GAME ) {
+			if( pm->gs->module == GS_MODULE_GAME ) {
 				ps->pmove.pm_flags &= ~PMF_NO_PREDICTION;
 			}
 			if( ps->pmove.features & PMFEAT_GHOSTMOVE ) {
 				pm->contentmask = MASK_DEADSOLID;
 			} else if( ps->pmove.features & PMFEAT_TEAMGHOST ) {
-				int team = pmove_gs->api.GetEntityState( ps->POVnum, 0 )->team;
+				int team = pm->gs->api.GetEntityState( ps->POVnum, 0 )->team;
 				pm->contentmask = team == TEAM_ALPHA ? MASK_ALPHAPLAYERSOLID : MASK_BETAPLAYERSOLID;
 			} else {
 				pm->contentmask = MASK_PLAYERSOLID;
@@ -1284,7 +1266,7 @@ void Pmove( const gs_state_t * gs, pmove_t *pmove ) {
 			break;
 	}
 
-	if( !GS_MatchPaused( pmove_gs ) ) {
+	if( !GS_MatchPaused( pm->gs ) ) {
 		// drop timing counters
 		if( ps->pmove.pm_time ) {
 			int msec;
@@ -1308,76 +1290,76 @@ void Pmove( const gs_state_t * gs, pmove_t *pmove ) {
 		// crouch_time is handled at PM_AdjustBBox
 	}
 
-	pml.forwardPush = pm->cmd.forwardmove * SPEEDKEY / 127.0f;
-	pml.sidePush = pm->cmd.sidemove * SPEEDKEY / 127.0f;
-	pml.upPush = pm->cmd.upmove * SPEEDKEY / 127.0f;
+	pm->pml.forwardPush = pm->cmd.forwardmove * SPEEDKEY / 127.0f;
+	pm->pml.sidePush = pm->cmd.sidemove * SPEEDKEY / 127.0f;
+	pm->pml.upPush = pm->cmd.upmove * SPEEDKEY / 127.0f;
 
 	if( ps->pmove.pm_type != PM_NORMAL ) { // includes dead, freeze, chasecam...
-		if( !GS_MatchPaused( pmove_gs ) ) {
-			PM_ClearDash();
+		if( !GS_MatchPaused( pm->gs ) ) {
+			PM_ClearDash( pm );
 
-			PM_ClearWallJump();
+			PM_ClearWallJump( pm );
 
 			ps->pmove.knockback_time = 0;
 			ps->pmove.crouch_time = 0;
 			ps->pmove.tbag_time = 0;
 			ps->pmove.pm_flags &= ~( PMF_JUMPPAD_TIME | PMF_DOUBLEJUMPED | PMF_TIME_WATERJUMP | PMF_TIME_LAND | PMF_TIME_TELEPORT | PMF_SPECIAL_HELD );
 
-			PM_AdjustBBox();
+			PM_AdjustBBox( pm );
 		}
 
 		if( ps->pmove.pm_type == PM_SPECTATOR ) {
-			PM_ApplyMouseAnglesClamp();
+			PM_ApplyMouseAnglesClamp( pm );
 
-			PM_FlyMove( false );
+			PM_FlyMove( pm, false );
 		} else {
-			pml.forwardPush = 0;
-			pml.sidePush = 0;
-			pml.upPush = 0;
+			pm->pml.forwardPush = 0;
+			pm->pml.sidePush = 0;
+			pm->pml.upPush = 0;
 		}
 
-		PM_EndMove();
+		PM_EndMove( pm );
 		return;
 	}
 
-	PM_ApplyMouseAnglesClamp();
+	PM_ApplyMouseAnglesClamp( pm );
 
 	// set mins, maxs, viewheight amd fov
-	PM_AdjustBBox();
+	PM_AdjustBBox( pm );
 
 	// set groundentity, watertype, and waterlevel
-	PM_CategorizePosition();
+	PM_CategorizePosition( pm );
 
-	int oldGroundEntity = pm->groundentity;
+	pm->oldGroundEntity = pm->groundentity;
 
-	PM_CheckSpecialMovement();
+	PM_CheckSpecialMovement( pm );
 
 	if( ps->pmove.pm_flags & PMF_TIME_TELEPORT ) {
 		// teleport pause stays exactly in place
 	} else if( ps->pmove.pm_flags & PMF_TIME_WATERJUMP ) {
 		// waterjump has no control, but falls
-		pml.velocity.z -= GRAVITY * pml.frametime;
-		if( pml.velocity.z < 0 ) {
+		pm->pml.velocity.z -= GRAVITY * pm->pml.frametime;
+		if( pm->pml.velocity.z < 0 ) {
 			// cancel as soon as we are falling down again
 			ps->pmove.pm_flags &= ~( PMF_TIME_WATERJUMP | PMF_TIME_LAND | PMF_TIME_TELEPORT );
 			ps->pmove.pm_time = 0;
 		}
 
-		PM_StepSlideMove();
+		PM_StepSlideMove( pm );
 	} else {
 		// Kurim
 		// Keep this order !
-		PM_CheckJump();
+		PM_CheckJump( pm );
 
 		if( GS_GetWeaponDef( ps->weapon )->zoom_fov == 0 || ( ps->pmove.features & PMFEAT_SCOPE ) == 0 ) {
-			PM_CheckDash();
-			PM_CheckWallJump();
+			PM_CheckDash( pm );
+			PM_CheckWallJump( pm );
 		}
 
-		PM_Friction();
+		PM_Friction( pm );
 
 		if( pm->waterlevel >= 2 ) {
-			PM_WaterMove();
+			PM_WaterMove( pm );
 		} else {
 			Vec3 angles = ps->viewangles;
 			if( angles.x > 180 ) {
@@ -1385,40 +1367,57 @@ void Pmove( const gs_state_t * gs, pmove_t *pmove ) {
 			}
 			angles.x /= 3;
 
-			AngleVectors( angles, &pml.forward, &pml.right, &pml.up );
+			AngleVectors( angles, &pm->pml.forward, &pm->pml.right, &pm->pml.up );
 
 			// hack to work when looking straight up and straight down
-			if( pml.forward.z == -1.0f ) {
-				pml.flatforward = pml.up;
-			} else if( pml.forward.z == 1.0f ) {
-				pml.flatforward = -pml.up;
+			if( pm->pml.forward.z == -1.0f ) {
+				pm->pml.flatforward = pm->pml.up;
+			} else if( pm->pml.forward.z == 1.0f ) {
+				pm->pml.flatforward = -pm->pml.up;
 			} else {
-				pml.flatforward = pml.forward;
+				pm->pml.flatforward = pm->pml.forward;
 			}
-			pml.flatforward.z = 0.0f;
-			pml.flatforward = SafeNormalize( pml.flatforward );
+			pm->pml.flatforward.z = 0.0f;
+			pm->pml.flatforward = SafeNormalize( pm->pml.flatforward );
 
-			PM_Move();
+			PM_Move( pm );
 		}
 	}
 
 	// set groundentity, watertype, and waterlevel for final spot
-	PM_CategorizePosition();
+	PM_CategorizePosition( pm );
+
+	PM_EndMove( pm );
+
+	pm->touchTriggers = true;
+}
+
+void PmoveFinish( pmove_t *pm ) {
+	ZoneScoped;
+
+	for( int i = 0; i < pm->numevents; i++ ) {
+		pm->gs->api.PredictedEvent( pm->playerState->POVnum, pm->events[i].ev, pm->events[i].parm );
+	}
+	pm->numevents = 0;
+
+	if( !pm->touchTriggers ) {
+		return;
+	}
 
-	PM_EndMove();
+	SyncPlayerState * ps = pm->playerState;
 
 	// Execute the triggers that are touched.
 	// We check the entire path between the origin before the pmove and the
 	// current origin to ensure no triggers are missed at high velocity.
 	// Note that this method assumes the movement has been linear.
-	pmove_gs->api.PMoveTouchTriggers( pm, pml.previous_origin );
+	pm->gs->api.PMoveTouchTriggers( pm, pm->pml.previous_origin );
 
-	PM_UpdateDeltaAngles(); // in case some trigger action has moved the view angles (like teleported).
+	PM_UpdateDeltaAngles( pm ); // in case some trigger action has moved the view angles (like teleported).
 
 	// touching triggers may force groundentity off
 	if( !( ps->pmove.pm_flags & PMF_ON_GROUND ) && pm->groundentity != -1 ) {
 		pm->groundentity = -1;
-		pml.velocity.z = 0;
+		pm->pml.velocity.z = 0;
 	}
 
 	if( pm->groundentity != -1 ) { // remove wall-jump and dash bits when touching ground
@@ -1428,15 +1427,15 @@ void Pmove( const gs_state_t * gs, pmove_t *pmove ) {
 		}
 
 		if( ps->pmove.walljump_time < PM_WALLJUMP_TIMEDELAY - 50 ) {
-			PM_ClearWallJump();
+			PM_ClearWallJump( pm );
 		}
 	}
 
-	if( oldGroundEntity == -1 ) {
+	if( pm->oldGroundEntity == -1 ) {
 		constexpr float min_fall_velocity = 200;
 		constexpr float max_fall_velocity = 800;
 
-		float fall_delta = fallvelocity - Max2( 0.0f, -pml.velocity.z );
+		float fall_delta = pm->fallvelocity - Max2( 0.0f, -pm->pml.velocity.z );
 
 		// scale velocity if in water
 		if( pm->waterlevel == 3 ) {
@@ -1451,9 +1450,14 @@ void Pmove( const gs_state_t * gs, pmove_t *pmove ) {
 
 		float frac = Unlerp01( min_fall_velocity, fall_delta, max_fall_velocity );
 		if( frac > 0 ) {
-			pmove_gs->api.PredictedEvent( ps->POVnum, EV_FALL, frac * 255 );
+			pm->gs->api.PredictedEvent( ps->POVnum, EV_FALL, frac * 255 );
 		}
 
 		ps->pmove.pm_flags &= ~PMF_JUMPPAD_TIME;
 	}
 }
+
+void Pmove( const gs_state_t * gs, pmove_t *pmove ) {
+	PmoveMove( gs, pmove );
+	PmoveFinish( pmove );
+}
@@ -60,6 +60,44 @@ enum {
 };
 
 #define MAXTOUCH    32
+#define MAX_PMOVE_EVENTS 8
+
+// all of the locals will be zeroed before each
+// pmove, just to make damn sure we don't have
+// any differences when running on client or server
+
+struct pml_t {
+	Vec3 origin;          // full float precision
+	Vec3 velocity;        // full float precision
+
+	Vec3 forward, right, up;
+	Vec3 flatforward;     // normalized forward without z component, saved here because it needs
+	// special handling for looking straight up or down
+	float frametime;
+
+	int groundsurfFlags;
+	cplane_t groundplane;
+	int groundcontents;
+
+	Vec3 previous_origin;
+	bool ladder;
+
+	float forwardPush, sidePush, upPush;
+
+	float maxPlayerSpeed;
+	float maxWalkSpeed;
+	float maxCrouchedSpeed;
+	float jumpPlayerSpeed;
+	float jumpPlayerSpeedWater;
+	float dashPlayerSpeed;
+};
+
+struct pmove_event_t {
+	int ev;
+	u64 parm;
+};
+
+struct gs_state_t;
 
 struct pmove_t {
 	// state (in / out)
@@ -82,6 +120,18 @@ struct pmove_t {
 	int contentmask;
 
 	bool ladder;
+
+	// working state, kept here so moves for different players don't share
+	// anything and can run at the same time
+	const gs_state_t *gs;
+	pml_t pml;
+	float fallvelocity;
+	int oldGroundEntity;
+	bool touchTriggers;
+
+	// predicted events are held until PmoveFinish
+	int numevents;
+	pmove_event_t events[MAX_PMOVE_EVENTS];
 };
 
 struct gs_module_api_t {
@@ -152,6 +202,13 @@ void GS_LinearMovementDelta( const SyncEntityState *ent, int64_t oldTime, int64_
 
 void Pmove( const gs_state_t * gs, pmove_t *pmove );
 
+// Pmove in two halves. PmoveMove only writes to the pmove and its
+// playerstate, so moves for different players can run in parallel.
+// PmoveFinish fires the predicted events and touches triggers, and has to
+// run serially in the order the moves would have been made
+void PmoveMove( const gs_state_t * gs, pmove_t *pmove );
+void PmoveFinish( pmove_t *pmove );
+
 //===============================================================
 
 #define HEALTH_TO_INT( x )    ( ( x ) < 1.0f ? (int)ceilf( ( x ) ) : (int)floorf( ( x ) + 0.5f ) )
@@ -0,0 +1,913 @@
+#include "qcommon/qcommon.h"
+#include "qcommon/array.h"
+#include "qcommon/cmodel.h"
+#include "qcommon/compression.h"
+#include "qcommon/csprng.h"
+#include "qcommon/fs.h"
+#include "qcommon/hash.h"
+#include "qcommon/metrics.h"
+#include "qcommon/rng.h"
+#include "qcommon/version.h"
+#include "gameshared/gs_public.h"
+#include "cgame/cg_public.h"
+
+/*
+ * loadgen connects lots of real network clients to a server so the snapshot
+ * build/encode/compress/send path gets exercised, which bots skip entirely.
+ *
+ * Each client has its own UDP socket and netchan and speaks the same protocol
+ * as the real client: challenge/connect, new/configstrings/baselines/begin,
+ * then delta acked snapshots parsed with SNAP_ParseFrame and usercmds at the
+ * client's rate. Clients predict themselves with Pmove against the map's
+ * collision model to steer away from walls, and hold attack in bursts.
+ *
+ * Usage: loadgen +loadgen <address> [clients]
+ * The server needs sv_iplimit 0, and only takes sv_maxclients of them.
+ */
+
+snapshot_t *SNAP_ParseFrame( msg_t *msg, snapshot_t *lastFrame, snapshot_t *backup, SyncEntityState *baselines, int showNet );
+void SNAP_ParseBaseline( msg_t *msg, SyncEntityState *baselines );
+
+static constexpr int LOADGEN_UCMD_FPS = 62;
+static constexpr int LOADGEN_MAX_CLIENTS = 1024;
+static constexpr int64_t LOADGEN_RESEND_TIME = 1000;
+static constexpr int64_t LOADGEN_REJECT_BACKOFF = 3000;
+static constexpr int64_t LOADGEN_TIMEOUT = 10000;
+
+enum LoadGenClientState {
+	LoadGenClient_Disconnected,
+	LoadGenClient_Connecting,
+	LoadGenClient_Handshake,
+	LoadGenClient_Connected,
+	LoadGenClient_Active,
+};
+
+struct LoadGenStats {
+	u32 snaps;
+	u32 packets_received;
+	u32 packets_sent;
+	u64 bytes_received;
+	u64 bytes_sent;
+};
+
+struct LoadGenClient {
+	LoadGenClientState state;
+	int num;
+
+	socket_t socket;
+	netchan_t netchan;
+	u64 session_id;
+	int64_t connect_time;
+	int64_t retry_time;
+
+	char reliable_commands[ MAX_RELIABLE_COMMANDS ][ MAX_STRING_CHARS ];
+	int64_t reliable_sequence;
+	int64_t reliable_acknowledge;
+	int64_t last_executed_server_command;
+
+	int servercount;
+	int playernum;
+	int64_t snap_frame_time;
+
+	snapshot_t * snapshots; // [UPDATE_BACKUP]
+	SyncEntityState * baselines; // [MAX_EDICTS]
+	int64_t received_snap_num;
+	int64_t snap_server_time;
+	int64_t snap_received_time;
+	int64_t ucmd_executed;
+
+	usercmd_t cmds[ CMD_BACKUP ];
+	int64_t cmd_sent_time[ CMD_BACKUP ];
+	int64_t ucmd_head;
+	int64_t ucmd_sent;
+	int64_t ucmd_acknowledged;
+	int64_t last_ucmd_time;
+
+	int64_t last_packet_sent_time;
+	int64_t last_packet_received_time;
+
+	float yaw;
+	float yaw_speed;
+	int64_t next_turn_time;
+	bool attacking;
+	int64_t next_attack_toggle_time;
+	bool joined;
+
+	LoadGenStats stats;
+};
+
+static cvar_t * loadgen_movement;
+static cvar_t * loadgen_fire;
+static cvar_t * loadgen_pps;
+static cvar_t * loadgen_report;
+
+static LoadGenClient * clients;
+static int num_clients;
+static netadr_t server_address;
+static RNG rng;
+static ArenaAllocator frame_arena;
+
+static int64_t realtime;
+static int64_t last_report_time;
+
+static NonRAIIDynamicArray< s64 > latency_samples;
+static NonRAIIDynamicArray< s64 > pmove_samples;
+
+static CollisionModel * collision_model;
+static char collision_map[ MAX_QPATH ];
+static gs_state_t loadgen_gs;
+
+// the client whose packet is being parsed, so ERR_DROPs can drop just that one
+static LoadGenClient * parsing_client;
+
+/*
+==============================================================================
+
+PREDICTION
+
+==============================================================================
+*/
+
+static void LG_GS_Trace( trace_t * t, Vec3 start, Vec3 mins, Vec3 maxs, Vec3 end, int ignore, int contentmask, int timeDelta ) {
+	CM_TransformedBoxTrace( CM_Client, collision_model, t, start, end, mins, maxs, NULL, contentmask, Vec3( 0.0f ), Vec3( 0.0f ) );
+	t->ent = t->fraction < 1.0f ? 0 : -1;
+}
+
+static SyncEntityState * LG_GS_GetEntityState( int entNum, int deltaTime ) {
+	static SyncEntityState world;
+	return &world;
+}
+
+static int LG_GS_PointContents( Vec3 point, int timeDelta ) {
+	return CM_TransformedPointContents( CM_Client, collision_model, point, NULL, Vec3( 0.0f ), Vec3( 0.0f ) );
+}
+
+static void LG_GS_PredictedEvent( int entNum, int ev, u64 parm ) { }
+static void LG_GS_PredictedFireWeapon( int entNum, u64 weapon_and_entropy ) { }
+static void LG_GS_PMoveTouchTriggers( pmove_t * pm, Vec3 previous_origin ) { }
+
+static void LG_LoadCollisionModel( const char * mapname ) {
+	if( collision_model != NULL && strcmp( collision_map, mapname ) == 0 ) {
+		return;
+	}
+
+	if( collision_model != NULL ) {
+		CM_Free( CM_Client, collision_model );
+		collision_model = NULL;
+	}
+	Q_strncpyz( collision_map, mapname, sizeof( collision_map ) );
+
+	TempAllocator temp = frame_arena.temp();
+
+	const char * bsp_path = temp( "{}/base/maps/{}.bsp", RootDirPath(), mapname );
+	Span< u8 > data = ReadFileBinary( sys_allocator, bsp_path );
+	defer { FREE( sys_allocator, data.ptr ); };
+
+	if( data.ptr == NULL ) {
+		const char * zst_path = temp( "{}.zst", bsp_path );
+		Span< u8 > compressed = ReadFileBinary( sys_allocator, zst_path );
+		defer { FREE( sys_allocator, compressed.ptr ); };
+		if( compressed.ptr == NULL || !Decompress( zst_path, sys_allocator, compressed, &data ) ) {
+			Com_Printf( S_COLOR_YELLOW "Couldn't load map %s, clients won't predict\n", mapname );
+			return;
+		}
+	}
+
+	collision_model = CM_LoadMap( CM_Client, data, Hash64( temp( "maps/{}", mapname ) ) );
+}
+
+/*
+* LG_Predict
+*
+* Runs the unacknowledged usercmds on top of the latest snapshot like the
+* client does every frame, and returns where the player will end up.
+*/
+static SyncPlayerState LG_Predict( LoadGenClient * client ) {
+	const snapshot_t * snap = &client->snapshots[ client->received_snap_num & UPDATE_MASK ];
+
+	SyncPlayerState ps = snap->playerState;
+	ps.POVnum = client->playernum + 1;
+
+	if( collision_model == NULL || client->ucmd_head - client->ucmd_executed >= CMD_BACKUP ) {
+		return ps;
+	}
+
+	u64 start = Sys_Microseconds();
+
+	loadgen_gs.gameState = snap->gameState;
+
+	pmove_t pm = { };
+	pm.playerState = &ps;
+
+	for( int64_t i = client->ucmd_executed + 1; i <= client->ucmd_head; i++ ) {
+		pm.cmd = client->cmds[ i & CMD_MASK ];
+		Pmove( &loadgen_gs, &pm );
+	}
+
+	pmove_samples.add( Sys_Microseconds() - start );
+
+	return ps;
+}
+
+/*
+==============================================================================
+
+INPUT
+
+==============================================================================
+*/
+
+static void LG_UpdateAttack( LoadGenClient * client ) {
+	if( realtime < client->next_attack_toggle_time ) {
+		return;
+	}
+
+	float fraction = Clamp01( loadgen_fire->value );
+	if( fraction <= 0.0f || fraction >= 1.0f ) {
+		client->attacking = fraction >= 1.0f;
+		client->next_attack_toggle_time = realtime + 1000;
+		return;
+	}
+
+	// bursts of 0.2-1.5s, spaced out so we hold attack for the requested fraction of the time
+	float burst = RandomUniformFloat( &rng, 200.0f, 1500.0f );
+	client->attacking = !client->attacking;
+	client->next_attack_toggle_time = realtime + int64_t( client->attacking ? burst : burst * ( 1.0f - fraction ) / fraction );
+}
+
+static void LG_UpdateMovement( LoadGenClient * client, usercmd_t * cmd, const SyncPlayerState * predicted, int msec ) {
+	const char * mode = loadgen_movement->string;
+
+	if( strcmp( mode, "idle" ) == 0 ) {
+		return;
+	}
+
+	if( strcmp( mode, "circle" ) == 0 ) {
+		client->yaw += 90.0f * msec * 0.001f;
+		cmd->forwardmove = 127;
+		return;
+	}
+
+	// random: run around, turning every so often and whenever prediction says we're about to hit a wall
+	bool blocked = false;
+	if( collision_model != NULL ) {
+		Vec3 forward = Vec3( cosf( Radians( client->yaw ) ), sinf( Radians( client->yaw ) ), 0.0f );
+		Vec3 start = predicted->pmove.origin;
+		trace_t trace;
+		LG_GS_Trace( &trace, start, playerbox_stand_mins, playerbox_stand_maxs, start + forward * 64.0f, 0, MASK_PLAYERSOLID, 0 );
+		blocked = trace.fraction < 1.0f;
+	}
+
+	if( blocked || realtime >= client->next_turn_time ) {
+		client->yaw_speed = RandomFloat11( &rng ) * 180.0f;
+		if( blocked ) {
+			client->yaw += RandomUniformFloat( &rng, 90.0f, 270.0f );
+		}
+		client->next_turn_time = realtime + RandomUniform( &rng, 500, 3000 );
+	}
+
+	client->yaw += client->yaw_speed * msec * 0.001f;
+	cmd->forwardmove = 127;
+	cmd->sidemove = client->yaw_speed > 90.0f ? 127 : client->yaw_speed < -90.0f ? -127 : 0;
+	if( Probability( &rng, 0.02f ) ) {
+		cmd->upmove = 127;
+	}
+}
+
+static void LG_CreateUserCommand( LoadGenClient * client ) {
+	int64_t msec = realtime - client->last_ucmd_time;
+	client->last_ucmd_time = realtime;
+
+	SyncPlayerState predicted = LG_Predict( client );
+
+	client->ucmd_head++;
+	usercmd_t * cmd = &client->cmds[ client->ucmd_head & CMD_MASK ];
+	const usercmd_t * prev = &client->cmds[ ( client->ucmd_head - 1 ) & CMD_MASK ];
+	*cmd = { };
+
+	// the server runs the player forward by the difference between usercmd timestamps
+	int64_t server_time = client->snap_server_time + ( realtime - client->snap_received_time ) - client->snap_frame_time / 2;
+	cmd->serverTimeStamp = Max2( server_time, prev->serverTimeStamp + 1 );
+	cmd->msec = Clamp( int64_t( 1 ), cmd->serverTimeStamp - prev->serverTimeStamp, int64_t( 200 ) );
+	cmd->entropy = Random32( &rng );
+
+	LG_UpdateAttack( client );
+	if( client->attacking ) {
+		cmd->buttons |= BUTTON_ATTACK;
+	}
+
+	LG_UpdateMovement( client, cmd, &predicted, msec );
+
+	cmd->angles[ YAW ] = ANGLE2SHORT( AngleNormalize360( client->yaw ) );
+
+	client->cmd_sent_time[ client->ucmd_head & CMD_MASK ] = 0;
+}
+
+/*
+==============================================================================
+
+NETWORK
+
+==============================================================================
+*/
+
+static void LG_AddReliableCommand( LoadGenClient * client, const char * cmd ) {
+	if( client->reliable_sequence > client->reliable_acknowledge + MAX_RELIABLE_COMMANDS ) {
+		Com_Printf( "loadgen%d: client command overflow\n", client->num );
+		return;
+	}
+
+	client->reliable_sequence++;
+	Q_strncpyz( client->reliable_commands[ client->reliable_sequence & ( MAX_RELIABLE_COMMANDS - 1 ) ], cmd, MAX_STRING_CHARS );
+}
+
+static void LG_Transmit( LoadGenClient * client, msg_t * msg ) {
+	Netchan_PushAllFragments( &client->netchan );
+
+	if( msg->cursize > 60 ) {
+		Netchan_CompressMessage( msg );
+	}
+
+	Netchan_Transmit( &client->netchan, msg );
+
+	client->last_packet_sent_time = realtime;
+	client->stats.packets_sent++;
+	client->stats.bytes_sent += msg->cursize;
+}
+
+static void LG_WriteUserCommands( LoadGenClient * client, msg_t * msg ) {
+	int64_t first = Max2( client->ucmd_acknowledged + 1, client->ucmd_sent + 1 - 3 );
+	int64_t head = client->ucmd_head + 1;
+	if( head - first > CMD_MASK / 2 ) {
+		first = head - 3;
+	}
+
+	MSG_WriteUint8( msg, clc_move );
+	MSG_WriteInt32( msg, client->received_snap_num > 0 ? client->received_snap_num : -1 );
+	MSG_WriteInt32( msg, head );
+	MSG_WriteUint8( msg, head - first );
+
+	usercmd_t nullcmd = { };
+	const usercmd_t * oldcmd = &nullcmd;
+	for( int64_t i = first; i < head; i++ ) {
+		const usercmd_t * cmd = &client->cmds[ i & CMD_MASK ];
+		MSG_WriteDeltaUsercmd( msg, oldcmd, cmd );
+		oldcmd = cmd;
+
+		if( client->cmd_sent_time[ i & CMD_MASK ] == 0 ) {
+			client->cmd_sent_time[ i & CMD_MASK ] = realtime;
+		}
+	}
+
+	client->ucmd_sent = client->ucmd_head;
+}
+
+static void LG_SendMessage( LoadGenClient * client ) {
+	msg_t msg;
+	uint8_t msg_data[ MAX_MSGLEN ];
+	MSG_Init( &msg, msg_data, sizeof( msg_data ) );
+
+	MSG_WriteUint8( &msg, clc_svcack );
+	MSG_WriteIntBase128( &msg, client->last_executed_server_command );
+
+	for( int64_t i = client->reliable_acknowledge + 1; i <= client->reliable_sequence; i++ ) {
+		MSG_WriteUint8( &msg, clc_clientcommand );
+		MSG_WriteIntBase128( &msg, i );
+		MSG_WriteString( &msg, client->reliable_commands[ i & ( MAX_RELIABLE_COMMANDS - 1 ) ] );
+	}
+
+	if( client->state == LoadGenClient_Active ) {
+		LG_WriteUserCommands( client, &msg );
+	}
+
+	LG_Transmit( client, &msg );
+}
+
+static void LG_Connect( LoadGenClient * client ) {
+	netadr_t address;
+	NET_InitAddress( &address, server_address.type );
+	if( !NET_OpenSocket( &client->socket, SOCKET_UDP, &address, false ) ) {
+		Com_Printf( "loadgen%d: couldn't open UDP socket: %s\n", client->num, NET_ErrorString() );
+		client->retry_time = realtime + LOADGEN_REJECT_BACKOFF;
+		return;
+	}
+
+	CSPRNG_Bytes( &client->session_id, sizeof( client->session_id ) );
+
+	client->state = LoadGenClient_Connecting;
+	client->connect_time = realtime;
+	client->last_packet_received_time = realtime;
+
+	Netchan_OutOfBandPrint( &client->socket, &server_address, "getchallenge\n" );
+}
+
+static void LG_Disconnect( LoadGenClient * client, bool notify_server, int64_t retry_delay ) {
+	if( client->state >= LoadGenClient_Handshake && notify_server ) {
+		// send it a few times in case one gets dropped, like the client does
+		for( int i = 0; i < 3; i++ ) {
+			LG_AddReliableCommand( client, "disconnect" );
+			LG_SendMessage( client );
+		}
+	}
+
+	if( client->socket.open ) {
+		NET_CloseSocket( &client->socket );
+	}
+
+	FREE( sys_allocator, client->snapshots );
+	FREE( sys_allocator, client->baselines );
+
+	int num = client->num;
+	*client = { };
+	client->num = num;
+	client->retry_time = realtime + retry_delay;
+}
+
+static void LG_ConnectionlessPacket( LoadGenClient * client, msg_t * msg ) {
+	MSG_BeginReading( msg );
+	MSG_ReadInt32( msg ); // skip the -1
+
+	const char * s = MSG_ReadStringLine( msg );
+	Cmd_TokenizeString( s );
+	const char * c = Cmd_Argv( 0 );
+
+	if( client->state != LoadGenClient_Connecting ) {
+		return;
+	}
+
+	if( strcmp( c, "challenge" ) == 0 ) {
+		char userinfo[ MAX_INFO_STRING ] = "";
+		Info_SetValueForKey( userinfo, "name", va( "loadgen%d", client->num ) );
+
+		TempAllocator temp = frame_arena.temp();
+		Netchan_OutOfBandPrint( &client->socket, &server_address, "%s", temp( "connect {} {} {} \"{}\"\n",
+			APP_PROTOCOL_VERSION, client->session_id, Cmd_Argv( 1 ), userinfo ) );
+		client->connect_time = realtime;
+		return;
+	}
+
+	if( strcmp( c, "client_connect" ) == 0 ) {
+		Netchan_Setup( &client->netchan, &client->socket, &server_address, client->session_id );
+
+		client->snapshots = ALLOC_MANY( sys_allocator, snapshot_t, UPDATE_BACKUP );
+		client->baselines = ALLOC_MANY( sys_allocator, SyncEntityState, MAX_EDICTS );
+		memset( client->snapshots, 0, sizeof( snapshot_t ) * UPDATE_BACKUP );
+		memset( client->baselines, 0, sizeof( SyncEntityState ) * MAX_EDICTS );
+
+		client->state = LoadGenClient_Handshake;
+		LG_AddReliableCommand( client, "new" );
+		return;
+	}
+
+	if( strcmp( c, "reject" ) == 0 ) {
+		MSG_ReadStringLine( msg ); // type
+		MSG_ReadStringLine( msg ); // flags
+		Com_DPrintf( "loadgen%d: connection refused: %s\n", client->num, MSG_ReadStringLine( msg ) );
+		LG_Disconnect( client, false, LOADGEN_REJECT_BACKOFF );
+		return;
+	}
+}
+
+static void LG_ParseServerCommand( LoadGenClient * client, msg_t * msg ) {
+	Cmd_TokenizeString( MSG_ReadString( msg ) );
+	const char * s = Cmd_Argv( 0 );
+
+	if( strcmp( s, "cmd" ) == 0 ) {
+		LG_AddReliableCommand( client, Cmd_Args() );
+	}
+	else if( strcmp( s, "precache" ) == 0 ) {
+		LG_LoadCollisionModel( Cmd_Argv( 2 ) );
+		LG_AddReliableCommand( client, va( "begin %i", atoi( Cmd_Argv( 1 ) ) ) );
+	}
+	else if( strcmp( s, "changing" ) == 0 ) {
+		client->received_snap_num = 0;
+		client->state = LoadGenClient_Connected;
+	}
+	else if( strcmp( s, "reconnect" ) == 0 ) {
+		client->received_snap_num = 0;
+		client->joined = false;
+		client->state = LoadGenClient_Handshake;
+		LG_AddReliableCommand( client, "new" );
+	}
+	else if( strcmp( s, "disconnect" ) == 0 || strcmp( s, "forcereconnect" ) == 0 ) {
+		Com_DPrintf( "loadgen%d: disconnected: %s\n", client->num, Cmd_Argv( 2 ) );
+		LG_Disconnect( client, false, LOADGEN_REJECT_BACKOFF );
+	}
+}
+
+static void LG_ParseServerData( LoadGenClient * client, msg_t * msg ) {
+	int protocol = MSG_ReadInt32( msg );
+	if( protocol != APP_PROTOCOL_VERSION ) {
+		Com_Error( ERR_DROP, "Server returned version %i, not %i", protocol, APP_PROTOCOL_VERSION );
+	}
+
+	client->servercount = MSG_ReadInt32( msg );
+	client->snap_frame_time = MSG_ReadInt16( msg );
+	client->playernum = MSG_ReadInt16( msg );
+
+	int bitflags = MSG_ReadUint8( msg );
+	if( ( bitflags & SV_BITFLAGS_HTTP ) != 0 ) {
+		if( ( bitflags & SV_BITFLAGS_HTTP_BASEURL ) != 0 ) {
+			MSG_ReadString( msg );
+		}
+		else {
+			MSG_ReadInt16( msg );
+		}
+	}
+
+	// the server resets its command buffers when it sends serverdata
+	client->reliable_sequence = 0;
+	client->reliable_acknowledge = 0;
+	client->last_executed_server_command = 0;
+	client->received_snap_num = 0;
+	client->ucmd_head = 0;
+	client->ucmd_sent = 0;
+	client->ucmd_acknowledged = 0;
+	client->ucmd_executed = 0;
+	memset( client->cmds, 0, sizeof( client->cmds ) );
+
+	client->state = LoadGenClient_Connected;
+	LG_AddReliableCommand( client, va( "configstrings %i 0", client->servercount ) );
+}
+
+static void LG_ParseFrame( LoadGenClient * client, msg_t * msg ) {
+	snapshot_t * old_snap = client->received_snap_num > 0 ? &client->snapshots[ client->received_snap_num & UPDATE_MASK ] : NULL;
+	snapshot_t * snap = SNAP_ParseFrame( msg, old_snap, client->snapshots, client->baselines, 0 );
+	if( !snap->valid ) {
+		return;
+	}
+
+	client->received_snap_num = snap->serverFrame;
+	client->snap_server_time = snap->serverTime;
+	client->snap_received_time = realtime;
+	client->stats.snaps++;
+
+	if( snap->ucmdExecuted > client->ucmd_executed ) {
+		client->ucmd_executed = snap->ucmdExecuted;
+
+		int64_t sent = client->cmd_sent_time[ snap->ucmdExecuted & CMD_MASK ];
+		if( sent != 0 && client->ucmd_head - snap->ucmdExecuted < CMD_BACKUP ) {
+			latency_samples.add( realtime - sent );
+		}
+	}
+
+	if( client->state == LoadGenClient_Connected ) {
+		client->state = LoadGenClient_Active;
+		client->ucmd_executed = snap->ucmdExecuted;
+		client->last_ucmd_time = realtime;
+		client->yaw = RandomFloat01( &rng ) * 360.0f;
+
+		if( !client->joined ) {
+			LG_AddReliableCommand( client, "join" );
+			client->joined = true;
+		}
+	}
+}
+
+static void LG_ParseServerMessage( LoadGenClient * client, msg_t * msg ) {
+	while( msg->readcount < msg->cursize && client->state >= LoadGenClient_Handshake ) {
+		int cmd = MSG_ReadUint8( msg );
+		switch( cmd ) {
+			default:
+				Com_Error( ERR_DROP, "LG_ParseServerMessage: Illegible server message" );
+				break;
+
+			case svc_servercmd: {
+				int64_t num = MSG_ReadInt32( msg );
+				if( num <= client->last_executed_server_command ) {
+					MSG_ReadString( msg );
+					break;
+				}
+				client->last_executed_server_command = num;
+				LG_ParseServerCommand( client, msg );
+			} break;
+
+			case svc_servercs:
+				LG_ParseServerCommand( client, msg );
+				break;
+
+			case svc_serverdata:
+				if( client->state != LoadGenClient_Handshake ) {
+					return;
+				}
+				LG_ParseServerData( client, msg );
+				break;
+
+			case svc_spawnbaseline:
+				SNAP_ParseBaseline( msg, client->baselines );
+				break;
+
+			case svc_clcack:
+				client->reliable_acknowledge = MSG_ReadUintBase128( msg );
+				client->ucmd_acknowledged = MSG_ReadUintBase128( msg );
+				break;
+
+			case svc_frame:
+				LG_ParseFrame( client, msg );
+				break;
+		}
+	}
+}
+
+static void LG_ReadPackets( LoadGenClient * client ) {
+	msg_t msg;
+	uint8_t msg_data[ MAX_MSGLEN ];
+	MSG_Init( &msg, msg_data, sizeof( msg_data ) );
+
+	parsing_client = client;
+	defer { parsing_client = NULL; };
+
+	netadr_t address;
+	int ret;
+	while( client->socket.open && ( ret = NET_GetPacket( &client->socket, &address, &msg ) ) != 0 ) {
+		if( ret == -1 ) {
+			continue;
+		}
+
+		client->last_packet_received_time = realtime;
+		client->stats.packets_received++;
+		client->stats.bytes_received += msg.cursize;
+
+		if( *( int * ) msg.data == -1 ) {
+			LG_ConnectionlessPacket( client, &msg );
+			continue;
+		}
+
+		if( client->state < LoadGenClient_Handshake || msg.cursize < 8 ) {
+			continue;
+		}
+
+		if( !Netchan_Process( &client->netchan, &msg ) ) {
+			continue;
+		}
+
+		MSG_BeginReading( &msg );
+		MSG_ReadInt32( &msg ); // sequence
+		MSG_ReadInt32( &msg ); // sequence_ack
+		if( msg.compressed && Netchan_DecompressMessage( &msg ) < 0 ) {
+			continue;
+		}
+
+		LG_ParseServerMessage( client, &msg );
+	}
+}
+
+static void LG_ClientFrame( LoadGenClient * client, bool can_connect ) {
+	switch( client->state ) {
+		case LoadGenClient_Disconnected:
+			if( can_connect && realtime >= client->retry_time ) {
+				LG_Connect( client );
+			}
+			return;
+
+		case LoadGenClient_Connecting:
+			if( realtime - client->connect_time > LOADGEN_RESEND_TIME ) {
+				LG_Disconnect( client, false, 0 );
+			}
+			return;
+
+		default:
+			break;
+	}
+
+	if( realtime - client->last_packet_received_time > LOADGEN_TIMEOUT ) {
+		Com_Printf( "loadgen%d: timed out\n", client->num );
+		LG_Disconnect( client, true, LOADGEN_REJECT_BACKOFF );
+		return;
+	}
+
+	if( client->netchan.unsentFragments ) {
+		Netchan_TransmitNextFragment( &client->netchan );
+		return;
+	}
+
+	if( client->state < LoadGenClient_Active ) {
+		// keep acknowledging server commands while we connect
+		if( realtime - client->last_packet_sent_time > 100 ) {
+			LG_SendMessage( client );
+		}
+		return;
+	}
+
+	if( realtime - client->last_ucmd_time >= 1000 / LOADGEN_UCMD_FPS ) {
+		LG_CreateUserCommand( client );
+	}
+
+	int packet_time = Min2( 1000 / Clamp( 1, loadgen_pps->integer, 1000 ), int( client->snap_frame_time ) );
+	if( realtime - client->last_packet_sent_time >= packet_time ) {
+		LG_SendMessage( client );
+	}
+}
+
+/*
+==============================================================================
+
+REPORTING
+
+==============================================================================
+*/
+
+static void LG_Report() {
+	float dt = Max2( int64_t( 1 ), realtime - last_report_time ) * 0.001f;
+	last_report_time = realtime;
+
+	int active = 0;
+	LoadGenStats total = { };
+	for( int i = 0; i < num_clients; i++ ) {
+		LoadGenClient * client = &clients[ i ];
+		if( client->state == LoadGenClient_Active ) {
+			active++;
+		}
+
+		total.snaps += client->stats.snaps;
+		total.packets_received += client->stats.packets_received;
+		total.packets_sent += client->stats.packets_sent;
+		total.bytes_received += client->stats.bytes_received;
+		total.bytes_sent += client->stats.bytes_sent;
+		client->stats = { };
+	}
+
+	float per_client = 1.0f / ( Max2( active, 1 ) * dt );
+	Com_Printf( "%d/%d clients active over %.1fs, per client: %.1f snaps/s, %.1f/%.1f packets/s in/out, %.2f/%.2f KB/s in/out\n",
+		active, num_clients, dt,
+		total.snaps * per_client,
+		total.packets_received * per_client, total.packets_sent * per_client,
+		total.bytes_received * per_client / 1024.0f, total.bytes_sent * per_client / 1024.0f );
+
+	PrintPercentilesHeader( "" );
+	PrintPercentiles( "ucmd ms", latency_samples.span() );
+	PrintPercentiles( "pmove us", pmove_samples.span() );
+
+	latency_samples.clear();
+	pmove_samples.clear();
+}
+
+/*
+==============================================================================
+
+COMMANDS
+
+==============================================================================
+*/
+
+static void LG_Stop() {
+	for( int i = 0; i < num_clients; i++ ) {
+		LG_Disconnect( &clients[ i ], true, 0 );
+	}
+
+	FREE( sys_allocator, clients );
+	clients = NULL;
+	num_clients = 0;
+}
+
+/*
+* LG_Start_f
+* loadgen <address> [clients]
+*/
+static void LG_Start_f() {
+	if( Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: %s <address> [clients]\n", Cmd_Argv( 0 ) );
+		return;
+	}
+
+	netadr_t address;
+	if( !NET_StringToAddress( Cmd_Argv( 1 ), &address ) || ( address.type != NA_IP && address.type != NA_IP6 ) ) {
+		Com_Printf( "Bad server address\n" );
+		return;
+	}
+	if( NET_GetAddressPort( &address ) == 0 ) {
+		NET_SetAddressPort( &address, PORT_SERVER );
+	}
+
+	LG_Stop();
+
+	server_address = address;
+	num_clients = Clamp( 1, Cmd_Argc() >= 3 ? atoi( Cmd_Argv( 2 ) ) : MAX_CLIENTS, LOADGEN_MAX_CLIENTS );
+	clients = ALLOC_MANY( sys_allocator, LoadGenClient, num_clients );
+	for( int i = 0; i < num_clients; i++ ) {
+		clients[ i ] = { };
+		clients[ i ].num = i;
+	}
+
+	realtime = Sys_Milliseconds();
+	last_report_time = realtime;
+	latency_samples.clear();
+	pmove_samples.clear();
+
+	Com_Printf( "Connecting %d clients to %s\n", num_clients, NET_AddressToString( &server_address ) );
+}
+
+static void LG_Stop_f() {
+	LG_Stop();
+}
+
+static void LG_Stats_f() {
+	realtime = Sys_Milliseconds();
+	LG_Report();
+}
+
+/*
+==============================================================================
+
+ENGINE INTERFACE
+
+==============================================================================
+*/
+
+void CL_Init() {
+	constexpr size_t frame_arena_size = 1024 * 1024; // 1MB
+	void * frame_arena_memory = ALLOC_SIZE( sys_allocator, frame_arena_size, 16 );
+	frame_arena = ArenaAllocator( frame_arena_memory, frame_arena_size );
+
+	u64 entropy[ 2 ];
+	CSPRNG_Bytes( entropy, sizeof( entropy ) );
+	rng = NewRNG( entropy[ 0 ], entropy[ 1 ] );
+
+	// don't append to the server's log if we're run from the same directory
+	if( strcmp( Cvar_String( "logconsole" ), "server.log" ) == 0 ) {
+		Cvar_ForceSet( "logconsole", "loadgen.log" );
+	}
+
+	loadgen_movement = Cvar_Get( "loadgen_movement", "random", 0 );
+	loadgen_fire = Cvar_Get( "loadgen_fire", "0.3", 0 );
+	loadgen_pps = Cvar_Get( "loadgen_pps", "40", 0 );
+	loadgen_report = Cvar_Get( "loadgen_report", "5", 0 );
+
+	latency_samples.init( sys_allocator );
+	pmove_samples.init( sys_allocator );
+
+	loadgen_gs = { };
+	loadgen_gs.module = GS_MODULE_CGAME;
+	loadgen_gs.maxclients = MAX_CLIENTS;
+	loadgen_gs.api.Trace = LG_GS_Trace;
+	loadgen_gs.api.GetEntityState = LG_GS_GetEntityState;
+	loadgen_gs.api.PointContents = LG_GS_PointContents;
+	loadgen_gs.api.PredictedEvent = LG_GS_PredictedEvent;
+	loadgen_gs.api.PredictedFireWeapon = LG_GS_PredictedFireWeapon;
+	loadgen_gs.api.PMoveTouchTriggers = LG_GS_PMoveTouchTriggers;
+
+	Cmd_AddCommand( "loadgen", LG_Start_f );
+	Cmd_AddCommand( "loadgen_stop", LG_Stop_f );
+	Cmd_AddCommand( "loadgen_stats", LG_Stats_f );
+}
+
+void CL_Shutdown() {
+	LG_Stop();
+
+	Cmd_RemoveCommand( "loadgen" );
+	Cmd_RemoveCommand( "loadgen_stop" );
+	Cmd_RemoveCommand( "loadgen_stats" );
+
+	latency_samples.shutdown();
+	pmove_samples.shutdown();
+
+	if( collision_model != NULL ) {
+		CM_Free( CM_Client, collision_model );
+		collision_model = NULL;
+	}
+
+	FREE( sys_allocator, frame_arena.get_memory() );
+}
+
+void CL_Frame( int realmsec, int gamemsec ) {
+	ZoneScoped;
+
+	frame_arena.clear();
+	realtime = Sys_Milliseconds();
+
+	// connect one client at a time, the server keeps one challenge per IP
+	bool can_connect = true;
+	for( int i = 0; i < num_clients; i++ ) {
+		if( clients[ i ].state == LoadGenClient_Connecting ) {
+			can_connect = false;
+		}
+	}
+
+	for( int i = 0; i < num_clients; i++ ) {
+		LoadGenClient * client = &clients[ i ];
+		LG_ReadPackets( client );
+		LG_ClientFrame( client, can_connect );
+		if( client->state == LoadGenClient_Connecting ) {
+			can_connect = false;
+		}
+	}
+
+	if( num_clients > 0 && loadgen_report->value > 0 && realtime - last_report_time >= loadgen_report->value * 1000.0f ) {
+		LG_Report();
+	}
+
+	Sys_Sleep( 1 );
+}
+
+void CL_Disconnect( const char * message ) {
+	if( parsing_client != NULL ) {
+		Com_Printf( "loadgen%d: %s\n", parsing_client->num, message );
+		LG_Disconnect( parsing_client, true, LOADGEN_REJECT_BACKOFF );
+		parsing_client = NULL;
+	}
+}
+
+void Con_Print( const char * text ) { }
+
+void Key_Init() { }
+void Key_Shutdown() { }
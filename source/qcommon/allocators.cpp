@@ -91,6 +91,9 @@ struct AllocationTracker {
 
 #endif
 
+// per thread so counting doesn't need a lock
+static thread_local u64 thread_allocations;
+
 struct SystemAllocator final : public Allocator {
 	AllocationTracker tracker;
 
@@ -107,6 +110,7 @@ struct SystemAllocator final : public Allocator {
 		 */
 
 		assert( alignment <= 16 );
+		thread_allocations++;
 		void * ptr = malloc( size );
 		TracyAlloc( ptr, size );
 		tracker.track( ptr, func, file, line );
@@ -115,6 +119,7 @@ struct SystemAllocator final : public Allocator {
 
 	void * try_reallocate( void * ptr, size_t current_size, size_t new_size, size_t alignment, const char * func, const char * file, int line ) {
 		assert( alignment <= 16 );
+		thread_allocations++;
 
 		TracyFree( ptr );
 		tracker.untrack( ptr, func, file, line );
@@ -250,3 +255,7 @@ float ArenaAllocator::max_utilisation() const {
 
 static SystemAllocator sys_allocator_;
 Allocator * sys_allocator = &sys_allocator_;
+
+u64 ThreadAllocationCount() {
+	return thread_allocations;
+}
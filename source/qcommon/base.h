@@ -73,6 +73,8 @@ struct DeferHelper {
 
 extern Allocator * sys_allocator;
 
+u64 ThreadAllocationCount(); // sys_allocator allocations made on the calling thread
+
 struct ArenaAllocator;
 struct TempAllocator final : public Allocator {
 	TempAllocator() = default;
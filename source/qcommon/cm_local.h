@@ -25,9 +25,6 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 cmodel_t * CM_NewCModel( CModelServerOrClient soc, u64 hash );
 
-void    CM_InitBoxHull( CollisionModel *cms );
-void    CM_InitOctagonHull( CollisionModel *cms );
-
 void    CM_FloodAreaConnections( CollisionModel *cms );
 
 void CM_LoadQ3BrushModel( CModelServerOrClient soc, CollisionModel * cms, Span< const u8 > data );
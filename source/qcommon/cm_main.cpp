@@ -30,26 +30,6 @@ static Hashmap< cmodel_t, 4096 > * GetCModels( CModelServerOrClient soc ) {
 	return soc == CM_Client ? &client_cmodels : &server_cmodels;
 }
 
-static void CM_AllocateCheckCounts( CollisionModel *cms ) {
-	cms->checkcount = 0;
-	cms->map_brush_checkcheckouts = ALLOC_MANY( sys_allocator, int, cms->numbrushes );
-	cms->map_face_checkcheckouts = ALLOC_MANY( sys_allocator, int, cms->numfaces );
-}
-
-static void CM_FreeCheckCounts( CollisionModel *cms ) {
-	cms->checkcount = 0;
-
-	if( cms->map_brush_checkcheckouts ) {
-		FREE( sys_allocator, cms->map_brush_checkcheckouts );
-		cms->map_brush_checkcheckouts = NULL;
-	}
-
-	if( cms->map_face_checkcheckouts ) {
-		FREE( sys_allocator, cms->map_face_checkcheckouts );
-		cms->map_face_checkcheckouts = NULL;
-	}
-}
-
 static void CM_Clear( CModelServerOrClient soc, CollisionModel * cms ) {
 	if( cms->map_shaderrefs ) {
 		FREE( sys_allocator, cms->map_shaderrefs[0].name );
@@ -142,8 +122,6 @@ static void CM_Clear( CModelServerOrClient soc, CollisionModel * cms ) {
 		cms->map_entitystring = &cms->map_entitystring_empty;
 	}
 
-	CM_FreeCheckCounts( cms );
-
 	ClearBounds( &cms->world_mins, &cms->world_maxs );
 }
 
@@ -170,8 +148,6 @@ CollisionModel * CM_LoadMap( CModelServerOrClient soc, Span< const u8 > data, u6
 	const char * suffix = "*0";
 	cms->world_hash = Hash64( suffix, strlen( suffix ), cms->base_hash );
 
-	CM_InitBoxHull( cms );
-	CM_InitOctagonHull( cms );
 	CM_Clear( soc, cms );
 
 	CM_LoadQ3BrushModel( soc, cms, data );
@@ -184,8 +160,6 @@ CollisionModel * CM_LoadMap( CModelServerOrClient soc, Span< const u8 > data, u6
 		CM_FloodAreaConnections( cms );
 	}
 
-	CM_AllocateCheckCounts( cms );
-
 	memset( cms->nullrow, 255, MAX_CM_LEAFS / 8 );
 
 	return cms;
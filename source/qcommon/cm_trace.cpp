@@ -26,6 +26,7 @@ typedef struct {
 	int leaf_count, leaf_maxcount;
 	int *leaf_list;
 	Vec3 leaf_mins, leaf_maxs;
+	BoxLeafnumsBounds *leaf_bounds;
 } boxLeafsWork_t;
 
 typedef struct {
@@ -50,34 +51,74 @@ typedef struct {
 
 	int *brush_checkcounts;
 	int *face_checkcounts;
+
+	// nonzero when this trace is part of a batch sharing the checkcount
+	u32 batch_bit;
+	u32 *brush_batchmasks;
+	u32 *face_batchmasks;
 } traceWork_t;
 
+/*
+* per thread tracing state, so several threads can trace the same map at
+* once. the checkcount arrays grow to fit the biggest map traced so far
+*/
+struct TraceScratch {
+	int checkcount;
+
+	int num_brushes;
+	int num_faces;
+	int *brush_checkcounts;
+	int *face_checkcounts;
+
+	// which traces of a batch have checked each brush/face, valid while the
+	// checkcount matches
+	u32 *brush_batchmasks;
+	u32 *face_batchmasks;
+
+	cbrushside_t box_brushsides[6];
+	cbrush_t box_brush[1];
+	int box_markbrushes[1];
+	cmodel_t box_cmodel[1];
+	int box_checkcount;
+
+	cbrushside_t oct_brushsides[10];
+	cbrush_t oct_brush[1];
+	int oct_markbrushes[1];
+	cmodel_t oct_cmodel[1];
+	int oct_checkcount;
+
+	TraceScratch();
+	~TraceScratch();
+};
+
+static thread_local TraceScratch trace_scratch;
+
 /*
 * CM_InitBoxHull
 *
 * Set up the planes so that the six floats of a bounding box
 * can just be stored out and get a proper clipping hull structure.
 */
-void CM_InitBoxHull( CollisionModel *cms ) {
-	cms->box_brush->numsides = 6;
-	cms->box_brush->brushsides = cms->box_brushsides;
-	cms->box_brush->contents = CONTENTS_BODY;
+static void CM_InitBoxHull( TraceScratch *scratch ) {
+	scratch->box_brush->numsides = 6;
+	scratch->box_brush->brushsides = scratch->box_brushsides;
+	scratch->box_brush->contents = CONTENTS_BODY;
 
 	// Make sure CM_CollideBox() will not reject the brush by its bounds
-	ClearBounds( &cms->box_brush->maxs, &cms->box_brush->mins );
+	ClearBounds( &scratch->box_brush->maxs, &scratch->box_brush->mins );
 
-	cms->box_markbrushes[0] = 0;
+	scratch->box_markbrushes[0] = 0;
 
-	cms->box_cmodel->brushes = cms->box_brush;
-	cms->box_cmodel->builtin = true;
-	cms->box_cmodel->nummarkfaces = 0;
-	cms->box_cmodel->markfaces = NULL;
-	cms->box_cmodel->markbrushes = cms->box_markbrushes;
-	cms->box_cmodel->nummarkbrushes = 1;
+	scratch->box_cmodel->brushes = scratch->box_brush;
+	scratch->box_cmodel->builtin = true;
+	scratch->box_cmodel->nummarkfaces = 0;
+	scratch->box_cmodel->markfaces = NULL;
+	scratch->box_cmodel->markbrushes = scratch->box_markbrushes;
+	scratch->box_cmodel->nummarkbrushes = 1;
 
 	for( int i = 0; i < 6; i++ ) {
 		// brush sides
-		cbrushside_t * s = cms->box_brushsides + i;
+		cbrushside_t * s = scratch->box_brushsides + i;
 		s->surfFlags = 0;
 
 		// planes
@@ -98,7 +139,7 @@ void CM_InitBoxHull( CollisionModel *cms ) {
 * Set up the planes so that the six floats of a bounding box
 * can just be stored out and get a proper clipping hull structure.
 */
-void CM_InitOctagonHull( CollisionModel *cms ) {
+static void CM_InitOctagonHull( TraceScratch *scratch ) {
 	const Vec3 oct_dirs[4] = {
 		Vec3(  1.0f,  1.0f, 0.0f ),
 		Vec3( -1.0f,  1.0f, 0.0f ),
@@ -106,26 +147,26 @@ void CM_InitOctagonHull( CollisionModel *cms ) {
 		Vec3(  1.0f, -1.0f, 0.0f )
 	};
 
-	cms->oct_brush->numsides = 10;
-	cms->oct_brush->brushsides = cms->oct_brushsides;
-	cms->oct_brush->contents = CONTENTS_BODY;
+	scratch->oct_brush->numsides = 10;
+	scratch->oct_brush->brushsides = scratch->oct_brushsides;
+	scratch->oct_brush->contents = CONTENTS_BODY;
 
 	// Make sure CM_CollideBox() will not reject the brush by its bounds
-	ClearBounds( &cms->oct_brush->maxs, &cms->oct_brush->mins );
+	ClearBounds( &scratch->oct_brush->maxs, &scratch->oct_brush->mins );
 
-	cms->oct_markbrushes[0] = 0;
+	scratch->oct_markbrushes[0] = 0;
 
-	cms->oct_cmodel->brushes = cms->oct_brush;
-	cms->oct_cmodel->builtin = true;
-	cms->oct_cmodel->nummarkfaces = 0;
-	cms->oct_cmodel->markfaces = NULL;
-	cms->oct_cmodel->markbrushes = cms->oct_markbrushes;
-	cms->oct_cmodel->nummarkbrushes = 1;
+	scratch->oct_cmodel->brushes = scratch->oct_brush;
+	scratch->oct_cmodel->builtin = true;
+	scratch->oct_cmodel->nummarkfaces = 0;
+	scratch->oct_cmodel->markfaces = NULL;
+	scratch->oct_cmodel->markbrushes = scratch->oct_markbrushes;
+	scratch->oct_cmodel->nummarkbrushes = 1;
 
 	// axial planes
 	for( int i = 0; i < 6; i++ ) {
 		// brush sides
-		cbrushside_t * s = cms->oct_brushsides + i;
+		cbrushside_t * s = scratch->oct_brushsides + i;
 		s->surfFlags = 0;
 
 		// planes
@@ -142,7 +183,7 @@ void CM_InitOctagonHull( CollisionModel *cms ) {
 	// non-axial planes
 	for( int i = 6; i < 10; i++ ) {
 		// brush sides
-		cbrushside_t * s = cms->oct_brushsides + i;
+		cbrushside_t * s = scratch->oct_brushsides + i;
 		s->surfFlags = 0;
 
 		// planes
@@ -151,23 +192,65 @@ void CM_InitOctagonHull( CollisionModel *cms ) {
 	}
 }
 
+TraceScratch::TraceScratch() {
+	CM_InitBoxHull( this );
+	CM_InitOctagonHull( this );
+}
+
+TraceScratch::~TraceScratch() {
+	FREE( sys_allocator, brush_checkcounts );
+	FREE( sys_allocator, face_checkcounts );
+	FREE( sys_allocator, brush_batchmasks );
+	FREE( sys_allocator, face_batchmasks );
+}
+
+/*
+* CM_GetTraceScratch
+*/
+static TraceScratch *CM_GetTraceScratch( const CollisionModel *cms ) {
+	TraceScratch *scratch = &trace_scratch;
+
+	// checkcount only goes up, so leftovers from other maps never match
+	if( scratch->num_brushes < cms->numbrushes ) {
+		FREE( sys_allocator, scratch->brush_checkcounts );
+		FREE( sys_allocator, scratch->brush_batchmasks );
+		scratch->num_brushes = cms->numbrushes;
+		scratch->brush_checkcounts = ALLOC_MANY( sys_allocator, int, scratch->num_brushes );
+		scratch->brush_batchmasks = ALLOC_MANY( sys_allocator, u32, scratch->num_brushes );
+		memset( scratch->brush_checkcounts, 0, scratch->num_brushes * sizeof( int ) );
+	}
+
+	if( scratch->num_faces < cms->numfaces ) {
+		FREE( sys_allocator, scratch->face_checkcounts );
+		FREE( sys_allocator, scratch->face_batchmasks );
+		scratch->num_faces = cms->numfaces;
+		scratch->face_checkcounts = ALLOC_MANY( sys_allocator, int, scratch->num_faces );
+		scratch->face_batchmasks = ALLOC_MANY( sys_allocator, u32, scratch->num_faces );
+		memset( scratch->face_checkcounts, 0, scratch->num_faces * sizeof( int ) );
+	}
+
+	return scratch;
+}
+
 /*
 * CM_ModelForBBox
 *
 * To keep everything totally uniform, bounding boxes are turned into inline models
 */
 cmodel_t *CM_ModelForBBox( CollisionModel *cms, Vec3 mins, Vec3 maxs ) {
-	cms->box_brushsides[0].plane.dist = maxs.x;
-	cms->box_brushsides[1].plane.dist = -mins.x;
-	cms->box_brushsides[2].plane.dist = maxs.y;
-	cms->box_brushsides[3].plane.dist = -mins.y;
-	cms->box_brushsides[4].plane.dist = maxs.z;
-	cms->box_brushsides[5].plane.dist = -mins.z;
+	TraceScratch *scratch = &trace_scratch;
 
-	cms->box_cmodel->mins = mins;
-	cms->box_cmodel->maxs = maxs;
+	scratch->box_brushsides[0].plane.dist = maxs.x;
+	scratch->box_brushsides[1].plane.dist = -mins.x;
+	scratch->box_brushsides[2].plane.dist = maxs.y;
+	scratch->box_brushsides[3].plane.dist = -mins.y;
+	scratch->box_brushsides[4].plane.dist = maxs.z;
+	scratch->box_brushsides[5].plane.dist = -mins.z;
 
-	return cms->box_cmodel;
+	scratch->box_cmodel->mins = mins;
+	scratch->box_cmodel->maxs = maxs;
+
+	return scratch->box_cmodel;
 }
 
 /*
@@ -177,6 +260,7 @@ cmodel_t *CM_ModelForBBox( CollisionModel *cms, Vec3 mins, Vec3 maxs ) {
 * Internally offset to be symmetric on all sides.
 */
 cmodel_t *CM_OctagonModelForBBox( CollisionModel *cms, Vec3 mins, Vec3 maxs ) {
+	TraceScratch *scratch = &trace_scratch;
 	float a, b, d, t;
 	float sina, cosa;
 	Vec3 offset, size[2];
@@ -185,16 +269,16 @@ cmodel_t *CM_OctagonModelForBBox( CollisionModel *cms, Vec3 mins, Vec3 maxs ) {
 	size[0] = mins - offset;
 	size[1] = maxs - offset;
 
-	cms->oct_cmodel->cyl_offset = offset;
-	cms->oct_cmodel->mins = size[0];
-	cms->oct_cmodel->maxs = size[1];
+	scratch->oct_cmodel->cyl_offset = offset;
+	scratch->oct_cmodel->mins = size[0];
+	scratch->oct_cmodel->maxs = size[1];
 
-	cms->oct_brushsides[0].plane.dist = size[1].x;
-	cms->oct_brushsides[1].plane.dist = -size[0].x;
-	cms->oct_brushsides[2].plane.dist = size[1].y;
-	cms->oct_brushsides[3].plane.dist = -size[0].y;
-	cms->oct_brushsides[4].plane.dist = size[1].z;
-	cms->oct_brushsides[5].plane.dist = -size[0].z;
+	scratch->oct_brushsides[0].plane.dist = size[1].x;
+	scratch->oct_brushsides[1].plane.dist = -size[0].x;
+	scratch->oct_brushsides[2].plane.dist = size[1].y;
+	scratch->oct_brushsides[3].plane.dist = -size[0].y;
+	scratch->oct_brushsides[4].plane.dist = size[1].z;
+	scratch->oct_brushsides[5].plane.dist = -size[0].z;
 
 	a = size[1].x; // halfx
 	b = size[1].y; // halfy
@@ -214,19 +298,19 @@ cmodel_t *CM_OctagonModelForBBox( CollisionModel *cms, Vec3 mins, Vec3 maxs ) {
 
 	// the following should match normals set in CM_InitOctagonHull
 
-	cms->oct_brushsides[6].plane.normal = Vec3( cosa, sina, 0 );
-	cms->oct_brushsides[6].plane.dist = d;
+	scratch->oct_brushsides[6].plane.normal = Vec3( cosa, sina, 0 );
+	scratch->oct_brushsides[6].plane.dist = d;
 
-	cms->oct_brushsides[7].plane.normal = Vec3( -cosa, sina, 0 );
-	cms->oct_brushsides[7].plane.dist = d;
+	scratch->oct_brushsides[7].plane.normal = Vec3( -cosa, sina, 0 );
+	scratch->oct_brushsides[7].plane.dist = d;
 
-	cms->oct_brushsides[8].plane.normal = Vec3( -cosa, -sina, 0 );
-	cms->oct_brushsides[8].plane.dist = d;
+	scratch->oct_brushsides[8].plane.normal = Vec3( -cosa, -sina, 0 );
+	scratch->oct_brushsides[8].plane.dist = d;
 
-	cms->oct_brushsides[9].plane.normal = Vec3( cosa, -sina, 0 );
-	cms->oct_brushsides[9].plane.dist = d;
+	scratch->oct_brushsides[9].plane.normal = Vec3( cosa, -sina, 0 );
+	scratch->oct_brushsides[9].plane.dist = d;
 
-	return cms->oct_cmodel;
+	return scratch->oct_cmodel;
 }
 
 int CM_PointLeafnum( const CollisionModel *cms, Vec3 p ) {
@@ -266,6 +350,49 @@ static AABBPlaneResult IntersectAABBPlane( Vec3 mins, Vec3 maxs, const cplane_t
 	return front_dist < 0 ? AABBPlaneResult_Behind : AABBPlaneResult_Straddling;
 }
 
+/*
+* CM_ConstrainLeafnumsBounds
+*
+* narrows the range the box can move in while node classifies it the same way
+*/
+static void CM_ConstrainLeafnumsBounds( BoxLeafnumsBounds *bounds, const cplane_t *p, AABBPlaneResult r ) {
+	int axis = -1;
+	for( int i = 0; i < 3; i++ ) {
+		if( p->normal[ i ] == 1.0f || p->normal[ i ] == -1.0f ) {
+			axis = i;
+		}
+		else if( p->normal[ i ] != 0.0f ) {
+			bounds->exact = true;
+			return;
+		}
+	}
+
+	if( axis == -1 ) {
+		bounds->exact = true;
+		return;
+	}
+
+	// positive normals test mins against the back and maxs against the
+	// front, negative normals swap them
+	bool positive = p->normal[ axis ] > 0.0f;
+	float d = positive ? p->dist : -p->dist;
+	float & mins_lo = bounds->mins_lo[ axis ];
+	float & mins_hi = bounds->mins_hi[ axis ];
+	float & maxs_lo = bounds->maxs_lo[ axis ];
+	float & maxs_hi = bounds->maxs_hi[ axis ];
+
+	if( r == AABBPlaneResult_Straddling ) {
+		mins_hi = Min2( mins_hi, d );
+		maxs_lo = Max2( maxs_lo, d );
+	}
+	else if( ( r == AABBPlaneResult_InFront ) == positive ) {
+		mins_lo = Max2( mins_lo, d );
+	}
+	else {
+		maxs_hi = Min2( maxs_hi, d );
+	}
+}
+
 /*
 * CM_BoxLeafnums
 *
@@ -277,6 +404,10 @@ static void CM_BoxLeafnums_r( boxLeafsWork_t *bw, const CollisionModel *cms, int
 
 		AABBPlaneResult r = IntersectAABBPlane( bw->leaf_mins, bw->leaf_maxs, node->plane );
 
+		if( bw->leaf_bounds != NULL && !bw->leaf_bounds->exact ) {
+			CM_ConstrainLeafnumsBounds( bw->leaf_bounds, node->plane, r );
+		}
+
 		if( r == AABBPlaneResult_InFront ) {
 			nodenum = node->children[ 0 ];
 			continue;
@@ -301,7 +432,7 @@ static void CM_BoxLeafnums_r( boxLeafsWork_t *bw, const CollisionModel *cms, int
 	}
 }
 
-int CM_BoxLeafnums( CollisionModel *cms, Vec3 mins, Vec3 maxs, int *list, int listsize, int *topnode ) {
+int CM_BoxLeafnums( CollisionModel *cms, Vec3 mins, Vec3 maxs, int *list, int listsize, int *topnode, BoxLeafnumsBounds *bounds ) {
 	boxLeafsWork_t bw;
 
 	bw.leaf_list = list;
@@ -310,6 +441,17 @@ int CM_BoxLeafnums( CollisionModel *cms, Vec3 mins, Vec3 maxs, int *list, int li
 	bw.leaf_mins = mins;
 	bw.leaf_maxs = maxs;
 	bw.leaf_topnode = -1;
+	bw.leaf_bounds = bounds;
+
+	if( bounds != NULL ) {
+		bounds->mins = mins;
+		bounds->maxs = maxs;
+		bounds->exact = false;
+		bounds->mins_lo = Vec3( -FLT_MAX );
+		bounds->mins_hi = Vec3( FLT_MAX );
+		bounds->maxs_lo = Vec3( -FLT_MAX );
+		bounds->maxs_hi = Vec3( FLT_MAX );
+	}
 
 	CM_BoxLeafnums_r( &bw, cms, 0 );
 
@@ -320,6 +462,25 @@ int CM_BoxLeafnums( CollisionModel *cms, Vec3 mins, Vec3 maxs, int *list, int li
 	return bw.leaf_count;
 }
 
+bool CM_SameBoxLeafnums( const BoxLeafnumsBounds *bounds, Vec3 mins, Vec3 maxs ) {
+	if( mins == bounds->mins && maxs == bounds->maxs ) {
+		return true;
+	}
+
+	if( bounds->exact ) {
+		return false;
+	}
+
+	for( int i = 0; i < 3; i++ ) {
+		if( mins[ i ] <= bounds->mins_lo[ i ] || mins[ i ] > bounds->mins_hi[ i ] )
+			return false;
+		if( maxs[ i ] < bounds->maxs_lo[ i ] || maxs[ i ] >= bounds->maxs_hi[ i ] )
+			return false;
+	}
+
+	return true;
+}
+
 static inline int CM_BrushContents( cbrush_t *brush, Vec3 p ) {
 	int i;
 	cbrushside_t *brushside;
@@ -520,7 +681,7 @@ static void CM_ClipBoxToBrush( traceWork_t *tw, const cbrush_t *brush ) {
 	if( !startout ) {
 		// original point was inside brush
 		tw->trace->startsolid = true;
-		tw->contents = brush->contents;
+		tw->trace->contents = brush->contents;
 		if( !getout ) {
 			tw->realfraction = 0;
 			tw->trace->allsolid = true;
@@ -574,22 +735,45 @@ static void CM_TestBoxInBrush( traceWork_t *tw, const cbrush_t *brush ) {
 	tw->trace->contents = brush->contents;
 }
 
+/*
+* CM_FirstCheck
+*
+* returns false if this trace has already checked the brush/face
+*/
+static inline bool CM_FirstCheck( const traceWork_t *tw, int *checkcounts, u32 *batchmasks, int idx ) {
+	if( tw->batch_bit == 0 ) {
+		if( checkcounts[idx] == tw->checkcount ) {
+			return false;
+		}
+		checkcounts[idx] = tw->checkcount;
+		return true;
+	}
+
+	if( checkcounts[idx] != tw->checkcount ) {
+		checkcounts[idx] = tw->checkcount;
+		batchmasks[idx] = 0;
+	}
+	if( batchmasks[idx] & tw->batch_bit ) {
+		return false;
+	}
+	batchmasks[idx] |= tw->batch_bit;
+	return true;
+}
+
 static void CM_CollideBox( traceWork_t *tw, const int *markbrushes, int nummarkbrushes, const int *markfaces, int nummarkfaces, void ( *func )( traceWork_t *, const cbrush_t *b ) ) {
 	ZoneScoped;
 
 	const cbrush_t *brushes = tw->brushes;
 	const cface_t *faces = tw->faces;
-	int checkcount = tw->checkcount;
 
 	// trace line against all brushes
 	for( int i = 0; i < nummarkbrushes; i++ ) {
 		int mb = markbrushes[i];
 		const cbrush_t *b = brushes + mb;
 
-		if( tw->brush_checkcounts[mb] == checkcount ) {
+		if( !CM_FirstCheck( tw, tw->brush_checkcounts, tw->brush_batchmasks, mb ) ) {
 			continue; // already checked this brush
 		}
-		tw->brush_checkcounts[mb] = checkcount;
 
 		if( !( b->contents & tw->contents ) ) {
 			continue;
@@ -612,10 +796,9 @@ static void CM_CollideBox( traceWork_t *tw, const int *markbrushes, int nummarkb
 		int mf = markfaces[i];
 		const cface_t *patch = faces + mf;
 
-		if( tw->face_checkcounts[mf] == checkcount ) {
+		if( !CM_FirstCheck( tw, tw->face_checkcounts, tw->face_batchmasks, mf ) ) {
 			continue; // already checked this brush
 		}
-		tw->face_checkcounts[mf] = checkcount;
 
 		if( !( patch->contents & tw->contents ) ) {
 			continue;
@@ -720,24 +903,18 @@ static void CM_RecursiveHullCheck( traceWork_t *tw, int num, float p1f, float p2
 	CM_RecursiveHullCheck( tw, node->children[ side ^ 1 ], midf, p2f, mid, p2 );
 }
 
-static void CM_BoxTrace( traceWork_t *tw, CollisionModel *cms, trace_t *tr,
-	Vec3 start, Vec3 end, Vec3 mins, Vec3 maxs,
-	const cmodel_t *cmodel, Vec3 origin, int brushmask ) {
-
-	ZoneScoped;
-
-	bool world = cmodel->hash == cms->world_hash;
-
+static void CM_InitTraceWork( traceWork_t *tw, CollisionModel *cms, trace_t *tr,
+	Vec3 start, Vec3 end, Vec3 mins, Vec3 maxs, const cmodel_t *cmodel, int brushmask ) {
 	// fill in a default trace
 	memset( tr, 0, sizeof( *tr ) );
 	tr->fraction = 1;
 
-	cms->checkcount++;  // for multi-check avoidance
+	TraceScratch *scratch = CM_GetTraceScratch( cms );
 
 	memset( tw, 0, sizeof( *tw ) );
 	// the epsilon considers blockers with realfraction == 1 and nudged fraction < 1
 	tw->realfraction = 1 + DIST_EPSILON;
-	tw->checkcount = cms->checkcount;
+	tw->checkcount = scratch->checkcount;
 	tw->trace = tr;
 	tw->contents = brushmask;
 	tw->cms = cms;
@@ -761,17 +938,34 @@ static void CM_BoxTrace( traceWork_t *tw, CollisionModel *cms, trace_t *tr,
 	tw->brushes = cmodel->brushes;
 	tw->faces = cmodel->faces;
 
-	if( cmodel == cms->oct_cmodel ) {
-		tw->brush_checkcounts = &cms->oct_checkcount;
+	if( cmodel == scratch->oct_cmodel ) {
+		tw->brush_checkcounts = &scratch->oct_checkcount;
 		tw->face_checkcounts = NULL;
-	} else if( cmodel == cms->box_cmodel ) {
-		tw->brush_checkcounts = &cms->box_checkcount;
+	} else if( cmodel == scratch->box_cmodel ) {
+		tw->brush_checkcounts = &scratch->box_checkcount;
 		tw->face_checkcounts = NULL;
 	} else {
-		tw->brush_checkcounts = cms->map_brush_checkcheckouts;
-		tw->face_checkcounts = cms->map_face_checkcheckouts;
+		tw->brush_checkcounts = scratch->brush_checkcounts;
+		tw->face_checkcounts = scratch->face_checkcounts;
 	}
 
+	for( int i = 0; i < 3; i++ ) {
+		tw->extents[ i ] = Max2( Abs( mins[ i ] ), Abs( maxs[ i ] ) );
+	}
+}
+
+static void CM_BoxTrace( traceWork_t *tw, CollisionModel *cms, trace_t *tr,
+	Vec3 start, Vec3 end, Vec3 mins, Vec3 maxs,
+	const cmodel_t *cmodel, Vec3 origin, int brushmask ) {
+
+	ZoneScoped;
+
+	bool world = cmodel->hash == cms->world_hash;
+
+	CM_GetTraceScratch( cms )->checkcount++;  // for multi-check avoidance
+
+	CM_InitTraceWork( tw, cms, tr, start, end, mins, maxs, cmodel, brushmask );
+
 	//
 	// check for position test special case
 	//
@@ -803,13 +997,6 @@ static void CM_BoxTrace( traceWork_t *tw, CollisionModel *cms, trace_t *tr,
 		return;
 	}
 
-	//
-	// check for point special case
-	//
-	for( int i = 0; i < 3; i++ ) {
-		tw->extents[ i ] = Max2( Abs( mins[ i ] ), Abs( maxs[ i ] ) );
-	}
-
 	//
 	// general sweeping through world
 	//
@@ -847,7 +1034,7 @@ void CM_TransformedBoxTrace( CModelServerOrClient soc, CollisionModel * cms, tra
 	}
 
 	// cylinder offset
-	if( cmodel == cms->oct_cmodel ) {
+	if( cmodel == trace_scratch.oct_cmodel ) {
 		start_l = start - cmodel->cyl_offset;
 		end_l = end - cmodel->cyl_offset;
 	} else {
@@ -893,3 +1080,183 @@ void CM_TransformedBoxTrace( CModelServerOrClient soc, CollisionModel * cms, tra
 
 	tr->endpos = Lerp( start, tr->fraction, end );
 }
+
+/*
+* CM_RecursiveHullCheckBatch
+*
+* walks the BSP with every trace of a batch at once. each trace visits the
+* same nodes in the same order as CM_RecursiveHullCheck would, so the
+* results are identical, but nodes shared by the batch are only fetched once
+*/
+struct TraceSegment {
+	traceWork_t *tw;
+	float p1f, p2f;
+	Vec3 p1, p2;
+};
+
+static void CM_RecursiveHullCheckBatch( CollisionModel *cms, int num, Vec3 extents, const TraceSegment *segs, int n ) {
+	// if < 0, we are in a leaf node
+	if( num < 0 ) {
+		const cleaf_t *leaf = &cms->map_leafs[ -1 - num ];
+		for( int i = 0; i < n; i++ ) {
+			traceWork_t *tw = segs[ i ].tw;
+			if( tw->realfraction <= segs[ i ].p1f ) {
+				continue; // already hit something nearer
+			}
+			if( leaf->contents & tw->contents ) {
+				CM_ClipBox( tw, leaf->markbrushes, leaf->nummarkbrushes, leaf->markfaces, leaf->nummarkfaces );
+			}
+		}
+		return;
+	}
+
+	const cnode_t * node = cms->map_nodes + num;
+	const cplane_t * plane = node->plane;
+
+	float radius = Abs( extents.x * plane->normal.x ) +
+		Abs( extents.y * plane->normal.y ) +
+		Abs( extents.z * plane->normal.z );
+
+	enum SegmentSides : u8 {
+		SegmentSides_None,
+		SegmentSides_Front,
+		SegmentSides_Back,
+		SegmentSides_FrontThenBack,
+		SegmentSides_BackThenFront,
+	};
+
+	SegmentSides sides[ MAX_TRACE_BATCH ];
+	float fracs[ MAX_TRACE_BATCH ];
+	float fracs2[ MAX_TRACE_BATCH ];
+
+	for( int i = 0; i < n; i++ ) {
+		const TraceSegment *seg = &segs[ i ];
+		if( seg->tw->realfraction <= seg->p1f ) {
+			sides[ i ] = SegmentSides_None;
+			continue;
+		}
+
+		float t1 = Dot( plane->normal, seg->p1 ) - plane->dist;
+		float t2 = Dot( plane->normal, seg->p2 ) - plane->dist;
+
+		if( t1 >= radius && t2 >= radius ) {
+			sides[ i ] = SegmentSides_Front;
+			continue;
+		}
+		if( t1 < -radius && t2 < -radius ) {
+			sides[ i ] = SegmentSides_Back;
+			continue;
+		}
+
+		// put the crosspoint DIST_EPSILON pixels on the near side
+		if( t1 < t2 ) {
+			float idist = 1.0f / ( t1 - t2 );
+			sides[ i ] = SegmentSides_BackThenFront;
+			fracs2[ i ] = ( t1 + radius ) * idist;
+			fracs[ i ] = ( t1 - radius ) * idist;
+		} else if( t1 > t2 ) {
+			float idist = 1.0f / ( t1 - t2 );
+			sides[ i ] = SegmentSides_FrontThenBack;
+			fracs2[ i ] = ( t1 - radius ) * idist;
+			fracs[ i ] = ( t1 + radius ) * idist;
+		} else {
+			sides[ i ] = SegmentSides_FrontThenBack;
+			fracs[ i ] = 1;
+			fracs2[ i ] = 0;
+		}
+	}
+
+	// recurse into the children in an order that keeps each trace's own
+	// order: front side first, then the back side, then the front side again
+	// for traces that start behind the plane
+	TraceSegment children[ MAX_TRACE_BATCH ];
+
+	for( int pass = 0; pass < 3; pass++ ) {
+		int num_children = 0;
+		for( int i = 0; i < n; i++ ) {
+			const TraceSegment *seg = &segs[ i ];
+			SegmentSides side = sides[ i ];
+			TraceSegment child = *seg;
+
+			bool whole = ( pass == 0 && side == SegmentSides_Front ) || ( pass == 1 && side == SegmentSides_Back );
+			bool near_half = ( pass == 0 && side == SegmentSides_FrontThenBack ) || ( pass == 1 && side == SegmentSides_BackThenFront );
+			bool far_half = ( pass == 1 && side == SegmentSides_FrontThenBack ) || ( pass == 2 && side == SegmentSides_BackThenFront );
+
+			if( near_half ) {
+				// move up to the node
+				float frac = Clamp01( fracs[ i ] );
+				child.p2f = seg->p1f + ( seg->p2f - seg->p1f ) * frac;
+				child.p2 = Lerp( seg->p1, frac, seg->p2 );
+			}
+			else if( far_half ) {
+				// go past the node
+				float frac2 = Clamp01( fracs2[ i ] );
+				child.p1f = seg->p1f + ( seg->p2f - seg->p1f ) * frac2;
+				child.p1 = Lerp( seg->p1, frac2, seg->p2 );
+			}
+			else if( !whole ) {
+				continue;
+			}
+
+			children[ num_children ] = child;
+			num_children++;
+		}
+
+		if( num_children > 0 ) {
+			CM_RecursiveHullCheckBatch( cms, node->children[ pass == 1 ? 1 : 0 ], extents, children, num_children );
+		}
+	}
+}
+
+void CM_BoxTraceBatch( CModelServerOrClient soc, CollisionModel * cms, trace_t * traces, const Vec3 * starts, const Vec3 * ends, int n,
+					   Vec3 mins, Vec3 maxs, int brushmask ) {
+	ZoneScoped;
+
+	assert( n <= MAX_TRACE_BATCH );
+
+	const cmodel_t * world = CM_FindCModel( soc, StringHash( cms->world_hash ) );
+
+	traceWork_t tws[ MAX_TRACE_BATCH ];
+	TraceSegment segs[ MAX_TRACE_BATCH ];
+	int num_segs = 0;
+
+	TraceScratch *scratch = CM_GetTraceScratch( cms );
+	scratch->checkcount++;
+
+	for( int i = 0; i < n; i++ ) {
+		// position tests don't walk the tree
+		if( starts[ i ] == ends[ i ] ) {
+			CM_TransformedBoxTrace( soc, cms, &traces[ i ], starts[ i ], ends[ i ], mins, maxs, world, brushmask, Vec3( 0.0f ), Vec3( 0.0f ) );
+			continue;
+		}
+
+		traceWork_t * tw = &tws[ i ];
+		CM_InitTraceWork( tw, cms, &traces[ i ], starts[ i ], ends[ i ], mins, maxs, world, brushmask );
+		tw->batch_bit = u32( 1 ) << i;
+		tw->brush_batchmasks = scratch->brush_batchmasks;
+		tw->face_batchmasks = scratch->face_batchmasks;
+
+		TraceSegment * seg = &segs[ num_segs ];
+		seg->tw = tw;
+		seg->p1f = 0;
+		seg->p2f = 1;
+		seg->p1 = starts[ i ];
+		seg->p2 = ends[ i ];
+		num_segs++;
+	}
+
+	// the position tests above bumped checkcount
+	for( int i = 0; i < num_segs; i++ ) {
+		segs[ i ].tw->checkcount = scratch->checkcount;
+	}
+
+	if( num_segs > 0 ) {
+		CM_RecursiveHullCheckBatch( cms, 0, segs[ 0 ].tw->extents, segs, num_segs );
+	}
+
+	for( int i = 0; i < num_segs; i++ ) {
+		trace_t * tr = segs[ i ].tw->trace;
+		tr->fraction = Clamp01( tr->fraction );
+		tr->endpos = Lerp( segs[ i ].tw->start, tr->fraction, segs[ i ].tw->end );
+	}
+}
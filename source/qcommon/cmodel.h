@@ -18,6 +18,8 @@
 
  */
 
+#pragma once
+
 #include "gameshared/q_math.h"
 #include "gameshared/q_collision.h"
 #include "qcommon/qfiles.h"
@@ -102,7 +104,6 @@ struct CollisionModel {
 	u64 base_hash;
 	u64 world_hash;
 
-	int checkcount;
 	int floodvalid;
 
 	u32 checksum;
@@ -159,22 +160,6 @@ struct CollisionModel {
 	char *map_entitystring;         // = &map_entitystring_empty;
 
 	const u8 *cmod_base;
-
-	// cm_trace.c
-	cbrushside_t box_brushsides[6];
-	cbrush_t box_brush[1];
-	int box_markbrushes[1];
-	cmodel_t box_cmodel[1];
-	int box_checkcount;
-
-	cbrushside_t oct_brushsides[10];
-	cbrush_t oct_brush[1];
-	int oct_markbrushes[1];
-	cmodel_t oct_cmodel[1];
-	int oct_checkcount;
-
-	int *map_brush_checkcheckouts;
-	int *map_face_checkcheckouts;
 };
 
 enum CModelServerOrClient {
@@ -206,13 +191,29 @@ int CM_TransformedPointContents( CModelServerOrClient soc, CollisionModel * cms,
 void CM_TransformedBoxTrace( CModelServerOrClient soc, CollisionModel * cms, trace_t * tr, Vec3 start, Vec3 end, Vec3 mins, Vec3 maxs,
 							 const cmodel_t *cmodel, int brushmask, Vec3 origin, Vec3 angles );
 
+// traces up to MAX_TRACE_BATCH boxes of the same size through the world in
+// a single walk of the BSP. the results match tracing them one at a time
+#define MAX_TRACE_BATCH 32
+void CM_BoxTraceBatch( CModelServerOrClient soc, CollisionModel * cms, trace_t * traces, const Vec3 * starts, const Vec3 * ends, int n,
+					   Vec3 mins, Vec3 maxs, int brushmask );
+
 int CM_ClusterRowSize( const CollisionModel *cms );
 int CM_AreaRowSize( const CollisionModel *cms );
 int CM_PointLeafnum( const CollisionModel *cms, Vec3 p );
 
+// every box inside these bounds touches the same leafs as the box they were
+// computed for, so callers can skip the BSP walk when a box moves a little
+struct BoxLeafnumsBounds {
+	Vec3 mins, maxs;
+	bool exact; // hit a non-axial plane, only the exact same box is known to match
+	Vec3 mins_lo, mins_hi; // mins_lo < mins <= mins_hi
+	Vec3 maxs_lo, maxs_hi; // maxs_lo <= maxs < maxs_hi
+};
+
 // call with topnode set to the headnode, returns with topnode
 // set to the first node that splits the box
-int CM_BoxLeafnums( CollisionModel *cms, Vec3 mins, Vec3 maxs, int *list, int listsize, int *topnode );
+int CM_BoxLeafnums( CollisionModel *cms, Vec3 mins, Vec3 maxs, int *list, int listsize, int *topnode, BoxLeafnumsBounds *bounds = NULL );
+bool CM_SameBoxLeafnums( const BoxLeafnumsBounds *bounds, Vec3 mins, Vec3 maxs );
 
 int CM_LeafCluster( const CollisionModel *cms, int leafnum );
 int CM_LeafArea( const CollisionModel *cms, int leafnum );
@@ -24,9 +24,12 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "qcommon/fs.h"
 #include "qcommon/glob.h"
 #include "qcommon/maplist.h"
+#include "qcommon/metrics.h"
+#include "qcommon/threadpool.h"
 #include "qcommon/threads.h"
 #include "qcommon/version.h"
 
+#include <algorithm>
 #include <setjmp.h>
 
 #define MAX_NUM_ARGVS   50
@@ -51,10 +54,35 @@ static cvar_t *logconsole_flush;
 static cvar_t *logconsole_timestamp;
 static cvar_t *com_showtrace;
 
+static Metric *metric_allocations;
+
 static Mutex *com_print_mutex;
 
 static int log_file = 0;
 
+/*
+ * Console output and the log file are written by a separate thread so
+ * printing doesn't stall the frame on stdout or disk. Com_Printf copies the
+ * formatted message into log_ring and the writer takes everything queued in
+ * one go. If the writer falls a full ring behind, messages are dropped and
+ * counted rather than blocking the printing thread.
+ */
+
+#define LOG_RING_SIZE ( 1024 * 1024 )
+
+static char log_ring[ LOG_RING_SIZE ]; // NUL terminated messages back to back, guarded by com_print_mutex
+static size_t log_ring_head;
+static size_t log_ring_tail;
+static u64 log_dropped;
+static u64 log_dropped_total;
+
+static Mutex *log_write_mutex; // held while writing to stdout or log_file
+static char log_batch[ LOG_RING_SIZE ];
+
+static Thread *log_writer;
+static Semaphore *log_writer_sem;
+static bool log_writer_quit;
+
 static server_state_t server_state = ss_dead;
 static connstate_t client_state = CA_UNINITIALIZED;
 static bool demo_playing = false;
@@ -106,6 +134,139 @@ void Com_EndRedirect() {
 	Unlock( com_print_mutex );
 }
 
+/*
+* Com_PushLogMessage
+* Needs com_print_mutex. Returns true if the ring was empty and the writer has to be woken
+*/
+static bool Com_PushLogMessage( const char *msg ) {
+	size_t len = strlen( msg ) + 1;
+	if( log_ring_tail - log_ring_head + len > LOG_RING_SIZE ) {
+		log_dropped++;
+		log_dropped_total++;
+		return false;
+	}
+
+	bool was_empty = log_ring_tail == log_ring_head;
+
+	size_t start = log_ring_tail % LOG_RING_SIZE;
+	size_t first = Min2( len, size_t( LOG_RING_SIZE ) - start );
+	memcpy( log_ring + start, msg, first );
+	memcpy( log_ring, msg + first, len - first );
+	log_ring_tail += len;
+
+	return was_empty;
+}
+
+/*
+* Com_WriteLogBatch
+* Needs log_write_mutex. Writes everything queued so far to stdout and the log file
+*/
+static void Com_WriteLogBatch() {
+	ZoneScoped;
+
+	Lock( com_print_mutex );
+
+	size_t len = log_ring_tail - log_ring_head;
+	size_t start = log_ring_head % LOG_RING_SIZE;
+	size_t first = Min2( len, size_t( LOG_RING_SIZE ) - start );
+	memcpy( log_batch, log_ring + start, first );
+	memcpy( log_batch + first, log_ring, len - first );
+	log_ring_head = log_ring_tail;
+
+	u64 dropped = log_dropped;
+	log_dropped = 0;
+
+	Unlock( com_print_mutex );
+
+	if( len == 0 && dropped == 0 ) {
+		return;
+	}
+
+	TracyPlot( "Log batch bytes", s64( len ) );
+
+	char timestamp[ 64 ] = "";
+	if( log_file && logconsole_timestamp && logconsole_timestamp->integer ) {
+		Sys_FormatTime( timestamp, sizeof( timestamp ), "%Y-%m-%dT%H:%M:%SZ " );
+	}
+	size_t timestamp_len = strlen( timestamp );
+
+	const char *p = log_batch;
+	while( p < log_batch + len ) {
+		size_t msg_len = strlen( p );
+
+		Sys_ConsoleOutput( p );
+
+		if( log_file ) {
+			FS_Write( timestamp, timestamp_len, log_file );
+			FS_Write( p, msg_len, log_file );
+		}
+
+		p += msg_len + 1;
+	}
+
+	if( dropped > 0 ) {
+		char msg[ 128 ];
+		snprintf( msg, sizeof( msg ), "%" PRIu64 " console messages dropped, the log writer fell behind\n", dropped );
+		Sys_ConsoleOutput( msg );
+		if( log_file ) {
+			FS_Write( timestamp, timestamp_len, log_file );
+			FS_Write( msg, strlen( msg ), log_file );
+		}
+	}
+
+	// once per batch rather than once per message
+	if( log_file && logconsole_flush && logconsole_flush->integer ) {
+		FS_Flush( log_file );
+	}
+}
+
+static void Com_FlushConsoleLog() {
+	Lock( log_write_mutex );
+	Com_WriteLogBatch();
+	Unlock( log_write_mutex );
+}
+
+static void Com_LogWriterThread( void *data ) {
+#if TRACY_ENABLE
+	tracy::SetThreadName( "Log writer" );
+#endif
+
+	while( true ) {
+		Wait( log_writer_sem );
+
+		Com_FlushConsoleLog();
+
+		Lock( com_print_mutex );
+		bool quit = log_writer_quit;
+		Unlock( com_print_mutex );
+
+		if( quit ) {
+			break;
+		}
+	}
+}
+
+static void Com_InitLogWriter() {
+	log_write_mutex = NewMutex();
+	log_writer_sem = NewSemaphore();
+	log_writer_quit = false;
+	log_writer = NewThread( Com_LogWriterThread );
+}
+
+static void Com_ShutdownLogWriter() {
+	Lock( com_print_mutex );
+	log_writer_quit = true;
+	Unlock( com_print_mutex );
+
+	// anything printed from here on is written immediately
+	Signal( log_writer_sem );
+	JoinThread( log_writer );
+	log_writer = NULL;
+
+	Com_FlushConsoleLog();
+	DeleteSemaphore( log_writer_sem );
+}
+
 void Com_DeferConsoleLogReopen() {
 	if( logconsole != NULL ) {
 		logconsole->modified = true;
@@ -118,9 +279,12 @@ static void Com_CloseConsoleLog( bool lock, bool shutdown ) {
 	}
 
 	if( lock ) {
-		Lock( com_print_mutex );
+		Lock( log_write_mutex );
 	}
 
+	// don't lose what's still queued for the old file
+	Com_WriteLogBatch();
+
 	if( log_file ) {
 		FS_FCloseFile( log_file );
 		log_file = 0;
@@ -131,14 +295,14 @@ static void Com_CloseConsoleLog( bool lock, bool shutdown ) {
 	}
 
 	if( lock ) {
-		Unlock( com_print_mutex );
+		Unlock( log_write_mutex );
 	}
 }
 
 static void Com_ReopenConsoleLog() {
 	char errmsg[MAX_PRINTMSG] = { 0 };
 
-	Lock( com_print_mutex );
+	Lock( log_write_mutex );
 
 	Com_CloseConsoleLog( false, false );
 
@@ -159,7 +323,7 @@ static void Com_ReopenConsoleLog() {
 		Mem_TempFree( name );
 	}
 
-	Unlock( com_print_mutex );
+	Unlock( log_write_mutex );
 
 	if( errmsg[0] ) {
 		Com_Printf( "%s", errmsg );
@@ -181,7 +345,6 @@ void Com_Printf( const char *format, ... ) {
 	va_end( argptr );
 
 	Lock( com_print_mutex );
-	defer { Unlock( com_print_mutex ); };
 
 	if( rd_target ) {
 		if( (int)( strlen( msg ) + strlen( rd_buffer ) ) > ( rd_buffersize - 1 ) ) {
@@ -189,26 +352,25 @@ void Com_Printf( const char *format, ... ) {
 			*rd_buffer = 0;
 		}
 		Q_strncatz( rd_buffer, msg, rd_buffersize );
+		Unlock( com_print_mutex );
 		return;
 	}
 
-	// also echo to debugging console
-	Sys_ConsoleOutput( msg );
-
 	Con_Print( msg );
 
 	TracyMessage( msg, strlen( msg ) );
 
-	if( log_file ) {
-		if( logconsole_timestamp && logconsole_timestamp->integer ) {
-			char timestamp[MAX_PRINTMSG];
-			Sys_FormatTime( timestamp, sizeof( timestamp ), "%Y-%m-%dT%H:%M:%SZ " );
-			FS_Printf( log_file, "%s", timestamp );
-		}
-		FS_Printf( log_file, "%s", msg );
-		if( logconsole_flush && logconsole_flush->integer ) {
-			FS_Flush( log_file ); // force it to save every time
-		}
+	// stdout and the log file get it from the writer thread
+	bool wake_writer = Com_PushLogMessage( msg );
+	bool async = log_writer != NULL && !log_writer_quit;
+
+	Unlock( com_print_mutex );
+
+	if( !async ) {
+		Com_FlushConsoleLog();
+	}
+	else if( wake_writer ) {
+		Signal( log_writer_sem );
 	}
 }
 
@@ -263,6 +425,7 @@ void Com_Error( com_error_code_t code, const char *format, ... ) {
 #if PUBLIC_BUILD
 		longjmp( abortframe, -1 );
 #else
+		Com_FlushConsoleLog();
 		abort();
 #endif
 	} else {
@@ -271,6 +434,8 @@ void Com_Error( com_error_code_t code, const char *format, ... ) {
 		CL_Shutdown();
 	}
 
+	Com_FlushConsoleLog();
+
 	if( log_file ) {
 		FS_FCloseFile( log_file );
 		log_file = 0;
@@ -489,6 +654,61 @@ void Q_free( void *buf ) {
 	free( buf );
 }
 
+static void Com_PrintBenchmarkPass( s64 * samples, int count, bool sync ) {
+	for( int i = 0; i < count; i++ ) {
+		s64 start = Sys_Microseconds();
+		Com_Printf( "printbenchmark %s %d: the quick brown fox jumps over the lazy dog\n", sync ? "sync" : "async", i );
+		if( sync ) {
+			Com_FlushConsoleLog();
+		}
+		samples[ i ] = Sys_Microseconds() - start;
+	}
+}
+
+/*
+* Com_PrintBenchmark_f
+* times Com_Printf with the writer thread against writing everything in place like we used to
+*/
+static void Com_PrintBenchmark_f() {
+	int count = Cmd_Argc() >= 2 ? Clamp( 1, atoi( Cmd_Argv( 1 ) ), 1000000 ) : 10000;
+
+	s64 * sync_samples = ALLOC_MANY( sys_allocator, s64, count );
+	s64 * async_samples = ALLOC_MANY( sys_allocator, s64, count );
+	defer {
+		FREE( sys_allocator, sync_samples );
+		FREE( sys_allocator, async_samples );
+	};
+
+	Com_FlushConsoleLog();
+	s64 sync_start = Sys_Microseconds();
+	Com_PrintBenchmarkPass( sync_samples, count, true );
+	s64 sync_time = Sys_Microseconds() - sync_start;
+
+	Lock( com_print_mutex );
+	u64 dropped_before = log_dropped_total;
+	Unlock( com_print_mutex );
+
+	s64 async_start = Sys_Microseconds();
+	Com_PrintBenchmarkPass( async_samples, count, false );
+	s64 async_time = Sys_Microseconds() - async_start;
+
+	Lock( com_print_mutex );
+	u64 dropped = log_dropped_total - dropped_before;
+	Unlock( com_print_mutex );
+
+	Com_FlushConsoleLog();
+
+	std::sort( sync_samples, sync_samples + count );
+	std::sort( async_samples, async_samples + count );
+
+	Com_Printf( "%d prints each, %" PRIu64 " dropped by the async pass\n", count, dropped );
+	Com_Printf( "         total ms   prints/ms   p50 us   p99 us   max us\n" );
+	Com_Printf( "sync   %10.2f %11.1f %8" PRIi64 " %8" PRIi64 " %8" PRIi64 "\n", sync_time / 1000.0, count / Max2( 0.001, sync_time / 1000.0 ),
+		sync_samples[ count / 2 ], sync_samples[ count * 99 / 100 ], sync_samples[ count - 1 ] );
+	Com_Printf( "async  %10.2f %11.1f %8" PRIi64 " %8" PRIi64 " %8" PRIi64 "\n", async_time / 1000.0, count / Max2( 0.001, async_time / 1000.0 ),
+		async_samples[ count / 2 ], async_samples[ count * 99 / 100 ], async_samples[ count - 1 ] );
+}
+
 /*
 * Qcommon_InitCommands
 */
@@ -499,6 +719,8 @@ void Qcommon_InitCommands() {
 		Cmd_AddCommand( "quit", Com_Quit );
 	}
 
+	Cmd_AddCommand( "printbenchmark", Com_PrintBenchmark_f );
+
 	commands_intialized = true;
 }
 
@@ -514,6 +736,8 @@ void Qcommon_ShutdownCommands() {
 		Cmd_RemoveCommand( "quit" );
 	}
 
+	Cmd_RemoveCommand( "printbenchmark" );
+
 	commands_intialized = false;
 }
 
@@ -534,6 +758,7 @@ void Qcommon_Init( int argc, char **argv ) {
 	}
 
 	com_print_mutex = NewMutex();
+	Com_InitLogWriter();
 
 	// initialize memory manager
 	Memory_Init();
@@ -602,11 +827,16 @@ void Qcommon_Init( int argc, char **argv ) {
 
 	CSPRNG_Init();
 
+	Metrics_Init();
+	metric_allocations = NewCounter( "main_thread_allocations_total", "Allocations made on the main thread" );
+
 	NET_Init();
 	Netchan_Init();
 
 	InitMapList();
 
+	InitThreadPool();
+
 	SV_Init();
 	CL_Init();
 
@@ -658,19 +888,26 @@ void Qcommon_Frame( unsigned int realMsec ) {
 
 	SV_Frame( realMsec, gameMsec );
 	CL_Frame( realMsec, gameMsec );
+
+	metric_allocations->value = ThreadAllocationCount();
+	Metrics_Publish();
 }
 
 /*
 * Qcommon_Shutdown
 */
 void Qcommon_Shutdown() {
+	ShutdownThreadPool();
+
 	Netchan_Shutdown();
 	NET_Shutdown();
+	Metrics_Shutdown();
 	Key_Shutdown();
 
 	Qcommon_ShutdownCommands();
 	Memory_ShutdownCommands();
 
+	Com_ShutdownLogWriter();
 	Com_CloseConsoleLog( true, true );
 
 	FS_Shutdown();
@@ -683,5 +920,6 @@ void Qcommon_Shutdown() {
 	Cbuf_Shutdown();
 	Memory_Shutdown();
 
+	DeleteMutex( log_write_mutex );
 	DeleteMutex( com_print_mutex );
 }
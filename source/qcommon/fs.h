@@ -25,6 +25,10 @@ bool WriteFile( TempAllocator * temp, const char * path, const void * data, size
 bool MoveFile( Allocator * a, const char * old_path, const char * new_path, MoveFileReplace replace );
 bool RemoveFile( Allocator * a, const char * path );
 
+// returns an empty span if the file doesn't exist or is empty
+Span< const u8 > MapFile( Allocator * a, const char * path );
+void UnmapFile( Span< const u8 > mapped );
+
 struct ListDirHandle {
 	char impl[ 64 ];
 };
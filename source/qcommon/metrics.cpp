@@ -0,0 +1,198 @@
+#include <algorithm>
+
+#include "qcommon/base.h"
+#include "qcommon/qcommon.h"
+#include "qcommon/metrics.h"
+#include "qcommon/string.h"
+#include "qcommon/threads.h"
+
+static constexpr size_t MAX_METRICS = 128;
+
+static Metric metrics[ MAX_METRICS ];
+static size_t num_metrics;
+
+// what the HTTP thread sees, guarded by published_mutex
+static Metric published[ MAX_METRICS ];
+static size_t num_published;
+static Mutex * published_mutex;
+
+void Metrics_Init() {
+	published_mutex = NewMutex();
+}
+
+void Metrics_Shutdown() {
+	DeleteMutex( published_mutex );
+	published_mutex = NULL;
+}
+
+static Metric * NewMetric( MetricType type, const char * name, const char * help ) {
+	for( size_t i = 0; i < num_metrics; i++ ) {
+		if( strcmp( metrics[ i ].name, name ) == 0 ) {
+			assert( metrics[ i ].type == type );
+			return &metrics[ i ];
+		}
+	}
+
+	if( num_metrics == ARRAY_COUNT( metrics ) ) {
+		Com_Error( ERR_FATAL, "Too many metrics" );
+	}
+
+	Metric * metric = &metrics[ num_metrics ];
+	num_metrics++;
+
+	*metric = { };
+	metric->type = type;
+	metric->name = name;
+	metric->help = help;
+
+	return metric;
+}
+
+Metric * NewCounter( const char * name, const char * help ) {
+	return NewMetric( MetricType_Counter, name, help );
+}
+
+Metric * NewGauge( const char * name, const char * help ) {
+	return NewMetric( MetricType_Gauge, name, help );
+}
+
+Metric * NewHistogram( const char * name, const char * help, Span< const double > bounds ) {
+	assert( bounds.n <= MAX_HISTOGRAM_BUCKETS );
+
+	Metric * metric = NewMetric( MetricType_Histogram, name, help );
+	metric->num_bounds = Min2( bounds.n, MAX_HISTOGRAM_BUCKETS );
+	for( size_t i = 0; i < metric->num_bounds; i++ ) {
+		metric->bounds[ i ] = bounds[ i ];
+	}
+
+	return metric;
+}
+
+void Metrics_Publish() {
+	ZoneScoped;
+
+	if( published_mutex == NULL ) {
+		return;
+	}
+
+	Lock( published_mutex );
+	memcpy( published, metrics, sizeof( Metric ) * num_metrics );
+	num_published = num_metrics;
+	Unlock( published_mutex );
+}
+
+/*
+ * Prometheus text exposition format
+ */
+
+static Span< const char > MetricBaseName( const char * name ) {
+	const char * labels = strchr( name, '{' );
+	return Span< const char >( name, labels != NULL ? labels - name : strlen( name ) );
+}
+
+static Span< const char > MetricLabels( const char * name ) {
+	const char * labels = strchr( name, '{' );
+	if( labels == NULL ) {
+		return Span< const char >();
+	}
+
+	// without the braces
+	return Span< const char >( labels + 1, strlen( labels ) - 2 );
+}
+
+static void AppendNumber( DynamicString * str, double x ) {
+	char buf[ 64 ];
+	snprintf( buf, sizeof( buf ), "%.9g", x );
+	str->append( "{}", buf );
+}
+
+// ggformat's brace escaping doesn't handle {{{}, so braces go in as arguments
+static void FormatHistogramLine( DynamicString * str, const Metric * metric, const char * suffix, const char * le ) {
+	Span< const char > labels = MetricLabels( metric->name );
+
+	str->append( "{}{}", MetricBaseName( metric->name ), suffix );
+	if( le != NULL ) {
+		if( labels.n > 0 ) {
+			str->append( "{}{},le=\"{}\"{}", "{", labels, le, "}" );
+		}
+		else {
+			str->append( "{}le=\"{}\"{}", "{", le, "}" );
+		}
+	}
+	else if( labels.n > 0 ) {
+		str->append( "{}{}{}", "{", labels, "}" );
+	}
+	str->append( " " );
+}
+
+static void FormatMetric( DynamicString * str, const Metric * metric ) {
+	if( metric->type != MetricType_Histogram ) {
+		str->append( "{} ", metric->name );
+		AppendNumber( str, metric->value );
+		str->append( "\n" );
+		return;
+	}
+
+	u64 cumulative = 0;
+	for( size_t i = 0; i < metric->num_bounds; i++ ) {
+		char le[ 64 ];
+		snprintf( le, sizeof( le ), "%.9g", metric->bounds[ i ] );
+
+		cumulative += metric->buckets[ i ];
+		FormatHistogramLine( str, metric, "_bucket", le );
+		str->append( "{}\n", cumulative );
+	}
+
+	FormatHistogramLine( str, metric, "_bucket", "+Inf" );
+	str->append( "{}\n", metric->count );
+
+	FormatHistogramLine( str, metric, "_sum", NULL );
+	AppendNumber( str, metric->sum );
+	str->append( "\n" );
+
+	FormatHistogramLine( str, metric, "_count", NULL );
+	str->append( "{}\n", metric->count );
+}
+
+void Metrics_Format( DynamicString * str ) {
+	constexpr const char * type_names[] = { "counter", "gauge", "histogram" };
+
+	Lock( published_mutex );
+
+	Span< const char > family = Span< const char >();
+	for( size_t i = 0; i < num_published; i++ ) {
+		const Metric * metric = &published[ i ];
+
+		// HELP and TYPE once per family of labelled metrics
+		Span< const char > base = MetricBaseName( metric->name );
+		if( base.n != family.n || memcmp( base.ptr, family.ptr, base.n ) != 0 ) {
+			str->append( "# HELP {} {}\n", base, metric->help );
+			str->append( "# TYPE {} {}\n", base, type_names[ metric->type ] );
+			family = base;
+		}
+
+		FormatMetric( str, metric );
+	}
+
+	Unlock( published_mutex );
+}
+
+void PrintPercentilesHeader( const char * title ) {
+	Com_Printf( "%-10s %8s %8s %8s %8s\n", title, "p50", "p90", "p99", "max" );
+}
+
+void PrintPercentiles( const char * name, Span< s64 > samples ) {
+	if( samples.n == 0 ) {
+		Com_Printf( "%-10s %8s %8s %8s %8s\n", name, "-", "-", "-", "-" );
+		return;
+	}
+
+	std::sort( samples.begin(), samples.end() );
+
+	auto percentile = [&]( size_t p ) {
+		return samples[ Min2( samples.n - 1, samples.n * p / 100 ) ];
+	};
+
+	Com_Printf( "%-10s %8u %8u %8u %8u\n", name,
+		u32( percentile( 50 ) ), u32( percentile( 90 ) ), u32( percentile( 99 ) ), u32( samples[ samples.n - 1 ] ) );
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "qcommon/types.h"
+
+/*
+ * Counters, gauges and fixed bucket histograms, served as Prometheus text by
+ * the server's /metrics page.
+ *
+ * Recording is a plain add with no locking, so metrics must only be touched
+ * from the main thread. Metrics_Publish copies them for the HTTP thread once
+ * a frame. Names and help strings must be string literals. Names can carry
+ * labels, like frame_seconds_total{stage="game"}, and metrics with the same
+ * name apart from the labels should be registered one after another.
+ */
+
+constexpr size_t MAX_HISTOGRAM_BUCKETS = 16;
+
+enum MetricType {
+	MetricType_Counter,
+	MetricType_Gauge,
+	MetricType_Histogram,
+};
+
+struct Metric {
+	MetricType type;
+	const char * name;
+	const char * help;
+
+	double value; // counters and gauges
+
+	double bounds[ MAX_HISTOGRAM_BUCKETS ];
+	size_t num_bounds;
+	u64 buckets[ MAX_HISTOGRAM_BUCKETS + 1 ];
+	double sum;
+	u64 count;
+};
+
+void Metrics_Init();
+void Metrics_Shutdown();
+
+// registering the same name twice returns the same metric, so it's fine to do on every map load
+Metric * NewCounter( const char * name, const char * help );
+Metric * NewGauge( const char * name, const char * help );
+Metric * NewHistogram( const char * name, const char * help, Span< const double > bounds );
+
+inline void Increment( Metric * counter, double x = 1.0 ) {
+	counter->value += x;
+}
+
+inline void SetGauge( Metric * gauge, double x ) {
+	gauge->value = x;
+}
+
+inline void Observe( Metric * histogram, double x ) {
+	size_t bucket = 0;
+	while( bucket < histogram->num_bounds && x > histogram->bounds[ bucket ] ) {
+		bucket++;
+	}
+	histogram->buckets[ bucket ]++;
+	histogram->sum += x;
+	histogram->count++;
+}
+
+void Metrics_Publish();
+
+class DynamicString;
+void Metrics_Format( DynamicString * str );
+
+// for printing timings to the console, sorts samples
+void PrintPercentilesHeader( const char * title );
+void PrintPercentiles( const char * name, Span< s64 > samples );
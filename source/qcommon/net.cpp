@@ -36,6 +36,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #endif
 
 #include "qcommon/qcommon.h"
+#include "qcommon/metrics.h"
 #include "qcommon/sys_net.h"
 
 #define MAX_LOOPBACK    4
@@ -68,6 +69,11 @@ static loopback_t loopbacks[2];
 static char errorstring[MAX_PRINTMSG];
 static bool net_initialized = false;
 
+static Metric *metric_packets_sent;
+static Metric *metric_packets_received;
+static Metric *metric_bytes_sent;
+static Metric *metric_bytes_received;
+
 /*
 =============================================================================
 PRIVATE FUNCTIONS
@@ -763,8 +769,14 @@ int NET_GetPacket( const socket_t *socket, netadr_t *address, msg_t *message ) {
 		case SOCKET_LOOPBACK:
 			return NET_Loopback_GetPacket( socket, address, message );
 
-		case SOCKET_UDP:
-			return NET_UDP_GetPacket( socket, address, message );
+		case SOCKET_UDP: {
+			int ret = NET_UDP_GetPacket( socket, address, message );
+			if( ret == 1 ) {
+				Increment( metric_packets_received );
+				Increment( metric_bytes_received, message->cursize );
+			}
+			return ret;
+		}
 
 		case SOCKET_TCP:
 			return NET_TCP_GetPacket( socket, address, message );
@@ -825,6 +837,8 @@ bool NET_SendPacket( const socket_t *socket, const void *data, size_t length, co
 			return NET_Loopback_SendPacket( socket, data, length, address );
 
 		case SOCKET_UDP:
+			Increment( metric_packets_sent );
+			Increment( metric_bytes_sent, length );
 			return NET_UDP_SendPacket( socket, data, length, address );
 
 		case SOCKET_TCP:
@@ -1572,6 +1586,11 @@ void NET_Init() {
 
 	Sys_NET_Init();
 
+	metric_packets_sent = NewCounter( "net_packets_sent_total", "UDP packets sent" );
+	metric_packets_received = NewCounter( "net_packets_received_total", "UDP packets received" );
+	metric_bytes_sent = NewCounter( "net_sent_bytes_total", "UDP bytes sent, including headers written by netchan" );
+	metric_bytes_received = NewCounter( "net_received_bytes_total", "UDP bytes received" );
+
 	net_initialized = true;
 }
 
@@ -20,6 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "qcommon/qcommon.h"
 #include "qcommon/csprng.h"
+#include "qcommon/metrics.h"
 
 #if defined ( __MACOSX__ )
 #include <arpa/inet.h>
@@ -85,6 +86,10 @@ static cvar_t *showpackets;
 static cvar_t *showdrop;
 static cvar_t *net_showfragments;
 
+static Metric *metric_fragments_sent;
+static Metric *metric_fragments_received;
+static Metric *metric_dropped;
+
 /*
 * Netchan_OutOfBand
 *
@@ -294,6 +299,8 @@ bool Netchan_TransmitNextFragment( netchan_t *chan ) {
 	int fragmentLength;
 	bool last;
 
+	Increment( metric_fragments_sent );
+
 	// write the packet header
 	MSG_Init( &send, send_buf, sizeof( send_buf ) );
 	MSG_Clear( &send );
@@ -522,6 +529,7 @@ bool Netchan_Process( netchan_t *chan, msg_t *msg ) {
 	//
 	chan->dropped = sequence - ( chan->incomingSequence + 1 );
 	if( chan->dropped > 0 ) {
+		Increment( metric_dropped, chan->dropped );
 		if( showdrop->integer || showpackets->integer ) {
 			Com_Printf( "%s:Dropped %i packets at %i\n", NET_AddressToString( &chan->remoteAddress ), chan->dropped,
 						sequence );
@@ -533,6 +541,8 @@ bool Netchan_Process( netchan_t *chan, msg_t *msg ) {
 	// bump incoming_reliable_sequence
 	//
 	if( fragmented ) {
+		Increment( metric_fragments_received );
+
 		// TTimo
 		// make sure we add the fragments in correct order
 		// either a packet was dropped, or we received this one too soon
@@ -619,6 +629,10 @@ void Netchan_Init() {
 	showpackets = Cvar_Get( "showpackets", "0", 0 );
 	showdrop = Cvar_Get( "showdrop", "0", 0 );
 	net_showfragments = Cvar_Get( "net_showfragments", "0", 0 );
+
+	metric_fragments_sent = NewCounter( "netchan_fragments_sent_total", "Netchan message fragments sent" );
+	metric_fragments_received = NewCounter( "netchan_fragments_received_total", "Netchan message fragments received" );
+	metric_dropped = NewCounter( "netchan_dropped_packets_total", "Netchan packets that never arrived" );
 }
 
 /*
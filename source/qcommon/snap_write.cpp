@@ -18,6 +18,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 */
 
+#include <algorithm> // std::sort
+
 #include "qcommon/qcommon.h"
 #include "qcommon/cmodel.h"
 #include "server/server.h"
@@ -98,6 +100,142 @@ static void SNAP_EmitPacketEntities( ginfo_t *gi, client_snapshot_t *from, clien
 	MSG_WriteEntityNumber( msg, 0, false ); // end of packetentities
 }
 
+/*
+* SNAP_EntityPriority
+*/
+static float SNAP_EntityPriority( const SyncEntityState *ent, Vec3 vieworg, int deferred ) {
+	// players matter more than props, and the longer an update waits the more it matters
+	float relevance = ent->type == ET_PLAYER ? 4.0f : 1.0f;
+	float dist = Max2( 256.0f, Length( ent->origin - vieworg ) );
+	return relevance * ( 1 + deferred ) / dist;
+}
+
+struct SnapCandidate {
+	int index;
+	const SyncEntityState *old;         // NULL for entities the client doesn't have yet
+	size_t bytes;
+	float priority;
+};
+
+/*
+* SNAP_ScheduleEntities
+*
+* Fits the entity updates into the client's byte budget. Updates that don't
+* fit are held back: entities the client already has keep the state they
+* were acked with so nothing gets written for them, and new entities are
+* left out of the frame. Either way the frame ends up holding exactly what
+* the client has, so later deltas from it stay correct.
+*/
+static void SNAP_ScheduleEntities( client_t *client, client_snapshot_t *from, client_snapshot_t *to, size_t budget,
+								   SyncEntityState *baselines, SyncEntityState *client_entities, int num_client_entities ) {
+	static uint8_t scratch_data[MAX_MSGLEN];
+	static SnapCandidate candidates[MAX_EDICTS];
+	int num_candidates = 0;
+
+	const SyncPlayerState *ps = &to->ps[0];
+	Vec3 vieworg = ps->pmove.origin;
+	vieworg.z += ps->viewheight;
+
+	msg_t scratch;
+	MSG_Init( &scratch, scratch_data, sizeof( scratch_data ) );
+
+	int from_num_entities = from != NULL ? from->num_entities : 0;
+	size_t required = 0;
+
+	int oldindex = 0;
+	for( int newindex = 0; newindex < to->num_entities; newindex++ ) {
+		SyncEntityState *newent = &client_entities[( to->first_entity + newindex ) % num_client_entities];
+		const SyncEntityState *oldent = NULL;
+
+		// removals are always sent
+		while( oldindex < from_num_entities ) {
+			const SyncEntityState *ent = &client_entities[( from->first_entity + oldindex ) % num_client_entities];
+			if( ent->number > newent->number ) {
+				break;
+			}
+			oldindex++;
+			if( ent->number == newent->number ) {
+				oldent = ent;
+				break;
+			}
+			required += 2;
+		}
+
+		MSG_Clear( &scratch );
+		if( oldent != NULL ) {
+			MSG_WriteDeltaEntity( &scratch, oldent, newent, false );
+		} else {
+			MSG_WriteDeltaEntity( &scratch, &baselines[newent->number], newent, true );
+		}
+
+		if( scratch.cursize == 0 ) {
+			client->snap_deferred[newent->number] = 0;
+			continue;
+		}
+
+		// the client's own entity, its POV and events can't wait, and
+		// holding back an entity that had events would fire them again
+		int deferred = client->snap_deferred[newent->number];
+		bool has_events = newent->type == ET_SOUNDEVENT || newent->events[0].type != 0 || ( oldent != NULL && oldent->events[0].type != 0 );
+		bool must_send = newent->number == int( ps->playerNum + 1 ) || newent->number == int( ps->POVnum ) ||
+			has_events || deferred >= SNAP_MAX_DEFERRED;
+		if( must_send ) {
+			client->snap_deferred[newent->number] = 0;
+			required += scratch.cursize;
+			continue;
+		}
+
+		SnapCandidate *candidate = &candidates[num_candidates++];
+		candidate->index = newindex;
+		candidate->old = oldent;
+		candidate->bytes = scratch.cursize;
+		candidate->priority = SNAP_EntityPriority( newent, vieworg, deferred );
+	}
+
+	std::sort( candidates, candidates + num_candidates, []( const SnapCandidate & a, const SnapCandidate & b ) {
+		return a.priority > b.priority;
+	} );
+
+	size_t remaining = budget > required ? budget - required : 0;
+	bool dropped_new = false;
+
+	for( int i = 0; i < num_candidates; i++ ) {
+		SnapCandidate *candidate = &candidates[i];
+		SyncEntityState *newent = &client_entities[( to->first_entity + candidate->index ) % num_client_entities];
+
+		if( candidate->bytes <= remaining ) {
+			remaining -= candidate->bytes;
+			client->snap_deferred[newent->number] = 0;
+			continue;
+		}
+
+		client->snap_deferred[newent->number]++;
+		client->netstats_deferred++;
+
+		if( candidate->old != NULL ) {
+			*newent = *candidate->old;
+		} else {
+			newent->number = 0;
+			dropped_new = true;
+		}
+	}
+
+	if( !dropped_new ) {
+		return;
+	}
+
+	// squeeze the held back new entities out of the frame
+	int num_entities = 0;
+	for( int i = 0; i < to->num_entities; i++ ) {
+		const SyncEntityState *ent = &client_entities[( to->first_entity + i ) % num_client_entities];
+		if( ent->number != 0 ) {
+			client_entities[( to->first_entity + num_entities ) % num_client_entities] = *ent;
+			num_entities++;
+		}
+	}
+	to->num_entities = num_entities;
+}
+
 /*
 * SNAP_WriteDeltaGameStateToClient
 */
@@ -320,6 +458,12 @@ void SNAP_WriteFrameSnapToClient( ginfo_t *gi, client_t *client, msg_t *msg, int
 	}
 	MSG_WriteUint8( msg, 0 );
 
+	// hold back what doesn't fit in the client's budget
+	if( client->snap_budget > 0 && !frame->multipov ) {
+		size_t budget = size_t( client->snap_budget ) > msg->cursize ? client->snap_budget - msg->cursize : 0;
+		SNAP_ScheduleEntities( client, oldframe, frame, budget, baselines, client_entities->entities, client_entities->num_entities );
+	}
+
 	// delta encode the entities
 	SNAP_EmitPacketEntities( gi, oldframe, frame, msg, baselines, client_entities->entities, client_entities->num_entities );
 
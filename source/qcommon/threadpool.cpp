@@ -1,7 +1,6 @@
 #include "qcommon/base.h"
 #include "qcommon/threads.h"
-#include "client/client.h"
-#include "client/threadpool.h"
+#include "qcommon/threadpool.h"
 
 struct Job {
 	JobCallback callback;
@@ -25,6 +24,9 @@ static size_t jobs_done;
 static Worker workers[ 32 ];
 static u32 num_workers;
 
+// for jobs the calling thread picks up in ThreadPoolFinish
+static ArenaAllocator main_thread_arena;
+
 static void ThreadPoolWorker( void * data ) {
 #if TRACY_ENABLE
 	tracy::SetThreadName( "Thread pool worker" );
@@ -78,8 +80,10 @@ void InitThreadPool() {
 
 	num_workers = Min2( GetCoreCount() - 1, u32( ARRAY_COUNT( workers ) ) );
 
+	constexpr size_t arena_size = 1024 * 1024; // 1MB
+	main_thread_arena = ArenaAllocator( ALLOC_SIZE( sys_allocator, arena_size, 16 ), arena_size );
+
 	for( u32 i = 0; i < num_workers; i++ ) {
-		constexpr size_t arena_size = 1024 * 1024; // 1MB
 		void * arena_memory = ALLOC_SIZE( sys_allocator, arena_size, 16 );
 		workers[ i ].arena = ArenaAllocator( arena_memory, arena_size );
 		workers[ i ].thread = NewThread( ThreadPoolWorker, &workers[ i ].arena );
@@ -102,6 +106,8 @@ void ShutdownThreadPool() {
 		FREE( sys_allocator, workers[ i ].arena.get_memory() );
 	}
 
+	FREE( sys_allocator, main_thread_arena.get_memory() );
+
 	DeleteSemaphore( completion_sem );
 	DeleteSemaphore( jobs_sem );
 	DeleteMutex( jobs_mutex );
@@ -167,7 +173,7 @@ void ThreadPoolFinish() {
 		Unlock( jobs_mutex );
 
 		{
-			TempAllocator temp = cls.frame_arena.temp();
+			TempAllocator temp = main_thread_arena.temp();
 			job->callback( &temp, job->data );
 		}
 
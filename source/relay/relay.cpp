@@ -0,0 +1,1447 @@
+#include "qcommon/qcommon.h"
+#include "qcommon/csprng.h"
+#include "qcommon/rng.h"
+#include "qcommon/version.h"
+#include "gameshared/gs_public.h"
+#include "cgame/cg_public.h"
+
+/*
+ * relay connects to a game server once as a multiview client, the same kind
+ * of stream the server records demos from, and re-serves it to spectators.
+ * The game server builds and sends one snapshot per frame no matter how many
+ * people are watching.
+ *
+ * Viewers speak the normal client protocol to the relay. They get the
+ * relay's copy of the configstrings and baselines while connecting, then
+ * every upstream frame delta encoded against whichever frame they last
+ * acked. Viewers acking the same frame get the same bytes, so each frame is
+ * usually encoded once or twice however many viewers there are.
+ *
+ * The game server has to set sv_relay_password, and the relay sends it in
+ * relay_password.
+ *
+ * Usage: relay +relay <address>
+ * Spectators connect to relay_port, 44500 by default. loadgen makes good
+ * synthetic viewers.
+ */
+
+snapshot_t *SNAP_ParseFrame( msg_t *msg, snapshot_t *lastFrame, snapshot_t *backup, SyncEntityState *baselines, int showNet );
+void SNAP_ParseBaseline( msg_t *msg, SyncEntityState *baselines );
+
+static constexpr int RELAY_MAX_VIEWERS = 1024;
+static constexpr int RELAY_MAX_CHALLENGES = 1024;
+static constexpr int RELAY_MAX_ENCODED_FRAMES = 8;
+static constexpr int64_t RELAY_RESEND_TIME = 1000;
+static constexpr int64_t RELAY_RECONNECT_TIME = 3000;
+static constexpr int64_t RELAY_TIMEOUT = 10000;
+
+enum RelayUpstreamState {
+	RelayUpstream_Disconnected,
+	RelayUpstream_Connecting,
+	RelayUpstream_Handshake,
+	RelayUpstream_Connected,
+	RelayUpstream_Active,
+};
+
+struct RelayUpstream {
+	RelayUpstreamState state;
+
+	socket_t socket;
+	netchan_t netchan;
+	u64 session_id;
+	int64_t connect_time;
+	int64_t retry_time;
+
+	char reliable_commands[ MAX_RELIABLE_COMMANDS ][ MAX_STRING_CHARS ];
+	int64_t reliable_sequence;
+	int64_t reliable_acknowledge;
+	int64_t last_executed_server_command;
+
+	int servercount;
+	int playernum;
+	int64_t snap_frame_time;
+	char mapname[ MAX_QPATH ];
+
+	char ( * configstrings )[ MAX_CONFIGSTRING_CHARS ]; // [MAX_CONFIGSTRINGS]
+	SyncEntityState * baselines; // [MAX_EDICTS]
+	snapshot_t * snapshots; // [UPDATE_BACKUP]
+	int64_t received_snap_num;
+	int64_t sent_snap_num;
+
+	int64_t last_packet_sent_time;
+	int64_t last_packet_received_time;
+};
+
+// reliable commands are stored once and shared by every viewer they go to
+struct RelayCommand {
+	u32 refcount;
+	char text[ MAX_STRING_CHARS ];
+};
+
+enum RelayViewerState {
+	RelayViewer_Free,
+	RelayViewer_Connected,
+	RelayViewer_Loading,
+	RelayViewer_Active,
+};
+
+struct RelayViewer {
+	RelayViewerState state;
+	char name[ MAX_NAME_CHARS ];
+	bool waiting_for_upstream; // asked for "new" before the relay had anything to send
+	bool overflowed; // dropped at the end of the frame
+
+	netchan_t netchan;
+
+	RelayCommand * reliable_commands[ MAX_RELIABLE_COMMANDS ];
+	int64_t reliable_sequence;
+	int64_t reliable_sent;
+	int64_t reliable_acknowledge;
+	int64_t client_command_executed;
+
+	int64_t ucmd_received;
+	int64_t lastframe;
+
+	int64_t last_packet_sent_time;
+	int64_t last_packet_received_time;
+};
+
+struct RelayChallenge {
+	netadr_t address;
+	int challenge;
+	int64_t time;
+};
+
+// an encoded frame body, shared by every viewer acking the same delta frame
+struct RelayEncodedFrame {
+	int64_t delta_frame;
+	size_t offset;
+	size_t length;
+};
+
+struct RelayStats {
+	u32 snaps;
+	u32 encodes;
+	u32 packets_received;
+	u32 packets_sent;
+	u64 bytes_received;
+	u64 bytes_sent;
+};
+
+static cvar_t * relay_port;
+static cvar_t * relay_password;
+static cvar_t * relay_name;
+static cvar_t * relay_maxviewers;
+
+static RelayUpstream upstream;
+static netadr_t upstream_address;
+static bool relay_running;
+
+static socket_t listen_socket;
+static RelayViewer * viewers[ RELAY_MAX_VIEWERS ];
+static RelayChallenge challenges[ RELAY_MAX_CHALLENGES ];
+
+static RelayEncodedFrame encoded_frames[ RELAY_MAX_ENCODED_FRAMES ];
+static int num_encoded_frames;
+static uint8_t encoded_frames_data[ MAX_MSGLEN * 2 ];
+static size_t encoded_frames_used;
+
+static RNG rng;
+static ArenaAllocator frame_arena;
+static int64_t realtime;
+static int64_t last_stats_time;
+static RelayStats upstream_stats;
+static RelayStats viewer_stats;
+
+// whoever's packet is being parsed, so ERR_DROPs only drop that connection
+static RelayViewer * parsing_viewer;
+static bool parsing_upstream;
+
+/*
+==============================================================================
+
+SHARED COMMANDS
+
+==============================================================================
+*/
+
+static RelayCommand * RL_NewCommand( const char * text ) {
+	RelayCommand * command = ALLOC( sys_allocator, RelayCommand );
+	command->refcount = 1;
+	Q_strncpyz( command->text, text, sizeof( command->text ) );
+	return command;
+}
+
+static void RL_ReleaseCommand( RelayCommand * command ) {
+	assert( command->refcount > 0 );
+	command->refcount--;
+	if( command->refcount == 0 ) {
+		FREE( sys_allocator, command );
+	}
+}
+
+static void RL_ReleaseViewerCommands( RelayViewer * viewer ) {
+	for( int i = 0; i < MAX_RELIABLE_COMMANDS; i++ ) {
+		if( viewer->reliable_commands[ i ] != NULL ) {
+			RL_ReleaseCommand( viewer->reliable_commands[ i ] );
+			viewer->reliable_commands[ i ] = NULL;
+		}
+	}
+}
+
+/*
+==============================================================================
+
+VIEWERS
+
+==============================================================================
+*/
+
+static void RL_FreeViewer( RelayViewer * viewer ) {
+	for( int i = 0; i < RELAY_MAX_VIEWERS; i++ ) {
+		if( viewers[ i ] == viewer ) {
+			viewers[ i ] = NULL;
+		}
+	}
+
+	if( parsing_viewer == viewer ) {
+		parsing_viewer = NULL;
+	}
+
+	RL_ReleaseViewerCommands( viewer );
+	FREE( sys_allocator, viewer );
+}
+
+static void RL_Transmit( netchan_t * netchan, msg_t * msg, RelayStats * stats ) {
+	Netchan_PushAllFragments( netchan );
+
+	int zerror = Netchan_CompressMessage( msg );
+	if( zerror < 0 ) {
+		Com_DPrintf( "RL_Transmit (ignoring compression): Compression error %i\n", zerror );
+	}
+
+	Netchan_Transmit( netchan, msg );
+
+	stats->packets_sent++;
+	stats->bytes_sent += msg->cursize;
+}
+
+static void RL_InitViewerMessage( RelayViewer * viewer, msg_t * msg, uint8_t * data, size_t size ) {
+	MSG_Init( msg, data, size );
+	MSG_Clear( msg );
+
+	// acknowledge the last client command and usercmd we got
+	MSG_WriteUint8( msg, svc_clcack );
+	MSG_WriteUintBase128( msg, viewer->client_command_executed );
+	MSG_WriteUintBase128( msg, viewer->ucmd_received );
+}
+
+static void RL_SendViewerMessage( RelayViewer * viewer, msg_t * msg ) {
+	viewer->last_packet_sent_time = realtime;
+	RL_Transmit( &viewer->netchan, msg, &viewer_stats );
+}
+
+/*
+* RL_QueueViewerCommand
+* Same sequencing and overflow rules as the game server's reliable commands
+*/
+static void RL_QueueViewerCommand( RelayViewer * viewer, RelayCommand * command ) {
+	if( viewer->overflowed ) {
+		return;
+	}
+
+	viewer->reliable_sequence++;
+	if( viewer->reliable_sequence - viewer->reliable_acknowledge == MAX_RELIABLE_COMMANDS + 1 ) {
+		viewer->reliable_sequence--;
+		viewer->overflowed = true;
+		return;
+	}
+
+	int index = viewer->reliable_sequence & ( MAX_RELIABLE_COMMANDS - 1 );
+	if( viewer->reliable_commands[ index ] != NULL ) {
+		RL_ReleaseCommand( viewer->reliable_commands[ index ] );
+	}
+	viewer->reliable_commands[ index ] = command;
+	command->refcount++;
+}
+
+static void RL_ViewerCommand( RelayViewer * viewer, const char * text ) {
+	RelayCommand * command = RL_NewCommand( text );
+	RL_QueueViewerCommand( viewer, command );
+	RL_ReleaseCommand( command );
+}
+
+static void RL_BroadcastCommand( const char * text ) {
+	RelayCommand * command = RL_NewCommand( text );
+	for( int i = 0; i < RELAY_MAX_VIEWERS; i++ ) {
+		RelayViewer * viewer = viewers[ i ];
+		if( viewer != NULL && viewer->state >= RelayViewer_Loading ) {
+			RL_QueueViewerCommand( viewer, command );
+		}
+	}
+	RL_ReleaseCommand( command );
+}
+
+static void RL_AddReliableCommandsToMessage( RelayViewer * viewer, msg_t * msg ) {
+	for( int64_t i = viewer->reliable_acknowledge + 1; i <= viewer->reliable_sequence; i++ ) {
+		const RelayCommand * command = viewer->reliable_commands[ i & ( MAX_RELIABLE_COMMANDS - 1 ) ];
+		if( command == NULL ) {
+			continue;
+		}
+		MSG_WriteUint8( msg, svc_servercmd );
+		MSG_WriteInt32( msg, i );
+		MSG_WriteString( msg, command->text );
+	}
+	viewer->reliable_sent = viewer->reliable_sequence;
+}
+
+static void RL_DropViewer( RelayViewer * viewer, const char * reason ) {
+	Com_DPrintf( "%s disconnected (%s)\n", viewer->name, reason );
+
+	msg_t msg;
+	uint8_t msg_data[ MAX_MSGLEN ];
+	RL_InitViewerMessage( viewer, &msg, msg_data, sizeof( msg_data ) );
+
+	// not through the command ring, which might be what overflowed
+	MSG_WriteUint8( &msg, svc_servercmd );
+	MSG_WriteInt32( &msg, viewer->reliable_sequence + 1 );
+	MSG_WriteString( &msg, va( "disconnect %i \"%s\"", DROP_TYPE_GENERAL, reason ) );
+	RL_SendViewerMessage( viewer, &msg );
+	Netchan_PushAllFragments( &viewer->netchan );
+
+	RL_FreeViewer( viewer );
+}
+
+static void RL_ResetViewerCommandBuffers( RelayViewer * viewer ) {
+	viewer->client_command_executed = 0;
+	viewer->reliable_sequence = 0;
+	viewer->reliable_sent = 0;
+	viewer->reliable_acknowledge = 0;
+	RL_ReleaseViewerCommands( viewer );
+
+	viewer->ucmd_received = 0;
+	viewer->lastframe = -1;
+}
+
+/*
+* RL_New
+* Sends the relay's serverdata, like SV_New_f
+*/
+static void RL_New( RelayViewer * viewer ) {
+	if( upstream.state != RelayUpstream_Active ) {
+		viewer->waiting_for_upstream = true;
+		return;
+	}
+	viewer->waiting_for_upstream = false;
+
+	msg_t msg;
+	uint8_t msg_data[ MAX_MSGLEN ];
+	RL_InitViewerMessage( viewer, &msg, msg_data, sizeof( msg_data ) );
+
+	MSG_WriteUint8( &msg, svc_serverdata );
+	MSG_WriteInt32( &msg, APP_PROTOCOL_VERSION );
+	MSG_WriteInt32( &msg, upstream.servercount );
+	MSG_WriteInt16( &msg, (unsigned short)upstream.snap_frame_time );
+	MSG_WriteInt16( &msg, upstream.playernum );
+	MSG_WriteUint8( &msg, 0 ); // no downloads from the relay
+
+	RL_ResetViewerCommandBuffers( viewer );
+
+	RL_SendViewerMessage( viewer, &msg );
+	Netchan_PushAllFragments( &viewer->netchan );
+
+	viewer->state = RelayViewer_Loading;
+}
+
+static void RL_Configstrings( RelayViewer * viewer ) {
+	if( viewer->state != RelayViewer_Loading ) {
+		return;
+	}
+
+	if( atoi( Cmd_Argv( 1 ) ) != upstream.servercount ) {
+		RL_ViewerCommand( viewer, "reconnect" );
+		return;
+	}
+
+	int start = Max2( 0, atoi( Cmd_Argv( 2 ) ) );
+	while( start < MAX_CONFIGSTRINGS && viewer->reliable_sequence - viewer->reliable_acknowledge < MAX_RELIABLE_COMMANDS - 8 ) {
+		if( upstream.configstrings[ start ][ 0 ] ) {
+			RL_ViewerCommand( viewer, va( "cs %i \"%s\"", start, upstream.configstrings[ start ] ) );
+		}
+		start++;
+	}
+
+	if( start == MAX_CONFIGSTRINGS ) {
+		RL_ViewerCommand( viewer, va( "cmd baselines %i 0", upstream.servercount ) );
+	}
+	else {
+		RL_ViewerCommand( viewer, va( "cmd configstrings %i %i", upstream.servercount, start ) );
+	}
+}
+
+static void RL_Baselines( RelayViewer * viewer ) {
+	if( viewer->state != RelayViewer_Loading ) {
+		return;
+	}
+
+	if( atoi( Cmd_Argv( 1 ) ) != upstream.servercount ) {
+		RL_New( viewer );
+		return;
+	}
+
+	int start = Max2( 0, atoi( Cmd_Argv( 2 ) ) );
+
+	msg_t msg;
+	uint8_t msg_data[ MAX_MSGLEN ];
+	RL_InitViewerMessage( viewer, &msg, msg_data, sizeof( msg_data ) );
+
+	SyncEntityState nullstate = { };
+	while( msg.cursize < FRAGMENT_SIZE * 3 && start < MAX_EDICTS ) {
+		const SyncEntityState * base = &upstream.baselines[ start ];
+		if( base->number != 0 ) {
+			MSG_WriteUint8( &msg, svc_spawnbaseline );
+			MSG_WriteDeltaEntity( &msg, &nullstate, base, true );
+		}
+		start++;
+	}
+
+	if( start == MAX_EDICTS ) {
+		RL_ViewerCommand( viewer, va( "precache %i \"%s\"", upstream.servercount, upstream.mapname ) );
+	}
+	else {
+		RL_ViewerCommand( viewer, va( "cmd baselines %i %i", upstream.servercount, start ) );
+	}
+
+	RL_AddReliableCommandsToMessage( viewer, &msg );
+	RL_SendViewerMessage( viewer, &msg );
+}
+
+static void RL_Begin( RelayViewer * viewer ) {
+	if( viewer->state != RelayViewer_Loading ) {
+		return;
+	}
+
+	if( atoi( Cmd_Argv( 1 ) ) != upstream.servercount ) {
+		RL_ViewerCommand( viewer, "changing" );
+		RL_ViewerCommand( viewer, "reconnect" );
+		return;
+	}
+
+	viewer->state = RelayViewer_Active;
+	viewer->lastframe = -1;
+	Com_Printf( "%s started watching\n", viewer->name );
+}
+
+static void RL_ExecuteViewerCommand( RelayViewer * viewer, const char * text ) {
+	Cmd_TokenizeString( text );
+	const char * c = Cmd_Argv( 0 );
+
+	if( strcmp( c, "new" ) == 0 ) {
+		RL_New( viewer );
+	}
+	else if( strcmp( c, "configstrings" ) == 0 ) {
+		RL_Configstrings( viewer );
+	}
+	else if( strcmp( c, "baselines" ) == 0 ) {
+		RL_Baselines( viewer );
+	}
+	else if( strcmp( c, "begin" ) == 0 ) {
+		RL_Begin( viewer );
+	}
+	else if( strcmp( c, "disconnect" ) == 0 ) {
+		Com_Printf( "%s disconnected\n", viewer->name );
+		RL_FreeViewer( viewer );
+	}
+
+	// spectators can't say or do anything else through the relay
+}
+
+static void RL_ParseMoveCommand( RelayViewer * viewer, msg_t * msg ) {
+	int64_t lastframe = MSG_ReadInt32( msg );
+	unsigned int ucmd_head = (unsigned int)MSG_ReadInt32( msg );
+	unsigned int ucmd_count = MSG_ReadUint8( msg );
+
+	if( ucmd_count > CMD_MASK ) {
+		RL_DropViewer( viewer, "Error: Ucmd overflow" );
+		return;
+	}
+
+	// viewers can't move anything, but the usercmds still need reading
+	usercmd_t cmds[ 2 ] = { };
+	for( unsigned int i = 0; i < ucmd_count; i++ ) {
+		MSG_ReadDeltaUsercmd( msg, &cmds[ i & 1 ], &cmds[ ( i + 1 ) & 1 ] );
+	}
+	viewer->ucmd_received = ucmd_head < 1 ? 0 : ucmd_head - 1;
+
+	if( viewer->state == RelayViewer_Active ) {
+		viewer->lastframe = lastframe;
+	}
+}
+
+static void RL_ParseViewerMessage( RelayViewer * viewer, msg_t * msg ) {
+	bool move_issued = false;
+
+	while( msg->readcount < msg->cursize ) {
+		int c = MSG_ReadUint8( msg );
+		switch( c ) {
+			default:
+				RL_DropViewer( viewer, "Error: Unknown command char" );
+				return;
+
+			case clc_move:
+				if( move_issued ) {
+					return;
+				}
+				move_issued = true;
+				RL_ParseMoveCommand( viewer, msg );
+				break;
+
+			case clc_svcack: {
+				int64_t num = MSG_ReadIntBase128( msg );
+				if( num >= viewer->reliable_acknowledge && num <= viewer->reliable_sent ) {
+					viewer->reliable_acknowledge = num;
+				}
+			} break;
+
+			case clc_clientcommand: {
+				int64_t num = MSG_ReadIntBase128( msg );
+				const char * text = MSG_ReadString( msg );
+				if( num <= viewer->client_command_executed ) {
+					continue;
+				}
+				viewer->client_command_executed = num;
+				RL_ExecuteViewerCommand( viewer, text );
+				if( parsing_viewer == NULL ) {
+					return; // disconnected
+				}
+			} break;
+		}
+
+		if( parsing_viewer == NULL ) {
+			return;
+		}
+	}
+}
+
+/*
+==============================================================================
+
+VIEWER CONNECTIONS
+
+==============================================================================
+*/
+
+static void RL_GetChallenge( const netadr_t * address ) {
+	int oldest = 0;
+	int64_t oldest_time = S64_MAX;
+
+	for( int i = 0; i < RELAY_MAX_CHALLENGES; i++ ) {
+		if( NET_CompareBaseAddress( address, &challenges[ i ].address ) ) {
+			Netchan_OutOfBandPrint( &listen_socket, address, "challenge %i", challenges[ i ].challenge );
+			return;
+		}
+		if( challenges[ i ].time < oldest_time ) {
+			oldest_time = challenges[ i ].time;
+			oldest = i;
+		}
+	}
+
+	challenges[ oldest ].address = *address;
+	challenges[ oldest ].challenge = RandomUniform( &rng, 1, S16_MAX );
+	challenges[ oldest ].time = realtime;
+	Netchan_OutOfBandPrint( &listen_socket, address, "challenge %i", challenges[ oldest ].challenge );
+}
+
+static void RL_DirectConnect( const netadr_t * address ) {
+	if( atoi( Cmd_Argv( 1 ) ) != APP_PROTOCOL_VERSION ) {
+		Netchan_OutOfBandPrint( &listen_socket, address, "reject\n%i\n%i\nServer and client don't have the same version\n", DROP_TYPE_GENERAL, 0 );
+		return;
+	}
+
+	u64 session_id = StringToU64( Cmd_Argv( 2 ), 0 );
+	int challenge = atoi( Cmd_Argv( 3 ) );
+
+	int i;
+	for( i = 0; i < RELAY_MAX_CHALLENGES; i++ ) {
+		if( NET_CompareBaseAddress( address, &challenges[ i ].address ) ) {
+			break;
+		}
+	}
+	if( i == RELAY_MAX_CHALLENGES || challenges[ i ].challenge != challenge ) {
+		Netchan_OutOfBandPrint( &listen_socket, address, "reject\n%i\n%i\nBad challenge\n", DROP_TYPE_GENERAL, DROP_FLAG_AUTORECONNECT );
+		return;
+	}
+	NET_InitAddress( &challenges[ i ].address, NA_NOTRANSMIT );
+	challenges[ i ].time = 0;
+
+	int max_viewers = Clamp( 1, relay_maxviewers->integer, RELAY_MAX_VIEWERS );
+	int slot = -1;
+	for( int j = 0; j < max_viewers; j++ ) {
+		if( viewers[ j ] == NULL ) {
+			slot = j;
+			break;
+		}
+	}
+	if( slot == -1 ) {
+		Netchan_OutOfBandPrint( &listen_socket, address, "reject\n%i\n%i\nRelay is full\n", DROP_TYPE_GENERAL, DROP_FLAG_AUTORECONNECT );
+		return;
+	}
+
+	RelayViewer * viewer = ALLOC( sys_allocator, RelayViewer );
+	memset( viewer, 0, sizeof( *viewer ) );
+	viewers[ slot ] = viewer;
+
+	const char * name = Info_ValueForKey( Cmd_Argv( 4 ), "name" );
+	Q_strncpyz( viewer->name, name != NULL ? name : "viewer", sizeof( viewer->name ) );
+
+	Netchan_Setup( &viewer->netchan, &listen_socket, address, session_id );
+	RL_ResetViewerCommandBuffers( viewer );
+	viewer->state = RelayViewer_Connected;
+	viewer->last_packet_received_time = realtime;
+
+	Netchan_OutOfBandPrint( &listen_socket, address, "client_connect\n%s", "" );
+}
+
+static void RL_ViewerConnectionlessPacket( const netadr_t * address, msg_t * msg ) {
+	MSG_BeginReading( msg );
+	MSG_ReadInt32( msg ); // skip the -1
+
+	const char * s = MSG_ReadStringLine( msg );
+	Cmd_TokenizeString( s );
+	const char * c = Cmd_Argv( 0 );
+
+	if( strcmp( c, "getchallenge" ) == 0 ) {
+		RL_GetChallenge( address );
+	}
+	else if( strcmp( c, "connect" ) == 0 ) {
+		RL_DirectConnect( address );
+	}
+}
+
+static bool RL_ProcessViewerPacket( RelayViewer * viewer, msg_t * msg ) {
+	if( !Netchan_Process( &viewer->netchan, msg ) ) {
+		return false;
+	}
+
+	MSG_BeginReading( msg );
+	MSG_ReadInt32( msg ); // sequence
+	MSG_ReadInt32( msg ); // sequence_ack
+	MSG_ReadUint64( msg ); // session_id
+	if( msg->compressed && Netchan_DecompressMessage( msg ) < 0 ) {
+		return false;
+	}
+
+	return true;
+}
+
+static void RL_ReadViewerPackets() {
+	static msg_t msg;
+	static uint8_t msg_data[ MAX_MSGLEN ];
+	MSG_Init( &msg, msg_data, sizeof( msg_data ) );
+
+	int ret;
+	netadr_t address;
+	while( listen_socket.open && ( ret = NET_GetPacket( &listen_socket, &address, &msg ) ) != 0 ) {
+		if( ret == -1 ) {
+			continue;
+		}
+
+		viewer_stats.packets_received++;
+		viewer_stats.bytes_received += msg.cursize;
+
+		if( *( int * ) msg.data == -1 ) {
+			RL_ViewerConnectionlessPacket( &address, &msg );
+			continue;
+		}
+
+		MSG_BeginReading( &msg );
+		MSG_ReadInt32( &msg ); // sequence number
+		MSG_ReadInt32( &msg ); // sequence number
+		u64 session_id = MSG_ReadUint64( &msg );
+
+		for( int i = 0; i < RELAY_MAX_VIEWERS; i++ ) {
+			RelayViewer * viewer = viewers[ i ];
+			if( viewer == NULL || viewer->netchan.session_id != session_id ) {
+				continue;
+			}
+
+			viewer->netchan.remoteAddress = address;
+			if( RL_ProcessViewerPacket( viewer, &msg ) ) {
+				viewer->last_packet_received_time = realtime;
+				parsing_viewer = viewer;
+				RL_ParseViewerMessage( viewer, &msg );
+				parsing_viewer = NULL;
+			}
+			break;
+		}
+	}
+}
+
+/*
+==============================================================================
+
+FRAMES
+
+==============================================================================
+*/
+
+static const snapshot_t * RL_Snapshot( int64_t frame_num ) {
+	if( frame_num <= 0 ) {
+		return NULL;
+	}
+	const snapshot_t * snap = &upstream.snapshots[ frame_num & UPDATE_MASK ];
+	return snap->valid && snap->serverFrame == frame_num ? snap : NULL;
+}
+
+/*
+* RL_WriteFrameBody
+*
+* Everything in svc_frame after the per-viewer header, which only depends
+* on the frame being sent and the frame it's delta'd from
+*/
+static void RL_WriteFrameBody( msg_t * msg, const snapshot_t * frame, const snapshot_t * oldframe ) {
+	int flags = FRAMESNAP_FLAG_ALLENTITIES | FRAMESNAP_FLAG_MULTIPOV;
+	if( oldframe != NULL ) {
+		flags |= FRAMESNAP_FLAG_DELTA;
+	}
+	MSG_WriteUint8( msg, flags );
+
+	// game commands from every frame the viewer hasn't acked
+	MSG_WriteUint8( msg, svc_gamecommands );
+	int64_t first = oldframe != NULL ? oldframe->serverFrame + 1 : frame->serverFrame;
+	for( int64_t num = first; num <= frame->serverFrame; num++ ) {
+		const snapshot_t * snap = RL_Snapshot( num );
+		if( snap == NULL ) {
+			continue;
+		}
+
+		for( int i = 0; i < snap->numgamecommands; i++ ) {
+			const gcommand_t * gcmd = &snap->gamecommands[ i ];
+			MSG_WriteInt16( msg, frame->serverFrame - num );
+			MSG_WriteString( msg, snap->gamecommandsData + gcmd->commandOffset );
+			if( gcmd->all ) {
+				MSG_WriteUint8( msg, 0 );
+			}
+			else {
+				MSG_WriteUint8( msg, sizeof( gcmd->targets ) );
+				MSG_WriteData( msg, gcmd->targets, sizeof( gcmd->targets ) );
+			}
+		}
+	}
+	MSG_WriteInt16( msg, -1 );
+
+	MSG_WriteUint8( msg, svc_match );
+	MSG_WriteDeltaGameState( msg, oldframe != NULL ? &oldframe->gameState : NULL, &frame->gameState );
+
+	for( int i = 0; i < frame->numplayers; i++ ) {
+		MSG_WriteUint8( msg, svc_playerinfo );
+		bool delta = oldframe != NULL && oldframe->numplayers > i;
+		MSG_WriteDeltaPlayerState( msg, delta ? &oldframe->playerStates[ i ] : NULL, &frame->playerStates[ i ] );
+	}
+	MSG_WriteUint8( msg, 0 );
+
+	// same merge as SNAP_EmitPacketEntities
+	MSG_WriteUint8( msg, svc_packetentities );
+
+	int old_num_entities = oldframe != NULL ? oldframe->numEntities : 0;
+	int newindex = 0;
+	int oldindex = 0;
+	while( newindex < frame->numEntities || oldindex < old_num_entities ) {
+		const SyncEntityState * newent = NULL;
+		const SyncEntityState * oldent = NULL;
+		int newnum = 9999;
+		int oldnum = 9999;
+
+		if( newindex < frame->numEntities ) {
+			newent = &frame->parsedEntities[ newindex & ( MAX_PARSE_ENTITIES - 1 ) ];
+			newnum = newent->number;
+		}
+		if( oldindex < old_num_entities ) {
+			oldent = &oldframe->parsedEntities[ oldindex & ( MAX_PARSE_ENTITIES - 1 ) ];
+			oldnum = oldent->number;
+		}
+
+		if( newnum == oldnum ) {
+			MSG_WriteDeltaEntity( msg, oldent, newent, false );
+			oldindex++;
+			newindex++;
+		}
+		else if( newnum < oldnum ) {
+			MSG_WriteDeltaEntity( msg, &upstream.baselines[ newnum ], newent, true );
+			newindex++;
+		}
+		else {
+			MSG_WriteEntityNumber( msg, oldnum, true );
+			oldindex++;
+		}
+	}
+
+	MSG_WriteEntityNumber( msg, 0, false );
+}
+
+/*
+* RL_EncodedFrame
+* Returns the frame body delta'd from the given frame, encoding it if no other viewer needed it yet
+*/
+static const RelayEncodedFrame * RL_EncodedFrame( const snapshot_t * frame, const snapshot_t * oldframe ) {
+	int64_t delta_frame = oldframe != NULL ? oldframe->serverFrame : -1;
+
+	for( int i = 0; i < num_encoded_frames; i++ ) {
+		if( encoded_frames[ i ].delta_frame == delta_frame ) {
+			return &encoded_frames[ i ];
+		}
+	}
+
+	if( num_encoded_frames == RELAY_MAX_ENCODED_FRAMES ) {
+		return NULL;
+	}
+
+	msg_t msg;
+	MSG_Init( &msg, encoded_frames_data + encoded_frames_used, sizeof( encoded_frames_data ) - encoded_frames_used );
+	if( msg.maxsize < MAX_MSGLEN / 2 ) {
+		return NULL;
+	}
+
+	RL_WriteFrameBody( &msg, frame, oldframe );
+	viewer_stats.encodes++;
+
+	RelayEncodedFrame * encoded = &encoded_frames[ num_encoded_frames++ ];
+	encoded->delta_frame = delta_frame;
+	encoded->offset = encoded_frames_used;
+	encoded->length = msg.cursize;
+	encoded_frames_used += msg.cursize;
+
+	return encoded;
+}
+
+static void RL_SendViewerFrame( RelayViewer * viewer, const snapshot_t * frame ) {
+	// delta from what the viewer acked, if we still have it
+	const snapshot_t * oldframe = NULL;
+	if( viewer->lastframe > 0 && frame->serverFrame - viewer->lastframe < UPDATE_MASK ) {
+		oldframe = RL_Snapshot( viewer->lastframe );
+	}
+
+	msg_t msg;
+	uint8_t msg_data[ MAX_MSGLEN ];
+	RL_InitViewerMessage( viewer, &msg, msg_data, sizeof( msg_data ) );
+	RL_AddReliableCommandsToMessage( viewer, &msg );
+
+	MSG_WriteUint8( &msg, svc_frame );
+	MSG_WriteIntBase128( &msg, frame->serverTime );
+	MSG_WriteUintBase128( &msg, frame->serverFrame );
+	MSG_WriteUintBase128( &msg, viewer->lastframe );
+	MSG_WriteUintBase128( &msg, viewer->ucmd_received );
+
+	const RelayEncodedFrame * encoded = RL_EncodedFrame( frame, oldframe );
+	if( encoded != NULL ) {
+		MSG_WriteData( &msg, encoded_frames_data + encoded->offset, encoded->length );
+	}
+	else {
+		RL_WriteFrameBody( &msg, frame, oldframe );
+		viewer_stats.encodes++;
+	}
+
+	RL_SendViewerMessage( viewer, &msg );
+	viewer_stats.snaps++;
+}
+
+static void RL_SendFrames() {
+	ZoneScoped;
+
+	const snapshot_t * frame = RL_Snapshot( upstream.received_snap_num );
+	if( frame == NULL ) {
+		return;
+	}
+
+	num_encoded_frames = 0;
+	encoded_frames_used = 0;
+
+	for( int i = 0; i < RELAY_MAX_VIEWERS; i++ ) {
+		RelayViewer * viewer = viewers[ i ];
+		if( viewer != NULL && viewer->state == RelayViewer_Active ) {
+			RL_SendViewerFrame( viewer, frame );
+		}
+	}
+
+	TracyPlot( "Relay frame encodes", s64( num_encoded_frames ) );
+}
+
+static void RL_ViewerFrame( RelayViewer * viewer ) {
+	if( realtime - viewer->last_packet_received_time > RELAY_TIMEOUT ) {
+		Com_Printf( "%s timed out\n", viewer->name );
+		RL_FreeViewer( viewer );
+		return;
+	}
+
+	if( viewer->overflowed ) {
+		RL_DropViewer( viewer, "Error: Server command overflow" );
+		return;
+	}
+
+	if( viewer->netchan.unsentFragments ) {
+		Netchan_TransmitNextFragment( &viewer->netchan );
+		return;
+	}
+
+	if( viewer->waiting_for_upstream && upstream.state == RelayUpstream_Active ) {
+		RL_New( viewer );
+		return;
+	}
+
+	// active viewers get their reliable commands with the frames, unless the upstream has gone quiet
+	if( viewer->state == RelayViewer_Active && realtime - viewer->last_packet_sent_time < 100 ) {
+		return;
+	}
+
+	if( viewer->reliable_sequence > viewer->reliable_sent || realtime - viewer->last_packet_sent_time > 1000 ) {
+		msg_t msg;
+		uint8_t msg_data[ MAX_MSGLEN ];
+		RL_InitViewerMessage( viewer, &msg, msg_data, sizeof( msg_data ) );
+		RL_AddReliableCommandsToMessage( viewer, &msg );
+		RL_SendViewerMessage( viewer, &msg );
+	}
+}
+
+/*
+==============================================================================
+
+UPSTREAM
+
+==============================================================================
+*/
+
+static void RL_AddUpstreamCommand( const char * cmd ) {
+	if( upstream.reliable_sequence > upstream.reliable_acknowledge + MAX_RELIABLE_COMMANDS ) {
+		Com_Printf( "relay: client command overflow\n" );
+		return;
+	}
+
+	upstream.reliable_sequence++;
+	Q_strncpyz( upstream.reliable_commands[ upstream.reliable_sequence & ( MAX_RELIABLE_COMMANDS - 1 ) ], cmd, MAX_STRING_CHARS );
+}
+
+static void RL_SendUpstreamMessage() {
+	msg_t msg;
+	uint8_t msg_data[ MAX_MSGLEN ];
+	MSG_Init( &msg, msg_data, sizeof( msg_data ) );
+
+	MSG_WriteUint8( &msg, clc_svcack );
+	MSG_WriteIntBase128( &msg, upstream.last_executed_server_command );
+
+	for( int64_t i = upstream.reliable_acknowledge + 1; i <= upstream.reliable_sequence; i++ ) {
+		MSG_WriteUint8( &msg, clc_clientcommand );
+		MSG_WriteIntBase128( &msg, i );
+		MSG_WriteString( &msg, upstream.reliable_commands[ i & ( MAX_RELIABLE_COMMANDS - 1 ) ] );
+	}
+
+	// no usercmds, this only acks the frames we got
+	if( upstream.state == RelayUpstream_Active ) {
+		MSG_WriteUint8( &msg, clc_move );
+		MSG_WriteInt32( &msg, upstream.received_snap_num > 0 ? upstream.received_snap_num : -1 );
+		MSG_WriteInt32( &msg, 0 );
+		MSG_WriteUint8( &msg, 0 );
+	}
+
+	upstream.last_packet_sent_time = realtime;
+	RL_Transmit( &upstream.netchan, &msg, &upstream_stats );
+}
+
+static void RL_ConnectUpstream() {
+	netadr_t address;
+	NET_InitAddress( &address, upstream_address.type );
+	if( !NET_OpenSocket( &upstream.socket, SOCKET_UDP, &address, false ) ) {
+		Com_Printf( "relay: couldn't open UDP socket: %s\n", NET_ErrorString() );
+		upstream.retry_time = realtime + RELAY_RECONNECT_TIME;
+		return;
+	}
+
+	CSPRNG_Bytes( &upstream.session_id, sizeof( upstream.session_id ) );
+
+	upstream.state = RelayUpstream_Connecting;
+	upstream.connect_time = realtime;
+	upstream.last_packet_received_time = realtime;
+
+	Netchan_OutOfBandPrint( &upstream.socket, &upstream_address, "getchallenge\n" );
+}
+
+static void RL_DisconnectUpstream( bool notify_server, int64_t retry_delay ) {
+	if( upstream.state >= RelayUpstream_Handshake && notify_server ) {
+		for( int i = 0; i < 3; i++ ) {
+			RL_AddUpstreamCommand( "disconnect" );
+			RL_SendUpstreamMessage();
+		}
+	}
+
+	if( upstream.socket.open ) {
+		NET_CloseSocket( &upstream.socket );
+	}
+
+	// viewers hang on until we're back
+	if( upstream.state >= RelayUpstream_Connected ) {
+		RL_BroadcastCommand( "changing" );
+		RL_BroadcastCommand( "reconnect" );
+	}
+
+	FREE( sys_allocator, upstream.snapshots );
+	FREE( sys_allocator, upstream.baselines );
+	FREE( sys_allocator, upstream.configstrings );
+
+	upstream = { };
+	upstream.retry_time = realtime + retry_delay;
+}
+
+static void RL_UpstreamConnectionlessPacket( msg_t * msg ) {
+	MSG_BeginReading( msg );
+	MSG_ReadInt32( msg ); // skip the -1
+
+	const char * s = MSG_ReadStringLine( msg );
+	Cmd_TokenizeString( s );
+	const char * c = Cmd_Argv( 0 );
+
+	if( upstream.state != RelayUpstream_Connecting ) {
+		return;
+	}
+
+	if( strcmp( c, "challenge" ) == 0 ) {
+		char userinfo[ MAX_INFO_STRING ] = "";
+		Info_SetValueForKey( userinfo, "name", relay_name->string );
+		Info_SetValueForKey( userinfo, "relay", relay_password->string );
+
+		TempAllocator temp = frame_arena.temp();
+		Netchan_OutOfBandPrint( &upstream.socket, &upstream_address, "%s", temp( "connect {} {} {} \"{}\"\n",
+			APP_PROTOCOL_VERSION, upstream.session_id, Cmd_Argv( 1 ), userinfo ) );
+		upstream.connect_time = realtime;
+		return;
+	}
+
+	if( strcmp( c, "client_connect" ) == 0 ) {
+		Netchan_Setup( &upstream.netchan, &upstream.socket, &upstream_address, upstream.session_id );
+
+		upstream.snapshots = ALLOC_MANY( sys_allocator, snapshot_t, UPDATE_BACKUP );
+		upstream.baselines = ALLOC_MANY( sys_allocator, SyncEntityState, MAX_EDICTS );
+		upstream.configstrings = ( char ( * )[ MAX_CONFIGSTRING_CHARS ] ) ALLOC_SIZE( sys_allocator, MAX_CONFIGSTRINGS * MAX_CONFIGSTRING_CHARS, 16 );
+		memset( upstream.snapshots, 0, sizeof( snapshot_t ) * UPDATE_BACKUP );
+		memset( upstream.baselines, 0, sizeof( SyncEntityState ) * MAX_EDICTS );
+		memset( upstream.configstrings, 0, MAX_CONFIGSTRINGS * MAX_CONFIGSTRING_CHARS );
+
+		Com_Printf( "relay: connected to %s\n", NET_AddressToString( &upstream_address ) );
+
+		upstream.state = RelayUpstream_Handshake;
+		RL_AddUpstreamCommand( "new" );
+		return;
+	}
+
+	if( strcmp( c, "reject" ) == 0 ) {
+		MSG_ReadStringLine( msg ); // type
+		MSG_ReadStringLine( msg ); // flags
+		Com_Printf( "relay: connection refused: %s\n", MSG_ReadStringLine( msg ) );
+		RL_DisconnectUpstream( false, RELAY_RECONNECT_TIME );
+		return;
+	}
+}
+
+static void RL_UpdateConfigstrings() {
+	// configstrings can come batched
+	for( int i = 1; i < Cmd_Argc() - 1; i += 2 ) {
+		int index = atoi( Cmd_Argv( i ) );
+		if( index >= 0 && index < MAX_CONFIGSTRINGS ) {
+			Q_strncpyz( upstream.configstrings[ index ], Cmd_Argv( i + 1 ), MAX_CONFIGSTRING_CHARS );
+		}
+	}
+}
+
+static void RL_ParseUpstreamCommand( msg_t * msg ) {
+	const char * text = MSG_ReadString( msg );
+	Cmd_TokenizeString( text );
+	const char * s = Cmd_Argv( 0 );
+
+	if( strcmp( s, "cmd" ) == 0 ) {
+		RL_AddUpstreamCommand( Cmd_Args() );
+	}
+	else if( strcmp( s, "precache" ) == 0 ) {
+		Q_strncpyz( upstream.mapname, Cmd_Argv( 2 ), sizeof( upstream.mapname ) );
+		RL_AddUpstreamCommand( va( "begin %i", atoi( Cmd_Argv( 1 ) ) ) );
+	}
+	else if( strcmp( s, "changing" ) == 0 ) {
+		upstream.received_snap_num = 0;
+		upstream.state = RelayUpstream_Connected;
+		RL_BroadcastCommand( text );
+	}
+	else if( strcmp( s, "reconnect" ) == 0 ) {
+		upstream.received_snap_num = 0;
+		upstream.state = RelayUpstream_Handshake;
+		RL_AddUpstreamCommand( "new" );
+		RL_BroadcastCommand( text );
+	}
+	else if( strcmp( s, "disconnect" ) == 0 || strcmp( s, "forcereconnect" ) == 0 ) {
+		Com_Printf( "relay: disconnected: %s\n", Cmd_Argv( 2 ) );
+		RL_DisconnectUpstream( false, RELAY_RECONNECT_TIME );
+	}
+	else {
+		if( strcmp( s, "cs" ) == 0 ) {
+			RL_UpdateConfigstrings();
+		}
+
+		// everything else goes to the viewers as is
+		if( upstream.state >= RelayUpstream_Connected ) {
+			RL_BroadcastCommand( text );
+		}
+	}
+}
+
+static void RL_ParseServerData( msg_t * msg ) {
+	int protocol = MSG_ReadInt32( msg );
+	if( protocol != APP_PROTOCOL_VERSION ) {
+		Com_Error( ERR_DROP, "Server returned version %i, not %i", protocol, APP_PROTOCOL_VERSION );
+	}
+
+	upstream.servercount = MSG_ReadInt32( msg );
+	upstream.snap_frame_time = MSG_ReadInt16( msg );
+	upstream.playernum = MSG_ReadInt16( msg );
+
+	int bitflags = MSG_ReadUint8( msg );
+	if( ( bitflags & SV_BITFLAGS_HTTP ) != 0 ) {
+		if( ( bitflags & SV_BITFLAGS_HTTP_BASEURL ) != 0 ) {
+			MSG_ReadString( msg );
+		}
+		else {
+			MSG_ReadInt16( msg );
+		}
+	}
+
+	// the server resets its command buffers when it sends serverdata
+	upstream.reliable_sequence = 0;
+	upstream.reliable_acknowledge = 0;
+	upstream.last_executed_server_command = 0;
+	upstream.received_snap_num = 0;
+	upstream.sent_snap_num = 0;
+
+	// frames and baselines from the last level are no good now
+	memset( upstream.snapshots, 0, sizeof( snapshot_t ) * UPDATE_BACKUP );
+	memset( upstream.baselines, 0, sizeof( SyncEntityState ) * MAX_EDICTS );
+	memset( upstream.configstrings, 0, MAX_CONFIGSTRINGS * MAX_CONFIGSTRING_CHARS );
+
+	upstream.state = RelayUpstream_Connected;
+	RL_AddUpstreamCommand( va( "configstrings %i 0", upstream.servercount ) );
+}
+
+static void RL_ParseFrame( msg_t * msg ) {
+	snapshot_t * old_snap = upstream.received_snap_num > 0 ? &upstream.snapshots[ upstream.received_snap_num & UPDATE_MASK ] : NULL;
+	snapshot_t * snap = SNAP_ParseFrame( msg, old_snap, upstream.snapshots, upstream.baselines, 0 );
+	if( !snap->valid ) {
+		return;
+	}
+
+	if( !snap->multipov ) {
+		Com_Error( ERR_DROP, "Server didn't send a multiview stream, check relay_password" );
+	}
+
+	upstream.received_snap_num = snap->serverFrame;
+	upstream_stats.snaps++;
+
+	if( upstream.state == RelayUpstream_Connected ) {
+		upstream.state = RelayUpstream_Active;
+		Com_Printf( "relay: relaying %s\n", upstream.mapname );
+	}
+}
+
+static void RL_ParseUpstreamMessage( msg_t * msg ) {
+	while( msg->readcount < msg->cursize && upstream.state >= RelayUpstream_Handshake ) {
+		int cmd = MSG_ReadUint8( msg );
+		switch( cmd ) {
+			default:
+				Com_Error( ERR_DROP, "RL_ParseUpstreamMessage: Illegible server message" );
+				break;
+
+			case svc_servercmd: {
+				int64_t num = MSG_ReadInt32( msg );
+				if( num <= upstream.last_executed_server_command ) {
+					MSG_ReadString( msg );
+					break;
+				}
+				upstream.last_executed_server_command = num;
+				RL_ParseUpstreamCommand( msg );
+			} break;
+
+			case svc_servercs:
+				RL_ParseUpstreamCommand( msg );
+				break;
+
+			case svc_serverdata:
+				if( upstream.state != RelayUpstream_Handshake ) {
+					return;
+				}
+				RL_ParseServerData( msg );
+				break;
+
+			case svc_spawnbaseline:
+				SNAP_ParseBaseline( msg, upstream.baselines );
+				break;
+
+			case svc_clcack:
+				upstream.reliable_acknowledge = MSG_ReadUintBase128( msg );
+				MSG_ReadUintBase128( msg ); // ucmd acknowledged
+				break;
+
+			case svc_frame:
+				RL_ParseFrame( msg );
+				break;
+		}
+	}
+}
+
+static void RL_ReadUpstreamPackets() {
+	msg_t msg;
+	uint8_t msg_data[ MAX_MSGLEN ];
+	MSG_Init( &msg, msg_data, sizeof( msg_data ) );
+
+	parsing_upstream = true;
+	defer { parsing_upstream = false; };
+
+	netadr_t address;
+	int ret;
+	while( upstream.socket.open && ( ret = NET_GetPacket( &upstream.socket, &address, &msg ) ) != 0 ) {
+		if( ret == -1 ) {
+			continue;
+		}
+
+		upstream.last_packet_received_time = realtime;
+		upstream_stats.packets_received++;
+		upstream_stats.bytes_received += msg.cursize;
+
+		if( *( int * ) msg.data == -1 ) {
+			RL_UpstreamConnectionlessPacket( &msg );
+			continue;
+		}
+
+		if( upstream.state < RelayUpstream_Handshake || msg.cursize < 8 ) {
+			continue;
+		}
+
+		if( !Netchan_Process( &upstream.netchan, &msg ) ) {
+			continue;
+		}
+
+		MSG_BeginReading( &msg );
+		MSG_ReadInt32( &msg ); // sequence
+		MSG_ReadInt32( &msg ); // sequence_ack
+		if( msg.compressed && Netchan_DecompressMessage( &msg ) < 0 ) {
+			continue;
+		}
+
+		RL_ParseUpstreamMessage( &msg );
+	}
+}
+
+static void RL_UpstreamFrame() {
+	switch( upstream.state ) {
+		case RelayUpstream_Disconnected:
+			if( relay_running && realtime >= upstream.retry_time ) {
+				RL_ConnectUpstream();
+			}
+			return;
+
+		case RelayUpstream_Connecting:
+			if( realtime - upstream.connect_time > RELAY_RESEND_TIME ) {
+				RL_DisconnectUpstream( false, 0 );
+			}
+			return;
+
+		default:
+			break;
+	}
+
+	if( realtime - upstream.last_packet_received_time > RELAY_TIMEOUT ) {
+		Com_Printf( "relay: upstream timed out\n" );
+		RL_DisconnectUpstream( true, RELAY_RECONNECT_TIME );
+		return;
+	}
+
+	if( upstream.netchan.unsentFragments ) {
+		Netchan_TransmitNextFragment( &upstream.netchan );
+		return;
+	}
+
+	// ack every frame as soon as it arrives so the server keeps delta compressing
+	bool new_frame = upstream.received_snap_num != upstream.sent_snap_num;
+	if( new_frame || realtime - upstream.last_packet_sent_time > 100 ) {
+		RL_SendUpstreamMessage();
+	}
+}
+
+/*
+==============================================================================
+
+COMMANDS
+
+==============================================================================
+*/
+
+static void RL_Stop() {
+	relay_running = false;
+	RL_DisconnectUpstream( true, 0 );
+
+	for( int i = 0; i < RELAY_MAX_VIEWERS; i++ ) {
+		if( viewers[ i ] != NULL ) {
+			RL_DropViewer( viewers[ i ], "Relay shutting down" );
+		}
+	}
+
+	if( listen_socket.open ) {
+		NET_CloseSocket( &listen_socket );
+	}
+}
+
+/*
+* RL_Start_f
+* relay <address>
+*/
+static void RL_Start_f() {
+	if( Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: %s <address>\n", Cmd_Argv( 0 ) );
+		return;
+	}
+
+	netadr_t address;
+	if( !NET_StringToAddress( Cmd_Argv( 1 ), &address ) || ( address.type != NA_IP && address.type != NA_IP6 ) ) {
+		Com_Printf( "Bad server address\n" );
+		return;
+	}
+	if( NET_GetAddressPort( &address ) == 0 ) {
+		NET_SetAddressPort( &address, PORT_SERVER );
+	}
+
+	RL_Stop();
+
+	netadr_t listen_address;
+	NET_InitAddress( &listen_address, NA_IP );
+	NET_SetAddressPort( &listen_address, relay_port->integer );
+	if( !NET_OpenSocket( &listen_socket, SOCKET_UDP, &listen_address, true ) ) {
+		Com_Printf( "relay: couldn't listen on port %i: %s\n", relay_port->integer, NET_ErrorString() );
+		return;
+	}
+
+	upstream_address = address;
+	relay_running = true;
+	realtime = Sys_Milliseconds();
+	last_stats_time = realtime;
+
+	Com_Printf( "Relaying %s to port %i\n", NET_AddressToString( &upstream_address ), relay_port->integer );
+}
+
+static void RL_Stop_f() {
+	RL_Stop();
+}
+
+static void RL_Stats_f() {
+	realtime = Sys_Milliseconds();
+	float dt = Max2( int64_t( 1 ), realtime - last_stats_time ) * 0.001f;
+	last_stats_time = realtime;
+
+	int active = 0;
+	int loading = 0;
+	for( int i = 0; i < RELAY_MAX_VIEWERS; i++ ) {
+		if( viewers[ i ] != NULL ) {
+			if( viewers[ i ]->state == RelayViewer_Active ) {
+				active++;
+			}
+			else {
+				loading++;
+			}
+		}
+	}
+
+	Com_Printf( "upstream: %.1f snaps/s, %.2f/%.2f KB/s in/out\n", upstream_stats.snaps / dt,
+		upstream_stats.bytes_received / dt / 1024.0f, upstream_stats.bytes_sent / dt / 1024.0f );
+	Com_Printf( "viewers: %d watching, %d connecting, %.1f snaps/s, %.1f encodes/s, %.2f/%.2f KB/s in/out\n", active, loading,
+		viewer_stats.snaps / dt, viewer_stats.encodes / dt,
+		viewer_stats.bytes_received / dt / 1024.0f, viewer_stats.bytes_sent / dt / 1024.0f );
+
+	upstream_stats = { };
+	viewer_stats = { };
+}
+
+/*
+==============================================================================
+
+ENGINE INTERFACE
+
+==============================================================================
+*/
+
+void CL_Init() {
+	constexpr size_t frame_arena_size = 1024 * 1024; // 1MB
+	void * frame_arena_memory = ALLOC_SIZE( sys_allocator, frame_arena_size, 16 );
+	frame_arena = ArenaAllocator( frame_arena_memory, frame_arena_size );
+
+	u64 entropy[ 2 ];
+	CSPRNG_Bytes( entropy, sizeof( entropy ) );
+	rng = NewRNG( entropy[ 0 ], entropy[ 1 ] );
+
+	// don't append to the server's log if we're run from the same directory
+	if( strcmp( Cvar_String( "logconsole" ), "server.log" ) == 0 ) {
+		Cvar_ForceSet( "logconsole", "relay.log" );
+	}
+
+	relay_port = Cvar_Get( "relay_port", va( "%i", PORT_SERVER + 100 ), CVAR_ARCHIVE );
+	relay_password = Cvar_Get( "relay_password", "", 0 );
+	relay_name = Cvar_Get( "relay_name", "relay", CVAR_ARCHIVE );
+	relay_maxviewers = Cvar_Get( "relay_maxviewers", "512", CVAR_ARCHIVE );
+
+	Cmd_AddCommand( "relay", RL_Start_f );
+	Cmd_AddCommand( "relay_stop", RL_Stop_f );
+	Cmd_AddCommand( "relay_stats", RL_Stats_f );
+}
+
+void CL_Shutdown() {
+	RL_Stop();
+
+	Cmd_RemoveCommand( "relay" );
+	Cmd_RemoveCommand( "relay_stop" );
+	Cmd_RemoveCommand( "relay_stats" );
+
+	FREE( sys_allocator, frame_arena.get_memory() );
+}
+
+void CL_Frame( int realmsec, int gamemsec ) {
+	ZoneScoped;
+
+	frame_arena.clear();
+	realtime = Sys_Milliseconds();
+
+	RL_ReadUpstreamPackets();
+	RL_UpstreamFrame();
+
+	RL_ReadViewerPackets();
+
+	if( upstream.state == RelayUpstream_Active && upstream.received_snap_num != upstream.sent_snap_num ) {
+		RL_SendFrames();
+		upstream.sent_snap_num = upstream.received_snap_num;
+	}
+
+	for( int i = 0; i < RELAY_MAX_VIEWERS; i++ ) {
+		if( viewers[ i ] != NULL ) {
+			RL_ViewerFrame( viewers[ i ] );
+		}
+	}
+
+	Sys_Sleep( 1 );
+}
+
+void CL_Disconnect( const char * message ) {
+	if( parsing_viewer != NULL ) {
+		Com_Printf( "%s: %s\n", parsing_viewer->name, message );
+		RL_FreeViewer( parsing_viewer );
+		parsing_viewer = NULL;
+	}
+	else if( parsing_upstream ) {
+		Com_Printf( "relay: %s\n", message );
+		RL_DisconnectUpstream( true, RELAY_RECONNECT_TIME );
+		parsing_upstream = false;
+	}
+}
+
+void Con_Print( const char * text ) { }
+
+void Key_Init() { }
+void Key_Shutdown() { }
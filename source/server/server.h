@@ -22,6 +22,7 @@
 
 #include "qcommon/qcommon.h"
 #include "qcommon/rng.h"
+#include "qcommon/metrics.h"
 #include "game/g_local.h"
 
 //=============================================================================
@@ -84,6 +85,14 @@ struct game_command_t {
 	char command[MAX_STRING_CHARS];
 };
 
+// reliable commands are stored once and shared by every client they go to
+struct ServerCommand {
+	u32 refcount;
+	bool sent;                      // configstrings only get batched into commands nobody has been sent yet
+	size_t len;
+	char text[MAX_STRING_CHARS];
+};
+
 #define LATENCY_COUNTS  16
 
 #define HTTP_CLIENT_SESSION_SIZE 16
@@ -101,7 +110,7 @@ struct client_t {
 
 	socket_t socket;
 
-	char reliableCommands[MAX_RELIABLE_COMMANDS][MAX_STRING_CHARS];
+	ServerCommand * reliableCommands[MAX_RELIABLE_COMMANDS];
 	int64_t reliableSequence;      // last added reliable message, not necesarily sent or acknowledged yet
 	int64_t reliableAcknowledge;   // last acknowledged reliable message
 	int64_t reliableSent;          // last sent reliable message, not necesarily acknowledged yet
@@ -125,8 +134,23 @@ struct client_t {
 	int64_t nodelta_frame;              // when we get confirmation of this frame, the non-delta frame is through
 	int64_t lastSentFrameNum;  // for knowing which was last frame we sent
 
+	// bandwidth scheduling, see SV_UpdateClientRate
+	int snap_rate;                  // estimated bytes/sec the client's link can take
+	int snap_interval;              // server frames between snapshots
+	int snap_budget;                // bytes the next snapshot may use, 0 for no limit
+	int snap_lost_packets;          // packets the netchan saw dropped since the last snapshot
+	u8 snap_deferred[MAX_EDICTS];   // snapshots in a row each entity's update was held back
+
 	int frame_latency[LATENCY_COUNTS];
 	int ping;
+
+	// traffic since the last netstats command
+	u32 netstats_snaps;
+	u32 netstats_packets_in;
+	u64 netstats_bytes_in;
+	u64 netstats_bytes_out;
+	u32 netstats_deferred;
+
 	edict_t *edict;                 // EDICT_NUM(clientnum+1)
 	char name[MAX_INFO_VALUE];      // extracted from userinfo, high bits masked
 	char session[HTTP_CLIENT_SESSION_SIZE];  // session id for HTTP requests
@@ -151,6 +175,9 @@ struct client_t {
 // out before legitimate users connected
 #define MAX_CHALLENGES  1024
 
+// entity updates held back this many snapshots in a row get sent regardless of the budget
+#define SNAP_MAX_DEFERRED 10
+
 // MAX_SNAP_ENTITIES is the guess of what we consider maximum amount of entities
 // to be sent to a client into a snap. It's used for finding size of the backup storage
 #define MAX_SNAP_ENTITIES 64
@@ -183,6 +210,7 @@ struct server_static_t {
 	bool initialized;               // sv_init has completed
 	int64_t realtime;               // real world time - always increasing, no clamping, etc
 	int64_t gametime;               // game world time - always increasing, no clamping, etc
+	int64_t game_frame_acc_time;    // gametime SV_RunGameFrame hasn't simulated yet
 
 	ArenaAllocator frame_arena;
 
@@ -253,12 +281,36 @@ extern cvar_t *sv_public;         // should heartbeats be sent
 extern cvar_t *sv_debug_serverCmd;
 
 extern cvar_t *sv_uploads_http;
+extern cvar_t *sv_http_metrics;
 extern cvar_t *sv_uploads_baseurl;
 extern cvar_t *sv_uploads_demos;
 extern cvar_t *sv_uploads_demos_baseurl;
 
 extern cvar_t *sv_demodir;
 
+extern cvar_t *sv_recordinputs;
+
+extern cvar_t *sv_snap_scheduler;
+extern cvar_t *sv_snap_minrate;
+extern cvar_t *sv_snap_maxrate;
+extern cvar_t *sv_snap_maxinterval;
+
+extern cvar_t *sv_relay_password;
+
+struct ServerMetrics {
+	Metric * frame_seconds;
+	Metric * inputs_seconds;
+	Metric * game_seconds;
+	Metric * snapshot_seconds;
+	Metric * send_seconds;
+	Metric * sleep_seconds;
+	Metric * snapshot_bytes;
+	Metric * clients;
+	Metric * ping;
+};
+
+extern ServerMetrics sv_metrics;
+
 //===========================================================
 
 //
@@ -275,6 +327,15 @@ void SV_UserinfoChanged( client_t *cl );
 void SV_MasterHeartbeat();
 
 void SVC_MasterInfoResponse( const socket_t *socket, const netadr_t *address );
+
+struct ServerFrameTimings {
+	s64 inputs;
+	s64 game;
+	s64 send;
+	s64 total;
+};
+
+void SV_RunFrame( unsigned realmsec, unsigned gamemsec, ServerFrameTimings * timings );
 int SVC_FakeConnect( const char *fakeUserinfo, const char *fakeSocketType, const char *fakeIP );
 
 //
@@ -295,6 +356,9 @@ void SV_SetServerConfigStrings();
 // sv_send.c
 //
 bool SV_Netchan_Transmit( netchan_t *netchan, msg_t *msg );
+void SV_InitServerCommands();
+void SV_ReleaseServerCommands( client_t *client );
+void SV_AcknowledgeServerCommands( client_t *client, int64_t ack );
 void SV_AddServerCommand( client_t *client, const char *cmd );
 void SV_SendServerCommand( client_t *cl, const char *format, ... );
 void SV_AddGameCommand( client_t *client, const char *cmd );
@@ -364,6 +428,7 @@ void SV_ShutdownGameProgs();
 
 void PF_DropClient( edict_t *ent, int type, const char *message );
 int PF_GetClientState( int numClient );
+int64_t PF_Milliseconds();
 void PF_GameCmd( edict_t *ent, const char *cmd );
 void PF_ConfigString( int index, const char *val );
 const char *PF_GetConfigString( int index );
@@ -385,6 +450,21 @@ void SV_DemoGet_f( client_t *client );
 
 bool SV_IsDemoDownloadRequest( const char *request );
 
+//
+// sv_replay.c
+//
+void SV_Replay_BeginLevel( const char *mapname );
+void SV_Replay_StopRecording();
+void SV_Replay_RecordFrame( unsigned realmsec, unsigned gamemsec );
+void SV_Replay_RecordConnect( const client_t *client, const char *userinfo, u64 session_id, int challenge );
+void SV_Replay_RecordPacket( const client_t *client, const msg_t *msg );
+void SV_Replay_RecordClock( int64_t time );
+int64_t SV_Replay_ReadClock();
+void SV_Replay_CheckState();
+bool SV_Replay_Playing();
+void SV_Replay_ReadPackets();
+void SV_Replay_f();
+
 //
 // sv_web.c
 //
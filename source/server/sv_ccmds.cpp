@@ -170,6 +170,44 @@ void SV_Status_f() {
 	Com_Printf( "\n" );
 }
 
+/*
+* SV_NetStats_f
+* Per client traffic since the last netstats, for load testing
+*/
+static void SV_NetStats_f() {
+	static int64_t netstats_time;
+
+	if( !svs.clients ) {
+		Com_Printf( "No server running.\n" );
+		return;
+	}
+
+	int64_t now = Sys_Milliseconds();
+
+	Com_Printf( "num name                            snaps/s pkts/s in KB/s in KB/s out ping rate KB/s deferred/s\n" );
+	Com_Printf( "--- ------------------------------- ------- --------- ------- -------- ---- --------- ----------\n" );
+	for( int i = 0; i < sv_maxclients->integer; i++ ) {
+		client_t * cl = &svs.clients[ i ];
+		if( cl->state < CS_CONNECTED || ( cl->edict && ( cl->edict->r.svflags & SVF_FAKECLIENT ) ) ) {
+			continue;
+		}
+
+		float dt = Max2( int64_t( 1 ), now - Max2( netstats_time, cl->lastconnect ) ) * 0.001f;
+		Com_Printf( "%3i %-31s %7.1f %9.1f %7.2f %8.2f %4i %9.2f %10.1f\n", i, cl->name,
+			cl->netstats_snaps / dt, cl->netstats_packets_in / dt,
+			cl->netstats_bytes_in / dt / 1024.0f, cl->netstats_bytes_out / dt / 1024.0f,
+			Min2( cl->ping, 9999 ), cl->snap_rate / 1024.0f, cl->netstats_deferred / dt );
+
+		cl->netstats_snaps = 0;
+		cl->netstats_packets_in = 0;
+		cl->netstats_bytes_in = 0;
+		cl->netstats_bytes_out = 0;
+		cl->netstats_deferred = 0;
+	}
+
+	netstats_time = now;
+}
+
 /*
 * SV_Heartbeat_f
 */
@@ -227,6 +265,7 @@ static void SV_KillServer_f() {
 void SV_InitOperatorCommands() {
 	Cmd_AddCommand( "heartbeat", SV_Heartbeat_f );
 	Cmd_AddCommand( "status", SV_Status_f );
+	Cmd_AddCommand( "netstats", SV_NetStats_f );
 	Cmd_AddCommand( "serverinfo", SV_Serverinfo_f );
 	Cmd_AddCommand( "dumpuser", SV_DumpUser_f );
 
@@ -239,6 +278,8 @@ void SV_InitOperatorCommands() {
 	Cmd_AddCommand( "serverrecordstop", SV_Demo_Stop_f );
 	Cmd_AddCommand( "serverrecordcancel", SV_Demo_Cancel_f );
 
+	Cmd_AddCommand( "replayinputs", SV_Replay_f );
+
 	if( is_dedicated_server ) {
 		Cmd_AddCommand( "serverrecordpurge", SV_Demo_Purge_f );
 	}
@@ -254,6 +295,7 @@ void SV_InitOperatorCommands() {
 void SV_ShutdownOperatorCommands() {
 	Cmd_RemoveCommand( "heartbeat" );
 	Cmd_RemoveCommand( "status" );
+	Cmd_RemoveCommand( "netstats" );
 	Cmd_RemoveCommand( "serverinfo" );
 	Cmd_RemoveCommand( "dumpuser" );
 
@@ -266,6 +308,8 @@ void SV_ShutdownOperatorCommands() {
 	Cmd_RemoveCommand( "serverrecordstop" );
 	Cmd_RemoveCommand( "serverrecordcancel" );
 
+	Cmd_RemoveCommand( "replayinputs" );
+
 	if( is_dedicated_server ) {
 		Cmd_RemoveCommand( "serverrecordpurge" );
 	}
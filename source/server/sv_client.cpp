@@ -33,7 +33,7 @@ void SV_ClientResetCommandBuffers( client_t *client ) {
 	client->reliableAcknowledge = 0;
 	client->reliableSequence = 0;
 	client->reliableSent = 0;
-	memset( client->reliableCommands, 0, sizeof( client->reliableCommands ) );
+	SV_ReleaseServerCommands( client );
 
 	// reset the usercommands buffer(clc_move)
 	client->UcmdTime = 0;
@@ -44,6 +44,7 @@ void SV_ClientResetCommandBuffers( client_t *client ) {
 	// reset snapshots delta-compression
 	client->lastframe = -1;
 	client->lastSentFrameNum = 0;
+	memset( client->snap_deferred, 0, sizeof( client->snap_deferred ) );
 }
 
 /*
@@ -66,6 +67,7 @@ bool SV_ClientConnect( const socket_t *socket, const netadr_t *address, client_t
 
 
 	// the connection is accepted, set up the client slot
+	SV_ReleaseServerCommands( client );
 	memset( client, 0, sizeof( *client ) );
 	client->edict = ent;
 	client->challenge = challenge; // save challenge for checksumming
@@ -91,6 +93,13 @@ bool SV_ClientConnect( const socket_t *socket, const netadr_t *address, client_t
 
 	SV_ClientResetCommandBuffers( client );
 
+	// spectator relays get every entity and player so they can re-serve the match
+	if( !fakeClient && sv_relay_password->string[0] != '\0' ) {
+		const char * relay = Info_ValueForKey( userinfo, "relay" );
+		client->mv = relay != NULL && strcmp( relay, sv_relay_password->string ) == 0;
+	}
+	Info_RemoveKey( userinfo, "relay" );
+
 	// reset timeouts
 	client->lastPacketReceivedTime = svs.realtime;
 	client->lastconnect = Sys_Milliseconds();
@@ -109,7 +118,7 @@ bool SV_ClientConnect( const socket_t *socket, const netadr_t *address, client_t
 	}
 
 	// parse some info from the info strings
-	client->userinfoLatchTimeout = Sys_Milliseconds() + USERINFO_UPDATE_COOLDOWN_MSEC;
+	client->userinfoLatchTimeout = svs.realtime + USERINFO_UPDATE_COOLDOWN_MSEC;
 	Q_strncpyz( client->userinfo, userinfo, sizeof( client->userinfo ) );
 	SV_UserinfoChanged( client );
 
@@ -177,6 +186,8 @@ void SV_DropClient( client_t *drop, int type, const char *format, ... ) {
 		NET_CloseSocket( &drop->socket );
 	}
 
+	SV_ReleaseServerCommands( drop );
+
 	drop->state = CS_ZOMBIE;    // become free in a few seconds
 	drop->name[0] = 0;
 }
@@ -541,7 +552,7 @@ static void SV_UserinfoCommand_f( client_t *client ) {
 		return;
 	}
 
-	time = Sys_Milliseconds();
+	time = svs.realtime;
 	if( client->userinfoLatchTimeout > time ) {
 		Q_strncpyz( client->userinfoLatched, info, sizeof( client->userinfo ) );
 	} else {
@@ -758,6 +769,8 @@ void SV_ParseClientMessage( client_t *client, msg_t *msg ) {
 		return;
 	}
 
+	client->snap_lost_packets += client->netchan.dropped;
+
 	// only allow one move command
 	move_issued = false;
 	while( msg->readcount < msg->cursize ) {
@@ -787,7 +800,7 @@ void SV_ParseClientMessage( client_t *client, msg_t *msg ) {
 					//SV_DropClient( client, DROP_TYPE_GENERAL, "%s", "Error: bad server command acknowledged" );
 					return;
 				}
-				client->reliableAcknowledge = cmdNum;
+				SV_AcknowledgeServerCommands( client, cmdNum );
 			} break;
 
 			case clc_clientcommand: {
@@ -84,6 +84,7 @@ void SV_Demo_WriteSnap() {
 }
 
 static void SV_Demo_InitClient() {
+	SV_ReleaseServerCommands( &svs.demo.client );
 	memset( &svs.demo.client, 0, sizeof( svs.demo.client ) );
 
 	svs.demo.client.mv = true;
@@ -92,7 +93,6 @@ static void SV_Demo_InitClient() {
 	svs.demo.client.reliableAcknowledge = 0;
 	svs.demo.client.reliableSequence = 0;
 	svs.demo.client.reliableSent = 0;
-	memset( svs.demo.client.reliableCommands, 0, sizeof( svs.demo.client.reliableCommands ) );
 
 	svs.demo.client.lastframe = sv.framenum - 1;
 	svs.demo.client.nodelta = false;
@@ -50,6 +50,22 @@ int PF_GetClientState( int numClient ) {
 	return svs.clients[numClient].state;
 }
 
+/*
+* PF_Milliseconds
+*
+* Wall clock for the game. It goes through input recordings so replays see
+* the same times the live server did.
+*/
+int64_t PF_Milliseconds() {
+	if( SV_Replay_Playing() ) {
+		return SV_Replay_ReadClock();
+	}
+
+	int64_t time = Sys_Milliseconds();
+	SV_Replay_RecordClock( time );
+	return time;
+}
+
 /*
 * PF_GameCmd
 *
@@ -76,6 +76,8 @@ static void SV_SpawnServer( const char *mapname, bool devmap ) {
 	svs.realtime = Sys_Milliseconds();
 	svs.gametime = 0;
 
+	SV_Replay_BeginLevel( mapname );
+
 	SV_SetServerConfigStrings();
 
 	sv.nextSnapTime = 1000;
@@ -246,6 +248,8 @@ void SV_ShutdownGame( const char *finalmsg, bool reconnect ) {
 		SV_Demo_Stop_f();
 	}
 
+	SV_Replay_StopRecording();
+
 	if( svs.clients ) {
 		SV_FinalMessage( finalmsg, reconnect );
 	}
@@ -260,9 +264,13 @@ void SV_ShutdownGame( const char *finalmsg, bool reconnect ) {
 	Cvar_GetLatchedVars( CVAR_LATCH );
 
 	if( svs.clients ) {
+		for( int i = 0; i < sv_maxclients->integer; i++ ) {
+			SV_ReleaseServerCommands( &svs.clients[i] );
+		}
 		Mem_Free( svs.clients );
 		svs.clients = NULL;
 	}
+	SV_ReleaseServerCommands( &svs.demo.client );
 
 	if( svs.client_entities.entities ) {
 		Mem_Free( svs.client_entities.entities );
@@ -40,6 +40,7 @@ cvar_t *sv_zombietime;         // seconds to sink messages after disconnect
 cvar_t *rcon_password;         // password for remote server commands
 
 cvar_t *sv_uploads_http;
+cvar_t *sv_http_metrics;
 cvar_t *sv_uploads_baseurl;
 cvar_t *sv_uploads_demos;
 cvar_t *sv_uploads_demos_baseurl;
@@ -69,6 +70,17 @@ cvar_t *sv_debug_serverCmd;
 
 cvar_t *sv_demodir;
 
+cvar_t *sv_recordinputs;
+
+cvar_t *sv_snap_scheduler;
+cvar_t *sv_snap_minrate;
+cvar_t *sv_snap_maxrate;
+cvar_t *sv_snap_maxinterval;
+
+cvar_t *sv_relay_password;
+
+ServerMetrics sv_metrics;
+
 //============================================================================
 
 /*
@@ -199,9 +211,12 @@ static void SV_ReadPackets() {
 				}
 
 				cl->netchan.remoteAddress = address;
+				cl->netstats_packets_in++;
+				cl->netstats_bytes_in += msg.cursize;
 
 				if( SV_ProcessPacket( &cl->netchan, &msg ) ) { // this is a valid, sequenced packet, so process it
 					cl->lastPacketReceivedTime = svs.realtime;
+					SV_Replay_RecordPacket( cl, &msg );
 					SV_ParseClientMessage( cl, &msg );
 				}
 
@@ -233,9 +248,13 @@ static void SV_ReadPackets() {
 					SV_DropClient( cl, DROP_TYPE_GENERAL, "Error receiving packet: %s", NET_ErrorString() );
 				}
 			} else {
+				cl->netstats_packets_in++;
+				cl->netstats_bytes_in += msg.cursize;
+
 				if( SV_ProcessPacket( &cl->netchan, &msg ) ) {
 					// this is a valid, sequenced packet, so process it
 					cl->lastPacketReceivedTime = svs.realtime;
+					SV_Replay_RecordPacket( cl, &msg );
 					SV_ParseClientMessage( cl, &msg );
 				}
 			}
@@ -302,7 +321,7 @@ static void SV_CheckLatchedUserinfoChanges() {
 
 	client_t *cl;
 	int i;
-	int64_t time = Sys_Milliseconds();
+	int64_t time = svs.realtime;
 
 	for( i = 0, cl = svs.clients; i < sv_maxclients->integer; i++, cl++ ) {
 		if( cl->state == CS_FREE || cl->state == CS_ZOMBIE ) {
@@ -328,7 +347,7 @@ static void SV_CheckLatchedUserinfoChanges() {
 static bool SV_RunGameFrame( int msec ) {
 	ZoneScoped;
 
-	static int64_t accTime = 0;
+	int64_t & accTime = svs.game_frame_acc_time;
 	bool refreshSnapshot;
 	bool refreshGameModule;
 	bool sentFragments;
@@ -352,7 +371,7 @@ static bool SV_RunGameFrame( int msec ) {
 	}
 
 	// if there aren't pending packets to be sent, we can sleep
-	if( is_dedicated_server && !sentFragments && !refreshSnapshot ) {
+	if( is_dedicated_server && !sentFragments && !refreshSnapshot && !SV_Replay_Playing() ) {
 		int sleeptime = Min2( WORLDFRAMETIME - ( accTime + 1 ), sv.nextSnapTime - ( svs.gametime + 1 ) );
 
 		if( sleeptime > 0 ) {
@@ -371,7 +390,9 @@ static bool SV_RunGameFrame( int msec ) {
 			}
 			opened_sockets[open_ind] = NULL;
 
+			s64 sleep_start = Sys_Microseconds();
 			NET_Sleep( sleeptime, opened_sockets );
+			Increment( sv_metrics.sleep_seconds, ( Sys_Microseconds() - sleep_start ) / 1000000.0 );
 		}
 	}
 
@@ -449,6 +470,66 @@ void SV_Frame( unsigned realmsec, unsigned gamemsec ) {
 		return;
 	}
 
+	SV_Replay_RecordFrame( realmsec, gamemsec );
+
+	SV_RunFrame( realmsec, gamemsec, NULL );
+}
+
+/*
+* SV_UpdateMetrics
+*/
+static void SV_UpdateMetrics( s64 start, s64 inputs_done, s64 game_done, s64 send_done, double sleep_seconds, double snapshot_seconds ) {
+	// SV_RunGameFrame counts the time it sleeps waiting for packets and
+	// SV_SendClientDatagram counts snapshot building, so take those out
+	Observe( sv_metrics.frame_seconds, Max2( 0.0, ( send_done - start ) / 1000000.0 - sleep_seconds ) );
+	Increment( sv_metrics.inputs_seconds, ( inputs_done - start ) / 1000000.0 );
+	Increment( sv_metrics.game_seconds, Max2( 0.0, ( game_done - inputs_done ) / 1000000.0 - sleep_seconds ) );
+	Increment( sv_metrics.send_seconds, Max2( 0.0, ( send_done - game_done ) / 1000000.0 - snapshot_seconds ) );
+
+	int clients = 0;
+	int total_ping = 0;
+	for( int i = 0; i < sv_maxclients->integer; i++ ) {
+		const client_t * client = &svs.clients[ i ];
+		if( client->state != CS_SPAWNED || client->edict == NULL || ( client->edict->r.svflags & SVF_FAKECLIENT ) ) {
+			continue;
+		}
+		clients++;
+		total_ping += client->ping;
+	}
+
+	SetGauge( sv_metrics.clients, clients );
+	SetGauge( sv_metrics.ping, clients > 0 ? total_ping / double( clients ) / 1000.0 : 0.0 );
+}
+
+/*
+* SV_InitMetrics
+*/
+static void SV_InitMetrics() {
+	constexpr double frame_bounds[] = { 0.0005, 0.001, 0.002, 0.004, 0.008, 0.016, 0.032, 0.064 };
+	constexpr double snapshot_bounds[] = { 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384 };
+
+	sv_metrics.frame_seconds = NewHistogram( "server_frame_seconds", "Time spent running a server frame", Span< const double >( frame_bounds, ARRAY_COUNT( frame_bounds ) ) );
+	sv_metrics.inputs_seconds = NewCounter( "server_stage_seconds_total{stage=\"inputs\"}", "Time spent in each stage of the server frame" );
+	sv_metrics.game_seconds = NewCounter( "server_stage_seconds_total{stage=\"game\"}", "Time spent in each stage of the server frame" );
+	sv_metrics.snapshot_seconds = NewCounter( "server_stage_seconds_total{stage=\"snapshot\"}", "Time spent in each stage of the server frame" );
+	sv_metrics.send_seconds = NewCounter( "server_stage_seconds_total{stage=\"send\"}", "Time spent in each stage of the server frame" );
+	sv_metrics.sleep_seconds = NewCounter( "server_stage_seconds_total{stage=\"sleep\"}", "Time spent in each stage of the server frame" );
+	sv_metrics.snapshot_bytes = NewHistogram( "server_snapshot_bytes", "Size of snapshot packets", Span< const double >( snapshot_bounds, ARRAY_COUNT( snapshot_bounds ) ) );
+	sv_metrics.clients = NewGauge( "server_clients", "Spawned clients, not counting bots" );
+	sv_metrics.ping = NewGauge( "server_client_ping_seconds", "Average ping of spawned clients" );
+}
+
+/*
+* SV_RunFrame
+*
+* Everything SV_Frame does once the server is running. Input replays call
+* this directly with the recorded frame times and collect timings.
+*/
+void SV_RunFrame( unsigned realmsec, unsigned gamemsec, ServerFrameTimings * timings ) {
+	ZoneScoped;
+
+	s64 start = Sys_Microseconds();
+
 	svs.realtime += realmsec;
 	svs.gametime += gamemsec;
 
@@ -456,25 +537,59 @@ void SV_Frame( unsigned realmsec, unsigned gamemsec ) {
 	SV_CheckTimeouts();
 
 	// get packets from clients
-	SV_ReadPackets();
+	if( SV_Replay_Playing() ) {
+		SV_Replay_ReadPackets();
+	}
+	else {
+		SV_ReadPackets();
+	}
 
 	// apply latched userinfo changes
 	SV_CheckLatchedUserinfoChanges();
 
+	s64 inputs_done = Sys_Microseconds();
+
+	double sleep_seconds = sv_metrics.sleep_seconds->value;
+
 	// let everything in the world think and move
-	if( SV_RunGameFrame( gamemsec ) ) {
+	bool snapshot = SV_RunGameFrame( gamemsec );
+
+	s64 game_done = Sys_Microseconds();
+
+	double snapshot_seconds = sv_metrics.snapshot_seconds->value;
+
+	if( snapshot ) {
 		// send messages back to the clients that had packets read this frame
 		SV_SendClientMessages();
+	}
+
+	s64 send_done = Sys_Microseconds();
+
+	SV_UpdateMetrics( start, inputs_done, game_done, send_done,
+		sv_metrics.sleep_seconds->value - sleep_seconds, sv_metrics.snapshot_seconds->value - snapshot_seconds );
 
-		// write snap to server demo file
-		SV_Demo_WriteSnap();
+	if( snapshot ) {
+		// record or check the state the inputs led to
+		SV_Replay_CheckState();
 
-		// send a heartbeat to the master if needed
-		SV_MasterHeartbeat();
+		if( !SV_Replay_Playing() ) {
+			// write snap to server demo file
+			SV_Demo_WriteSnap();
+
+			// send a heartbeat to the master if needed
+			SV_MasterHeartbeat();
+		}
 
 		// clear teleport flags, etc for next frame
 		G_ClearSnap();
 	}
+
+	if( timings != NULL ) {
+		timings->inputs = inputs_done - start;
+		timings->game = game_done - inputs_done;
+		timings->send = send_done - game_done;
+		timings->total = send_done - start;
+	}
 }
 
 //============================================================================
@@ -544,6 +659,7 @@ void SV_Init() {
 	CSPRNG_Bytes( entropy, sizeof( entropy ) );
 	svs.rng = NewRNG( entropy[ 0 ], entropy[ 1 ] );
 
+	SV_InitServerCommands();
 	SV_InitOperatorCommands();
 
 	sv_mempool = Mem_AllocPool( NULL, "Server" );
@@ -574,6 +690,7 @@ void SV_Init() {
 	sv_showInfoQueries = Cvar_Get( "sv_showInfoQueries", "0", 0 );
 
 	sv_uploads_http = Cvar_Get( "sv_uploads_http", "1", CVAR_READONLY );
+	sv_http_metrics = Cvar_Get( "sv_http_metrics", "0", CVAR_ARCHIVE );
 	sv_uploads_baseurl = Cvar_Get( "sv_uploads_baseurl", "", CVAR_ARCHIVE );
 	sv_uploads_demos = Cvar_Get( "sv_uploads_demos", "1", CVAR_ARCHIVE );
 	sv_uploads_demos_baseurl =  Cvar_Get( "sv_uploads_demos_baseurl", "", CVAR_ARCHIVE );
@@ -608,8 +725,19 @@ void SV_Init() {
 	g_autorecord = Cvar_Get( "g_autorecord", is_dedicated_server ? "1" : "0", CVAR_ARCHIVE );
 	g_autorecord_maxdemos = Cvar_Get( "g_autorecord_maxdemos", "200", CVAR_ARCHIVE );
 
+	sv_recordinputs = Cvar_Get( "sv_recordinputs", "0", CVAR_ARCHIVE );
+
 	sv_debug_serverCmd = Cvar_Get( "sv_debug_serverCmd", "0", CVAR_ARCHIVE );
 
+	sv_snap_scheduler = Cvar_Get( "sv_snap_scheduler", "1", CVAR_ARCHIVE );
+	sv_snap_minrate = Cvar_Get( "sv_snap_minrate", "8000", CVAR_ARCHIVE );
+	sv_snap_maxrate = Cvar_Get( "sv_snap_maxrate", "32000", CVAR_ARCHIVE );
+	sv_snap_maxinterval = Cvar_Get( "sv_snap_maxinterval", "3", CVAR_ARCHIVE );
+
+	sv_relay_password = Cvar_Get( "sv_relay_password", "", 0 );
+
+	SV_InitMetrics();
+
 	// this is a message holder for shared use
 	MSG_Init( &tmpMessage, tmpMessageData, sizeof( tmpMessageData ) );
 
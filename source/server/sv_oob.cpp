@@ -517,6 +517,8 @@ static void SVC_DirectConnect( const socket_t *socket, const netadr_t *address )
 		Com_DPrintf( "Server is full. Rejected a connection.\n" );
 		return;
 	}
+	SV_Replay_RecordConnect( newcl, userinfo, session_id, challenge );
+
 	if( newcl->state && newcl->edict && ( newcl->edict->r.svflags & SVF_FAKECLIENT ) ) {
 		SV_DropClient( newcl, DROP_TYPE_GENERAL, "%s", "Need room for a real player" );
 	}
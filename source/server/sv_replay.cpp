@@ -0,0 +1,594 @@
+/*
+Copyright (C) 1997-2001 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include <time.h>
+
+#include "server/server.h"
+#include "qcommon/array.h"
+#include "qcommon/hash.h"
+#include "qcommon/metrics.h"
+#include "qcommon/string.h"
+
+/*
+ * Input recordings capture everything that feeds the simulation from outside:
+ * the frame times and RNG seed SV_Frame picks, the wall clock the game reads,
+ * real client connects, and every client message after the netchan has dealt
+ * with it. Replaying them
+ * from the same map spawn drives SV_RunFrame with the same inputs, so the
+ * game state after each snapshot should hash the same as it did live.
+ *
+ * Recordings start when a level spawns with sv_recordinputs set. Clients
+ * carried over from the previous level get reconnected at the start of the
+ * replay, so replays are only exact for recordings that start empty.
+ *
+ * Replay clients get a netchan that builds, compresses and sequences every
+ * message like a real one but never hands anything to the OS.
+ */
+
+#define SV_REPLAY_DIR "replays"
+#define SV_REPLAY_EXTENSION ".replay"
+
+static constexpr int REPLAY_MAGIC = 0x50524443; // CDRP
+static constexpr u64 REPLAY_VERSION = 1;
+
+enum ReplayEventType : u8 {
+	ReplayEvent_Frame,
+	ReplayEvent_Connect,
+	ReplayEvent_Packet,
+	ReplayEvent_State,
+	ReplayEvent_Clock,
+};
+
+struct ReplayHeader {
+	char mapname[ MAX_QPATH ];
+	int maxclients;
+	int spawncount;
+	int64_t realtime;
+	int64_t game_frame_acc_time;
+	RNG rng;
+};
+
+static int record_file;
+
+static struct {
+	bool playing;
+	msg_t msg;
+	ReplayHeader header;
+
+	socket_t socket;
+	netadr_t address;
+
+	u32 states_matched;
+	u32 states_mismatched;
+	int64_t first_mismatch_frame;
+} replay;
+
+static void SV_Replay_Write( const msg_t * msg ) {
+	FS_Write( msg->data, msg->cursize, record_file );
+}
+
+/*
+* SV_Replay_HashGameState
+* everything clients get told about, which is everything inputs can change
+*/
+static u64 SV_Replay_HashGameState() {
+	u64 hash = Hash64( u64( svs.gametime ) );
+	hash = Hash64( &server_gs.gameState, sizeof( server_gs.gameState ), hash );
+
+	for( int i = 0; i < sv.gi.num_edicts; i++ ) {
+		const edict_t * ent = EDICT_NUM( i );
+		if( !ent->r.inuse ) {
+			continue;
+		}
+
+		hash = Hash64( &ent->s, sizeof( ent->s ), hash );
+		if( ent->r.client != NULL ) {
+			hash = Hash64( &ent->r.client->ps, sizeof( ent->r.client->ps ), hash );
+		}
+	}
+
+	return hash;
+}
+
+static void SV_Replay_WriteConnect( const client_t * client, const char * userinfo, u64 session_id, int challenge ) {
+	static uint8_t buffer[ MAX_INFO_STRING + 64 ];
+	msg_t msg;
+	MSG_Init( &msg, buffer, sizeof( buffer ) );
+
+	MSG_WriteUint8( &msg, ReplayEvent_Connect );
+	MSG_WriteUintBase128( &msg, client - svs.clients );
+	MSG_WriteUint64( &msg, session_id );
+	MSG_WriteIntBase128( &msg, challenge );
+	MSG_WriteString( &msg, userinfo );
+
+	SV_Replay_Write( &msg );
+}
+
+static void SV_Replay_StartRecording( const char * mapname ) {
+	char date[ 128 ];
+	time_t now = time( NULL );
+	strftime( date, sizeof( date ), "%Y-%m-%d_%H-%M-%S", localtime( &now ) );
+
+	char filename[ MAX_QPATH ];
+	snprintf( filename, sizeof( filename ), "%s/%s_%s%s", SV_REPLAY_DIR, date, mapname, SV_REPLAY_EXTENSION );
+	COM_SanitizeFilePath( filename );
+
+	if( FS_FOpenBaseFile( filename, &record_file, FS_WRITE ) == -1 ) {
+		Com_Printf( "Error: Couldn't open file: %s\n", filename );
+		record_file = 0;
+		return;
+	}
+
+	Com_Printf( "Recording server inputs: %s\n", filename );
+
+	DynamicString config( sys_allocator );
+	Cvar_WriteVariables( &config );
+
+	static uint8_t buffer[ 256 ];
+	msg_t msg;
+	MSG_Init( &msg, buffer, sizeof( buffer ) );
+
+	MSG_WriteInt32( &msg, REPLAY_MAGIC );
+	MSG_WriteUintBase128( &msg, REPLAY_VERSION );
+	MSG_WriteString( &msg, mapname );
+	MSG_WriteUintBase128( &msg, sv_maxclients->integer );
+	MSG_WriteIntBase128( &msg, svs.spawncount );
+	MSG_WriteIntBase128( &msg, svs.realtime );
+	MSG_WriteIntBase128( &msg, svs.game_frame_acc_time );
+	MSG_WriteUint64( &msg, svs.rng.state );
+	MSG_WriteUint64( &msg, svs.rng.inc );
+	MSG_WriteUintBase128( &msg, config.length() );
+	SV_Replay_Write( &msg );
+
+	FS_Write( config.c_str(), config.length(), record_file );
+
+	for( int i = 0; i < sv_maxclients->integer; i++ ) {
+		const client_t * cl = &svs.clients[ i ];
+		if( cl->state == CS_FREE || cl->state == CS_ZOMBIE ) {
+			continue;
+		}
+		if( cl->edict && ( cl->edict->r.svflags & SVF_FAKECLIENT ) ) {
+			continue;
+		}
+
+		SV_Replay_WriteConnect( cl, cl->userinfo, cl->netchan.session_id, cl->challenge );
+	}
+}
+
+void SV_Replay_StopRecording() {
+	if( record_file == 0 ) {
+		return;
+	}
+
+	FS_FCloseFile( record_file );
+	record_file = 0;
+}
+
+/*
+* SV_Replay_BeginLevel
+* called from SV_SpawnServer before the map gets loaded
+*/
+void SV_Replay_BeginLevel( const char * mapname ) {
+	if( replay.playing ) {
+		svs.spawncount = replay.header.spawncount;
+		svs.realtime = replay.header.realtime;
+		svs.game_frame_acc_time = replay.header.game_frame_acc_time;
+		svs.rng = replay.header.rng;
+		return;
+	}
+
+	SV_Replay_StopRecording();
+
+	if( sv_recordinputs->integer ) {
+		SV_Replay_StartRecording( mapname );
+	}
+}
+
+void SV_Replay_RecordFrame( unsigned realmsec, unsigned gamemsec ) {
+	if( record_file == 0 ) {
+		return;
+	}
+
+	uint8_t buffer[ 64 ];
+	msg_t msg;
+	MSG_Init( &msg, buffer, sizeof( buffer ) );
+
+	MSG_WriteUint8( &msg, ReplayEvent_Frame );
+	MSG_WriteUintBase128( &msg, realmsec );
+	MSG_WriteUintBase128( &msg, gamemsec );
+	MSG_WriteUint64( &msg, svs.rng.state );
+	MSG_WriteUint64( &msg, svs.rng.inc );
+
+	SV_Replay_Write( &msg );
+}
+
+void SV_Replay_RecordConnect( const client_t * client, const char * userinfo, u64 session_id, int challenge ) {
+	if( record_file == 0 ) {
+		return;
+	}
+
+	SV_Replay_WriteConnect( client, userinfo, session_id, challenge );
+}
+
+void SV_Replay_RecordPacket( const client_t * client, const msg_t * packet ) {
+	if( record_file == 0 ) {
+		return;
+	}
+
+	size_t len = packet->cursize - packet->readcount;
+
+	uint8_t buffer[ 32 ];
+	msg_t msg;
+	MSG_Init( &msg, buffer, sizeof( buffer ) );
+
+	MSG_WriteUint8( &msg, ReplayEvent_Packet );
+	MSG_WriteUintBase128( &msg, client - svs.clients );
+	MSG_WriteUintBase128( &msg, len );
+
+	SV_Replay_Write( &msg );
+	FS_Write( packet->data + packet->readcount, len, record_file );
+}
+
+void SV_Replay_RecordClock( int64_t time ) {
+	if( record_file == 0 ) {
+		return;
+	}
+
+	uint8_t buffer[ 16 ];
+	msg_t msg;
+	MSG_Init( &msg, buffer, sizeof( buffer ) );
+
+	MSG_WriteUint8( &msg, ReplayEvent_Clock );
+	MSG_WriteIntBase128( &msg, time );
+
+	SV_Replay_Write( &msg );
+}
+
+bool SV_Replay_Playing() {
+	return replay.playing;
+}
+
+static bool SV_Replay_Done() {
+	return replay.msg.readcount >= replay.msg.cursize;
+}
+
+static ReplayEventType SV_Replay_PeekEvent() {
+	return ReplayEventType( replay.msg.data[ replay.msg.readcount ] );
+}
+
+static client_t * SV_Replay_ReadClient() {
+	u64 slot = MSG_ReadUintBase128( &replay.msg );
+	if( slot >= u64( sv_maxclients->integer ) ) {
+		return NULL;
+	}
+	return &svs.clients[ slot ];
+}
+
+static void SV_Replay_Connect() {
+	client_t * cl = SV_Replay_ReadClient();
+	u64 session_id = MSG_ReadUint64( &replay.msg );
+	int challenge = MSG_ReadIntBase128( &replay.msg );
+
+	char userinfo[ MAX_INFO_STRING ];
+	Q_strncpyz( userinfo, MSG_ReadString( &replay.msg ), sizeof( userinfo ) );
+
+	if( cl == NULL ) {
+		return;
+	}
+
+	if( cl->state && cl->edict && ( cl->edict->r.svflags & SVF_FAKECLIENT ) ) {
+		SV_DropClient( cl, DROP_TYPE_GENERAL, "%s", "Need room for a real player" );
+	}
+
+	SV_ClientConnect( &replay.socket, &replay.address, cl, userinfo, session_id, challenge, false );
+}
+
+static void SV_Replay_Packet() {
+	client_t * cl = SV_Replay_ReadClient();
+	size_t len = MSG_ReadUintBase128( &replay.msg );
+	if( replay.msg.readcount + len > replay.msg.cursize ) {
+		replay.msg.readcount = replay.msg.cursize;
+		return;
+	}
+
+	msg_t packet;
+	MSG_Init( &packet, replay.msg.data + replay.msg.readcount, len );
+	packet.cursize = len;
+	MSG_SkipData( &replay.msg, len );
+
+	if( cl == NULL || cl->state == CS_FREE || cl->state == CS_ZOMBIE ) {
+		return;
+	}
+	if( cl->edict && ( cl->edict->r.svflags & SVF_FAKECLIENT ) ) {
+		return;
+	}
+
+	cl->lastPacketReceivedTime = svs.realtime;
+	SV_ParseClientMessage( cl, &packet );
+}
+
+/*
+* SV_Replay_ReadPackets
+* stands in for SV_ReadPackets while replaying
+*/
+void SV_Replay_ReadPackets() {
+	while( !SV_Replay_Done() ) {
+		ReplayEventType type = SV_Replay_PeekEvent();
+		if( type == ReplayEvent_Connect ) {
+			MSG_ReadUint8( &replay.msg );
+			SV_Replay_Connect();
+		}
+		else if( type == ReplayEvent_Packet ) {
+			MSG_ReadUint8( &replay.msg );
+			SV_Replay_Packet();
+		}
+		else {
+			break;
+		}
+	}
+}
+
+int64_t SV_Replay_ReadClock() {
+	if( SV_Replay_Done() || SV_Replay_PeekEvent() != ReplayEvent_Clock ) {
+		return svs.realtime;
+	}
+
+	MSG_ReadUint8( &replay.msg );
+	return MSG_ReadIntBase128( &replay.msg );
+}
+
+static void SV_Replay_StateMismatch() {
+	if( replay.states_mismatched == 0 ) {
+		replay.first_mismatch_frame = sv.framenum;
+	}
+	replay.states_mismatched++;
+}
+
+void SV_Replay_CheckState() {
+	if( record_file == 0 && !replay.playing ) {
+		return;
+	}
+
+	u64 hash = SV_Replay_HashGameState();
+
+	if( replay.playing ) {
+		if( SV_Replay_Done() || SV_Replay_PeekEvent() != ReplayEvent_State ) {
+			SV_Replay_StateMismatch();
+			return;
+		}
+
+		MSG_ReadUint8( &replay.msg );
+		if( MSG_ReadUint64( &replay.msg ) == hash ) {
+			replay.states_matched++;
+		}
+		else {
+			SV_Replay_StateMismatch();
+		}
+		return;
+	}
+
+	uint8_t buffer[ 16 ];
+	msg_t msg;
+	MSG_Init( &msg, buffer, sizeof( buffer ) );
+
+	MSG_WriteUint8( &msg, ReplayEvent_State );
+	MSG_WriteUint64( &msg, hash );
+
+	SV_Replay_Write( &msg );
+}
+
+static bool SV_Replay_ReadHeader( Span< const char > * config ) {
+	if( MSG_ReadInt32( &replay.msg ) != REPLAY_MAGIC ) {
+		Com_Printf( "Not an input recording\n" );
+		return false;
+	}
+
+	u64 version = MSG_ReadUintBase128( &replay.msg );
+	if( version != REPLAY_VERSION ) {
+		Com_Printf( "Unsupported input recording version %u\n", u32( version ) );
+		return false;
+	}
+
+	ReplayHeader * header = &replay.header;
+	Q_strncpyz( header->mapname, MSG_ReadString( &replay.msg ), sizeof( header->mapname ) );
+	header->maxclients = MSG_ReadUintBase128( &replay.msg );
+	header->spawncount = MSG_ReadIntBase128( &replay.msg );
+	header->realtime = MSG_ReadIntBase128( &replay.msg );
+	header->game_frame_acc_time = MSG_ReadIntBase128( &replay.msg );
+	header->rng.state = MSG_ReadUint64( &replay.msg );
+	header->rng.inc = MSG_ReadUint64( &replay.msg );
+
+	size_t config_len = MSG_ReadUintBase128( &replay.msg );
+	if( replay.msg.readcount + config_len > replay.msg.cursize ) {
+		Com_Printf( "Input recording is truncated\n" );
+		return false;
+	}
+
+	*config = Span< const char >( ( const char * ) replay.msg.data + replay.msg.readcount, config_len );
+	MSG_SkipData( &replay.msg, config_len );
+
+	return true;
+}
+
+static void SV_Replay_ExecuteConfig( Span< const char > config ) {
+	while( config.n > 0 ) {
+		size_t len = 0;
+		while( len < config.n && config[ len ] != '\n' && config[ len ] != '\r' ) {
+			len++;
+		}
+
+		if( len > 0 ) {
+			char line[ MAX_STRING_CHARS ];
+			Q_strncpyz( line, config.ptr, Min2( sizeof( line ), len + 1 ) );
+			Cmd_ExecuteString( line );
+		}
+
+		config = config + Min2( len + 1, config.n );
+	}
+}
+
+/*
+* SV_Replay_f
+* replayinputs <name>
+*/
+void SV_Replay_f() {
+	if( Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: replayinputs <name>\n" );
+		return;
+	}
+
+	if( replay.playing ) {
+		Com_Printf( "Already replaying\n" );
+		return;
+	}
+
+	char filename[ MAX_QPATH ];
+	snprintf( filename, sizeof( filename ), "%s/%s", SV_REPLAY_DIR, Cmd_Argv( 1 ) );
+	COM_SanitizeFilePath( filename );
+	COM_DefaultExtension( filename, SV_REPLAY_EXTENSION, sizeof( filename ) );
+
+	if( !COM_ValidateRelativeFilename( filename ) ) {
+		Com_Printf( "Invalid filename.\n" );
+		return;
+	}
+
+	void * data;
+	int len = FS_LoadBaseFile( filename, &data, NULL, 0 );
+	if( len <= 0 ) {
+		Com_Printf( "Couldn't load %s\n", filename );
+		return;
+	}
+	defer { FS_FreeBaseFile( data ); };
+
+	MSG_Init( &replay.msg, ( uint8_t * ) data, len );
+	replay.msg.cursize = len;
+
+	Span< const char > config;
+	if( !SV_Replay_ReadHeader( &config ) ) {
+		return;
+	}
+
+	Com_Printf( "Replaying server inputs: %s\n", filename );
+
+	// start from a fresh game like the recording did
+	SV_ShutdownGame( "Replaying server inputs", false );
+	sv.state = ss_dead;
+	SV_Replay_ExecuteConfig( config );
+
+	replay.playing = true;
+	defer { replay.playing = false; };
+
+	replay.socket = { };
+	replay.socket.open = true;
+	replay.socket.type = SOCKET_LOOPBACK;
+	NET_InitAddress( &replay.address, NA_NOTRANSMIT );
+
+	replay.states_matched = 0;
+	replay.states_mismatched = 0;
+	replay.first_mismatch_frame = 0;
+
+	SV_Map( replay.header.mapname, false );
+
+	if( !svs.initialized || sv.state != ss_game ) {
+		Com_Printf( "Couldn't spawn %s\n", replay.header.mapname );
+		return;
+	}
+
+	if( sv_maxclients->integer != replay.header.maxclients ) {
+		Com_Printf( "Recording was made with sv_maxclients %i, can't replay it with %i\n",
+			replay.header.maxclients, sv_maxclients->integer );
+		return;
+	}
+
+	DynamicArray< s64 > inputs( sys_allocator );
+	DynamicArray< s64 > game( sys_allocator );
+	DynamicArray< s64 > send( sys_allocator );
+	DynamicArray< s64 > total( sys_allocator );
+
+	// clients carried over from the previous level
+	SV_Replay_ReadPackets();
+
+	s64 recorded_time = 0;
+	s64 start = Sys_Microseconds();
+
+	while( !SV_Replay_Done() ) {
+		u8 type = MSG_ReadUint8( &replay.msg );
+
+		if( type == ReplayEvent_State ) {
+			// the live server took a snapshot we didn't
+			MSG_ReadUint64( &replay.msg );
+			SV_Replay_StateMismatch();
+			continue;
+		}
+
+		if( type == ReplayEvent_Clock ) {
+			// the live game read the clock somewhere we didn't
+			MSG_ReadIntBase128( &replay.msg );
+			continue;
+		}
+
+		if( type != ReplayEvent_Frame ) {
+			Com_Printf( "Input recording is corrupt\n" );
+			break;
+		}
+
+		unsigned realmsec = MSG_ReadUintBase128( &replay.msg );
+		unsigned gamemsec = MSG_ReadUintBase128( &replay.msg );
+		RNG rng;
+		rng.state = MSG_ReadUint64( &replay.msg );
+		rng.inc = MSG_ReadUint64( &replay.msg );
+
+		svs.frame_arena.clear();
+		svs.rng = rng;
+
+		ServerFrameTimings timings;
+		SV_RunFrame( realmsec, gamemsec, &timings );
+
+		inputs.add( timings.inputs );
+		game.add( timings.game );
+		send.add( timings.send );
+		total.add( timings.total );
+
+		recorded_time += realmsec;
+	}
+
+	s64 elapsed = Sys_Microseconds() - start;
+
+	Com_Printf( "Replayed %u frames, %.2fs of recording in %.2fs (%.1fx)\n",
+		u32( total.size() ), recorded_time / 1000.0f, elapsed / 1000000.0f, recorded_time * 1000.0f / Max2( elapsed, s64( 1 ) ) );
+
+	if( replay.states_mismatched == 0 ) {
+		Com_Printf( "All %u game states matched\n", replay.states_matched );
+	}
+	else {
+		Com_Printf( S_COLOR_RED "%u of %u game states didn't match, starting at frame %u\n",
+			replay.states_mismatched, replay.states_matched + replay.states_mismatched, u32( replay.first_mismatch_frame ) );
+	}
+
+	if( total.size() == 0 ) {
+		return;
+	}
+
+	PrintPercentilesHeader( "usec" );
+	PrintPercentiles( "inputs", inputs.span() );
+	PrintPercentiles( "game", game.span() );
+	PrintPercentiles( "send", send.span() );
+	PrintPercentiles( "total", total.span() );
+}
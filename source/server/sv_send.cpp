@@ -72,65 +72,230 @@ void SV_AddGameCommand( client_t *client, const char *cmd ) {
 }
 
 /*
-* SV_AddServerCommand
+* commands are let go of once they're acknowledged, so at most every
+* client's reliable command ring and the demo client's are full at once.
+* on top of that every broadcast holds one while it queues it, and queueing
+* can drop a client, which broadcasts again, at most once per client
+*/
+static ServerCommand server_commands[( MAX_CLIENTS + 1 ) * MAX_RELIABLE_COMMANDS + MAX_CLIENTS + 2];
+static ServerCommand * free_server_commands[ARRAY_COUNT( server_commands )];
+static size_t num_free_server_commands;
+
+// the newest broadcast, so configstrings sent to everyone can be batched
+static ServerCommand * last_broadcast;
+
+/*
+* SV_InitServerCommands
+*/
+void SV_InitServerCommands() {
+	for( size_t i = 0; i < ARRAY_COUNT( server_commands ); i++ ) {
+		server_commands[i].refcount = 0;
+		free_server_commands[i] = &server_commands[ARRAY_COUNT( server_commands ) - i - 1];
+	}
+	num_free_server_commands = ARRAY_COUNT( server_commands );
+	last_broadcast = NULL;
+}
+
+static ServerCommand *SV_NewServerCommand( const char *cmd ) {
+	if( num_free_server_commands == 0 ) {
+		Com_Error( ERR_FATAL, "Ran out of server commands" );
+	}
+
+	num_free_server_commands--;
+	ServerCommand *command = free_server_commands[num_free_server_commands];
+	command->refcount = 1;
+	command->sent = false;
+	Q_strncpyz( command->text, cmd, sizeof( command->text ) );
+	command->len = strlen( command->text );
+
+	return command;
+}
+
+static void SV_ReleaseServerCommand( ServerCommand *command ) {
+	assert( command->refcount > 0 );
+
+	command->refcount--;
+	if( command->refcount == 0 ) {
+		if( command == last_broadcast ) {
+			last_broadcast = NULL;
+		}
+		free_server_commands[num_free_server_commands] = command;
+		num_free_server_commands++;
+	}
+}
+
+/*
+* SV_ReleaseServerCommands
+* let go of everything in the client's reliable command ring
+*/
+void SV_ReleaseServerCommands( client_t *client ) {
+	for( int i = 0; i < MAX_RELIABLE_COMMANDS; i++ ) {
+		if( client->reliableCommands[i] != NULL ) {
+			SV_ReleaseServerCommand( client->reliableCommands[i] );
+			client->reliableCommands[i] = NULL;
+		}
+	}
+}
+
+/*
+* SV_AcknowledgeServerCommands
+* the client has everything up to ack, so we don't need to hold on to it
+*/
+void SV_AcknowledgeServerCommands( client_t *client, int64_t ack ) {
+	for( int64_t i = client->reliableAcknowledge + 1; i <= ack; i++ ) {
+		ServerCommand **command = &client->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )];
+		if( *command != NULL ) {
+			SV_ReleaseServerCommand( *command );
+			*command = NULL;
+		}
+	}
+	client->reliableAcknowledge = ack;
+}
+
+/*
+* SV_BatchConfigString
+*
+* ch : To avoid overflow of messages from excessive amount of configstrings
+* we batch them here. On incoming "cs" command, we'll append it to a pending
+* "cs" command that has space in it, if not, we'll create a new one.
+*/
+static bool SV_BatchConfigString( ServerCommand *command, const char *cmd ) {
+	// length of the index/value (leave room for one space and null char)
+	size_t len = strlen( cmd ) - 1;
+
+	if( command->sent || strncmp( command->text, "cs ", 3 ) != 0 ) {
+		return false;
+	}
+
+	// is there any room?
+	if( command->len + len >= MAX_STRING_CHARS ) {
+		return false;
+	}
+
+	Q_strncatz( command->text, cmd + 2, MAX_STRING_CHARS - 1 );
+	command->len = strlen( command->text );
+	return true;
+}
+
+static bool SV_TakesServerCommands( const client_t *client ) {
+	return client->edict == NULL || !( client->edict->r.svflags & SVF_FAKECLIENT );
+}
+
+/*
+* SV_QueueServerCommand
 *
 * The given command will be transmitted to the client, and is guaranteed to
 * not have future snapshot_t executed before it is executed
 */
-void SV_AddServerCommand( client_t *client, const char *cmd ) {
-	int index;
+static void SV_QueueServerCommand( client_t *client, ServerCommand *command ) {
 	unsigned int i;
 
+	client->reliableSequence++;
+	// if we would be losing an old command that hasn't been acknowledged, we must drop the connection
+	// we check == instead of >= so a broadcast print added by SV_DropClient() doesn't cause a recursive drop client
+	if( client->reliableSequence - client->reliableAcknowledge == MAX_RELIABLE_COMMANDS + 1 ) {
+		//Com_Printf( "===== pending server commands =====\n" );
+		for( i = client->reliableAcknowledge + 1; i <= client->reliableSequence; i++ ) {
+			const ServerCommand *pending = client->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )];
+			Com_DPrintf( "cmd %5d: %s\n", i, pending != NULL ? pending->text : "" );
+		}
+		Com_DPrintf( "cmd %5d: %s\n", i, command->text );
+		SV_DropClient( client, DROP_TYPE_GENERAL, "%s", "Error: Server command overflow" );
+		return;
+	}
+
+	int index = client->reliableSequence & ( MAX_RELIABLE_COMMANDS - 1 );
+	if( client->reliableCommands[index] != NULL ) {
+		SV_ReleaseServerCommand( client->reliableCommands[index] );
+	}
+	client->reliableCommands[index] = command;
+	command->refcount++;
+}
+
+/*
+* SV_AddServerCommand
+*
+* Queues a command for a single client
+*/
+void SV_AddServerCommand( client_t *client, const char *cmd ) {
 	if( !client ) {
 		return;
 	}
 
-	if( client->edict && ( client->edict->r.svflags & SVF_FAKECLIENT ) ) {
+	if( !SV_TakesServerCommands( client ) ) {
 		return;
 	}
 
-	if( !cmd || !cmd[0] || !strlen( cmd ) ) {
+	if( !cmd || !cmd[0] ) {
 		return;
 	}
 
-	// ch : To avoid overflow of messages from excessive amount of configstrings
-	// we batch them here. On incoming "cs" command, we'll trackback the queue
-	// to find a pending "cs" command that has space in it. If we'll find one,
-	// we'll batch this there, if not, we'll create a new one.
+	// trackback the queue for a pending "cs" command only this client has
 	if( !strncmp( cmd, "cs ", 3 ) ) {
-		// length of the index/value (leave room for one space and null char)
-		size_t len = strlen( cmd ) - 1;
-		for( i = client->reliableSequence; i > client->reliableSent; i-- ) {
-			size_t otherLen;
-			char *otherCmd;
-
-			otherCmd = client->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )];
-			if( !strncmp( otherCmd, "cs ", 3 ) ) {
-				otherLen = strlen( otherCmd );
-				// is there any room? (should check for sizeof client->reliableCommands[0]?)
-				if( ( otherLen + len ) < MAX_STRING_CHARS ) {
-					// yahoo, put it in here
-					Q_strncatz( otherCmd, cmd + 2, MAX_STRING_CHARS - 1 );
-					return;
-				}
+		for( int64_t i = client->reliableSequence; i > client->reliableSent; i-- ) {
+			ServerCommand *other = client->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )];
+			if( other != NULL && other->refcount == 1 && SV_BatchConfigString( other, cmd ) ) {
+				return;
 			}
 		}
 	}
 
-	client->reliableSequence++;
-	// if we would be losing an old command that hasn't been acknowledged, we must drop the connection
-	// we check == instead of >= so a broadcast print added by SV_DropClient() doesn't cause a recursive drop client
-	if( client->reliableSequence - client->reliableAcknowledge == MAX_RELIABLE_COMMANDS + 1 ) {
-		//Com_Printf( "===== pending server commands =====\n" );
-		for( i = client->reliableAcknowledge + 1; i <= client->reliableSequence; i++ ) {
-			Com_DPrintf( "cmd %5d: %s\n", i, client->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )] );
+	ServerCommand *command = SV_NewServerCommand( cmd );
+	SV_QueueServerCommand( client, command );
+	SV_ReleaseServerCommand( command );
+}
+
+/*
+* SV_BroadcastServerCommand
+*
+* Queues one shared copy of a command for every connected client
+*/
+static void SV_BroadcastServerCommand( const char *cmd, bool demo ) {
+	if( !cmd[0] ) {
+		return;
+	}
+
+	client_t *recipients[MAX_CLIENTS + 1];
+	int num_recipients = 0;
+
+	for( int i = 0; i < sv_maxclients->integer; i++ ) {
+		client_t *client = &svs.clients[i];
+		if( client->state < CS_CONNECTING || !SV_TakesServerCommands( client ) ) {
+			continue;
 		}
-		Com_DPrintf( "cmd %5d: %s\n", i, cmd );
-		SV_DropClient( client, DROP_TYPE_GENERAL, "%s", "Error: Server command overflow" );
+		recipients[num_recipients++] = client;
+	}
+
+	if( demo && svs.demo.file ) {
+		recipients[num_recipients++] = &svs.demo.client;
+	}
+
+	if( num_recipients == 0 ) {
 		return;
 	}
-	index = client->reliableSequence & ( MAX_RELIABLE_COMMANDS - 1 );
-	Q_strncpyz( client->reliableCommands[index], cmd, sizeof( client->reliableCommands[index] ) );
+
+	// batch into the last broadcast if it's still at the end of everyone's queue
+	if( !strncmp( cmd, "cs ", 3 ) && last_broadcast != NULL && last_broadcast->refcount == u32( num_recipients ) ) {
+		bool everyone = true;
+		for( int i = 0; i < num_recipients; i++ ) {
+			const client_t *client = recipients[i];
+			if( client->reliableCommands[client->reliableSequence & ( MAX_RELIABLE_COMMANDS - 1 )] != last_broadcast ) {
+				everyone = false;
+				break;
+			}
+		}
+
+		if( everyone && SV_BatchConfigString( last_broadcast, cmd ) ) {
+			return;
+		}
+	}
+
+	ServerCommand *command = SV_NewServerCommand( cmd );
+	for( int i = 0; i < num_recipients; i++ ) {
+		SV_QueueServerCommand( recipients[i], command );
+	}
+	last_broadcast = command->refcount > 1 ? command : NULL;
+	SV_ReleaseServerCommand( command );
 }
 
 /*
@@ -143,8 +308,6 @@ void SV_AddServerCommand( client_t *client, const char *cmd ) {
 void SV_SendServerCommand( client_t *cl, const char *format, ... ) {
 	va_list argptr;
 	char message[MAX_MSGLEN];
-	client_t *client;
-	int i;
 
 	va_start( argptr, format );
 	vsnprintf( message, sizeof( message ), format, argptr );
@@ -158,18 +321,8 @@ void SV_SendServerCommand( client_t *cl, const char *format, ... ) {
 		return;
 	}
 
-	// send the data to all relevant clients
-	for( i = 0, client = svs.clients; i < sv_maxclients->integer; i++, client++ ) {
-		if( client->state < CS_CONNECTING ) {
-			continue;
-		}
-		SV_AddServerCommand( client, message );
-	}
-
-	// add to demo
-	if( svs.demo.file ) {
-		SV_AddServerCommand( &svs.demo.client, message );
-	}
+	// send the data to all relevant clients and the demo
+	SV_BroadcastServerCommand( message, true );
 }
 
 /*
@@ -191,22 +344,23 @@ void SV_AddReliableCommandsToMessage( client_t *client, msg_t *msg ) {
 
 	// write any unacknowledged serverCommands
 	for( i = client->reliableAcknowledge + 1; i <= client->reliableSequence; i++ ) {
-		if( !strlen( client->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )] ) ) {
+		ServerCommand *command = client->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )];
+		if( command == NULL ) {
 			continue;
 		}
+		command->sent = true;
 		MSG_WriteUint8( msg, svc_servercmd );
 		if( !client->reliable ) {
 			MSG_WriteInt32( msg, i );
 		}
-		MSG_WriteString( msg, client->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )] );
+		MSG_WriteString( msg, command->text );
 		if( sv_debug_serverCmd->integer ) {
-			Com_Printf( "SV_AddServerCommandsToMessage(%i):%s\n", i,
-						client->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )] );
+			Com_Printf( "SV_AddServerCommandsToMessage(%i):%s\n", i, command->text );
 		}
 	}
 	client->reliableSent = client->reliableSequence;
 	if( client->reliable ) {
-		client->reliableAcknowledge = client->reliableSent;
+		SV_AcknowledgeServerCommands( client, client->reliableSent );
 	}
 }
 
@@ -222,8 +376,6 @@ void SV_AddReliableCommandsToMessage( client_t *client, msg_t *msg ) {
 * Sends a command to all connected clients. Ignores client->state < CS_SPAWNED check
 */
 void SV_BroadcastCommand( const char *format, ... ) {
-	client_t *client;
-	int i;
 	va_list argptr;
 	char string[1024];
 
@@ -235,12 +387,7 @@ void SV_BroadcastCommand( const char *format, ... ) {
 	vsnprintf( string, sizeof( string ), format, argptr );
 	va_end( argptr );
 
-	for( i = 0, client = svs.clients; i < sv_maxclients->integer; i++, client++ ) {
-		if( client->state < CS_CONNECTING ) {
-			continue;
-		}
-		SV_SendServerCommand( client, string );
-	}
+	SV_BroadcastServerCommand( string, false );
 }
 
 //===============================================================================
@@ -334,7 +481,9 @@ bool SV_SendMessageToClient( client_t *client, msg_t *msg ) {
 
 	// transmit the message data
 	client->lastPacketSentTime = svs.realtime;
-	return SV_Netchan_Transmit( &client->netchan, msg );
+	bool sent = SV_Netchan_Transmit( &client->netchan, msg );
+	client->netstats_bytes_out += msg->cursize;
+	return sent;
 }
 
 /*
@@ -371,6 +520,56 @@ void SV_BuildClientFrameSnap( client_t *client ) {
 		client, &server_gs.gameState, &svs.client_entities, sv_mempool );
 }
 
+/*
+* SV_UpdateClientRate
+*
+* Estimates how much the client's link can take from packet loss and how far
+* behind its snapshot acks are. The rate backs off multiplicatively when the
+* link looks congested and grows back additively, and once it bottoms out the
+* client gets snapshots less often instead.
+*/
+static void SV_UpdateClientRate( client_t *client ) {
+	if( !sv_snap_scheduler->integer || client->reliable || client->mv ) {
+		client->snap_interval = 1;
+		client->snap_budget = 0;
+		return;
+	}
+
+	int min_rate = Max2( 1000, sv_snap_minrate->integer );
+	int max_rate = Max2( min_rate, sv_snap_maxrate->integer );
+	int max_interval = Clamp( 1, sv_snap_maxinterval->integer, 8 );
+
+	if( client->snap_rate == 0 ) {
+		client->snap_rate = max_rate;
+		client->snap_interval = 1;
+	}
+
+	// snapshots in flight beyond what the client's ping accounts for
+	int64_t unacked = client->lastSentFrameNum - client->lastframe;
+	int64_t expected = client->ping / svc.snapFrameTime + client->snap_interval + 2;
+	bool congested = client->snap_lost_packets > 0 || ( client->lastframe > 0 && unacked > expected );
+	client->snap_lost_packets = 0;
+
+	if( congested ) {
+		if( client->snap_rate == min_rate ) {
+			client->snap_interval = Min2( client->snap_interval + 1, max_interval );
+		}
+		client->snap_rate = Max2( min_rate, client->snap_rate * 3 / 4 );
+	}
+	else {
+		client->snap_rate = Min2( max_rate, client->snap_rate + max_rate / 50 );
+		if( client->snap_interval > 1 && client->snap_rate >= min_rate * 2 ) {
+			client->snap_interval--;
+		}
+	}
+
+	client->snap_interval = Min2( client->snap_interval, max_interval );
+
+	// keep snapshots to a single packet so they never need fragmenting
+	int budget = client->snap_rate * int( svc.snapFrameTime ) * client->snap_interval / 1000;
+	client->snap_budget = Min2( budget, FRAGMENT_SIZE );
+}
+
 /*
 * SV_SendClientDatagram
 */
@@ -379,15 +578,24 @@ static bool SV_SendClientDatagram( client_t *client ) {
 		return true;
 	}
 
+	SV_UpdateClientRate( client );
+
 	SV_InitClientMessage( client, &tmpMessage, NULL, 0 );
 
 	SV_AddReliableCommandsToMessage( client, &tmpMessage );
 
 	// send over all the relevant SyncEntityState
 	// and the SyncPlayerState
+	s64 start = Sys_Microseconds();
+	size_t before = tmpMessage.cursize;
+
 	SV_BuildClientFrameSnap( client );
 
 	SV_WriteFrameSnapToClient( client, &tmpMessage );
+	client->netstats_snaps++;
+
+	Increment( sv_metrics.snapshot_seconds, ( Sys_Microseconds() - start ) / 1000000.0 );
+	Observe( sv_metrics.snapshot_bytes, tmpMessage.cursize - before );
 
 	return SV_SendMessageToClient( client, &tmpMessage );
 }
@@ -413,6 +621,11 @@ void SV_SendClientMessages() {
 		}
 
 		if( client->state == CS_SPAWNED ) {
+			// clients on poor links get snapshots less often
+			if( client->snap_interval > 1 && sv.framenum - client->lastSentFrameNum < client->snap_interval ) {
+				continue;
+			}
+
 			if( !SV_SendClientDatagram( client ) ) {
 				Com_Printf( "Error sending message to %s: %s\n", client->name, NET_ErrorString() );
 				if( client->reliable ) {
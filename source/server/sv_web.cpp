@@ -20,6 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "server/server.h"
 #include "qcommon/q_trie.h"
+#include "qcommon/string.h"
 #include "qcommon/threads.h"
 
 #define MAX_INCOMING_HTTP_CONNECTIONS           48
@@ -366,6 +367,13 @@ void SV_Web_RemoveGameClient( const char *session ) {
 	Mem_ZoneFree( client );
 }
 
+/*
+* SV_Web_IsMetricsRequest
+*/
+static bool SV_Web_IsMetricsRequest( const sv_http_request_t *request ) {
+	return request->resource != NULL && !Q_stricmp( request->resource, "metrics" ) && sv_http_metrics->integer;
+}
+
 /*
 * SV_Web_FindGameClientBySession
 */
@@ -792,13 +800,14 @@ static void SV_Web_ReceiveRequest( socket_t *socket, sv_http_connection_t *con )
 			request->error = HTTP_RESP_REQUEST_TOO_LARGE;
 		}
 
-		// request must come from a connected client with a valid session id
+		// request must come from a connected client with a valid session id, except
+		// for /metrics which gets scraped by monitoring
 		if( !request->error && request->stream.header_done ) {
 			// check real IP header value for upstream HTTP connections
 			if( con->is_upstream &&
 				( request->realAddr.type == NA_NOTRANSMIT || SV_Web_ConnectionLimitReached( &request->realAddr ) ) ) {
 				request->error = HTTP_RESP_SERVICE_UNAVAILABLE;
-			} else if( !SV_Web_FindGameClientBySession( request->clientSession, request->clientNum ) ) {
+			} else if( !SV_Web_IsMetricsRequest( request ) && !SV_Web_FindGameClientBySession( request->clientSession, request->clientNum ) ) {
 				request->error = HTTP_RESP_FORBIDDEN;
 			}
 		}
@@ -932,6 +941,21 @@ static void SV_Web_RouteRequest( const sv_http_request_t *request, sv_http_respo
 		} else {
 			response->code = HTTP_RESP_BAD_REQUEST;
 		}
+	} else if( SV_Web_IsMetricsRequest( request ) ) {
+		if( request->method != HTTP_METHOD_GET ) {
+			response->code = HTTP_RESP_BAD_REQUEST;
+			return;
+		}
+
+		DynamicString metrics( sys_allocator );
+		Metrics_Format( &metrics );
+
+		response->content = ( char * ) Mem_ZoneMalloc( metrics.length() );
+		memcpy( response->content, metrics.c_str(), metrics.length() );
+		response->code = HTTP_RESP_OK;
+
+		*content = response->content;
+		*content_length = metrics.length();
 	} else {
 		response->code = HTTP_RESP_NOT_FOUND;
 	}
@@ -1035,6 +1059,10 @@ static void SV_Web_RespondToQuery( sv_http_connection_t *con ) {
 					 response->code, SV_Web_ResponseCodeMessage( response->code ) );
 		content = err_body;
 		content_length = strlen( err_body );
+	} else if( !response->file ) {
+		// the only generated content is /metrics
+		Q_strncatz( resp_stream->header_buf, "Content-Type: text/plain; version=0.0.4\r\n",
+					sizeof( resp_stream->header_buf ) );
 	}
 
 	// resource length
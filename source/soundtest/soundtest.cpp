@@ -0,0 +1,298 @@
+#include "qcommon/base.h"
+#include "qcommon/qcommon.h"
+#include "client/client.h"
+#include "client/assets.h"
+
+// the checks look at the voice pool directly
+#include "client/cl_sound.cpp"
+
+/*
+ * soundtest runs the sound system against whatever OpenAL device it gets and
+ * checks that voices are pooled and virtualized the way they should be: the
+ * loudest MAX_VOICES audible voices get sources, everything else is virtual
+ * and picks up where it should have been when it becomes audible again
+ *
+ * Usage: ALSOFT_DRIVERS=null soundtest
+ * Exits with an error if any check fails.
+ */
+
+client_static_t cls;
+
+static int num_checks;
+static int num_failed_checks;
+
+bool IsWindowFocused() {
+	return true;
+}
+
+template< typename... Rest >
+static void Check( bool ok, const char * fmt, const Rest & ... rest ) {
+	num_checks++;
+	if( ok )
+		return;
+
+	num_failed_checks++;
+
+	char buf[ 256 ];
+	ggformat( buf, sizeof( buf ), fmt, rest... );
+	Com_Printf( S_COLOR_RED "FAILED: %s\n", buf );
+}
+
+struct VoiceCounts {
+	u32 real;
+	u32 virtual_voices;
+};
+
+static VoiceCounts CountVoices() {
+	VoiceCounts counts = { };
+	for( u32 i = 0; i < num_playing_sound_effects; i++ ) {
+		const PlayingSound * ps = &playing_sound_effects[ i ];
+		for( u8 j = 0; j < ps->sfx->num_sounds; j++ ) {
+			const Voice * voice = &ps->voices[ j ];
+			if( !voice->started || voice->stopped )
+				continue;
+
+			if( voice->source != 0 ) {
+				counts.real++;
+			}
+			else {
+				counts.virtual_voices++;
+			}
+		}
+	}
+	return counts;
+}
+
+static void CheckVoiceCounts( const char * what, u32 real, u32 virtual_voices ) {
+	VoiceCounts counts = CountVoices();
+	Check( counts.real == real, "{}: {} real voices, expected {}", what, counts.real, real );
+	Check( counts.virtual_voices == virtual_voices, "{}: {} virtual voices, expected {}", what, counts.virtual_voices, virtual_voices );
+	Check( counts.real + num_free_sound_sources == MAX_VOICES, "{}: {} real voices and {} free sources don't add up to the pool", what, counts.real, num_free_sound_sources );
+}
+
+static void Update( s64 msec ) {
+	constexpr mat3_t axis = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+
+	// S_Update only prints AL errors in release builds, and it doesn't
+	// see the ones the stream thread makes until the next frame
+	ALenum err = alGetError();
+	Check( err == AL_NO_ERROR, "AL error: {}", ALErrorMessage( err ) );
+
+	cls.monotonicTime += msec;
+	S_Update( Vec3( 0.0f ), Vec3( 0.0f ), axis );
+}
+
+constexpr u32 NUM_NOISES = 80;
+constexpr u32 NUM_NEAR_NOISES = 60;
+constexpr u32 NUM_SILENT_NOISES = 10;
+static ImmediateSoundHandle noises[ NUM_NOISES ];
+static ImmediateSoundHandle silent_noises[ NUM_SILENT_NOISES ];
+
+// noises get further away with i, the silent ones are closest but can't be heard
+static void UpdateNoises( bool near_noises, s64 msec ) {
+	for( u32 i = near_noises ? 0 : NUM_NEAR_NOISES; i < NUM_NOISES; i++ ) {
+		noises[ i ] = S_ImmediateFixedSound( "sounds/noise/white", Vec3( 100.0f + 20.0f * i, 0.0f, 0.0f ), 1.0f, noises[ i ] );
+	}
+
+	for( u32 i = 0; i < NUM_SILENT_NOISES; i++ ) {
+		silent_noises[ i ] = S_ImmediateFixedSound( "sounds/noise/white", Vec3( 50.0f, 0.0f, 0.0f ), 0.0f, silent_noises[ i ] );
+	}
+
+	Update( msec );
+}
+
+static void TestVoicePool() {
+	const SoundEffect * noise = FindSoundEffect( "sounds/noise/white" );
+	Check( noise != NULL && noise->num_sounds == 1, "sounds/noise/white should be a single voice" );
+	if( noise == NULL || noise->num_sounds != 1 )
+		return;
+
+	CheckVoiceCounts( "before playing anything", 0, 0 );
+
+	// more audible voices than sources
+	for( int i = 0; i < 10; i++ ) {
+		UpdateNoises( true, 16 );
+	}
+	CheckVoiceCounts( "all playing", MAX_VOICES, NUM_NOISES + NUM_SILENT_NOISES - MAX_VOICES );
+
+	Vec3 listener = Vec3( 0.0f );
+	float quietest_real = FLT_MAX;
+	float loudest_virtual = 0.0f;
+	for( u32 i = 0; i < num_playing_sound_effects; i++ ) {
+		const PlayingSound * ps = &playing_sound_effects[ i ];
+		float gain = VoiceGain( ps, 0, listener );
+		if( ps->voices[ 0 ].source != 0 ) {
+			quietest_real = Min2( quietest_real, gain );
+			ALint state = CheckedALGetSource( ps->voices[ 0 ].source, AL_SOURCE_STATE );
+			Check( state == AL_PLAYING, "real voice isn't playing" );
+		}
+		else {
+			loudest_virtual = Max2( loudest_virtual, gain );
+		}
+	}
+	Check( quietest_real >= loudest_virtual, "a virtual voice ({}) is louder than a real one ({})", loudest_virtual, quietest_real );
+
+	// stop the near noises, the far ones that were virtual should get
+	// sources and pick up where they would have been. the silent ones stay
+	// virtual even though there are sources free
+	UpdateNoises( false, 16 );
+	CheckVoiceCounts( "far noises", NUM_NOISES - NUM_NEAR_NOISES, NUM_SILENT_NOISES );
+
+	u32 num_resumed = 0;
+	for( u32 i = 0; i < num_playing_sound_effects; i++ ) {
+		const PlayingSound * ps = &playing_sound_effects[ i ];
+		const Voice * voice = &ps->voices[ 0 ];
+		if( voice->source == 0 )
+			continue;
+
+		// playing sounds get swapped around when the near noises are removed
+		u64 idx;
+		bool ok = immediate_sounds_hashtable.get( ps->immediate_handle.x, &idx );
+		Check( ok && idx == i, "immediate sound hashtable is out of date" );
+
+		// the far noises that didn't have sources, the ones that did are
+		// playing at whatever rate the device plays them
+		bool resumed = false;
+		for( u32 j = MAX_VOICES; j < NUM_NOISES; j++ ) {
+			resumed = resumed || ps->immediate_handle.x == noises[ j ].x;
+		}
+		if( !resumed )
+			continue;
+
+		num_resumed++;
+
+		s64 expected = VoiceSampleOffset( ps, voice );
+		s64 offset = CheckedALGetSource( voice->source, AL_SAMPLE_OFFSET );
+		s64 tolerance = voice->sound->sample_rate / 10;
+		s64 error = Min2( Abs( offset - expected ), s64( voice->sound->num_samples ) - Abs( offset - expected ) );
+		Check( error <= tolerance, "voice resumed at sample {}, expected {}", offset, expected );
+	}
+	Check( num_resumed == NUM_NOISES - MAX_VOICES, "{} voices resumed, expected {}", num_resumed, NUM_NOISES - MAX_VOICES );
+
+	// immediate sounds stop when they stop getting touched
+	Update( 16 );
+	CheckVoiceCounts( "untouched", 0, 0 );
+	Check( num_playing_sound_effects == 0, "{} sound effects still playing", num_playing_sound_effects );
+
+	// one-shots finish by time, even if they never got a source
+	for( u32 i = 0; i < NUM_SILENT_NOISES; i++ ) {
+		S_StartFixedSound( "sounds/noise/white", Vec3( 100.0f, 0.0f, 0.0f ), CHAN_AUTO, 0.0f );
+	}
+	Update( 16 );
+	CheckVoiceCounts( "silent one-shots", 0, NUM_SILENT_NOISES );
+
+	Update( 60 * 1000 );
+	Check( num_playing_sound_effects == 0, "{} one-shots didn't finish", num_playing_sound_effects );
+	CheckVoiceCounts( "finished one-shots", 0, 0 );
+}
+
+static const SoundStream * FindActiveStream() {
+	Lock( streams_mutex );
+	defer { Unlock( streams_mutex ); };
+
+	for( const SoundStream & stream : streams ) {
+		if( stream.decoder != NULL && !stream.stopped )
+			return &stream;
+	}
+	return NULL;
+}
+
+static bool AnyStreamOpen() {
+	Lock( streams_mutex );
+	defer { Unlock( streams_mutex ); };
+
+	for( const SoundStream & stream : streams ) {
+		if( stream.decoder != NULL )
+			return true;
+	}
+	return false;
+}
+
+static void TestStreaming() {
+	const Sound * music = FindSound( "sounds/music/menu_1" );
+	Check( music != NULL && music->streamed, "sounds/music/menu_1 should be streamed" );
+	if( music == NULL || !music->streamed )
+		return;
+
+	S_StartGlobalSound( "sounds/music/menu_1", CHAN_AUTO, 1.0f );
+	Update( 16 );
+	CheckVoiceCounts( "streaming", 1, 0 );
+
+	const SoundStream * stream = FindActiveStream();
+	Check( stream != NULL, "streamed voice has no stream" );
+	if( stream == NULL )
+		return;
+
+	// play through more than the initially queued buffers in real time so
+	// the stream thread has to keep it going
+	for( int i = 0; i < 100; i++ ) {
+		Sys_Sleep( 16 );
+		Update( 16 );
+	}
+
+	ALuint source = stream->source;
+	Check( CheckedALGetSource( source, AL_SOURCE_STATE ) == AL_PLAYING, "stream stopped playing" );
+	Check( CheckedALGetSource( source, AL_BUFFERS_QUEUED ) > 0, "stream ran dry" );
+	CheckVoiceCounts( "still streaming", 1, 0 );
+
+	S_StopAllSounds( false );
+	CheckVoiceCounts( "stopped stream", 0, 0 );
+
+	// a stream that gets stopped mid-decode is closed by the stream thread
+	bool closed = false;
+	for( int i = 0; i < 100 && !closed; i++ ) {
+		closed = !AnyStreamOpen();
+		if( !closed ) {
+			Sys_Sleep( 1 );
+		}
+	}
+	Check( closed, "stopped stream never got closed" );
+}
+
+/*
+==============================================================================
+
+ENGINE INTERFACE
+
+==============================================================================
+*/
+
+void CL_Init() {
+	constexpr size_t frame_arena_size = 1024 * 1024; // 1MB
+	void * frame_arena_memory = ALLOC_SIZE( sys_allocator, frame_arena_size, 16 );
+	cls.frame_arena = ArenaAllocator( frame_arena_memory, frame_arena_size );
+	cls.rng = NewRNG( 1, 2 );
+
+	TempAllocator temp = cls.frame_arena.temp();
+	InitAssets( &temp );
+}
+
+void CL_Shutdown() {
+	ShutdownAssets();
+	FREE( sys_allocator, cls.frame_arena.get_memory() );
+}
+
+void CL_Frame( int realmsec, int gamemsec ) {
+	if( !S_Init() ) {
+		Com_Error( ERR_FATAL, "S_Init failed, try ALSOFT_DRIVERS=null" );
+	}
+
+	TestVoicePool();
+	TestStreaming();
+
+	S_Shutdown();
+
+	if( num_failed_checks > 0 ) {
+		Com_Error( ERR_FATAL, "%d/%d checks failed", num_failed_checks, num_checks );
+	}
+
+	Com_Printf( "All %d checks passed\n", num_checks );
+	Sys_Quit();
+}
+
+void CL_Disconnect( const char * message ) { }
+
+void Con_Print( const char * text ) { }
+
+void Key_Init() { }
+void Key_Shutdown() { }
@@ -0,0 +1,11 @@
+#include "server/server.h"
+
+// loadgen, relay and soundtest run on the server platform layer without a server
+
+// snap_write.cpp finds edicts through sv
+server_t sv;
+
+void SV_Init() { }
+void SV_Shutdown( const char * finalmsg ) { }
+void SV_ShutdownGame( const char * finalmsg, bool reconnect ) { }
+void SV_Frame( unsigned realmsec, unsigned gamemsec ) { }
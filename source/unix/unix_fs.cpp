@@ -27,6 +27,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <fcntl.h>
 #include <unistd.h>
 #include <linux/fs.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/syscall.h>
 
@@ -81,6 +82,29 @@ bool RemoveFile( Allocator * a, const char * path ) {
 	return unlink( path ) == 0;
 }
 
+Span< const u8 > MapFile( Allocator * a, const char * path ) {
+	int fd = open( path, O_RDONLY );
+	if( fd == -1 )
+		return Span< const u8 >();
+	defer { close( fd ); };
+
+	struct stat buf;
+	if( fstat( fd, &buf ) == -1 || buf.st_size == 0 )
+		return Span< const u8 >();
+
+	void * mapped = mmap( NULL, buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	if( mapped == MAP_FAILED )
+		return Span< const u8 >();
+
+	return Span< const u8 >( ( const u8 * ) mapped, buf.st_size );
+}
+
+void UnmapFile( Span< const u8 > mapped ) {
+	if( mapped.ptr == NULL )
+		return;
+	munmap( const_cast< u8 * >( mapped.ptr ), mapped.n );
+}
+
 bool CreateDirectory( Allocator * a, const char * path ) {
 	return mkdir( path, 0755 ) == 0 || errno == EEXIST;
 }
@@ -77,6 +77,9 @@ void Sys_Error( const char *format, ... ) {
 	vsnprintf( string, sizeof( string ), format, argptr );
 	va_end( argptr );
 
+	// Com_Error has already written the console output, make sure it gets
+	// out before we _exit
+	fflush( stdout );
 	fprintf( stderr, "Error: %s\n", string );
 
 	_exit( 1 );
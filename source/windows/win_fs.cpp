@@ -101,6 +101,38 @@ bool RemoveFile( Allocator * a, const char * path ) {
 	return DeleteFileW( wide_path ) != 0;
 }
 
+Span< const u8 > MapFile( Allocator * a, const char * path ) {
+	wchar_t * wide_path = UTF8ToWide( a, path );
+	defer { FREE( a, wide_path ); };
+
+	HANDLE file = CreateFileW( wide_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if( file == INVALID_HANDLE_VALUE )
+		return Span< const u8 >();
+	defer { CloseHandle( file ); };
+
+	LARGE_INTEGER size;
+	if( GetFileSizeEx( file, &size ) == 0 || size.QuadPart == 0 )
+		return Span< const u8 >();
+
+	// the view keeps the mapping alive so we can close the handles straight away
+	HANDLE mapping = CreateFileMappingW( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	if( mapping == NULL )
+		return Span< const u8 >();
+	defer { CloseHandle( mapping ); };
+
+	void * view = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	if( view == NULL )
+		return Span< const u8 >();
+
+	return Span< const u8 >( ( const u8 * ) view, checked_cast< size_t >( size.QuadPart ) );
+}
+
+void UnmapFile( Span< const u8 > mapped ) {
+	if( mapped.ptr == NULL )
+		return;
+	UnmapViewOfFile( mapped.ptr );
+}
+
 #undef CreateDirectory
 bool CreateDirectory( Allocator * a, const char * path ) {
 	wchar_t * wide_path = UTF8ToWide( a, path );